@@ -0,0 +1,165 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "net/net_api.h"
+#include "protocol/compress.h"
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+using namespace messenger;
+
+namespace {
+
+// Размер одного корпуса — типичная крупная вставка
+constexpr std::size_t CORPUS_SIZE = 64U * 1024U;
+
+enum Corpus : std::int64_t {
+    ChatCorpus = 0,
+    LogCorpus = 1,
+    RandomCorpus = 2,
+};
+
+// Переписка: реплики из словаря разговорной речи вперемешку
+[[nodiscard]]
+auto chatCorpus() -> std::string {
+    constexpr std::array<std::string_view, 24> WORDS{
+        "привет", "как",    "дела",    "нормально", "сегодня", "завтра",
+        "созвон", "в",      "три",     "давай",     "посмотри", "ссылку",
+        "ok",     "deploy", "упал",    "опять",     "кажется", "это",
+        "тест",   "ветка",  "смержил", "спасибо",   "?",        "!"};
+    std::mt19937 random(42);
+    std::uniform_int_distribution<std::size_t> word(0, WORDS.size() - 1);
+    std::uniform_int_distribution<int> length(3, 12);
+
+    std::string text;
+    while (text.size() < CORPUS_SIZE) {
+        const int words = length(random);
+        for (int index = 0; index < words; ++index) {
+            text += WORDS.at(word(random));
+            text += ' ';
+        }
+        text += '\n';
+    }
+    text.resize(CORPUS_SIZE);
+    return text;
+}
+
+// Вставленный лог: временные метки, уровни и повторяющиеся стеки
+[[nodiscard]]
+auto logCorpus() -> std::string {
+    constexpr std::array<std::string_view, 4> LEVELS{"INFO", "DEBUG", "WARN",
+                                                     "ERROR"};
+    constexpr std::string_view STACK =
+        "    at messenger::net::Connection::flush (connection.cpp:88)\n"
+        "    at messenger::app::runConnection (p2p_chat.cpp:1412)\n"
+        "    at messenger::app::chat_loop (p2p_chat.cpp:1468)\n"
+        "    at main (messenger.cpp:97)\n";
+    std::mt19937 random(7);
+    std::uniform_int_distribution<std::size_t> level(0, LEVELS.size() - 1);
+    std::uniform_int_distribution<std::uint32_t> value(0, 99999);
+
+    std::string text;
+    std::uint64_t millis = 1700000000000ULL;
+    while (text.size() < CORPUS_SIZE) {
+        millis += value(random) % 50U;
+        const std::string_view lvl = LEVELS.at(level(random));
+        text += std::to_string(millis) + " [" + std::string(lvl) +
+                "] worker-" + std::to_string(value(random) % 8U) +
+                " request id=" + std::to_string(value(random)) +
+                " status=" + std::to_string(200U + value(random) % 4U) +
+                " latency_ms=" + std::to_string(value(random) % 900U) + "\n";
+        if (lvl == "ERROR") {
+            text += STACK;
+        }
+    }
+    text.resize(CORPUS_SIZE);
+    return text;
+}
+
+// Несжимаемые данные: худший случай (бинарный файл, архив)
+[[nodiscard]]
+auto randomCorpus() -> std::string {
+    std::mt19937 random(1);
+    std::string text(CORPUS_SIZE, '\0');
+    for (char& byte : text) {
+        byte = static_cast<char>(random());
+    }
+    return text;
+}
+
+[[nodiscard]]
+auto corpus(std::int64_t kind) -> std::string {
+    switch (kind) {
+        case ChatCorpus:
+            return chatCorpus();
+        case LogCorpus:
+            return logCorpus();
+        default:
+            return randomCorpus();
+    }
+}
+
+void reportCost(benchmark::State& state, std::size_t bytes) {
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                            static_cast<std::int64_t>(bytes));
+    // Процессорное время на мегабайт исходного текста
+    state.counters["cpu_ms_per_mb"] = benchmark::Counter(
+        static_cast<double>(bytes) / (1024.0 * 1024.0) * 1e-3,
+        benchmark::Counter::kIsIterationInvariantRate |
+            benchmark::Counter::kInvert);
+}
+
+}  // namespace
+
+// Сжатие корпуса: пропускная способность, степень сжатия, CPU на МБ
+void BM_CompressPayload(benchmark::State& state) {
+    const std::string text = corpus(state.range(0));
+    std::string packed;
+
+    bool compressed = false;
+    for (auto _ : state) {
+        compressed = proto::compress_payload(text, packed);
+        benchmark::DoNotOptimize(packed.data());
+    }
+
+    reportCost(state, text.size());
+    state.counters["ratio"] =
+        compressed ? static_cast<double>(text.size()) /
+                         static_cast<double>(packed.size())
+                   : 1.0;
+}
+BENCHMARK(BM_CompressPayload)
+    ->ArgName("corpus")
+    ->Arg(ChatCorpus)
+    ->Arg(LogCorpus)
+    ->Arg(RandomCorpus);
+
+// Распаковка на стороне получателя
+void BM_DecompressPayload(benchmark::State& state) {
+    const std::string text = corpus(state.range(0));
+    std::string packed;
+    if (!proto::compress_payload(text, packed)) {
+        state.SkipWithError("корпус не сжимается");
+        return;
+    }
+    std::string unpacked;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(proto::decompress_payload(
+            packed, net::MaxPayloadSize::value, unpacked));
+    }
+
+    reportCost(state, text.size());
+}
+BENCHMARK(BM_DecompressPayload)
+    ->ArgName("corpus")
+    ->Arg(ChatCorpus)
+    ->Arg(LogCorpus);
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
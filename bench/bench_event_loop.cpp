@@ -0,0 +1,163 @@
+#include <benchmark/benchmark.h>
+#include <sys/resource.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include "net/event_loop.h"
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+using namespace messenger;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Длительность наблюдения за простаивающей сессией
+constexpr auto IDLE_WINDOW = std::chrono::seconds(2);
+
+// Прежний интервал опроса таймеров через select()
+constexpr int LEGACY_SELECT_TIMEOUT_USEC = 500000;
+
+// Ближайший дедлайн простаивающей сессии — очередной Ping (10 с)
+constexpr auto IDLE_PING_INTERVAL = std::chrono::seconds(10);
+
+[[nodiscard]]
+auto cpuTimeUsec() -> double {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    const auto to_usec = [](const timeval& time_v) {
+        return static_cast<double>(time_v.tv_sec) * 1e6 +
+               static_cast<double>(time_v.tv_usec);
+    };
+    return to_usec(usage.ru_utime) + to_usec(usage.ru_stime);
+}
+
+struct IdleSession {
+    std::array<int, 2> sock_pair{-1, -1};
+
+    IdleSession() {
+        ::socketpair(AF_UNIX, SOCK_STREAM, 0, sock_pair.data());
+    }
+    ~IdleSession() {
+        ::close(sock_pair[0]);
+        ::close(sock_pair[1]);
+    }
+
+    IdleSession(const IdleSession&) = delete;
+    IdleSession& operator=(const IdleSession&) = delete;
+    IdleSession(IdleSession&&) = delete;
+    IdleSession& operator=(IdleSession&&) = delete;
+};
+
+void reportIdle(benchmark::State& state, std::uint64_t wakeups,
+                double cpu_usec, double seconds) {
+    state.counters["wakeups_per_sec"] = static_cast<double>(wakeups) / seconds;
+    state.counters["cpu_usec_per_sec"] = cpu_usec / seconds;
+}
+
+}  // namespace
+
+// Прежняя схема: select() с таймаутом 500 мс ради опроса Ack/Ping‑таймеров
+void BM_IdleSessionSelectPolling(benchmark::State& state) {
+    const IdleSession session;
+    const int sock_fd = session.sock_pair[0];
+
+    for (auto _ : state) {
+        std::uint64_t wakeups = 0;
+        const double cpu_before = cpuTimeUsec();
+        const auto start = Clock::now();
+
+        while (Clock::now() - start < IDLE_WINDOW) {
+            fd_set readfds;
+            FD_ZERO(&readfds);
+            FD_SET(sock_fd, &readfds);
+
+            timeval t_v{};
+            t_v.tv_usec = LEGACY_SELECT_TIMEOUT_USEC;
+            benchmark::DoNotOptimize(
+                ::select(sock_fd + 1, &readfds, nullptr, nullptr, &t_v));
+            ++wakeups;
+        }
+
+        const double seconds =
+            std::chrono::duration<double>(Clock::now() - start).count();
+        reportIdle(state, wakeups, cpuTimeUsec() - cpu_before, seconds);
+    }
+}
+BENCHMARK(BM_IdleSessionSelectPolling)
+    ->Iterations(1)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Новая схема: epoll + timerfd на ближайший дедлайн (очередной Ping)
+void BM_IdleSessionEpollTimerfd(benchmark::State& state) {
+    const IdleSession session;
+    const int sock_fd = session.sock_pair[0];
+
+    net::EventLoop loop;
+    loop.add(sock_fd, EPOLLIN);
+
+    for (auto _ : state) {
+        const std::uint64_t wakeups_before = loop.wakeups();
+        const double cpu_before = cpuTimeUsec();
+        const auto start = Clock::now();
+
+        loop.arm_timer(start + IDLE_PING_INTERVAL);
+        while (true) {
+            const auto remaining =
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    IDLE_WINDOW - (Clock::now() - start));
+            if (remaining.count() <= 0) {
+                break;
+            }
+            // Ограничение по времени — только чтобы завершить замер
+            benchmark::DoNotOptimize(
+                loop.wait(static_cast<int>(remaining.count())));
+        }
+
+        const double seconds =
+            std::chrono::duration<double>(Clock::now() - start).count();
+        // Последнее пробуждение — окончание окна замера, а не событие сессии
+        reportIdle(state, loop.wakeups() - wakeups_before - 1,
+                   cpuTimeUsec() - cpu_before, seconds);
+    }
+}
+BENCHMARK(BM_IdleSessionEpollTimerfd)
+    ->Iterations(1)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Точность пробуждения по timerfd: отклонение от дедлайна
+void BM_TimerfdWakeupLatency(benchmark::State& state) {
+    net::EventLoop loop;
+    const auto delay = std::chrono::milliseconds(state.range(0));
+    double total_lateness_usec = 0.0;
+
+    for (auto _ : state) {
+        const auto deadline = Clock::now() + delay;
+        loop.arm_timer(deadline);
+        do {
+            benchmark::DoNotOptimize(loop.wait());
+        } while (!loop.timer_expired());
+        total_lateness_usec +=
+            std::chrono::duration<double, std::micro>(Clock::now() - deadline)
+                .count();
+    }
+
+    state.counters["lateness_usec"] =
+        total_lateness_usec / static_cast<double>(state.iterations());
+}
+BENCHMARK(BM_TimerfdWakeupLatency)
+    ->Arg(1)
+    ->Arg(10)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
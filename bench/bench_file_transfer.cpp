@@ -0,0 +1,174 @@
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "net/connection.h"
+#include "net/frame_header.h"
+#include "net/frame_reader.h"
+#include "net/outbound_queue.h"
+#include "net/raii_socket.h"
+#include "protocol/file_frames.h"
+#include "protocol/message.hpp"
+#include "protocol/protocol_api.h"
+#include "protocol/serializer.h"
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+using namespace messenger;
+
+namespace {
+
+// Размер передаваемого файла
+constexpr std::size_t FILE_SIZE = 32U * 1024U * 1024U;
+
+enum Path : std::int64_t {
+    SendfilePath = 0,  // proto::send_file_chunk: sendfile() из page cache
+    CopyPath = 1,      // pread() в буфер и send() кадра из него
+};
+
+// Временный файл на всё время бенчмарка, после первого прохода — в page
+// cache: замер сравнивает копирование, а не диск
+class SourceFile {
+public:
+    SourceFile()
+        : path_(std::filesystem::temp_directory_path() /
+                ("bench_file_" + std::to_string(::getpid()))) {
+        std::ofstream(path_, std::ios::binary)
+            << std::string(FILE_SIZE, 'f');
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+        fd_ = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    ~SourceFile() {
+        ::close(fd_);
+        std::filesystem::remove(path_);
+    }
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+    SourceFile(SourceFile&&) = delete;
+    SourceFile& operator=(SourceFile&&) = delete;
+
+    [[nodiscard]]
+    auto fd() const -> int {
+        return fd_;
+    }
+
+private:
+    std::filesystem::path path_;
+    int fd_{-1};
+};
+
+void waitWritable(int socket_fd) {
+    pollfd writable{socket_fd, POLLOUT, 0};
+    ::poll(&writable, 1, -1);
+}
+
+// Дождаться, пока очередь целиком уйдёт в сокет
+void drain(net::Connection& conn) {
+    while (!conn.outbound().empty()) {
+        waitWritable(conn.fd());
+        benchmark::DoNotOptimize(conn.outbound().flush(conn.fd()));
+    }
+}
+
+// Получатель: разбирает FileChunk без копирования и считает байты файла
+void runReceiver(net::Connection& conn) {
+    net::FrameReader& reader = conn.reader();
+    std::uint64_t received = 0;
+    while (received < FILE_SIZE) {
+        pollfd readable{conn.fd(), POLLIN, 0};
+        ::poll(&readable, 1, -1);
+        if (reader.fill(conn.fd()) != net::FrameReader::ReadStatus::Ok) {
+            return;
+        }
+        std::span<const std::uint8_t> frame;
+        while (reader.next_frame(frame) ==
+               net::FrameReader::FrameStatus::Ready) {
+            const auto chunk = proto::parse_file_chunk(frame);
+            if (chunk) {
+                benchmark::DoNotOptimize(chunk->data.data());
+                received += chunk->data.size();
+            }
+        }
+    }
+}
+
+void sendCopied(net::Connection& conn, int file_fd,
+                std::vector<std::uint8_t>& buffer, std::uint64_t offset,
+                std::size_t length) {
+    std::array<std::uint8_t, proto::HEADER_SIZE + proto::FILE_OFFSET_SIZE>
+        prefix{};
+    const auto header = proto::encode_header(
+        net::HeaderFormat::V1, proto::MsgType::FileChunk, 1,
+        static_cast<std::uint32_t>(proto::FILE_OFFSET_SIZE + length));
+    const auto offset_bytes = proto::encode_file_offset(offset);
+    const auto header_bytes = header.view();
+    std::copy(header_bytes.begin(), header_bytes.end(), prefix.begin());
+    std::copy(offset_bytes.begin(), offset_bytes.end(),
+              prefix.begin() + proto::HEADER_SIZE);
+
+    buffer.resize(length);
+    benchmark::DoNotOptimize(::pread(file_fd, buffer.data(), length,
+                                     static_cast<off_t>(offset)));
+    benchmark::DoNotOptimize(conn.outbound().send(conn.fd(), prefix, buffer));
+}
+
+}  // namespace
+
+// Файл через socketpair кусками FILE_CHUNK_SIZE: sendfile() против
+// чтения в пользовательский буфер и send(). Пропускная способность и
+// процессорное время отправителя на мегабайт
+void BM_FileTransfer(benchmark::State& state) {
+    const auto path = static_cast<Path>(state.range(0));
+    static const SourceFile source;
+    std::vector<std::uint8_t> buffer;
+
+    for (auto _ : state) {
+        std::array<int, 2> sock_pair{-1, -1};
+        ::socketpair(AF_UNIX, SOCK_STREAM, 0, sock_pair.data());
+        net::Connection sender{net::Socket(sock_pair[0])};
+        net::Connection receiver{net::Socket(sock_pair[1])};
+        std::thread receiver_thread([&receiver] { runReceiver(receiver); });
+
+        for (std::uint64_t offset = 0; offset < FILE_SIZE;
+             offset += proto::FILE_CHUNK_SIZE) {
+            drain(sender);
+            if (path == SendfilePath) {
+                benchmark::DoNotOptimize(proto::send_file_chunk(
+                    sender, 1, source.fd(), offset, proto::FILE_CHUNK_SIZE));
+            } else {
+                sendCopied(sender, source.fd(), buffer, offset,
+                           proto::FILE_CHUNK_SIZE);
+            }
+        }
+        drain(sender);
+        receiver_thread.join();
+    }
+
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                            static_cast<std::int64_t>(FILE_SIZE));
+    state.counters["cpu_ms_per_mb"] = benchmark::Counter(
+        static_cast<double>(FILE_SIZE) / (1024.0 * 1024.0) * 1e-3,
+        benchmark::Counter::kIsIterationInvariantRate |
+            benchmark::Counter::kInvert);
+}
+BENCHMARK(BM_FileTransfer)
+    ->ArgName("path")
+    ->Arg(SendfilePath)
+    ->Arg(CopyPath)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
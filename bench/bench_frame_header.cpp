@@ -0,0 +1,151 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "net/frame_header.h"
+#include "protocol/message.hpp"
+#include "protocol/serializer.h"
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+using namespace messenger;
+
+namespace {
+
+enum Format : std::int64_t {
+    V1Format = 1,
+    V2Format = 2,
+};
+
+[[nodiscard]]
+auto headerFormat(std::int64_t format) -> net::HeaderFormat {
+    return format == V1Format ? net::HeaderFormat::V1 : net::HeaderFormat::V2;
+}
+
+// Поток чата в середине сеанса: msg_id в тысячах; на 10 кадров — 4 Text
+// по 120 байт, 3 Ack, 2 Typing и Ping
+[[nodiscard]]
+auto chatTraffic() -> std::vector<proto::Message> {
+    std::vector<proto::Message> messages;
+    for (std::uint32_t index = 0; index < 1000; ++index) {
+        const std::uint32_t msg_id = 5000 + index;
+        switch (index % 10) {
+            case 0:
+            case 3:
+            case 5:
+            case 8:
+                messages.push_back(
+                    {proto::MsgType::Text, msg_id, std::string(120, 'x')});
+                break;
+            case 1:
+            case 4:
+            case 7:
+                messages.push_back({proto::MsgType::Ack, msg_id, {}});
+                break;
+            case 2:
+            case 6:
+                messages.push_back({proto::MsgType::Typing, 0, {}});
+                break;
+            default:
+                messages.push_back({proto::MsgType::Ping, index, {}});
+                break;
+        }
+    }
+    return messages;
+}
+
+void reportWire(benchmark::State& state, std::size_t frames,
+                std::size_t wire_bytes, std::size_t payload_bytes) {
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) *
+                            static_cast<std::int64_t>(frames));
+    state.counters["wire_bytes_per_frame"] =
+        static_cast<double>(wire_bytes) / static_cast<double>(frames);
+    state.counters["header_bytes_per_frame"] =
+        static_cast<double>(wire_bytes - payload_bytes) /
+        static_cast<double>(frames);
+}
+
+}  // namespace
+
+// Только заголовок на стеке — путь отправки protocol_api
+void BM_EncodeHeader(benchmark::State& state) {
+    const net::HeaderFormat format = headerFormat(state.range(0));
+    const std::vector<proto::Message> messages = chatTraffic();
+
+    std::size_t wire_bytes = 0;
+    std::size_t payload_bytes = 0;
+    for (const auto& msg : messages) {
+        wire_bytes += proto::encode_header(
+                          format, msg.type, msg.id,
+                          static_cast<std::uint32_t>(msg.payload.size()))
+                          .size +
+                      msg.payload.size();
+        payload_bytes += msg.payload.size();
+    }
+
+    for (auto _ : state) {
+        for (const auto& msg : messages) {
+            auto header = proto::encode_header(
+                format, msg.type, msg.id,
+                static_cast<std::uint32_t>(msg.payload.size()));
+            benchmark::DoNotOptimize(header);
+        }
+    }
+    reportWire(state, messages.size(), wire_bytes, payload_bytes);
+}
+BENCHMARK(BM_EncodeHeader)->ArgName("v")->Arg(V1Format)->Arg(V2Format);
+
+// serialize(): кадр целиком в вектор
+void BM_Serialize(benchmark::State& state) {
+    const net::HeaderFormat format = headerFormat(state.range(0));
+    const std::vector<proto::Message> messages = chatTraffic();
+
+    std::size_t wire_bytes = 0;
+    std::size_t payload_bytes = 0;
+    for (const auto& msg : messages) {
+        wire_bytes += proto::serialize(msg, format).size();
+        payload_bytes += msg.payload.size();
+    }
+
+    for (auto _ : state) {
+        for (const auto& msg : messages) {
+            benchmark::DoNotOptimize(proto::serialize(msg, format));
+        }
+    }
+    reportWire(state, messages.size(), wire_bytes, payload_bytes);
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                            static_cast<std::int64_t>(wire_bytes));
+}
+BENCHMARK(BM_Serialize)->ArgName("v")->Arg(V1Format)->Arg(V2Format);
+
+// deserialize() потока кадров
+void BM_Deserialize(benchmark::State& state) {
+    const net::HeaderFormat format = headerFormat(state.range(0));
+    const std::vector<proto::Message> messages = chatTraffic();
+
+    std::vector<std::vector<std::uint8_t>> frames;
+    std::size_t wire_bytes = 0;
+    std::size_t payload_bytes = 0;
+    for (const auto& msg : messages) {
+        frames.push_back(proto::serialize(msg, format));
+        wire_bytes += frames.back().size();
+        payload_bytes += msg.payload.size();
+    }
+
+    proto::Message out{};
+    for (auto _ : state) {
+        for (const auto& frame : frames) {
+            benchmark::DoNotOptimize(proto::deserialize(frame, out));
+        }
+    }
+    reportWire(state, messages.size(), wire_bytes, payload_bytes);
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                            static_cast<std::int64_t>(wire_bytes));
+}
+BENCHMARK(BM_Deserialize)->ArgName("v")->Arg(V1Format)->Arg(V2Format);
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
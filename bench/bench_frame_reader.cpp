@@ -0,0 +1,181 @@
+#include <benchmark/benchmark.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "net/frame_reader.h"
+#include "net/net_api.h"
+#include "protocol/message.hpp"
+#include "protocol/serializer.h"
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+namespace {
+
+// Счётчик вызовов recv() внутри бенчмарка
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+std::uint64_t recv_syscalls = 0;
+
+}  // namespace
+
+// Перехват recv() в бинарнике бенчмарка: и net::recv_bytes, и FrameReader
+// собраны в этот же исполняемый файл, поэтому их вызовы идут сюда и
+// учитываются, после чего уходят в ядро напрямую
+extern "C" ssize_t recv(int socket_fd, void* buffer, std::size_t length,
+                        int flags) {
+    ++recv_syscalls;
+    return ::syscall(SYS_recvfrom, socket_fd, buffer, length, flags, nullptr,
+                     nullptr);
+}
+
+using namespace messenger;
+
+namespace {
+
+// Количество кадров в одной пачке
+constexpr std::uint32_t BURST_FRAMES = 64;
+
+struct BurstSocketPair {
+    std::array<int, 2> sock_pair{-1, -1};
+    std::vector<std::uint8_t> burst;
+
+    explicit BurstSocketPair(std::size_t payload_size) {
+        ::socketpair(AF_UNIX, SOCK_STREAM, 0, sock_pair.data());
+
+        // Мелкие Ack вперемешку с Text заданного размера
+        for (std::uint32_t msg_id = 1; msg_id <= BURST_FRAMES; ++msg_id) {
+            const proto::Message msg =
+                (msg_id % 2 == 0)
+                    ? proto::Message{proto::MsgType::Ack, msg_id, {}}
+                    : proto::Message{proto::MsgType::Text, msg_id,
+                                     std::string(payload_size, 'x')};
+            const auto bytes = proto::serialize(msg);
+            burst.insert(burst.end(), bytes.begin(), bytes.end());
+        }
+    }
+    ~BurstSocketPair() {
+        ::close(sock_pair[0]);
+        ::close(sock_pair[1]);
+    }
+
+    BurstSocketPair(const BurstSocketPair&) = delete;
+    BurstSocketPair& operator=(const BurstSocketPair&) = delete;
+    BurstSocketPair(BurstSocketPair&&) = delete;
+    BurstSocketPair& operator=(BurstSocketPair&&) = delete;
+
+    void sendBurst() const {
+        ::send(sock_pair[1], burst.data(), burst.size(), 0);
+    }
+};
+
+void reportSyscalls(benchmark::State& state, std::uint64_t syscalls) {
+    const auto frames =
+        static_cast<double>(state.iterations()) * BURST_FRAMES;
+    state.counters["recv_per_frame"] = static_cast<double>(syscalls) / frames;
+    state.counters["frames_per_sec"] =
+        benchmark::Counter(frames, benchmark::Counter::kIsRate);
+}
+
+}  // namespace
+
+// До: net::recv_bytes — заголовок и payload отдельными recv() на кадр
+void BM_RecvBytesPerFrame(benchmark::State& state) {
+    const BurstSocketPair pair(static_cast<std::size_t>(state.range(0)));
+    std::vector<std::uint8_t> frame;
+    recv_syscalls = 0;
+
+    for (auto _ : state) {
+        pair.sendBurst();
+        for (std::uint32_t index = 0; index < BURST_FRAMES; ++index) {
+            benchmark::DoNotOptimize(net::recv_bytes(pair.sock_pair[0], frame));
+        }
+    }
+
+    reportSyscalls(state, recv_syscalls);
+}
+BENCHMARK(BM_RecvBytesPerFrame)->Arg(0)->Arg(64)->Arg(1024);
+
+// После: FrameReader — крупный recv() и разбор всех буферизованных кадров
+void BM_FrameReaderBurst(benchmark::State& state) {
+    const BurstSocketPair pair(static_cast<std::size_t>(state.range(0)));
+    net::FrameReader reader;
+    std::span<const std::uint8_t> frame;
+    recv_syscalls = 0;
+
+    for (auto _ : state) {
+        pair.sendBurst();
+        std::uint32_t parsed = 0;
+        while (parsed < BURST_FRAMES) {
+            benchmark::DoNotOptimize(reader.fill(pair.sock_pair[0]));
+            while (reader.next_frame(frame) ==
+                   net::FrameReader::FrameStatus::Ready) {
+                benchmark::DoNotOptimize(frame.data());
+                ++parsed;
+            }
+        }
+    }
+
+    reportSyscalls(state, recv_syscalls);
+}
+BENCHMARK(BM_FrameReaderBurst)->Arg(0)->Arg(64)->Arg(1024);
+
+// Разбор пачки в Message: payload копируется в собственную строку
+void BM_DeserializeBurst(benchmark::State& state) {
+    const BurstSocketPair pair(static_cast<std::size_t>(state.range(0)));
+    net::FrameReader reader;
+    std::span<const std::uint8_t> frame;
+    recv_syscalls = 0;
+
+    for (auto _ : state) {
+        pair.sendBurst();
+        std::uint32_t parsed = 0;
+        while (parsed < BURST_FRAMES) {
+            benchmark::DoNotOptimize(reader.fill(pair.sock_pair[0]));
+            while (reader.next_frame(frame) ==
+                   net::FrameReader::FrameStatus::Ready) {
+                proto::Message msg{};
+                benchmark::DoNotOptimize(proto::deserialize(frame, msg));
+                ++parsed;
+            }
+        }
+    }
+
+    reportSyscalls(state, recv_syscalls);
+}
+BENCHMARK(BM_DeserializeBurst)->Arg(0)->Arg(64)->Arg(1024);
+
+// Разбор пачки в MessageView: payload указывает в буфер FrameReader
+void BM_DeserializeViewBurst(benchmark::State& state) {
+    const BurstSocketPair pair(static_cast<std::size_t>(state.range(0)));
+    net::FrameReader reader;
+    proto::ReceiveArena arena;
+    std::span<const std::uint8_t> frame;
+    recv_syscalls = 0;
+
+    for (auto _ : state) {
+        pair.sendBurst();
+        std::uint32_t parsed = 0;
+        while (parsed < BURST_FRAMES) {
+            benchmark::DoNotOptimize(reader.fill(pair.sock_pair[0]));
+            while (reader.next_frame(frame) ==
+                   net::FrameReader::FrameStatus::Ready) {
+                proto::MessageView msg{};
+                benchmark::DoNotOptimize(
+                    proto::deserialize(frame, msg, arena));
+                ++parsed;
+            }
+        }
+    }
+
+    reportSyscalls(state, recv_syscalls);
+}
+BENCHMARK(BM_DeserializeViewBurst)->Arg(0)->Arg(64)->Arg(1024);
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
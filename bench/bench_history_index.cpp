@@ -0,0 +1,117 @@
+#include <benchmark/benchmark.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "app/history_index.h"
+#include "app/history_store.h"
+#include "utils/async_appender.h"
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+using namespace messenger;
+
+namespace {
+
+constexpr std::size_t STORED_MESSAGES = 1000000U;
+constexpr std::size_t RESULT_LIMIT = 20U;
+
+// История из миллиона сообщений с индексом: строится один раз на запуск
+// бенчмарков. Слово "редкое" — в каждом 10000-м сообщении, "частое" — в
+// каждом втором
+struct SearchCorpus {
+    std::string base = (std::filesystem::temp_directory_path() /
+                        ("messenger_bench_index_" + std::to_string(::getpid())))
+                           .string();
+    std::unique_ptr<app::HistoryStore> store;
+    std::unique_ptr<app::HistoryIndex> index;
+
+    SearchCorpus() {
+        utils::AsyncAppender::Options options{};
+        options.durability = utils::AsyncAppender::Durability::None;
+        store = std::make_unique<app::HistoryStore>(base, options);
+        index = std::make_unique<app::HistoryIndex>(base, *store);
+
+        for (std::size_t line = 0; line < STORED_MESSAGES; ++line) {
+            std::string text = "[Собеседник]: сообщение номер " +
+                               std::to_string(line % 1000) + " про погоду";
+            if (line % 2 == 0) {
+                text += " частое";
+            }
+            if (line % 10000 == 0) {
+                text += " редкое";
+            }
+            store->append(text);
+            index->add(text);
+        }
+        store->flush();
+        index->flush();
+    }
+
+    ~SearchCorpus() {
+        index.reset();
+        store.reset();
+        const std::filesystem::path base_path(base);
+        const std::string prefix = base_path.filename().string() + ".";
+        for (const auto& file : std::filesystem::directory_iterator(
+                 base_path.parent_path())) {
+            if (file.path().filename().string().starts_with(prefix)) {
+                std::filesystem::remove(file.path());
+            }
+        }
+    }
+
+    SearchCorpus(const SearchCorpus&) = delete;
+    SearchCorpus& operator=(const SearchCorpus&) = delete;
+    SearchCorpus(SearchCorpus&&) = delete;
+    SearchCorpus& operator=(SearchCorpus&&) = delete;
+};
+
+[[nodiscard]]
+auto corpus() -> SearchCorpus& {
+    static SearchCorpus instance;
+    return instance;
+}
+
+}  // namespace
+
+// До: поиск перебором всех записей истории
+void BM_HistoryLinearScan(benchmark::State& state) {
+    auto& history = corpus();
+    for (auto _ : state) {
+        std::size_t found = 0;
+        for (std::size_t entry = history.store->size();
+             entry-- > 0 && found < RESULT_LIMIT;) {
+            if (history.store->read(entry).find("редкое") !=
+                std::string_view::npos) {
+                ++found;
+            }
+        }
+        benchmark::DoNotOptimize(found);
+    }
+}
+BENCHMARK(BM_HistoryLinearScan)->Unit(benchmark::kMillisecond);
+
+// После: запрос к обратному индексу
+void BM_HistoryIndexSearch(benchmark::State& state) {
+    auto& history = corpus();
+    const std::array<std::string_view, 4> queries{
+        "редкое", "частое", "редкое частое погоду", "отсутствует"};
+    const std::string query(
+        queries[static_cast<std::size_t>(state.range(0))]);
+    for (auto _ : state) {
+        auto found = history.index->search(query, RESULT_LIMIT);
+        benchmark::DoNotOptimize(found.data());
+    }
+    state.SetLabel(query);
+}
+BENCHMARK(BM_HistoryIndexSearch)
+    ->DenseRange(0, 3)
+    ->Unit(benchmark::kMicrosecond);
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
@@ -0,0 +1,69 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "app/history_ring.h"
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+using namespace messenger;
+
+namespace {
+
+// Полная история чата и типичная строка
+constexpr std::size_t HISTORY_LINES = 10000U;
+const std::string HISTORY_LINE = "[Собеседник]: " + std::string(80, 'x');
+
+}  // namespace
+
+// До: vector<string>, обрезаемый erase(begin()) — каждая новая строка
+// сдвигает все 10000 строк
+void BM_HistoryVectorEraseBegin(benchmark::State& state) {
+    std::vector<std::string> history(HISTORY_LINES, HISTORY_LINE);
+    for (auto _ : state) {
+        history.push_back(HISTORY_LINE);
+        if (history.size() > HISTORY_LINES) {
+            history.erase(history.begin());
+        }
+    }
+    // Грубая оценка: объекты строк и их буферы (без накладных malloc)
+    state.counters["memory_bytes"] = static_cast<double>(
+        history.capacity() * sizeof(std::string) +
+        history.size() * (HISTORY_LINE.capacity() + 1));
+}
+BENCHMARK(BM_HistoryVectorEraseBegin);
+
+// После: кольцо в одной арене — вытеснение старой строки O(1)
+void BM_HistoryRingPush(benchmark::State& state) {
+    app::HistoryRing history(HISTORY_LINES);
+    for (std::size_t index = 0; index < HISTORY_LINES; ++index) {
+        history.push(HISTORY_LINE);
+    }
+    for (auto _ : state) {
+        history.push(HISTORY_LINE);
+    }
+    state.counters["memory_bytes"] =
+        static_cast<double>(history.memory_bytes());
+}
+BENCHMARK(BM_HistoryRingPush);
+
+// Вывод одной страницы /история: 20 последних строк
+void BM_HistoryRingPage(benchmark::State& state) {
+    app::HistoryRing history(HISTORY_LINES);
+    for (std::size_t index = 0; index < HISTORY_LINES; ++index) {
+        history.push(HISTORY_LINE);
+    }
+    for (auto _ : state) {
+        std::size_t bytes = 0;
+        for (std::size_t index = HISTORY_LINES - 20; index < HISTORY_LINES;
+             ++index) {
+            bytes += history[index].size();
+        }
+        benchmark::DoNotOptimize(bytes);
+    }
+}
+BENCHMARK(BM_HistoryRingPage);
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
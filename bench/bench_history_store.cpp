@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "app/history_store.h"
+#include "utils/async_appender.h"
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+using namespace messenger;
+
+namespace {
+
+// Типичная строка истории и число строк, загружаемых при запуске
+const std::string HISTORY_LINE = "[Собеседник]: " + std::string(80, 'x');
+constexpr std::size_t STARTUP_LINES = 200U;
+
+[[nodiscard]]
+auto benchBasePath() -> std::string {
+    return (std::filesystem::temp_directory_path() /
+            ("messenger_bench_store_" + std::to_string(::getpid())))
+        .string();
+}
+
+void removeFiles(const std::string& base) {
+    std::filesystem::remove(base + ".txt");
+    std::filesystem::remove(base + ".log");
+    std::filesystem::remove(base + ".idx");
+}
+
+}  // namespace
+
+// До: запуск читает весь chat_history.txt через getline
+void BM_StartupTextHistory(benchmark::State& state) {
+    const std::string base = benchBasePath();
+    {
+        std::ofstream text(base + ".txt");
+        for (std::int64_t index = 0; index < state.range(0); ++index) {
+            text << HISTORY_LINE << '\n';
+        }
+    }
+
+    for (auto _ : state) {
+        std::ifstream text(base + ".txt");
+        std::vector<std::string> history;
+        std::string line;
+        while (std::getline(text, line)) {
+            history.push_back(line);
+        }
+        benchmark::DoNotOptimize(history.data());
+    }
+    removeFiles(base);
+}
+BENCHMARK(BM_StartupTextHistory)->Arg(10000)->Arg(100000)->Arg(1000000);
+
+// После: открытие журнала с индексом и чтение только последних строк —
+// время не зависит от размера истории
+void BM_StartupHistoryStore(benchmark::State& state) {
+    const std::string base = benchBasePath();
+    utils::AsyncAppender::Options options{};
+    options.durability = utils::AsyncAppender::Durability::None;
+    {
+        app::HistoryStore store(base, options);
+        for (std::int64_t index = 0; index < state.range(0); ++index) {
+            store.append(HISTORY_LINE);
+        }
+    }
+
+    for (auto _ : state) {
+        app::HistoryStore store(base, options);
+        std::size_t bytes = 0;
+        for (std::size_t index = store.size() - STARTUP_LINES;
+             index < store.size(); ++index) {
+            bytes += store.read(index).size();
+        }
+        benchmark::DoNotOptimize(bytes);
+    }
+    removeFiles(base);
+}
+BENCHMARK(BM_StartupHistoryStore)->Arg(10000)->Arg(100000)->Arg(1000000);
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
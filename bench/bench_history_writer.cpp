@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "utils/async_appender.h"
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+using namespace messenger;
+
+namespace {
+
+// Типичная строка истории чата
+const std::string HISTORY_LINE = "[Собеседник]: " + std::string(80, 'x');
+
+[[nodiscard]]
+auto benchFilePath() -> std::filesystem::path {
+    return std::filesystem::temp_directory_path() /
+           ("messenger_bench_history_" + std::to_string(::getpid()) + ".txt");
+}
+
+}  // namespace
+
+// До: ofstream открывается, дописывается и закрывается на каждую строку
+// прямо в цикле чата
+void BM_OfstreamPerLine(benchmark::State& state) {
+    const auto path = benchFilePath();
+    for (auto _ : state) {
+        std::ofstream history_file(path, std::ios::app);
+        history_file << HISTORY_LINE << '\n';
+    }
+    std::filesystem::remove(path);
+}
+BENCHMARK(BM_OfstreamPerLine);
+
+// После: цикл чата только ставит строку в очередь; время итерации —
+// стоимость для цикла чата, диск — в потоке записи
+void BM_AsyncAppenderAppend(benchmark::State& state) {
+    const auto path = benchFilePath();
+    {
+        utils::AsyncAppender::Options options{};
+        options.durability =
+            static_cast<utils::AsyncAppender::Durability>(state.range(0));
+        utils::AsyncAppender appender(path.string(), options);
+
+        for (auto _ : state) {
+            appender.append(HISTORY_LINE + '\n');
+        }
+        appender.flush();
+
+        state.counters["records_per_batch"] =
+            static_cast<double>(appender.written_records()) /
+            static_cast<double>(appender.write_batches());
+        state.counters["syncs"] = static_cast<double>(appender.sync_count());
+    }
+    std::filesystem::remove(path);
+}
+// 0 — none, 1 — интервал 1 с, 2 — always
+BENCHMARK(BM_AsyncAppenderAppend)->Arg(0)->Arg(1)->Arg(2);
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
@@ -0,0 +1,146 @@
+#include <arpa/inet.h>
+#include <benchmark/benchmark.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <thread>
+
+#include "app/hub.h"
+#include "net/server_socket.h"
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+using namespace messenger;
+
+namespace {
+
+constexpr std::uint16_t HUB_BENCH_PORT = 55557;
+
+// Резидентная память процесса в байтах (/proc/self/statm)
+[[nodiscard]]
+auto residentBytes() -> double {
+    std::ifstream statm("/proc/self/statm");
+    std::size_t total_pages{};
+    std::size_t resident_pages{};
+    statm >> total_pages >> resident_pages;
+    return static_cast<double>(resident_pages) *
+           static_cast<double>(::sysconf(_SC_PAGESIZE));
+}
+
+void raiseDescriptorLimit() {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+// Дочерний процесс с клиентскими концами соединений: так хабу достаётся
+// весь RLIMIT_NOFILE, а не половина. Сообщает в channel_fd байт 1, когда
+// все peers подключены (0 — при ошибке), и держит соединения, пока
+// родитель не закроет свой конец. Только async-signal-safe вызовы: в
+// родителе уже запущен поток хаба
+[[noreturn]]
+void holdClients(std::size_t peers, int channel_fd) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(HUB_BENCH_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    // Сброс вместо FIN при выходе: тысячи эфемерных портов не остаются в
+    // TIME_WAIT и не мешают bind() следующих тестов
+    const linger reset{1, 0};
+
+    char status = 1;
+    for (std::size_t index = 0; index < peers; ++index) {
+        const int sock = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (sock < 0) {
+            status = 0;
+            break;
+        }
+        static_cast<void>(
+            ::setsockopt(sock, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset)));
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-cstyle-cast)
+        if (::connect(sock, (sockaddr*)&addr, sizeof(addr)) != 0) {
+            status = 0;
+            break;
+        }
+    }
+    static_cast<void>(::write(channel_fd, &status, 1));
+
+    char byte = 0;
+    static_cast<void>(::read(channel_fd, &byte, 1));
+    ::_exit(0);
+}
+
+}  // namespace
+
+// Хаб с N простаивающими участниками: время подключения всех и
+// пользовательская память хаба на одно соединение.
+// Клиентские концы живут в дочернем процессе, поэтому N ограничено
+// RLIMIT_NOFILE хаба, а не его половиной.
+void BM_HubIdleConnections(benchmark::State& state) {
+    raiseDescriptorLimit();
+    const auto peers = static_cast<std::size_t>(state.range(0));
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        app::Hub hub(net::create_listen_socket(HUB_BENCH_PORT, SOMAXCONN),
+                     false);
+        std::thread hub_thread([&hub] { hub.run(); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        const double rss_before = residentBytes();
+        state.ResumeTiming();
+
+        std::array<int, 2> channel{-1, -1};
+        const pid_t child =
+            ::socketpair(AF_UNIX, SOCK_STREAM, 0, channel.data()) == 0
+                ? ::fork()
+                : -1;
+        if (child == 0) {
+            ::close(channel[0]);
+            holdClients(peers, channel[1]);
+        }
+        if (child > 0) {
+            ::close(channel[1]);
+        }
+
+        char status = 0;
+        if (child < 0 || ::read(channel[0], &status, 1) != 1 ||
+            status != 1) {
+            state.SkipWithError("клиенты не подключились: мало дескрипторов");
+        } else {
+            while (hub.peer_count() < peers) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        state.PauseTiming();
+        const double rss_after = residentBytes();
+        state.counters["peers"] = static_cast<double>(hub.peer_count());
+        state.counters["rss_bytes_per_peer"] =
+            (rss_after - rss_before) / static_cast<double>(peers);
+        if (child > 0) {
+            ::close(channel[0]);
+            static_cast<void>(::waitpid(child, nullptr, 0));
+        }
+        hub.stop();
+        hub_thread.join();
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(BM_HubIdleConnections)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Iterations(1)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
@@ -0,0 +1,51 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdint>
+
+#include "utils/metrics.h"
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+using namespace messenger;
+
+namespace {
+
+// Общий для всех потоков счётчик — одна кэш-линия на всех
+std::atomic<std::uint64_t> shared_counter{0};
+
+utils::Counter sharded_counter;
+utils::Histogram latency_histogram;
+
+}  // namespace
+
+// До: один atomic, линия кочует между ядрами при каждом приращении
+void BM_SharedAtomicAdd(benchmark::State& state) {
+    for (auto _ : state) {
+        shared_counter.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+BENCHMARK(BM_SharedAtomicAdd)->ThreadRange(1, 8)->UseRealTime();
+
+// После: Counter с шардом на поток
+void BM_ShardedCounterAdd(benchmark::State& state) {
+    for (auto _ : state) {
+        sharded_counter.add();
+    }
+    if (state.thread_index() == 0) {
+        benchmark::DoNotOptimize(sharded_counter.value());
+    }
+}
+BENCHMARK(BM_ShardedCounterAdd)->ThreadRange(1, 8)->UseRealTime();
+
+// Замер задержки в Histogram: мьютекс своего шарда и запись в корзину
+void BM_HistogramRecord(benchmark::State& state) {
+    std::uint64_t value = 1;
+    for (auto _ : state) {
+        latency_histogram.record(value);
+        value = value * 7 % 100003;
+    }
+}
+BENCHMARK(BM_HistogramRecord)->ThreadRange(1, 4)->UseRealTime();
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
@@ -0,0 +1,91 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "app/outbox.h"
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+using namespace messenger;
+
+namespace {
+
+// Типичное сообщение чата
+const std::string MESSAGE_TEXT(120, 'x');
+
+// Прежние таблицы p2p_chat: ожидание Ack с копией текста и вектор
+// недоставленных сообщений с ещё одной копией
+struct LegacyPendingAck {
+    std::uint32_t id{};
+    int retry_count{};
+    std::string last_payload;
+};
+
+struct LegacyOutgoingMessage {
+    std::uint32_t message_id{};
+    std::string payload;
+    bool delivered{};
+};
+
+}  // namespace
+
+// До: отправка кладёт две копии текста, Ack ищет запись перебором
+// вектора, вектор обрезается erase(begin())
+void BM_LegacyOutboxSendAck(benchmark::State& state) {
+    const auto in_flight = static_cast<std::uint32_t>(state.range(0));
+    std::unordered_map<std::uint32_t, LegacyPendingAck> pending_acks;
+    std::vector<LegacyOutgoingMessage> undelivered;
+
+    const auto send = [&](std::uint32_t msg_id) {
+        pending_acks[msg_id] = LegacyPendingAck{msg_id, 0, MESSAGE_TEXT};
+        undelivered.push_back(LegacyOutgoingMessage{msg_id, MESSAGE_TEXT});
+        if (undelivered.size() > in_flight) {
+            undelivered.erase(undelivered.begin());
+        }
+    };
+    std::uint32_t next_id = 1;
+    for (; next_id <= in_flight; ++next_id) {
+        send(next_id);
+    }
+
+    // Ack самого старого сообщения и отправка нового
+    std::uint32_t oldest = 1;
+    for (auto _ : state) {
+        auto ack_it = pending_acks.find(oldest);
+        for (auto& outgoing : undelivered) {
+            if (outgoing.message_id == oldest) {
+                outgoing.delivered = true;
+                break;
+            }
+        }
+        pending_acks.erase(ack_it);
+        ++oldest;
+        send(next_id++);
+    }
+}
+BENCHMARK(BM_LegacyOutboxSendAck)->Arg(100)->Arg(1000)->Arg(10000);
+
+// После: одна запись на сообщение, Ack — O(1) по id
+void BM_OutboxSendAck(benchmark::State& state) {
+    const auto in_flight = static_cast<std::uint32_t>(state.range(0));
+    app::Outbox outbox(in_flight);
+
+    std::uint32_t next_id = 1;
+    for (; next_id <= in_flight; ++next_id) {
+        static_cast<void>(outbox.add(next_id, MESSAGE_TEXT));
+    }
+
+    std::uint32_t oldest = 1;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(outbox.find(oldest));
+        outbox.erase(oldest++);
+        static_cast<void>(outbox.add(next_id++, MESSAGE_TEXT));
+    }
+}
+BENCHMARK(BM_OutboxSendAck)->Arg(100)->Arg(1000)->Arg(10000);
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
@@ -0,0 +1,153 @@
+#include <benchmark/benchmark.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "app/dedup_window.h"
+#include "net/net_api.h"
+#include "protocol/message.hpp"
+#include "protocol/serializer.h"
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+using namespace messenger;
+
+namespace {
+
+// Размеры полезной нагрузки: от пустого кадра до MaxPayloadSize
+void payloadSizes(benchmark::internal::Benchmark* bench) {
+    bench->ArgName("bytes")->Arg(0);
+    for (std::int64_t size = 64;
+         size < static_cast<std::int64_t>(net::MaxPayloadSize::value);
+         size *= 16) {
+        bench->Arg(size);
+    }
+    bench->Arg(static_cast<std::int64_t>(net::MaxPayloadSize::value));
+}
+
+[[nodiscard]]
+auto textFrame(std::int64_t size) -> std::vector<std::uint8_t> {
+    return proto::serialize(proto::Message{
+        proto::MsgType::Text, 1, std::string(static_cast<std::size_t>(size),
+                                             'x')});
+}
+
+void reportBytes(benchmark::State& state) {
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                            state.range(0));
+}
+
+}  // namespace
+
+// Message -> кадр: заголовок и копия payload в новый вектор
+void BM_SerializeText(benchmark::State& state) {
+    const proto::Message msg{
+        proto::MsgType::Text, 1,
+        std::string(static_cast<std::size_t>(state.range(0)), 'x')};
+
+    for (auto _ : state) {
+        const auto bytes = proto::serialize(msg);
+        benchmark::DoNotOptimize(bytes.data());
+    }
+
+    reportBytes(state);
+}
+BENCHMARK(BM_SerializeText)->Apply(payloadSizes);
+
+// Кадр -> Message: payload копируется в строку сообщения
+void BM_DeserializeText(benchmark::State& state) {
+    const auto frame = textFrame(state.range(0));
+    proto::Message msg{};
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(proto::deserialize(frame, msg));
+    }
+
+    reportBytes(state);
+}
+BENCHMARK(BM_DeserializeText)->Apply(payloadSizes);
+
+// Кадр -> MessageView: без копии payload
+void BM_DeserializeTextView(benchmark::State& state) {
+    const auto frame = textFrame(state.range(0));
+    proto::ReceiveArena arena;
+    proto::MessageView msg{};
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(proto::deserialize(frame, msg, arena));
+    }
+
+    reportBytes(state);
+}
+BENCHMARK(BM_DeserializeTextView)->Apply(payloadSizes);
+
+// send_bytes -> recv_bytes через socketpair. Принимающая сторона — в
+// отдельном потоке: кадр крупнее буфера сокета иначе не отправить
+void BM_SendRecvBytes(benchmark::State& state) {
+    std::array<int, 2> sock_pair{-1, -1};
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sock_pair.data()) < 0) {
+        state.SkipWithError("socketpair");
+        return;
+    }
+    const auto frame = textFrame(state.range(0));
+
+    std::thread receiver([fd = sock_pair[0]] {
+        std::vector<std::uint8_t> received;
+        while (net::recv_bytes(fd, received) && !received.empty()) {
+        }
+    });
+
+    for (auto _ : state) {
+        if (!net::send_bytes(sock_pair[1], frame)) {
+            state.SkipWithError("send_bytes");
+            break;
+        }
+    }
+
+    ::shutdown(sock_pair[1], SHUT_WR);
+    receiver.join();
+    ::close(sock_pair[0]);
+    ::close(sock_pair[1]);
+
+    reportBytes(state);
+}
+BENCHMARK(BM_SendRecvBytes)->Apply(payloadSizes)->UseRealTime();
+
+// Дедупликация входящих Text: новые id вперемешку с повторами
+void BM_DedupCheckAndInsert(benchmark::State& state) {
+    app::DedupWindow window;
+    std::uint32_t next_id = 4;
+    std::uint32_t frame = 0;
+
+    for (auto _ : state) {
+        // Каждый восьмой кадр — повтор недавнего (ретрай после потери Ack)
+        const std::uint32_t msg_id =
+            (++frame % 8 == 0) ? next_id - 3 : next_id++;
+        benchmark::DoNotOptimize(window.check_and_insert(msg_id));
+    }
+}
+BENCHMARK(BM_DedupCheckAndInsert);
+
+// Поиск в заполненном окне без изменения
+void BM_DedupContains(benchmark::State& state) {
+    app::DedupWindow window;
+    const auto window_size = static_cast<std::uint32_t>(window.window_size());
+    for (std::uint32_t msg_id = 1; msg_id <= window_size; msg_id += 2) {
+        (void)window.check_and_insert(msg_id);
+    }
+    std::uint32_t msg_id = 1;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(window.contains(msg_id));
+        msg_id = msg_id % window_size + 1;
+    }
+}
+BENCHMARK(BM_DedupContains);
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
@@ -0,0 +1,189 @@
+#include <benchmark/benchmark.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "app/send_window.h"
+#include "app/session.h"
+#include "net/connection.h"
+#include "net/frame_reader.h"
+#include "net/raii_socket.h"
+#include "protocol/message.hpp"
+#include "protocol/protocol_api.h"
+#include "protocol/sack.h"
+#include "protocol/serializer.h"
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+using namespace messenger;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Типичное сообщение чата
+const std::string MESSAGE_TEXT(120, 'x');
+
+// Сообщений за одну итерацию замера
+constexpr std::uint32_t MESSAGES_PER_RUN = 4096U;
+
+// Получатель подтверждает пачкой, как p2p_chat: не реже чем через столько
+// сообщений и сразу, как только входящие кончились
+constexpr int ACK_EVERY_MESSAGES = 16;
+
+void waitReadable(int socket_fd) {
+    pollfd readable{socket_fd, POLLIN, 0};
+    ::poll(&readable, 1, -1);
+}
+
+// Получатель: принимает Text и отвечает Sack с окном 256 сообщений
+void runReceiver(net::Connection& conn, std::uint32_t total) {
+    app::SessionState session(1);
+    net::FrameReader& reader = conn.reader();
+    std::uint32_t received = 0;
+    int unacked = 0;
+
+    const auto acknowledge = [&] {
+        proto::SackBlocks blocks = session.sack_blocks();
+        blocks.window = 256U;
+        benchmark::DoNotOptimize(
+            proto::send_sack(conn, *session.last_received(), blocks));
+        unacked = 0;
+    };
+
+    while (received < total) {
+        waitReadable(conn.fd());
+        if (reader.fill(conn.fd()) != net::FrameReader::ReadStatus::Ok) {
+            return;
+        }
+        std::span<const std::uint8_t> frame;
+        while (reader.next_frame(frame) ==
+               net::FrameReader::FrameStatus::Ready) {
+            proto::Message msg{};
+            if (!proto::deserialize(frame, msg) ||
+                msg.type != proto::MsgType::Text) {
+                continue;
+            }
+            if (session.accept(msg.id)) {
+                ++received;
+            }
+            if (++unacked >= ACK_EVERY_MESSAGES) {
+                acknowledge();
+            }
+        }
+        if (unacked != 0) {
+            acknowledge();
+        }
+    }
+}
+
+[[nodiscard]]
+auto percentileUsec(std::vector<double>& samples, double fraction)
+    -> double {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    const auto index = static_cast<std::size_t>(
+        fraction * static_cast<double>(samples.size() - 1));
+    std::nth_element(samples.begin(),
+                     samples.begin() + static_cast<std::ptrdiff_t>(index),
+                     samples.end());
+    return samples[index];
+}
+
+}  // namespace
+
+// Пачка сообщений через socketpair с окном отправки заданного размера:
+// goodput (байт текста в секунду) и задержка от отправки до Sack.
+// Окно 1 — прежний stop-and-wait, большее окно держит канал заполненным
+void BM_SendWindowGoodput(benchmark::State& state) {
+    const auto window = static_cast<std::uint32_t>(state.range(0));
+    std::vector<double> latency_usec;
+    latency_usec.reserve(MESSAGES_PER_RUN);
+    std::uint64_t delivered_bytes = 0;
+
+    for (auto _ : state) {
+        std::array<int, 2> sock_pair{-1, -1};
+        ::socketpair(AF_UNIX, SOCK_STREAM, 0, sock_pair.data());
+        net::Connection sender{net::Socket(sock_pair[0])};
+        net::Connection receiver{net::Socket(sock_pair[1])};
+        std::thread receiver_thread(
+            [&receiver] { runReceiver(receiver, MESSAGES_PER_RUN); });
+
+        // Постоянное окно: cwnd сразу на пределе, рост не мешает замеру
+        app::SendWindow send_window(
+            app::SendWindow::Options{window, window, window});
+        std::vector<Clock::time_point> sent_at(MESSAGES_PER_RUN + 1);
+        net::FrameReader& reader = sender.reader();
+        std::uint32_t next_id = 1;
+        std::uint32_t acked_up_to = 0;
+
+        while (acked_up_to < MESSAGES_PER_RUN) {
+            while (next_id <= MESSAGES_PER_RUN && send_window.can_send()) {
+                sent_at[next_id] = Clock::now();
+                benchmark::DoNotOptimize(
+                    proto::send_text(sender, MESSAGE_TEXT, next_id));
+                send_window.on_send();
+                ++next_id;
+            }
+
+            waitReadable(sender.fd());
+            if (reader.fill(sender.fd()) !=
+                net::FrameReader::ReadStatus::Ok) {
+                break;
+            }
+            std::span<const std::uint8_t> frame;
+            while (reader.next_frame(frame) ==
+                   net::FrameReader::FrameStatus::Ready) {
+                proto::Message msg{};
+                if (!proto::deserialize(frame, msg) ||
+                    msg.type != proto::MsgType::Sack) {
+                    continue;
+                }
+                const auto blocks = proto::decode_sack(msg.payload);
+                const auto now = Clock::now();
+                // Поток не теряет и не переставляет кадры: хватает границы
+                const std::uint32_t newly_acked =
+                    msg.id > acked_up_to ? msg.id - acked_up_to : 0U;
+                for (; acked_up_to < msg.id; ++acked_up_to) {
+                    latency_usec.push_back(
+                        std::chrono::duration<double, std::micro>(
+                            now - sent_at[acked_up_to + 1])
+                            .count());
+                }
+                send_window.on_ack(newly_acked);
+                if (blocks) {
+                    send_window.on_peer_window(blocks->window);
+                }
+            }
+        }
+
+        receiver_thread.join();
+        delivered_bytes +=
+            std::uint64_t{MESSAGES_PER_RUN} * MESSAGE_TEXT.size();
+    }
+
+    state.SetBytesProcessed(static_cast<std::int64_t>(delivered_bytes));
+    state.SetItemsProcessed(static_cast<std::int64_t>(
+        state.iterations() * MESSAGES_PER_RUN));
+    state.counters["p50_usec"] = percentileUsec(latency_usec, 0.50);
+    state.counters["p99_usec"] = percentileUsec(latency_usec, 0.99);
+}
+BENCHMARK(BM_SendWindowGoodput)
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(64)
+    ->Arg(256)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
@@ -0,0 +1,131 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "net/timer_wheel.h"
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+using namespace messenger;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Таймаут ожидания Ack в чате
+constexpr auto ACK_TIMEOUT = std::chrono::seconds(5);
+
+// Шаг виртуального времени между пробуждениями цикла
+constexpr auto WAKEUP_STEP = std::chrono::milliseconds(10);
+
+// Дедлайн i-го сообщения: равномерно по окну таймаута, так что на каждое
+// пробуждение истекает примерно outstanding / 500 таймеров
+[[nodiscard]]
+auto spreadDeadline(Clock::time_point start, std::int64_t index,
+                    std::int64_t outstanding) -> Clock::time_point {
+    return start + ACK_TIMEOUT * index / outstanding;
+}
+
+struct ScannedAck {
+    Clock::time_point deadline;
+};
+
+}  // namespace
+
+// До: каждое пробуждение проходит всю pending_acks — поиск истёкших
+// (с вектором remove_ids) и ближайшего дедлайна для таймера
+void BM_ScanPendingAcks(benchmark::State& state) {
+    const std::int64_t outstanding = state.range(0);
+    const Clock::time_point start = Clock::now();
+
+    std::unordered_map<std::uint32_t, ScannedAck> pending;
+    for (std::int64_t index = 0; index < outstanding; ++index) {
+        pending[static_cast<std::uint32_t>(index)] =
+            ScannedAck{spreadDeadline(start, index, outstanding)};
+    }
+
+    Clock::time_point now = start;
+    std::uint64_t expired_total = 0;
+    for (auto _ : state) {
+        now += WAKEUP_STEP;
+
+        std::vector<std::uint32_t> remove_ids;
+        for (auto& [msg_id, ack] : pending) {
+            if (now >= ack.deadline) {
+                remove_ids.push_back(msg_id);
+            }
+        }
+        // Ретрай: истёкший Ack снова ждёт полный таймаут
+        for (const std::uint32_t msg_id : remove_ids) {
+            pending[msg_id].deadline = now + ACK_TIMEOUT;
+        }
+        expired_total += remove_ids.size();
+
+        Clock::time_point next = Clock::time_point::max();
+        for (const auto& [msg_id, ack] : pending) {
+            next = std::min(next, ack.deadline);
+        }
+        benchmark::DoNotOptimize(next);
+    }
+
+    state.counters["expired_per_wakeup"] =
+        static_cast<double>(expired_total) /
+        static_cast<double>(state.iterations());
+}
+BENCHMARK(BM_ScanPendingAcks)->Arg(1000)->Arg(10000)->Arg(100000);
+
+// После: колесо таймеров — работа пропорциональна числу истёкших
+void BM_TimerWheelExpire(benchmark::State& state) {
+    const std::int64_t outstanding = state.range(0);
+    const Clock::time_point start = Clock::now();
+
+    net::TimerWheel wheel(net::TimerWheel::DEFAULT_TICK, start);
+    for (std::int64_t index = 0; index < outstanding; ++index) {
+        static_cast<void>(
+            wheel.schedule(spreadDeadline(start, index, outstanding),
+                           static_cast<std::uint64_t>(index)));
+    }
+
+    Clock::time_point now = start;
+    std::uint64_t expired_total = 0;
+    for (auto _ : state) {
+        now += WAKEUP_STEP;
+
+        const auto& expired = wheel.expire(now);
+        for (const std::uint64_t key : expired) {
+            static_cast<void>(wheel.schedule(now + ACK_TIMEOUT, key));
+        }
+        expired_total += expired.size();
+
+        benchmark::DoNotOptimize(wheel.next_deadline());
+    }
+
+    state.counters["expired_per_wakeup"] =
+        static_cast<double>(expired_total) /
+        static_cast<double>(state.iterations());
+}
+BENCHMARK(BM_TimerWheelExpire)->Arg(1000)->Arg(10000)->Arg(100000);
+
+// Типичный путь сообщения: постановка таймера и отмена по приходу Ack
+// при 100k ожидающих
+void BM_TimerWheelScheduleCancel(benchmark::State& state) {
+    const Clock::time_point start = Clock::now();
+    net::TimerWheel wheel(net::TimerWheel::DEFAULT_TICK, start);
+    for (std::uint64_t index = 0; index < 100000; ++index) {
+        static_cast<void>(wheel.schedule(start + ACK_TIMEOUT, index));
+    }
+
+    std::uint64_t key = 100000;
+    for (auto _ : state) {
+        const auto timer_id = wheel.schedule(start + ACK_TIMEOUT, key++);
+        benchmark::DoNotOptimize(wheel.cancel(timer_id));
+    }
+}
+BENCHMARK(BM_TimerWheelScheduleCancel);
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
@@ -0,0 +1,52 @@
+#include "app/ack_retry.h"
+
+#include <string>
+
+#include "app/outbox.h"
+
+namespace messenger::app {
+
+[[nodiscard]]
+auto ack_timeout_action(const Outbox::Entry& entry, int max_retries)
+    -> AckTimeoutAction {
+    if (entry.retransmit_deferred) {
+        return AckTimeoutAction::WaitDeferred;
+    }
+    if (entry.retry_count < max_retries - 1) {
+        return AckTimeoutAction::Retransmit;
+    }
+    if (!entry.ping_for_ack_requested) {
+        return AckTimeoutAction::RequestPing;
+    }
+    if (entry.retry_count == max_retries - 1) {
+        return AckTimeoutAction::FinalRetransmit;
+    }
+    return AckTimeoutAction::GiveUp;
+}
+
+[[nodiscard]]
+auto counts_as_loss(AckTimeoutAction action) -> bool {
+    switch (action) {
+        case AckTimeoutAction::Retransmit:
+        case AckTimeoutAction::FinalRetransmit:
+        case AckTimeoutAction::WaitDeferred:
+            return true;
+        case AckTimeoutAction::RequestPing:
+        case AckTimeoutAction::GiveUp:
+            return false;
+    }
+    return false;
+}
+
+[[nodiscard]]
+auto retransmit_notice(const Outbox::Entry& entry, int max_retries)
+    -> std::string {
+    const std::string msg_id = std::to_string(entry.id);
+    if (entry.retry_count >= max_retries) {
+        return "[Последняя попытка отправки msg_id=" + msg_id + "]";
+    }
+    return "[Повторная отправка msg_id=" + msg_id + ", попытка " +
+           std::to_string(entry.retry_count) + "]";
+}
+
+}  // namespace messenger::app
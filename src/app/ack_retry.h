@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+
+#include "app/outbox.h"
+
+namespace messenger::app {
+
+// Повторы Text по таймауту Ack.
+//
+// Сначала max_retries - 1 обычных повторов, затем проверка связи
+// Ping/Pong и последний повтор; если Ack нет и после него — сообщение не
+// доставлено. Таймаут повтора — признак потери (RTO удваивается, окно
+// отправки сужается) и тогда, когда повтор не принят переполненной
+// очередью отправки и ждёт готовности сокета: иначе перегруженный канал
+// получал бы повторы чаще, а не реже.
+enum class AckTimeoutAction {
+    Retransmit,       // обычный повтор
+    RequestPing,      // проверка связи перед последним повтором
+    FinalRetransmit,  // последний повтор
+    WaitDeferred,     // прошлый повтор ещё ждёт места в очереди отправки
+    GiveUp            // повторы исчерпаны, Ack так и не пришёл
+};
+
+// Что делать по сработавшему таймеру Ack записи
+[[nodiscard]]
+auto ack_timeout_action(const Outbox::Entry& entry, int max_retries)
+    -> AckTimeoutAction;
+
+// Считается ли таймаут потерей
+[[nodiscard]]
+auto counts_as_loss(AckTimeoutAction action) -> bool;
+
+// Строка о повторе, ушедшем в сеть (retry_count уже увеличен)
+[[nodiscard]]
+auto retransmit_notice(const Outbox::Entry& entry, int max_retries)
+    -> std::string;
+
+}  // namespace messenger::app
@@ -0,0 +1,104 @@
+#include "app/dedup_window.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace messenger::app {
+
+namespace {
+
+constexpr std::size_t WORD_BITS = 64U;
+
+}  // namespace
+
+DedupWindow::DedupWindow(std::size_t window_size)
+    : window_size_(std::bit_ceil(std::max(window_size, WORD_BITS))),
+      bits_(window_size_ / WORD_BITS, 0) {}
+
+[[nodiscard]]
+auto DedupWindow::check_and_insert(std::uint32_t msg_id) -> bool {
+    if (empty_) {
+        restartAt(msg_id);
+        return true;
+    }
+
+    // Расстояние по модулю 2^32: положительное — id впереди наибольшего
+    const std::uint32_t ahead = msg_id - highest_;
+    if (ahead != 0 && ahead < (std::uint32_t{1} << 31U)) {
+        if (ahead >= window_size_) {
+            std::fill(bits_.begin(), bits_.end(), 0);
+        } else {
+            // Освободить биты id, которые окно проходит при сдвиге
+            for (std::uint32_t step = 1; step < ahead; ++step) {
+                clearBit(highest_ + step);
+            }
+        }
+        highest_ = msg_id;
+        setBit(msg_id);
+        return true;
+    }
+
+    const std::uint32_t behind = highest_ - msg_id;
+    if (behind >= window_size_) {
+        restartAt(msg_id);  // собеседник начал счёт заново
+        return true;
+    }
+
+    if (testBit(msg_id)) {
+        return false;
+    }
+    setBit(msg_id);
+    return true;
+}
+
+[[nodiscard]]
+auto DedupWindow::contains(std::uint32_t msg_id) const -> bool {
+    if (empty_) {
+        return false;
+    }
+    const std::uint32_t behind = highest_ - msg_id;
+    return behind < window_size_ && testBit(msg_id);
+}
+
+void DedupWindow::reset() {
+    std::fill(bits_.begin(), bits_.end(), 0);
+    highest_ = 0;
+    empty_ = true;
+}
+
+[[nodiscard]]
+auto DedupWindow::highest() const -> std::uint32_t {
+    return empty_ ? 0 : highest_;
+}
+
+[[nodiscard]]
+auto DedupWindow::window_size() const -> std::size_t {
+    return window_size_;
+}
+
+[[nodiscard]]
+auto DedupWindow::testBit(std::uint32_t msg_id) const -> bool {
+    const std::size_t bit = msg_id & (window_size_ - 1U);
+    return ((bits_[bit / WORD_BITS] >> (bit % WORD_BITS)) & 1U) != 0;
+}
+
+void DedupWindow::setBit(std::uint32_t msg_id) {
+    const std::size_t bit = msg_id & (window_size_ - 1U);
+    bits_[bit / WORD_BITS] |= std::uint64_t{1} << (bit % WORD_BITS);
+}
+
+void DedupWindow::clearBit(std::uint32_t msg_id) {
+    const std::size_t bit = msg_id & (window_size_ - 1U);
+    bits_[bit / WORD_BITS] &= ~(std::uint64_t{1} << (bit % WORD_BITS));
+}
+
+void DedupWindow::restartAt(std::uint32_t msg_id) {
+    std::fill(bits_.begin(), bits_.end(), 0);
+    highest_ = msg_id;
+    empty_ = false;
+    setBit(msg_id);
+}
+
+}  // namespace messenger::app
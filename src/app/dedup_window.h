@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace messenger::app {
+
+// Скользящее окно дедупликации входящих msg_id (как anti-replay в IPsec).
+//
+// Помнит наибольший принятый id и битовую карту последних window_size()
+// id перед ним. Проверка и запоминание — O(1) без хеширования и без
+// аллокаций: карта выделяется один раз в конструкторе. Сравнение id идёт
+// по арифметике последовательных номеров (RFC 1982), поэтому переход
+// счётчика через 2^32 не ломает окно.
+//
+// id, отстающий от наибольшего больше чем на размер окна, считается
+// признаком перезапуска собеседника (счётчик начат заново): окно
+// сбрасывается и начинается с этого id. Повторы одного кадра приходят
+// в пределах нескольких ретраев, то есть далеко внутри окна.
+class DedupWindow {
+public:
+    // Размер окна по умолчанию, id
+    static constexpr std::size_t DEFAULT_WINDOW_SIZE = 4096U;
+
+    // window_size округляется вверх до степени двойки, не меньше 64
+    explicit DedupWindow(std::size_t window_size = DEFAULT_WINDOW_SIZE);
+
+    // Проверить id и запомнить его. true — id новый, false — дубликат
+    [[nodiscard]]
+    auto check_and_insert(std::uint32_t msg_id) -> bool;
+
+    // Был ли id уже принят (без изменения окна)
+    [[nodiscard]]
+    auto contains(std::uint32_t msg_id) const -> bool;
+
+    // Забыть все принятые id
+    void reset();
+
+    // Наибольший принятый id (0 — окно пусто)
+    [[nodiscard]]
+    auto highest() const -> std::uint32_t;
+
+    [[nodiscard]]
+    auto window_size() const -> std::size_t;
+
+private:
+    [[nodiscard]]
+    auto testBit(std::uint32_t msg_id) const -> bool;
+    void setBit(std::uint32_t msg_id);
+    void clearBit(std::uint32_t msg_id);
+    void restartAt(std::uint32_t msg_id);
+
+    std::size_t window_size_;
+    // Кольцевая битовая карта: бит id — (id mod window_size_)
+    std::vector<std::uint64_t> bits_;
+    std::uint32_t highest_{0};
+    bool empty_{true};
+};
+
+}  // namespace messenger::app
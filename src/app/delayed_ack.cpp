@@ -0,0 +1,51 @@
+#include "app/delayed_ack.h"
+
+#include <cstdint>
+#include <optional>
+
+#include "net/connection.h"
+
+namespace messenger::app {
+
+[[nodiscard]]
+auto DelayedAck::on_received(Clock::time_point now) -> bool {
+    if (++unacked_ >= EVERY_MESSAGES) {
+        return true;
+    }
+    if (!deadline_) {
+        deadline_ = now + DELAY;
+    }
+    return false;
+}
+
+void DelayedAck::request_update(Clock::time_point now) {
+    if (unacked_ == 0) {
+        unacked_ = 1;
+    }
+    if (!deadline_) {
+        deadline_ = now + DELAY;
+    }
+}
+
+[[nodiscard]]
+auto DelayedAck::pending() const -> bool {
+    return unacked_ != 0;
+}
+
+[[nodiscard]]
+auto DelayedAck::deadline() const -> std::optional<Clock::time_point> {
+    return deadline_;
+}
+
+void DelayedAck::reset() {
+    unacked_ = 0;
+    deadline_.reset();
+}
+
+[[nodiscard]]
+auto DelayedAck::receive_window(const net::Connection& conn)
+    -> std::uint32_t {
+    return conn.outbound().above_high_watermark() ? 0U : RECEIVE_WINDOW;
+}
+
+}  // namespace messenger::app
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+#include "net/connection.h"
+
+namespace messenger::app {
+
+// Отложенное подтверждение принятых Text кадром Sack.
+//
+// Sack уходит через DELAY после первого неподтверждённого сообщения,
+// сразу — после EVERY_MESSAGES сообщений или попутно с ближайшим
+// исходящим Text, и закрывает все принятые с прошлого Sack сообщения
+// одним кадром. Таймер срока ведёт вызывающий по deadline(). Общее для
+// чата и нагрузочного прогона (режим «бенч»).
+class DelayedAck {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr auto DELAY = std::chrono::milliseconds(20);
+    static constexpr int EVERY_MESSAGES = 16;
+
+    // Окно получателя, объявляемое собеседнику в Sack: столько его
+    // сообщений может быть в полёте
+    static constexpr std::uint32_t RECEIVE_WINDOW = 256U;
+
+    // Принят Text. true — Sack пора отправить, не дожидаясь срока
+    [[nodiscard]]
+    auto on_received(Clock::time_point now) -> bool;
+
+    // Канал разгрузился: собеседнику, остановленному нулевым окном, нужен
+    // Sack с открытым окном, даже если новых сообщений от него не было
+    void request_update(Clock::time_point now);
+
+    // Есть что подтвердить
+    [[nodiscard]]
+    auto pending() const -> bool;
+
+    // Срок отложенного Sack; std::nullopt — подтверждать нечего
+    [[nodiscard]]
+    auto deadline() const -> std::optional<Clock::time_point>;
+
+    // Sack отправлен (или его заменит граница в приветствии)
+    void reset();
+
+    // Окно получателя для Sack: перегруженный канал (очередь отправки
+    // выше верхней отметки) просит собеседника остановиться
+    [[nodiscard]]
+    static auto receive_window(const net::Connection& conn) -> std::uint32_t;
+
+private:
+    int unacked_{0};
+    std::optional<Clock::time_point> deadline_;
+};
+
+}  // namespace messenger::app
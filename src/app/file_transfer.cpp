@@ -0,0 +1,297 @@
+#include "app/file_transfer.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include "protocol/file_frames.h"
+#include "utils/file_io.h"
+#include "utils/p2p_error.h"
+
+namespace messenger::app {
+
+namespace {
+
+[[nodiscard]]
+auto fileStat(int file_fd) -> struct stat {
+    struct stat file_stat {};
+    if (::fstat(file_fd, &file_stat) < 0) {
+        utils::throw_system_error("fstat");
+    }
+    return file_stat;
+}
+
+// Время изменения файла, нс от эпохи
+[[nodiscard]]
+auto modifiedNs(const struct stat& file_stat) -> std::uint64_t {
+    constexpr std::uint64_t NS_PER_SECOND = 1000000000U;
+    return static_cast<std::uint64_t>(file_stat.st_mtim.tv_sec) *
+               NS_PER_SECOND +
+           static_cast<std::uint64_t>(file_stat.st_mtim.tv_nsec);
+}
+
+[[nodiscard]]
+auto bytesPerSecond(std::uint64_t bytes, std::chrono::steady_clock::duration
+                                             elapsed) -> double {
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds > 0.0 ? static_cast<double>(bytes) / seconds : 0.0;
+}
+
+}  // namespace
+
+OutgoingFile::OutgoingFile(std::uint32_t transfer_id, const std::string& path)
+    : id_(transfer_id),
+      name_(std::filesystem::path(path).filename().string()) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        utils::throw_system_error("open");
+    }
+    const struct stat file_stat = fileStat(fd_);
+    if (!S_ISREG(file_stat.st_mode) ||
+        !proto::decode_file_offer(proto::encode_file_offer({0, name_}))) {
+        ::close(fd_);
+        throw std::runtime_error(path + ": не обычный файл");
+    }
+    size_ = static_cast<std::uint64_t>(file_stat.st_size);
+    modified_ns_ = modifiedNs(file_stat);
+}
+
+OutgoingFile::~OutgoingFile() {
+    ::close(fd_);
+}
+
+[[nodiscard]]
+auto OutgoingFile::offer() const -> proto::FileOffer {
+    return proto::FileOffer{size_, name_, modified_ns_};
+}
+
+void OutgoingFile::on_ack(std::uint64_t offset) {
+    offset = std::min(offset, size_);
+    if (!accepted_) {
+        accepted_ = true;
+        acked_ = offset;
+        sent_ = offset;
+        resumed_at_ = Clock::now();
+        resumed_from_ = offset;
+        return;
+    }
+    acked_ = std::max(acked_, offset);
+    sent_ = std::max(sent_, acked_);
+}
+
+[[nodiscard]]
+auto OutgoingFile::next_chunk(std::uint64_t window) const -> std::size_t {
+    const std::uint64_t in_flight = sent_ - acked_;
+    if (!accepted_ || sent_ >= size_ || in_flight >= window) {
+        return 0;
+    }
+    return static_cast<std::size_t>(
+        std::min({std::uint64_t{proto::FILE_CHUNK_SIZE}, size_ - sent_,
+                  window - in_flight}));
+}
+
+void OutgoingFile::on_chunk_sent(std::size_t length) {
+    sent_ += length;
+}
+
+void OutgoingFile::suspend() {
+    accepted_ = false;
+    sent_ = acked_;
+}
+
+[[nodiscard]]
+auto OutgoingFile::source_changed() const -> bool {
+    struct stat file_stat {};
+    if (::fstat(fd_, &file_stat) < 0) {
+        return true;
+    }
+    return static_cast<std::uint64_t>(file_stat.st_size) != size_ ||
+           modifiedNs(file_stat) != modified_ns_;
+}
+
+[[nodiscard]]
+auto OutgoingFile::accepted() const -> bool {
+    return accepted_;
+}
+
+[[nodiscard]]
+auto OutgoingFile::complete() const -> bool {
+    return accepted_ && acked_ == size_;
+}
+
+[[nodiscard]]
+auto OutgoingFile::id() const -> std::uint32_t {
+    return id_;
+}
+
+[[nodiscard]]
+auto OutgoingFile::name() const -> const std::string& {
+    return name_;
+}
+
+[[nodiscard]]
+auto OutgoingFile::size() const -> std::uint64_t {
+    return size_;
+}
+
+[[nodiscard]]
+auto OutgoingFile::acked() const -> std::uint64_t {
+    return acked_;
+}
+
+[[nodiscard]]
+auto OutgoingFile::sent() const -> std::uint64_t {
+    return sent_;
+}
+
+[[nodiscard]]
+auto OutgoingFile::fd() const -> int {
+    return fd_;
+}
+
+[[nodiscard]]
+auto OutgoingFile::throughput(Clock::time_point now) const -> double {
+    return bytesPerSecond(acked_ - resumed_from_, now - resumed_at_);
+}
+
+IncomingFile::IncomingFile(const std::string& dir,
+                           const proto::FileOffer& offer)
+    : dir_(dir),
+      name_(offer.name),
+      part_path_(dir + "/" + offer.name + std::string(PART_SUFFIX)),
+      offer_path_(part_path_ + std::string(OFFER_SUFFIX)),
+      size_(offer.size),
+      modified_ns_(offer.modified_ns),
+      resumed_at_(Clock::now()) {
+    std::filesystem::create_directories(dir_);
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    fd_ = ::open(part_path_.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC,
+                 utils::FILE_MODE);
+    if (fd_ < 0) {
+        utils::throw_system_error("open");
+    }
+
+    // Продолжение: всё, что уже лежит в .part, повторно не передаётся.
+    // .part другой версии файла (или без записанного предложения) и .part
+    // длиннее файла — остаток чужой передачи, она начинается заново.
+    // Предложение записывается на диск раньше первого куска передачи
+    try {
+        const std::string encoded = proto::encode_file_offer(offer);
+        const bool same_source = utils::read_file(offer_path_) == encoded;
+        received_ = static_cast<std::uint64_t>(fileStat(fd_).st_size);
+        if (!same_source || received_ > size_) {
+            received_ = 0;
+            if (::ftruncate(fd_, 0) < 0) {
+                utils::throw_system_error("ftruncate");
+            }
+        }
+        if (!same_source) {
+            utils::replace_file_synced(offer_path_, encoded);
+        }
+    } catch (...) {
+        ::close(fd_);
+        throw;
+    }
+    acked_ = received_;
+    resumed_from_ = received_;
+}
+
+IncomingFile::~IncomingFile() {
+    ::close(fd_);
+}
+
+[[nodiscard]]
+auto IncomingFile::write(std::uint64_t offset,
+                         std::span<const std::uint8_t> data) -> bool {
+    if (offset > received_ || data.size() > size_ - offset) {
+        return false;
+    }
+    // Начало куска уже записано до обрыва связи
+    data = data.subspan(static_cast<std::size_t>(
+        std::min<std::uint64_t>(received_ - offset, data.size())));
+
+    while (!data.empty()) {
+        const ssize_t written =
+            ::pwrite(fd_, data.data(), data.size(),
+                     static_cast<off_t>(received_));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            utils::throw_system_error("pwrite");
+        }
+        received_ += static_cast<std::uint64_t>(written);
+        data = data.subspan(static_cast<std::size_t>(written));
+    }
+    return true;
+}
+
+[[nodiscard]]
+auto IncomingFile::ack_due(std::uint64_t interval) const -> bool {
+    return received_ - acked_ >= interval || (complete() && acked_ != size_);
+}
+
+void IncomingFile::on_ack_sent() {
+    acked_ = received_;
+}
+
+auto IncomingFile::finish() -> std::string {
+    if (::fdatasync(fd_) < 0) {
+        utils::throw_system_error("fdatasync");
+    }
+
+    std::string path = dir_ + "/" + name_;
+    for (int copy = 1; std::filesystem::exists(path); ++copy) {
+        path = dir_ + "/" + name_ + "." + std::to_string(copy);
+    }
+    std::filesystem::rename(part_path_, path);
+    std::error_code error;
+    std::filesystem::remove(offer_path_, error);
+    return path;
+}
+
+[[nodiscard]]
+auto IncomingFile::matches(const proto::FileOffer& offer) const -> bool {
+    return offer.name == name_ && offer.size == size_ &&
+           offer.modified_ns == modified_ns_;
+}
+
+[[nodiscard]]
+auto IncomingFile::complete() const -> bool {
+    return received_ == size_;
+}
+
+[[nodiscard]]
+auto IncomingFile::received() const -> std::uint64_t {
+    return received_;
+}
+
+[[nodiscard]]
+auto IncomingFile::size() const -> std::uint64_t {
+    return size_;
+}
+
+[[nodiscard]]
+auto IncomingFile::name() const -> const std::string& {
+    return name_;
+}
+
+[[nodiscard]]
+auto IncomingFile::throughput(Clock::time_point now) const -> double {
+    return bytesPerSecond(received_ - resumed_from_, now - resumed_at_);
+}
+
+}  // namespace messenger::app
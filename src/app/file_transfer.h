@@ -0,0 +1,176 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "protocol/file_frames.h"
+
+namespace messenger::app {
+
+// Исходящая передача файла (команда /файл).
+//
+// Файл не читается в память: куски уходят в сокет через sendfile() прямо
+// из page cache (proto::send_file_chunk). Отправитель держит в полёте не
+// больше окна байт сверх подтверждённых. Первое подтверждение — ответ на
+// FileOffer — задаёт, с какого места слать: после обрыва связи передача
+// продолжается с последнего записанного получателем куска. Файл, изменённый
+// или укороченный после предложения, дальше не отправляется
+// (source_changed()).
+class OutgoingFile {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Открыть файл для отправки. При системной ошибке или если путь — не
+    // обычный файл, бросает исключение
+    OutgoingFile(std::uint32_t transfer_id, const std::string& path);
+    ~OutgoingFile();
+
+    OutgoingFile(const OutgoingFile&) = delete;
+    OutgoingFile& operator=(const OutgoingFile&) = delete;
+    OutgoingFile(OutgoingFile&&) = delete;
+    OutgoingFile& operator=(OutgoingFile&&) = delete;
+
+    [[nodiscard]]
+    auto offer() const -> proto::FileOffer;
+
+    // Получатель записал все байты до offset. Первое подтверждение после
+    // FileOffer переносит на offset и точку отправки
+    void on_ack(std::uint64_t offset);
+
+    // Длина следующего куска с sent(): не больше FILE_CHUNK_SIZE и не
+    // больше остатка окна; 0 — слать нечего или окно заполнено
+    [[nodiscard]]
+    auto next_chunk(std::uint64_t window) const -> std::size_t;
+
+    void on_chunk_sent(std::size_t length);
+
+    // Связь потеряна: отправка стоит до ответа на новый FileOffer
+    void suspend();
+
+    // Размер или время изменения файла уже не те, что в offer(): куски
+    // разошлись бы с обещанным содержимым, передачу нужно прервать
+    [[nodiscard]]
+    auto source_changed() const -> bool;
+
+    // Получатель ответил на FileOffer — можно слать куски
+    [[nodiscard]]
+    auto accepted() const -> bool;
+    // Получатель подтвердил весь файл
+    [[nodiscard]]
+    auto complete() const -> bool;
+
+    [[nodiscard]]
+    auto id() const -> std::uint32_t;
+    [[nodiscard]]
+    auto name() const -> const std::string&;
+    [[nodiscard]]
+    auto size() const -> std::uint64_t;
+    [[nodiscard]]
+    auto acked() const -> std::uint64_t;
+    [[nodiscard]]
+    auto sent() const -> std::uint64_t;
+    [[nodiscard]]
+    auto fd() const -> int;
+
+    // Скорость по подтверждённым в этом сеансе передачи байтам, байт/с
+    [[nodiscard]]
+    auto throughput(Clock::time_point now) const -> double;
+
+private:
+    std::uint32_t id_;
+    std::string name_;
+    int fd_{-1};
+    std::uint64_t size_{0};
+    std::uint64_t modified_ns_{0};
+    std::uint64_t acked_{0};
+    std::uint64_t sent_{0};
+    bool accepted_{false};
+    // Начало отсчёта скорости: момент и смещение первого подтверждения
+    Clock::time_point resumed_at_{};
+    std::uint64_t resumed_from_{0};
+};
+
+// Входящая передача файла.
+//
+// Куски пишутся pwrite() прямо из буфера приёма кадров в <каталог>/<имя>
+// .part, без сборки файла в памяти. Передача продолжается с размера
+// уже существующего .part — так переживается и обрыв связи, и
+// перезапуск любой из сторон. Рядом, в .part.offer, хранится FileOffer,
+// по которому начат .part: предложение другой версии файла (размер или
+// время изменения не совпали) начинает приём заново. Когда приняты все
+// байты, .part синхронизируется на диск и переименовывается в итоговое
+// имя.
+class IncomingFile {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Открыть (создать) .part в каталоге dir (создаётся при отсутствии).
+    // При системной ошибке бросает исключение
+    IncomingFile(const std::string& dir, const proto::FileOffer& offer);
+    ~IncomingFile();
+
+    IncomingFile(const IncomingFile&) = delete;
+    IncomingFile& operator=(const IncomingFile&) = delete;
+    IncomingFile(IncomingFile&&) = delete;
+    IncomingFile& operator=(IncomingFile&&) = delete;
+
+    // Записать кусок с offset. Уже записанная часть (повтор после
+    // обрыва) пропускается. false — кусок за дырой или за концом файла.
+    // При системной ошибке бросает исключение
+    [[nodiscard]]
+    auto write(std::uint64_t offset, std::span<const std::uint8_t> data)
+        -> bool;
+
+    // Пора подтвердить: с прошлого подтверждения записано не меньше
+    // interval байт или файл принят целиком
+    [[nodiscard]]
+    auto ack_due(std::uint64_t interval) const -> bool;
+    void on_ack_sent();
+
+    // Все байты приняты: .part на диск и в итоговое имя (при занятом
+    // имени добавляется номер). Возвращает путь принятого файла
+    auto finish() -> std::string;
+
+    // Та же передача (после обрыва связи): совпадают имя, размер и время
+    // изменения
+    [[nodiscard]]
+    auto matches(const proto::FileOffer& offer) const -> bool;
+
+    [[nodiscard]]
+    auto complete() const -> bool;
+    [[nodiscard]]
+    auto received() const -> std::uint64_t;
+    [[nodiscard]]
+    auto size() const -> std::uint64_t;
+    [[nodiscard]]
+    auto name() const -> const std::string&;
+
+    // Скорость приёма в этом сеансе передачи, байт/с
+    [[nodiscard]]
+    auto throughput(Clock::time_point now) const -> double;
+
+    // Суффикс незаконченного файла
+    static constexpr std::string_view PART_SUFFIX = ".part";
+    // Суффикс (после PART_SUFFIX) файла с предложением, по которому
+    // начат .part
+    static constexpr std::string_view OFFER_SUFFIX = ".offer";
+
+private:
+    std::string dir_;
+    std::string name_;
+    std::string part_path_;
+    std::string offer_path_;
+    int fd_{-1};
+    std::uint64_t size_{0};
+    std::uint64_t modified_ns_{0};
+    std::uint64_t received_{0};
+    std::uint64_t acked_{0};
+    Clock::time_point resumed_at_;
+    std::uint64_t resumed_from_{0};
+};
+
+}  // namespace messenger::app
@@ -0,0 +1,734 @@
+#include "app/history_index.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "app/history_store.h"
+#include "utils/file_io.h"
+#include "utils/p2p_error.h"
+
+namespace messenger::app {
+
+namespace {
+
+constexpr std::size_t MAGIC_SIZE = 8U;
+constexpr std::string_view MANIFEST_MAGIC = "MSGRFTS1";
+constexpr std::string_view SEGMENT_MAGIC = "MSGRSEG1";
+
+// Сегмент: заголовок [magic][число слов u32][0 u32][первая запись u64]
+// [конец записей u64], таблица слов [хеш u64][начало списка u32][длина u32],
+// отсортированная по хешу, затем списки номеров записей u32
+constexpr std::size_t SEGMENT_HEADER_SIZE = 32U;
+constexpr std::size_t TERM_SIZE = 16U;
+
+// Манифест: [magic][проиндексировано u64][следующий номер файла u64]
+// [число сегментов u64], затем на сегмент [номер файла u64][уровень u64]
+constexpr std::size_t MANIFEST_HEADER_SIZE = 32U;
+constexpr std::size_t MANIFEST_SEGMENT_SIZE = 16U;
+
+// FNV-1a, 64 бита
+constexpr std::uint64_t FNV_OFFSET = 14695981039346656037ULL;
+constexpr std::uint64_t FNV_PRIME = 1099511628211ULL;
+
+// Символ UTF-8, который не удалось разобрать
+constexpr std::uint32_t INVALID_CODE_POINT = 0xFFFFFFFFU;
+
+[[nodiscard]]
+auto hashWord(std::string_view word) -> std::uint64_t {
+    std::uint64_t hash = FNV_OFFSET;
+    for (const char byte : word) {
+        hash ^= static_cast<unsigned char>(byte);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+template <typename T>
+void put(std::string& buffer, T value) {
+    std::array<char, sizeof(T)> bytes{};
+    std::memcpy(bytes.data(), &value, sizeof(T));
+    buffer.append(bytes.data(), bytes.size());
+}
+
+template <typename T>
+[[nodiscard]]
+auto get(const char* data) -> T {
+    T value{};
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+// Разбор одного символа UTF-8 с позиции pos (pos сдвигается за него)
+[[nodiscard]]
+auto decodeUtf8(std::string_view text, std::size_t& pos) -> std::uint32_t {
+    const auto lead = static_cast<unsigned char>(text[pos]);
+    std::size_t length = 0;
+    std::uint32_t code_point = 0;
+    if (lead < 0x80U) {
+        ++pos;
+        return lead;
+    }
+    if (lead >= 0xC2U && lead <= 0xDFU) {
+        length = 2;
+        code_point = lead & 0x1FU;
+    } else if (lead >= 0xE0U && lead <= 0xEFU) {
+        length = 3;
+        code_point = lead & 0x0FU;
+    } else if (lead >= 0xF0U && lead <= 0xF4U) {
+        length = 4;
+        code_point = lead & 0x07U;
+    } else {
+        ++pos;
+        return INVALID_CODE_POINT;
+    }
+
+    if (pos + length > text.size()) {
+        ++pos;
+        return INVALID_CODE_POINT;
+    }
+    for (std::size_t index = 1; index < length; ++index) {
+        const auto byte = static_cast<unsigned char>(text[pos + index]);
+        if ((byte & 0xC0U) != 0x80U) {
+            ++pos;
+            return INVALID_CODE_POINT;
+        }
+        code_point = (code_point << 6U) | (byte & 0x3FU);
+    }
+    pos += length;
+    return code_point;
+}
+
+void encodeUtf8(std::uint32_t code_point, std::string& out) {
+    if (code_point < 0x80U) {
+        out.push_back(static_cast<char>(code_point));
+    } else if (code_point < 0x800U) {
+        out.push_back(static_cast<char>(0xC0U | (code_point >> 6U)));
+        out.push_back(static_cast<char>(0x80U | (code_point & 0x3FU)));
+    } else if (code_point < 0x10000U) {
+        out.push_back(static_cast<char>(0xE0U | (code_point >> 12U)));
+        out.push_back(static_cast<char>(0x80U | ((code_point >> 6U) & 0x3FU)));
+        out.push_back(static_cast<char>(0x80U | (code_point & 0x3FU)));
+    } else {
+        out.push_back(static_cast<char>(0xF0U | (code_point >> 18U)));
+        out.push_back(
+            static_cast<char>(0x80U | ((code_point >> 12U) & 0x3FU)));
+        out.push_back(static_cast<char>(0x80U | ((code_point >> 6U) & 0x3FU)));
+        out.push_back(static_cast<char>(0x80U | (code_point & 0x3FU)));
+    }
+}
+
+// Буквы и цифры: ASCII, а из остального — всё, кроме знаков Latin-1,
+// блоков пунктуации и символов, CJK-пунктуации и эмодзи
+[[nodiscard]]
+auto isWordChar(std::uint32_t code_point) -> bool {
+    if (code_point < 0x80U) {
+        return (code_point >= '0' && code_point <= '9') ||
+               (code_point >= 'a' && code_point <= 'z') ||
+               (code_point >= 'A' && code_point <= 'Z');
+    }
+    if (code_point == INVALID_CODE_POINT || code_point < 0xC0U ||
+        code_point == 0xD7U || code_point == 0xF7U) {
+        return false;
+    }
+    if ((code_point >= 0x2000U && code_point <= 0x2BFFU) ||
+        (code_point >= 0x3000U && code_point <= 0x303FU) ||
+        (code_point >= 0xFE00U && code_point <= 0xFE0FU) ||
+        code_point >= 0x1F000U) {
+        return false;
+    }
+    return true;
+}
+
+// Нижний регистр для латиницы (с Latin-1) и кириллицы
+[[nodiscard]]
+auto toLower(std::uint32_t code_point) -> std::uint32_t {
+    if ((code_point >= 'A' && code_point <= 'Z') ||
+        (code_point >= 0xC0U && code_point <= 0xDEU) ||  // À..Þ
+        (code_point >= 0x410U && code_point <= 0x42FU)) {  // А..Я
+        return code_point + 0x20U;
+    }
+    if (code_point >= 0x400U && code_point <= 0x40FU) {  // Ѐ..Џ, Ё
+        return code_point + 0x50U;
+    }
+    return code_point;
+}
+
+}  // namespace
+
+HistoryIndex::HistoryIndex(const std::string& base_path, HistoryStore& store)
+    : HistoryIndex(base_path, store, Options{}) {}
+
+HistoryIndex::HistoryIndex(const std::string& base_path, HistoryStore& store,
+                           Options options)
+    : manifest_path_(base_path + ".fts"), store_(store), options_(options) {
+    options_.flush_entries = std::max<std::size_t>(options_.flush_entries, 1U);
+    options_.merge_fanout = std::max<std::size_t>(options_.merge_fanout, 2U);
+
+    loadManifest();
+    disk_segments_ = segments_;
+    writer_ = std::thread([this] { run(); });
+
+    try {
+        catchUp();
+    } catch (...) {
+        stopWriter();
+        throw;
+    }
+}
+
+HistoryIndex::~HistoryIndex() {
+    // Замороженные сегменты дописываются; текущий сегмент в памяти не
+    // сохраняется: при следующем запуске он дочитывается из истории
+    stopWriter();
+}
+
+void HistoryIndex::add(std::string_view text) {
+    if (failed_.load(std::memory_order_acquire)) {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        throw std::runtime_error(error_);
+    }
+    adoptPublished();
+
+    const auto entry = static_cast<std::uint32_t>(indexed_entries_);
+    for (const auto& word : tokenize(text)) {
+        auto& postings = memory_[hashWord(word)];
+        if (postings.empty() || postings.back() != entry) {
+            postings.push_back(entry);
+        }
+    }
+
+    ++indexed_entries_;
+    if (indexed_entries_ - memory_first_ >= options_.flush_entries) {
+        freezeMemory();
+    }
+}
+
+void HistoryIndex::flush() {
+    std::uint64_t processed = processed_.load(std::memory_order_acquire);
+    while (processed < submitted_) {
+        processed_.wait(processed, std::memory_order_acquire);
+        processed = processed_.load(std::memory_order_acquire);
+    }
+    adoptPublished();
+}
+
+[[nodiscard]]
+auto HistoryIndex::search(std::string_view query, std::size_t limit)
+    -> std::vector<std::size_t> {
+    std::vector<std::string> words = tokenize(query);
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    std::vector<std::size_t> found;
+    if (words.empty() || limit == 0) {
+        return found;
+    }
+
+    std::vector<std::uint64_t> hashes;
+    hashes.reserve(words.size());
+    for (const auto& word : words) {
+        hashes.push_back(hashWord(word));
+    }
+
+    // Источники от новых записей к старым: сегмент в памяти,
+    // замороженные сегменты, затем сегменты на диске с конца
+    adoptPublished();
+    collectMemory(memory_, hashes, words, limit, found);
+    for (auto frozen = frozen_.rbegin();
+         frozen != frozen_.rend() && found.size() < limit; ++frozen) {
+        collectMemory((*frozen)->terms, hashes, words, limit, found);
+    }
+
+    std::vector<Postings> lists;
+    lists.reserve(hashes.size());
+    for (auto segment = segments_.rbegin();
+         segment != segments_.rend() && found.size() < limit; ++segment) {
+        lists.clear();
+        for (const std::uint64_t hash : hashes) {
+            const Postings postings = lookup(*segment, hash);
+            if (postings.empty()) {
+                break;
+            }
+            lists.push_back(postings);
+        }
+        if (lists.size() == hashes.size()) {
+            collect(lists, words, limit, found);
+        }
+    }
+    return found;
+}
+
+[[nodiscard]]
+auto HistoryIndex::indexed_entries() const -> std::size_t {
+    return static_cast<std::size_t>(indexed_entries_);
+}
+
+[[nodiscard]]
+auto HistoryIndex::segment_count() const -> std::size_t {
+    return segments_.size();
+}
+
+[[nodiscard]]
+auto HistoryIndex::tokenize(std::string_view text)
+    -> std::vector<std::string> {
+    std::vector<std::string> words;
+    std::string word;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        const std::uint32_t code_point = decodeUtf8(text, pos);
+        if (isWordChar(code_point)) {
+            encodeUtf8(toLower(code_point), word);
+        } else if (!word.empty()) {
+            words.push_back(std::move(word));
+            word.clear();
+        }
+    }
+    if (!word.empty()) {
+        words.push_back(std::move(word));
+    }
+    return words;
+}
+
+// Манифест отсутствует или повреждён — индекс строится заново
+void HistoryIndex::loadManifest() {
+    const std::optional<std::string> file = utils::read_file(manifest_path_);
+    if (!file) {
+        return;
+    }
+    const std::string& contents = *file;
+
+    if (contents.size() < MANIFEST_HEADER_SIZE ||
+        std::string_view(contents).substr(0, MAGIC_SIZE) != MANIFEST_MAGIC) {
+        return;
+    }
+    const char* data = contents.data();
+    const auto indexed = get<std::uint64_t>(data + MAGIC_SIZE);
+    const auto next_sequence = get<std::uint64_t>(data + 16);
+    const auto count = get<std::uint64_t>(data + 24);
+    if (contents.size() !=
+            MANIFEST_HEADER_SIZE + count * MANIFEST_SEGMENT_SIZE ||
+        indexed > store_.size()) {
+        return;
+    }
+
+    std::uint64_t expected_first = 0;
+    for (std::uint64_t index = 0; index < count; ++index) {
+        const char* record =
+            data + MANIFEST_HEADER_SIZE + index * MANIFEST_SEGMENT_SIZE;
+        Segment segment{};
+        segment.sequence = get<std::uint64_t>(record);
+        segment.level = static_cast<std::uint32_t>(
+            get<std::uint64_t>(record + sizeof(std::uint64_t)));
+        try {
+            openSegment(segment);
+        } catch (const std::exception&) {
+            segments_.clear();
+            return;
+        }
+        segments_.push_back(segment);
+        if (segment.first_entry != expected_first) {
+            segments_.clear();
+            return;
+        }
+        expected_first = segment.end_entry;
+    }
+    if (expected_first != indexed) {
+        segments_.clear();
+        return;
+    }
+
+    next_sequence_ = next_sequence;
+    indexed_entries_ = indexed;
+    memory_first_ = indexed;
+}
+
+void HistoryIndex::writeManifest() const {
+    std::string contents(MANIFEST_MAGIC);
+    put<std::uint64_t>(contents, disk_segments_.empty()
+                                     ? 0
+                                     : disk_segments_.back().end_entry);
+    put<std::uint64_t>(contents, next_sequence_);
+    put<std::uint64_t>(contents, disk_segments_.size());
+    for (const auto& segment : disk_segments_) {
+        put<std::uint64_t>(contents, segment.sequence);
+        put<std::uint64_t>(contents, segment.level);
+    }
+
+    // Манифест заменяется целиком: после сбоя виден старый или новый
+    utils::replace_file_synced(manifest_path_, contents);
+}
+
+// Дочитать записи истории, появившиеся после последнего сегмента
+void HistoryIndex::catchUp() {
+    const std::size_t total = store_.size();
+    for (std::size_t entry = indexed_entries(); entry < total; ++entry) {
+        add(store_.read(entry));
+    }
+}
+
+// Заморозить заполненный сегмент в памяти и отдать его потоку записи
+void HistoryIndex::freezeMemory() {
+    auto frozen = std::make_shared<FrozenSegment>();
+    frozen->first_entry = memory_first_;
+    frozen->end_entry = indexed_entries_;
+    frozen->terms = std::move(memory_);
+    memory_.clear();
+    memory_first_ = indexed_entries_;
+
+    frozen_.push_back(frozen);
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(std::move(frozen));
+    }
+    ++submitted_;
+    wake_.fetch_add(1, std::memory_order_release);
+    wake_.notify_one();
+}
+
+// Забрать сегменты, опубликованные потоком записи, и отпустить
+// замороженные сегменты, которые в них вошли
+void HistoryIndex::adoptPublished() {
+    if (!published_.load(std::memory_order_acquire)) {
+        return;
+    }
+    const std::lock_guard<std::mutex> lock(mutex_);
+    published_.store(false, std::memory_order_relaxed);
+    segments_ = std::move(published_segments_);
+    published_segments_.clear();
+
+    const std::uint64_t on_disk =
+        segments_.empty() ? 0 : segments_.back().end_entry;
+    while (!frozen_.empty() && frozen_.front()->end_entry <= on_disk) {
+        frozen_.pop_front();
+    }
+}
+
+// Поток записи дописывает уже поставленные сегменты и завершается
+void HistoryIndex::stopWriter() {
+    stop_requested_.store(true, std::memory_order_release);
+    wake_.fetch_add(1, std::memory_order_release);
+    wake_.notify_one();
+    writer_.join();
+}
+
+void HistoryIndex::run() {
+    while (true) {
+        // Счётчик читается до проверки очереди: постановка после проверки
+        // его изменит, и wait() не уснёт
+        const std::uint64_t wake = wake_.load(std::memory_order_acquire);
+        std::shared_ptr<const FrozenSegment> frozen;
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            if (!jobs_.empty()) {
+                frozen = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+        }
+
+        if (!frozen) {
+            if (stop_requested_.load(std::memory_order_acquire)) {
+                return;
+            }
+            wake_.wait(wake, std::memory_order_acquire);
+            continue;
+        }
+
+        // После ошибки сегменты не пишутся: индекс отключается, а при
+        // следующем запуске дочитывается из истории
+        if (!failed_.load(std::memory_order_relaxed)) {
+            try {
+                persist(*frozen);
+            } catch (const std::exception& error) {
+                const std::lock_guard<std::mutex> lock(mutex_);
+                error_ = error.what();
+                failed_.store(true, std::memory_order_release);
+            }
+        }
+        processed_.fetch_add(1, std::memory_order_release);
+        processed_.notify_all();
+    }
+}
+
+// Записать замороженный сегмент, слить хвост, заменить манифест и только
+// затем опубликовать новые сегменты потоку чата
+void HistoryIndex::persist(const FrozenSegment& frozen) {
+    Segment segment{};
+    segment.sequence = next_sequence_++;
+    segment.first_entry = frozen.first_entry;
+    segment.end_entry = frozen.end_entry;
+    writeSegment(segment, frozen.terms);
+    openSegment(segment);
+    disk_segments_.push_back(segment);
+
+    const std::vector<std::uint64_t> obsolete = mergeTail();
+    writeManifest();
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        published_segments_ = disk_segments_;
+        published_.store(true, std::memory_order_release);
+    }
+
+    // Поток чата мог ещё не забрать публикацию: удалённые файлы остаются
+    // отображёнными, пока живы их копии Segment
+    for (const std::uint64_t sequence : obsolete) {
+        std::remove(segmentPath(sequence).c_str());
+    }
+}
+
+[[nodiscard]]
+auto HistoryIndex::mergeTail() -> std::vector<std::uint64_t> {
+    std::vector<std::uint64_t> obsolete;
+    const std::size_t fanout = options_.merge_fanout;
+
+    while (disk_segments_.size() >= fanout) {
+        const auto tail =
+            disk_segments_.end() - static_cast<std::ptrdiff_t>(fanout);
+        const std::uint32_t level = tail->level;
+        if (!std::all_of(tail, disk_segments_.end(),
+                         [level](const Segment& s) {
+                             return s.level == level;
+                         })) {
+            break;
+        }
+
+        // Сегменты идут по возрастанию номеров записей, поэтому
+        // списки склеиваются, оставаясь отсортированными
+        TermMap terms;
+        for (auto segment = tail; segment != disk_segments_.end(); ++segment) {
+            const std::size_t postings_base =
+                SEGMENT_HEADER_SIZE + segment->term_count * TERM_SIZE;
+            for (std::uint32_t term = 0; term < segment->term_count; ++term) {
+                const char* record = segment->data.get() +
+                                     SEGMENT_HEADER_SIZE + term * TERM_SIZE;
+                const auto hash = get<std::uint64_t>(record);
+                const auto start = get<std::uint32_t>(record + 8);
+                const auto length = get<std::uint32_t>(record + 12);
+
+                auto& postings = terms[hash];
+                const std::size_t old_size = postings.size();
+                postings.resize(old_size + length);
+                std::memcpy(postings.data() + old_size,
+                            segment->data.get() + postings_base +
+                                std::size_t{start} * sizeof(std::uint32_t),
+                            std::size_t{length} * sizeof(std::uint32_t));
+            }
+        }
+
+        Segment merged{};
+        merged.sequence = next_sequence_++;
+        merged.level = level + 1;
+        merged.first_entry = tail->first_entry;
+        merged.end_entry = disk_segments_.back().end_entry;
+        writeSegment(merged, terms);
+        openSegment(merged);
+
+        for (auto segment = tail; segment != disk_segments_.end(); ++segment) {
+            obsolete.push_back(segment->sequence);
+        }
+        disk_segments_.erase(tail, disk_segments_.end());
+        disk_segments_.push_back(merged);
+    }
+    return obsolete;
+}
+
+void HistoryIndex::openSegment(Segment& segment) const {
+    const std::string path = segmentPath(segment.sequence);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    const int file_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file_fd < 0) {
+        utils::throw_system_error("open");
+    }
+    struct stat file_stat {};
+    if (::fstat(file_fd, &file_stat) < 0) {
+        ::close(file_fd);
+        utils::throw_system_error("fstat");
+    }
+    const auto size = static_cast<std::size_t>(file_stat.st_size);
+    if (size < SEGMENT_HEADER_SIZE) {
+        ::close(file_fd);
+        throw std::runtime_error(path + ": повреждённый сегмент индекса");
+    }
+
+    void* memory = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, file_fd, 0);
+    ::close(file_fd);
+    if (memory == MAP_FAILED) {
+        utils::throw_system_error("mmap");
+    }
+
+    const auto* data = static_cast<const char*>(memory);
+    const auto term_count = get<std::uint32_t>(data + MAGIC_SIZE);
+    if (std::string_view(data, MAGIC_SIZE) != SEGMENT_MAGIC ||
+        SEGMENT_HEADER_SIZE + std::size_t{term_count} * TERM_SIZE > size) {
+        ::munmap(memory, size);
+        throw std::runtime_error(path + ": повреждённый сегмент индекса");
+    }
+
+    segment.data = std::shared_ptr<const char>(
+        data, [size](const char* mapped) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+            ::munmap(const_cast<char*>(mapped), size);
+        });
+    segment.size = size;
+    segment.term_count = term_count;
+    segment.first_entry = get<std::uint64_t>(data + 16);
+    segment.end_entry = get<std::uint64_t>(data + 24);
+}
+
+void HistoryIndex::writeSegment(const Segment& segment,
+                                const TermMap& terms) const {
+    std::vector<std::uint64_t> hashes;
+    hashes.reserve(terms.size());
+    std::size_t total_postings = 0;
+    for (const auto& [hash, postings] : terms) {
+        hashes.push_back(hash);
+        total_postings += postings.size();
+    }
+    std::sort(hashes.begin(), hashes.end());
+
+    std::string contents(SEGMENT_MAGIC);
+    contents.reserve(SEGMENT_HEADER_SIZE + hashes.size() * TERM_SIZE +
+                     total_postings * sizeof(std::uint32_t));
+    put<std::uint32_t>(contents, static_cast<std::uint32_t>(hashes.size()));
+    put<std::uint32_t>(contents, 0);
+    put<std::uint64_t>(contents, segment.first_entry);
+    put<std::uint64_t>(contents, segment.end_entry);
+
+    std::uint32_t start = 0;
+    for (const std::uint64_t hash : hashes) {
+        const auto length =
+            static_cast<std::uint32_t>(terms.find(hash)->second.size());
+        put<std::uint64_t>(contents, hash);
+        put<std::uint32_t>(contents, start);
+        put<std::uint32_t>(contents, length);
+        start += length;
+    }
+    for (const std::uint64_t hash : hashes) {
+        const auto& postings = terms.find(hash)->second;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        contents.append(reinterpret_cast<const char*>(postings.data()),
+                        postings.size() * sizeof(std::uint32_t));
+    }
+
+    utils::write_file_synced(segmentPath(segment.sequence), contents);
+}
+
+[[nodiscard]]
+auto HistoryIndex::segmentPath(std::uint64_t sequence) const -> std::string {
+    return manifest_path_ + "." + std::to_string(sequence);
+}
+
+[[nodiscard]]
+auto HistoryIndex::lookup(const Segment& segment, std::uint64_t hash)
+    -> Postings {
+    const char* table = segment.data.get() + SEGMENT_HEADER_SIZE;
+
+    // Двоичный поиск по отсортированной таблице хешей
+    std::size_t low = 0;
+    std::size_t high = segment.term_count;
+    while (low < high) {
+        const std::size_t middle = low + (high - low) / 2;
+        if (get<std::uint64_t>(table + middle * TERM_SIZE) < hash) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low == segment.term_count ||
+        get<std::uint64_t>(table + low * TERM_SIZE) != hash) {
+        return {};
+    }
+
+    const char* record = table + low * TERM_SIZE;
+    const auto start = get<std::uint32_t>(record + 8);
+    const auto length = get<std::uint32_t>(record + 12);
+    const std::size_t postings_base =
+        SEGMENT_HEADER_SIZE + segment.term_count * TERM_SIZE;
+    if (postings_base + (std::size_t{start} + length) * sizeof(std::uint32_t) >
+        segment.size) {
+        return {};
+    }
+    // Списки выровнены на 4 байта: начало отображения выровнено на
+    // страницу, заголовок и таблица кратны 4
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    const auto* postings = reinterpret_cast<const std::uint32_t*>(
+        segment.data.get() + postings_base);
+    return Postings{postings + start, length};
+}
+
+[[nodiscard]]
+auto HistoryIndex::matches(std::size_t entry,
+                           const std::vector<std::string>& words) -> bool {
+    const std::vector<std::string> entry_words = tokenize(store_.read(entry));
+    return std::all_of(words.begin(), words.end(),
+                       [&entry_words](const std::string& word) {
+                           return std::find(entry_words.begin(),
+                                            entry_words.end(),
+                                            word) != entry_words.end();
+                       });
+}
+
+// Совпадения в сегменте в памяти (текущем или замороженном)
+void HistoryIndex::collectMemory(const TermMap& terms,
+                                 const std::vector<std::uint64_t>& hashes,
+                                 const std::vector<std::string>& words,
+                                 std::size_t limit,
+                                 std::vector<std::size_t>& found) {
+    if (found.size() >= limit) {
+        return;
+    }
+    std::vector<Postings> lists;
+    lists.reserve(hashes.size());
+    for (const std::uint64_t hash : hashes) {
+        const auto found_term = terms.find(hash);
+        if (found_term == terms.end()) {
+            return;
+        }
+        lists.emplace_back(found_term->second);
+    }
+    collect(lists, words, limit, found);
+}
+
+// Пересечение списков: обход самого короткого с конца и двоичный поиск
+// в остальных
+void HistoryIndex::collect(const std::vector<Postings>& lists,
+                           const std::vector<std::string>& words,
+                           std::size_t limit,
+                           std::vector<std::size_t>& found) {
+    const auto shortest = std::min_element(
+        lists.begin(), lists.end(),
+        [](Postings lhs, Postings rhs) { return lhs.size() < rhs.size(); });
+
+    for (auto entry = shortest->rbegin();
+         entry != shortest->rend() && found.size() < limit; ++entry) {
+        const bool in_all = std::all_of(
+            lists.begin(), lists.end(), [entry](Postings postings) {
+                return std::binary_search(postings.begin(), postings.end(),
+                                          *entry);
+            });
+        if (in_all && matches(*entry, words)) {
+            found.push_back(*entry);
+        }
+    }
+}
+
+}  // namespace messenger::app
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "app/history_store.h"
+
+namespace messenger::app {
+
+// Полнотекстовый индекс истории для /поиск.
+//
+// Обратный индекс: хеш слова → возрастающий список номеров записей
+// HistoryStore. Новые записи попадают в сегмент в памяти; заполненный
+// сегмент сбрасывается в неизменяемый файл <base>.fts.<N> (таблица
+// хешей, отсортированная для двоичного поиска, и списки номеров), который
+// затем читается через mmap. Сегменты одного уровня сливаются по
+// merge_fanout штук, так что их число растёт логарифмически. Манифест
+// <base>.fts (список сегментов и число проиндексированных записей)
+// заменяется атомарно через rename(), поэтому при запуске индекс не
+// строится заново: дочитываются только записи после последнего сегмента.
+//
+// Запись сегментов, слияние и замена манифеста выполняются фоновым
+// потоком записи: заполненный сегмент в памяти «замораживается» и
+// остаётся доступным поиску, пока его файл и новый манифест не будут
+// опубликованы. Поток чата на диск не ждёт.
+//
+// Слова — последовательности букв и цифр UTF-8 (латиница, кириллица и
+// прочие алфавиты) в нижнем регистре. Найденные по хешам записи
+// перепроверяются по тексту, так что коллизии хешей не дают ложных
+// совпадений.
+class HistoryIndex {
+public:
+    struct Options {
+        // Записей в сегменте в памяти до сброса на диск
+        std::size_t flush_entries{4096U};
+        // Сколько сегментов одного уровня сливаются в один
+        std::size_t merge_fanout{4U};
+    };
+
+    // Открывает индекс рядом с историей (<base_path>.fts), запускает поток
+    // записи и дочитывает записи store, которых в индексе ещё нет. При
+    // системной ошибке бросает исключение
+    HistoryIndex(const std::string& base_path, HistoryStore& store);
+    HistoryIndex(const std::string& base_path, HistoryStore& store,
+                 Options options);
+
+    // Дожидается записи замороженных сегментов и останавливает поток
+    ~HistoryIndex();
+
+    HistoryIndex(const HistoryIndex&) = delete;
+    HistoryIndex& operator=(const HistoryIndex&) = delete;
+    HistoryIndex(HistoryIndex&&) = delete;
+    HistoryIndex& operator=(HistoryIndex&&) = delete;
+
+    // Проиндексировать очередную запись истории: вызывается сразу после
+    // HistoryStore::append() с той же строкой. Не блокируется на диске;
+    // ошибку потока записи бросает исключением при следующем вызове
+    void add(std::string_view text);
+
+    // Дождаться, пока поток записи сохранит все замороженные сегменты.
+    // Блокирует вызывающего: для тестов и бенчмарков, не для цикла чата
+    void flush();
+
+    // Номера записей, содержащих все слова запроса, от новых к старым,
+    // не больше limit
+    [[nodiscard]]
+    auto search(std::string_view query, std::size_t limit)
+        -> std::vector<std::size_t>;
+
+    // Сколько записей истории проиндексировано
+    [[nodiscard]]
+    auto indexed_entries() const -> std::size_t;
+
+    // Сегментов на диске, опубликованных потоком записи
+    [[nodiscard]]
+    auto segment_count() const -> std::size_t;
+
+    // Слова текста в нижнем регистре, в порядке появления
+    [[nodiscard]]
+    static auto tokenize(std::string_view text) -> std::vector<std::string>;
+
+private:
+    using TermMap =
+        std::unordered_map<std::uint64_t, std::vector<std::uint32_t>>;
+
+    // Сегмент на диске, отображённый в память. Отображение общее у копий
+    // и снимается с последней из них: поток чата может искать в
+    // сегменте, который поток записи уже слил с соседними
+    struct Segment {
+        std::uint64_t sequence{};
+        std::uint32_t level{};
+        std::shared_ptr<const char> data;
+        std::size_t size{};
+        std::uint64_t first_entry{};
+        std::uint64_t end_entry{};
+        std::uint32_t term_count{};
+    };
+
+    // Заполненный сегмент в памяти, ожидающий записи на диск
+    struct FrozenSegment {
+        std::uint64_t first_entry{};
+        std::uint64_t end_entry{};
+        TermMap terms;
+    };
+
+    // Источник списков для поиска: сегмент на диске или в памяти
+    using Postings = std::span<const std::uint32_t>;
+
+    void loadManifest();
+    void writeManifest() const;
+    void catchUp();
+    void freezeMemory();
+    void adoptPublished();
+    void stopWriter();
+
+    // Поток записи
+    void run();
+    void persist(const FrozenSegment& frozen);
+    // Слить хвостовые сегменты одного уровня; возвращает номера файлов,
+    // которые можно удалить после записи манифеста
+    [[nodiscard]]
+    auto mergeTail() -> std::vector<std::uint64_t>;
+    void openSegment(Segment& segment) const;
+    void writeSegment(const Segment& segment, const TermMap& terms) const;
+
+    [[nodiscard]]
+    auto segmentPath(std::uint64_t sequence) const -> std::string;
+    [[nodiscard]]
+    static auto lookup(const Segment& segment, std::uint64_t hash)
+        -> Postings;
+    [[nodiscard]]
+    auto matches(std::size_t entry,
+                 const std::vector<std::string>& words) -> bool;
+    void collectMemory(const TermMap& terms,
+                       const std::vector<std::uint64_t>& hashes,
+                       const std::vector<std::string>& words,
+                       std::size_t limit, std::vector<std::size_t>& found);
+    void collect(const std::vector<Postings>& lists,
+                 const std::vector<std::string>& words, std::size_t limit,
+                 std::vector<std::size_t>& found);
+
+    std::string manifest_path_;
+    HistoryStore& store_;
+    Options options_;
+
+    // Состояние потока чата: опубликованные сегменты на диске,
+    // замороженные сегменты в порядке записей и сегмент в памяти —
+    // записи [memory_first_, indexed_entries_)
+    std::vector<Segment> segments_;
+    std::deque<std::shared_ptr<const FrozenSegment>> frozen_;
+    TermMap memory_;
+    std::uint64_t memory_first_{0};
+    std::uint64_t indexed_entries_{0};
+
+    // Состояние потока записи; до его запуска заполняется конструктором
+    std::vector<Segment> disk_segments_;
+    std::uint64_t next_sequence_{1};
+
+    // Передача между потоками: очередь сегментов на запись, сегменты,
+    // опубликованные после записи манифеста, и текст ошибки записи
+    std::mutex mutex_;
+    std::deque<std::shared_ptr<const FrozenSegment>> jobs_;
+    std::vector<Segment> published_segments_;
+    std::string error_;
+    std::atomic<bool> published_{false};
+    std::atomic<bool> failed_{false};
+
+    // Пробуждение потока записи и учёт обработанных сегментов, как в
+    // utils::AsyncAppender
+    std::atomic<std::uint64_t> wake_{0};
+    std::atomic<bool> stop_requested_{false};
+    std::uint64_t submitted_{0};
+    std::atomic<std::uint64_t> processed_{0};
+
+    std::thread writer_;
+};
+
+}  // namespace messenger::app
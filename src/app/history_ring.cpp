@@ -0,0 +1,120 @@
+#include "app/history_ring.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace messenger::app {
+
+HistoryRing::HistoryRing(std::size_t max_lines, std::size_t max_arena_bytes)
+    : max_arena_bytes_(std::max<std::size_t>(max_arena_bytes, 1U)),
+      arena_(std::min(INITIAL_ARENA_BYTES, max_arena_bytes_)),
+      entries_(std::max<std::size_t>(max_lines, 1U)) {}
+
+void HistoryRing::push(std::string_view line) {
+    line = line.substr(0, max_arena_bytes_);
+
+    // Пока арена не достигла предела, вместо вытеснения она растёт
+    if (arena_.size() < max_arena_bytes_ &&
+        used_bytes_ + line.size() > arena_.size() / 2) {
+        growArena(used_bytes_ + line.size());
+    }
+    const std::size_t arena_size = arena_.size();
+
+    // Строка должна лечь в арену непрерывно: не помещается до конца
+    // арены — начинается с её начала, хвост остаётся пустым
+    std::uint64_t offset = write_offset_;
+    if (offset % arena_size + line.size() > arena_size) {
+        offset += arena_size - offset % arena_size;
+    }
+
+    // Вытеснить старые строки, чьи байты перекрываются новой, и лишние
+    while (count_ != 0 &&
+           (count_ == entries_.size() ||
+            offset + line.size() - entries_[head_].offset > arena_size)) {
+        popOldest();
+    }
+
+    const auto physical = static_cast<std::size_t>(offset % arena_size);
+    std::copy(line.begin(), line.end(),
+              arena_.begin() + static_cast<std::ptrdiff_t>(physical));
+
+    entries_[(head_ + count_) % entries_.size()] = Entry{offset, line.size()};
+    ++count_;
+    used_bytes_ += line.size();
+    write_offset_ = offset + line.size();
+}
+
+[[nodiscard]]
+auto HistoryRing::operator[](std::size_t index) const -> std::string_view {
+    const Entry& entry = entries_[(head_ + index) % entries_.size()];
+    const auto physical =
+        static_cast<std::size_t>(entry.offset % arena_.size());
+    return std::string_view{arena_.data() + physical, entry.length};
+}
+
+[[nodiscard]]
+auto HistoryRing::size() const -> std::size_t {
+    return count_;
+}
+
+[[nodiscard]]
+auto HistoryRing::empty() const -> bool {
+    return count_ == 0;
+}
+
+[[nodiscard]]
+auto HistoryRing::max_lines() const -> std::size_t {
+    return entries_.size();
+}
+
+[[nodiscard]]
+auto HistoryRing::used_bytes() const -> std::size_t {
+    return used_bytes_;
+}
+
+[[nodiscard]]
+auto HistoryRing::memory_bytes() const -> std::size_t {
+    return arena_.capacity() + entries_.capacity() * sizeof(Entry);
+}
+
+void HistoryRing::clear() {
+    head_ = 0;
+    count_ = 0;
+    write_offset_ = 0;
+    used_bytes_ = 0;
+}
+
+void HistoryRing::growArena(std::size_t required) {
+    std::size_t new_size = arena_.size();
+    while (new_size < max_arena_bytes_ && new_size / 2 < required) {
+        new_size *= 2;
+    }
+    new_size = std::min(new_size, max_arena_bytes_);
+
+    // Живые строки переносятся в новую арену подряд, с нулевого смещения
+    std::vector<char> new_arena(new_size);
+    std::uint64_t offset = 0;
+    for (std::size_t index = 0; index < count_; ++index) {
+        Entry& entry = entries_[(head_ + index) % entries_.size()];
+        const std::string_view line = (*this)[index];
+        std::copy(line.begin(), line.end(),
+                  new_arena.begin() + static_cast<std::ptrdiff_t>(offset));
+        entry.offset = offset;
+        offset += entry.length;
+    }
+
+    arena_ = std::move(new_arena);
+    write_offset_ = offset;
+}
+
+void HistoryRing::popOldest() {
+    used_bytes_ -= entries_[head_].length;
+    head_ = (head_ + 1) % entries_.size();
+    --count_;
+}
+
+}  // namespace messenger::app
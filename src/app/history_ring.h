@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace messenger::app {
+
+// Кольцевая история сообщений в памяти.
+//
+// Байты строк лежат в одной непрерывной арене, а не в тысячах отдельных
+// std::string: добавление строки — одна запись в арену и в кольцо
+// описателей, без сдвига остальных строк. Арена растёт удвоением до
+// max_arena_bytes (после этого аллокаций нет), дальше при нехватке строк
+// или места вытесняются самые старые строки. Строка в арене всегда
+// непрерывна и выдаётся как string_view.
+class HistoryRing {
+public:
+    // Предел арены по умолчанию вмещает и самое длинное сообщение (1 МиБ)
+    static constexpr std::size_t DEFAULT_MAX_ARENA_BYTES = 4U * 1024U * 1024U;
+    // Начальный размер арены
+    static constexpr std::size_t INITIAL_ARENA_BYTES = 64U * 1024U;
+
+    explicit HistoryRing(std::size_t max_lines,
+                         std::size_t max_arena_bytes = DEFAULT_MAX_ARENA_BYTES);
+
+    // Добавить строку (длиннее предела арены — обрезается до него)
+    void push(std::string_view line);
+
+    // Строка по номеру: 0 — самая старая из хранимых.
+    // Действительна до следующего push()
+    [[nodiscard]]
+    auto operator[](std::size_t index) const -> std::string_view;
+
+    [[nodiscard]]
+    auto size() const -> std::size_t;
+
+    [[nodiscard]]
+    auto empty() const -> bool;
+
+    [[nodiscard]]
+    auto max_lines() const -> std::size_t;
+
+    // Байт строк в арене сейчас
+    [[nodiscard]]
+    auto used_bytes() const -> std::size_t;
+
+    // Вся память истории: арена и кольцо описателей
+    [[nodiscard]]
+    auto memory_bytes() const -> std::size_t;
+
+    void clear();
+
+private:
+    // Описатель строки: логическое смещение в арене (растёт монотонно,
+    // физическое — по модулю размера арены) и длина
+    struct Entry {
+        std::uint64_t offset{};
+        std::size_t length{};
+    };
+
+    void popOldest();
+    void growArena(std::size_t required);
+
+    std::size_t max_arena_bytes_;
+    std::vector<char> arena_;
+    std::vector<Entry> entries_;
+    std::size_t head_{0};   // индекс самой старой строки в entries_
+    std::size_t count_{0};
+    std::uint64_t write_offset_{0};
+    std::size_t used_bytes_{0};
+};
+
+}  // namespace messenger::app
@@ -0,0 +1,370 @@
+#include "app/history_store.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "utils/async_appender.h"
+#include "utils/file_io.h"
+#include "utils/p2p_error.h"
+
+namespace messenger::app {
+
+namespace {
+
+// Заголовки файлов журнала и индекса
+constexpr std::size_t MAGIC_SIZE = 8U;
+constexpr std::string_view LOG_MAGIC = "MSGRLOG1";
+constexpr std::string_view INDEX_MAGIC = "MSGRIDX1";
+
+constexpr std::size_t LENGTH_SIZE = sizeof(std::uint32_t);
+constexpr std::size_t OFFSET_SIZE = sizeof(std::uint64_t);
+
+// Столько недописанных записей копится в памяти, прежде чем append()
+// попробует отобразить уже дописанные и отбросить их копии
+constexpr std::size_t UNWRITTEN_REFRESH_ENTRIES = 256U;
+
+// Прочитать ровно size байт со смещения offset. false — файл короче
+[[nodiscard]]
+auto readExact(int file_fd, void* data, std::size_t size, std::uint64_t offset)
+    -> bool {
+    auto* bytes = static_cast<char*>(data);
+    std::size_t done = 0;
+    while (done < size) {
+        const ssize_t got = ::pread(file_fd, bytes + done, size - done,
+                                    static_cast<off_t>(offset + done));
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            utils::throw_system_error("pread");
+        }
+        if (got == 0) {
+            return false;
+        }
+        done += static_cast<std::size_t>(got);
+    }
+    return true;
+}
+
+void writeExact(int file_fd, const void* data, std::size_t size,
+                std::uint64_t offset) {
+    const auto* bytes = static_cast<const char*>(data);
+    std::size_t done = 0;
+    while (done < size) {
+        const ssize_t written = ::pwrite(file_fd, bytes + done, size - done,
+                                         static_cast<off_t>(offset + done));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            utils::throw_system_error("pwrite");
+        }
+        done += static_cast<std::size_t>(written);
+    }
+}
+
+void truncateFile(int file_fd, std::uint64_t size) {
+    if (::ftruncate(file_fd, static_cast<off_t>(size)) < 0) {
+        utils::throw_system_error("ftruncate");
+    }
+}
+
+[[nodiscard]]
+auto fileSize(int file_fd) -> std::uint64_t {
+    struct stat file_stat {};
+    if (::fstat(file_fd, &file_stat) < 0) {
+        utils::throw_system_error("fstat");
+    }
+    return static_cast<std::uint64_t>(file_stat.st_size);
+}
+
+// Открыть файл и проверить (у нового или оборванного при создании —
+// записать) заголовок. Возвращает дескриптор и размер файла
+[[nodiscard]]
+auto openWithMagic(const std::string& path, std::string_view magic,
+                   std::uint64_t& size) -> int {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    const int file_fd =
+        ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, utils::FILE_MODE);
+    if (file_fd < 0) {
+        utils::throw_system_error("open");
+    }
+
+    try {
+        size = fileSize(file_fd);
+        if (size < MAGIC_SIZE) {
+            truncateFile(file_fd, 0);
+            writeExact(file_fd, magic.data(), MAGIC_SIZE, 0);
+            size = MAGIC_SIZE;
+        } else {
+            std::array<char, MAGIC_SIZE> header{};
+            static_cast<void>(
+                readExact(file_fd, header.data(), header.size(), 0));
+            if (std::string_view(header.data(), header.size()) != magic) {
+                throw std::runtime_error(path + ": неизвестный формат файла");
+            }
+        }
+    } catch (...) {
+        ::close(file_fd);
+        throw;
+    }
+    return file_fd;
+}
+
+[[nodiscard]]
+auto mapFile(int file_fd, std::size_t size) -> const char* {
+    void* memory = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, file_fd, 0);
+    if (memory == MAP_FAILED) {
+        utils::throw_system_error("mmap");
+    }
+    return static_cast<const char*>(memory);
+}
+
+}  // namespace
+
+HistoryStore::HistoryStore(const std::string& base_path)
+    : HistoryStore(base_path, utils::AsyncAppender::Options{}) {}
+
+HistoryStore::HistoryStore(const std::string& base_path,
+                           utils::AsyncAppender::Options options)
+    : log_path_(base_path + ".log"), index_path_(base_path + ".idx") {
+    try {
+        recover();
+        opened_entries_ = entries_;
+        remap(entries_);
+        log_writer_ = std::make_unique<utils::AsyncAppender>(log_path_,
+                                                             options);
+        index_writer_ =
+            std::make_unique<utils::AsyncAppender>(index_path_, options);
+    } catch (...) {
+        unmap();
+        if (log_fd_ >= 0) {
+            ::close(log_fd_);
+        }
+        if (index_fd_ >= 0) {
+            ::close(index_fd_);
+        }
+        throw;
+    }
+}
+
+HistoryStore::~HistoryStore() {
+    // Дописать и зафиксировать очереди до закрытия файлов
+    log_writer_.reset();
+    index_writer_.reset();
+    unmap();
+    ::close(log_fd_);
+    ::close(index_fd_);
+}
+
+void HistoryStore::append(std::string_view line) {
+    const auto length = static_cast<std::uint32_t>(line.size());
+
+    std::string record(LENGTH_SIZE + line.size(), '\0');
+    std::memcpy(record.data(), &length, LENGTH_SIZE);
+    std::memcpy(record.data() + LENGTH_SIZE, line.data(), line.size());
+
+    std::string offset(OFFSET_SIZE, '\0');
+    std::memcpy(offset.data(), &log_size_, OFFSET_SIZE);
+
+    log_writer_->append(std::move(record));
+    index_writer_->append(std::move(offset));
+
+    log_size_ += LENGTH_SIZE + line.size();
+    ++entries_;
+    unwritten_.emplace_back(line);
+    if (unwritten_.size() >= UNWRITTEN_REFRESH_ENTRIES) {
+        refreshMapping();
+    }
+}
+
+[[nodiscard]]
+auto HistoryStore::size() const -> std::size_t {
+    return entries_;
+}
+
+[[nodiscard]]
+auto HistoryStore::read(std::size_t index) -> std::string_view {
+    if (index >= entries_) {
+        return {};
+    }
+    // Запись этого сеанса за пределами отображения: если фоновые потоки
+    // её уже дописали — отобразить файлы заново, иначе отдать копию
+    if (index >= mapped_entries_) {
+        refreshMapping();
+        const std::size_t first_unwritten = entries_ - unwritten_.size();
+        if (index >= mapped_entries_) {
+            if (index < first_unwritten) {
+                return {};
+            }
+            return unwritten_[index - first_unwritten];
+        }
+    }
+
+    std::uint64_t offset = 0;
+    std::memcpy(&offset, index_map_ + MAGIC_SIZE + index * OFFSET_SIZE,
+                OFFSET_SIZE);
+    if (offset + LENGTH_SIZE > log_map_size_) {
+        return {};
+    }
+    std::uint32_t length = 0;
+    std::memcpy(&length, log_map_ + offset, LENGTH_SIZE);
+    if (offset + LENGTH_SIZE + length > log_map_size_) {
+        return {};
+    }
+    return std::string_view{log_map_ + offset + LENGTH_SIZE, length};
+}
+
+void HistoryStore::flush() {
+    log_writer_->flush();
+    index_writer_->flush();
+}
+
+auto HistoryStore::import_text_file(const std::string& text_path)
+    -> std::size_t {
+    std::ifstream text_file(text_path);
+    if (!text_file) {
+        return 0;
+    }
+
+    std::size_t imported = 0;
+    std::string line;
+    while (std::getline(text_file, line)) {
+        append(line);
+        ++imported;
+    }
+    flush();
+    return imported;
+}
+
+[[nodiscard]]
+auto HistoryStore::log_path() const -> const std::string& {
+    return log_path_;
+}
+
+[[nodiscard]]
+auto HistoryStore::index_path() const -> const std::string& {
+    return index_path_;
+}
+
+[[nodiscard]]
+auto HistoryStore::recovered_entries() const -> std::size_t {
+    return recovered_entries_;
+}
+
+// Сверка журнала и индекса. Обычно стоит O(1): проверяется последнее
+// смещение индекса, а журнал читается только за ним
+void HistoryStore::recover() {
+    std::uint64_t log_size = 0;
+    std::uint64_t index_size = 0;
+    log_fd_ = openWithMagic(log_path_, LOG_MAGIC, log_size);
+    index_fd_ = openWithMagic(index_path_, INDEX_MAGIC, index_size);
+
+    std::uint64_t count = (index_size - MAGIC_SIZE) / OFFSET_SIZE;
+
+    // Отбросить смещения, чьи записи не дописаны в журнал
+    std::uint64_t next_record = MAGIC_SIZE;
+    while (count != 0) {
+        std::uint64_t offset = 0;
+        std::uint32_t length = 0;
+        if (readExact(index_fd_, &offset, OFFSET_SIZE,
+                      MAGIC_SIZE + (count - 1) * OFFSET_SIZE) &&
+            offset >= MAGIC_SIZE && offset + LENGTH_SIZE <= log_size &&
+            readExact(log_fd_, &length, LENGTH_SIZE, offset) &&
+            offset + LENGTH_SIZE + length <= log_size) {
+            next_record = offset + LENGTH_SIZE + length;
+            break;
+        }
+        --count;
+    }
+
+    // Досчитать смещения записей журнала, не попавших в индекс
+    std::vector<std::uint64_t> missing;
+    std::uint32_t length = 0;
+    while (next_record + LENGTH_SIZE <= log_size &&
+           readExact(log_fd_, &length, LENGTH_SIZE, next_record) &&
+           next_record + LENGTH_SIZE + length <= log_size) {
+        missing.push_back(next_record);
+        next_record += LENGTH_SIZE + length;
+    }
+
+    // Оборванная запись в конце журнала отрезается
+    if (next_record != log_size) {
+        truncateFile(log_fd_, next_record);
+    }
+    const std::uint64_t index_end = MAGIC_SIZE + count * OFFSET_SIZE;
+    if (index_end != index_size) {
+        truncateFile(index_fd_, index_end);
+    }
+    if (!missing.empty()) {
+        writeExact(index_fd_, missing.data(), missing.size() * OFFSET_SIZE,
+                   index_end);
+    }
+
+    log_size_ = next_record;
+    entries_ = static_cast<std::size_t>(count) + missing.size();
+    recovered_entries_ = missing.size();
+}
+
+[[nodiscard]]
+auto HistoryStore::writtenEntries() const -> std::size_t {
+    const std::uint64_t written = std::min(log_writer_->written_records(),
+                                           index_writer_->written_records());
+    return opened_entries_ + static_cast<std::size_t>(written);
+}
+
+void HistoryStore::refreshMapping() {
+    const std::size_t written = writtenEntries();
+    if (written <= mapped_entries_) {
+        return;
+    }
+    remap(written);
+    // Копии попавших в отображение записей больше не нужны
+    while (entries_ - unwritten_.size() < mapped_entries_) {
+        unwritten_.pop_front();
+    }
+}
+
+void HistoryStore::remap(std::size_t entries) {
+    unmap();
+
+    // Отображается только то, что уже есть в файлах
+    index_map_size_ = static_cast<std::size_t>(fileSize(index_fd_));
+    log_map_size_ = static_cast<std::size_t>(fileSize(log_fd_));
+    index_map_ = mapFile(index_fd_, index_map_size_);
+    log_map_ = mapFile(log_fd_, log_map_size_);
+    mapped_entries_ =
+        std::min(entries, (index_map_size_ - MAGIC_SIZE) / OFFSET_SIZE);
+}
+
+void HistoryStore::unmap() {
+    // NOLINTBEGIN(cppcoreguidelines-pro-type-const-cast)
+    if (index_map_ != nullptr) {
+        ::munmap(const_cast<char*>(index_map_), index_map_size_);
+        index_map_ = nullptr;
+    }
+    if (log_map_ != nullptr) {
+        ::munmap(const_cast<char*>(log_map_), log_map_size_);
+        log_map_ = nullptr;
+    }
+    // NOLINTEND(cppcoreguidelines-pro-type-const-cast)
+    mapped_entries_ = 0;
+}
+
+}  // namespace messenger::app
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "utils/async_appender.h"
+
+namespace messenger::app {
+
+// Постоянная история чата: журнал только на дозапись и индекс смещений.
+//
+//   <base>.log: "MSGRLOG1", затем записи [длина u32][байты строки]
+//   <base>.idx: "MSGRIDX1", затем смещения записей журнала, u64 на запись
+//
+// Открытие не читает историю целиком: индекс и журнал отображаются в
+// память (mmap), а строка с номером i читается по смещению из индекса —
+// время запуска не зависит от размера истории. Новые записи уходят в оба
+// файла через фоновые AsyncAppender. После аварийного завершения файлы
+// сверяются при открытии: оборванная запись журнала отрезается, лишние
+// смещения индекса отбрасываются, недостающие — досчитываются по хвосту
+// журнала.
+//
+// Записи этого сеанса, которые фоновые потоки ещё не дописали, хранятся
+// копией в памяти: read() отдаёт их оттуда и никогда не ждёт диска.
+// Отображение обновляется, когда оба AsyncAppender сообщают, что записи
+// уже в файлах, и тогда же копии в памяти отбрасываются.
+class HistoryStore {
+public:
+    // Открывает (создаёт) <base_path>.log и <base_path>.idx.
+    // При системной ошибке или чужом формате файлов бросает исключение
+    explicit HistoryStore(const std::string& base_path);
+    HistoryStore(const std::string& base_path,
+                 utils::AsyncAppender::Options options);
+
+    ~HistoryStore();
+
+    HistoryStore(const HistoryStore&) = delete;
+    HistoryStore& operator=(const HistoryStore&) = delete;
+    HistoryStore(HistoryStore&&) = delete;
+    HistoryStore& operator=(HistoryStore&&) = delete;
+
+    // Дописать строку (не блокируется на диске)
+    void append(std::string_view line);
+
+    // Количество записей, включая добавленные в этом сеансе
+    [[nodiscard]]
+    auto size() const -> std::size_t;
+
+    // Строка по номеру: 0 — самая старая. Не блокируется: недописанные
+    // записи этого сеанса читаются из памяти. Действительна до следующего
+    // read() или append()
+    [[nodiscard]]
+    auto read(std::size_t index) -> std::string_view;
+
+    // Дождаться записи всех добавленных строк
+    void flush();
+
+    // Однократный перенос старой текстовой истории (по строке на запись).
+    // Возвращает количество перенесённых строк
+    auto import_text_file(const std::string& text_path) -> std::size_t;
+
+    [[nodiscard]]
+    auto log_path() const -> const std::string&;
+    [[nodiscard]]
+    auto index_path() const -> const std::string&;
+
+    // Сколько смещений индекса досчитано по журналу при открытии
+    [[nodiscard]]
+    auto recovered_entries() const -> std::size_t;
+
+private:
+    void recover();
+    // Сколько записей уже дописано в оба файла
+    [[nodiscard]]
+    auto writtenEntries() const -> std::size_t;
+    // Отобразить дописанное и отбросить его копии в памяти
+    void refreshMapping();
+    void remap(std::size_t entries);
+    void unmap();
+
+    std::string log_path_;
+    std::string index_path_;
+
+    // Дескрипторы только для чтения — для mmap
+    int log_fd_{-1};
+    int index_fd_{-1};
+
+    // Отображённая часть файлов
+    const char* log_map_{nullptr};
+    std::size_t log_map_size_{0};
+    const char* index_map_{nullptr};
+    std::size_t index_map_size_{0};
+    std::size_t mapped_entries_{0};
+
+    // Логический размер журнала и число записей с учётом ещё не
+    // дописанных фоновыми потоками
+    std::uint64_t log_size_{0};
+    std::size_t entries_{0};
+    std::size_t recovered_entries_{0};
+
+    // Число записей при открытии: счётчики AsyncAppender идут с нуля
+    std::size_t opened_entries_{0};
+    // Копии записей [entries_ - unwritten_.size(), entries_), которых
+    // ещё нет в отображении
+    std::deque<std::string> unwritten_;
+
+    std::unique_ptr<utils::AsyncAppender> log_writer_;
+    std::unique_ptr<utils::AsyncAppender> index_writer_;
+};
+
+}  // namespace messenger::app
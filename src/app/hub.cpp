@@ -0,0 +1,449 @@
+#include "app/hub.h"
+
+// NOLINTBEGIN(modernize-deprecated-headers)
+#include <signal.h>
+// NOLINTEND(modernize-deprecated-headers)
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "app/session.h"
+#include "net/connection.h"
+#include "net/frame_header.h"
+#include "net/frame_reader.h"
+#include "net/outbound_queue.h"
+#include "net/raii_socket.h"
+#include "protocol/hello.h"
+#include "protocol/message.hpp"
+#include "protocol/serializer.h"
+#include "utils/p2p_error.h"
+
+namespace messenger::app {
+
+namespace {
+
+using messenger::proto::MessageView;
+using messenger::proto::MsgType;
+
+// Размер таблицы маршрутов Ack (кольцо по route id)
+constexpr std::size_t ROUTE_TABLE_SIZE = 65536U;
+
+// Блок чтения участника (буфер существует только на время пробуждения
+// или незавершённого кадра)
+constexpr std::size_t PEER_READ_CHUNK = 16U * 1024U;
+
+// Очередь отправки участника: вмещает пару кадров максимального размера;
+// переполнение означает, что участник не успевает принимать, и он
+// отключается
+constexpr messenger::net::OutboundQueue::Limits PEER_OUTBOUND_LIMITS{
+    2U * 1024U * 1024U, 1024U * 1024U, 256U * 1024U};
+
+// Флаг завершения из обработчика сигналов
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+volatile sig_atomic_t hub_shutdown_requested = 0;
+
+void handleHubExitSignal([[maybe_unused]] int signal_number) {
+    hub_shutdown_requested = 1;
+}
+
+// Поднять мягкий лимит открытых дескрипторов до жёсткого: каждому
+// участнику нужен свой дескриптор
+void raiseDescriptorLimit() {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 &&
+        limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+}  // namespace
+
+Hub::Hub(messenger::net::Socket listener, bool log_connections)
+    : listener_(std::move(listener)),
+      log_connections_(log_connections),
+      session_id_(SessionState::generate_session_id()),
+      routes_(ROUTE_TABLE_SIZE) {
+    stop_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stop_fd_ < 0) {
+        utils::throw_system_error("eventfd");
+    }
+
+    // Неблокирующий listener: accept() в цикле до EAGAIN
+    if (::fcntl(listener_.fd_return(), F_SETFL,
+                ::fcntl(listener_.fd_return(), F_GETFL) | O_NONBLOCK) < 0) {
+        ::close(stop_fd_);
+        utils::throw_system_error("fcntl");
+    }
+
+    loop_.add(listener_.fd_return(), EPOLLIN);
+    loop_.add(stop_fd_, EPOLLIN);
+}
+
+Hub::~Hub() {
+    ::close(stop_fd_);
+}
+
+void Hub::run() {
+    while (hub_shutdown_requested == 0) {
+        const auto& events = loop_.wait();
+
+        for (const auto& event : events) {
+            if (event.fd == stop_fd_) {
+                return;
+            }
+
+            if (event.fd == listener_.fd_return()) {
+                acceptPeers();
+                continue;
+            }
+
+            auto peer_it = peers_.find(event.fd);
+            if (peer_it == peers_.end()) {
+                continue;  // участник уже отключён в этом же круге
+            }
+
+            if ((event.events & EPOLLOUT) != 0 &&
+                !flushPeer(peer_it->second)) {
+                pending_drop_.push_back(event.fd);
+                continue;
+            }
+
+            if ((event.events & ~static_cast<std::uint32_t>(EPOLLOUT)) != 0 &&
+                !readPeer(peer_it->second)) {
+                pending_drop_.push_back(event.fd);
+            }
+        }
+
+        dropPending();
+    }
+}
+
+void Hub::stop() {
+    const std::uint64_t one = 1;
+    static_cast<void>(::write(stop_fd_, &one, sizeof(one)));
+}
+
+[[nodiscard]]
+auto Hub::peer_count() const -> std::size_t {
+    return peer_count_.load(std::memory_order_relaxed);
+}
+
+void Hub::acceptPeers() {
+    while (true) {
+        const int peer_fd = ::accept4(listener_.fd_return(), nullptr,
+                                      nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (peer_fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK ||
+                errno == ECONNABORTED) {
+                return;
+            }
+            if (errno == EMFILE || errno == ENFILE) {
+                // Дескрипторы исчерпаны: перестать следить за listener до
+                // отключения кого-либо, иначе epoll будит цикл без конца
+                std::cout << "[Хаб: исчерпан лимит дескрипторов, приём "
+                             "приостановлен]\n";
+                loop_.remove(listener_.fd_return());
+                accept_paused_ = true;
+                return;
+            }
+            utils::throw_system_error("accept4");
+        }
+
+        Peer peer{messenger::net::Connection(messenger::net::Socket(peer_fd),
+                                             PEER_OUTBOUND_LIMITS,
+                                             PEER_READ_CHUNK),
+                  next_serial_++, {}, 0, false};
+        loop_.add(peer_fd, EPOLLIN);
+        peers_.emplace(peer_fd, std::move(peer));
+        peer_count_.store(peers_.size(), std::memory_order_relaxed);
+
+        if (log_connections_) {
+            std::cout << "[Хаб: подключён участник fd=" << peer_fd
+                      << ", всего " << peers_.size() << "]\n";
+        }
+    }
+}
+
+[[nodiscard]]
+auto Hub::readPeer(Peer& peer) -> bool {
+    using messenger::net::FrameReader;
+
+    // Один recv() на пробуждение: справедливость между участниками при
+    // level-triggered epoll — остаток дочитается на следующем круге
+    FrameReader& reader = peer.conn.reader();
+    const FrameReader::ReadStatus status = reader.fill(peer.conn.fd());
+    if (status == FrameReader::ReadStatus::WouldBlock) {
+        return true;
+    }
+    if (status == FrameReader::ReadStatus::Closed) {
+        return false;  // участник отключился
+    }
+
+    std::span<const std::uint8_t> frame;
+    while (true) {
+        const FrameReader::FrameStatus frame_status = reader.next_frame(frame);
+        if (frame_status == FrameReader::FrameStatus::Incomplete) {
+            break;
+        }
+
+        // Text пересылается прямо из буфера приёма отправителя
+        MessageView msg{};
+        if (frame_status == FrameReader::FrameStatus::Invalid ||
+            !messenger::proto::deserialize(frame, msg, arena_)) {
+            return false;  // ошибка протокола
+        }
+
+        if (!dispatch(peer, msg)) {
+            return false;
+        }
+    }
+
+    reader.release_if_idle();
+    return true;
+}
+
+[[nodiscard]]
+auto Hub::flushPeer(Peer& peer) -> bool {
+    if (peer.conn.outbound().flush(peer.conn.fd()) ==
+        messenger::net::OutboundQueue::Status::Closed) {
+        return false;
+    }
+    updateWriteInterest(peer);
+    return true;
+}
+
+void Hub::updateWriteInterest(Peer& peer) {
+    auto& outbound = peer.conn.outbound();
+    const bool need_write = !outbound.empty();
+    if (need_write == peer.write_interest) {
+        return;
+    }
+
+    loop_.modify(peer.conn.fd(), need_write ? (EPOLLIN | EPOLLOUT) : EPOLLIN);
+    peer.write_interest = need_write;
+    if (!need_write) {
+        outbound.release_if_idle();
+    }
+}
+
+[[nodiscard]]
+auto Hub::dispatch(Peer& peer, const MessageView& msg) -> bool {
+    switch (msg.type) {
+        case MsgType::Text:
+            routeText(peer, msg);
+            return true;
+
+        case MsgType::Typing:
+            broadcast(peer, MessageView{MsgType::Typing, 0, {}});
+            return true;
+
+        case MsgType::Ack:
+            routeAck(msg);
+            return true;
+
+        case MsgType::Ping:
+            if (messenger::proto::decode_hello(msg.payload) &&
+                !sendHello(peer)) {
+                return false;
+            }
+            return sendFrame(peer, MessageView{MsgType::Pong, msg.id, {}});
+
+        case MsgType::Pong:
+            return true;  // хаб сам Ping не отправляет
+
+        default:
+            return false;
+    }
+}
+
+void Hub::routeText(Peer& sender, const MessageView& msg) {
+    // Повтор (ретрай) уже виденного Text — тот же route id, чтобы
+    // получатели отбросили дубликат по своей дедупликации
+    std::uint32_t route_id = 0;
+    for (const auto& recent : sender.recent) {
+        if (recent.route_id != 0 && recent.sender_msg_id == msg.id) {
+            route_id = recent.route_id;
+            break;
+        }
+    }
+
+    if (route_id != 0) {
+        const Route* route = findRoute(route_id);
+        if (route != nullptr && route->acked) {
+            // Доставка уже подтверждена, Ack до отправителя потерялся
+            if (!sendFrame(sender, MessageView{MsgType::Ack, msg.id, {}})) {
+                pending_drop_.push_back(sender.conn.fd());
+            }
+            return;
+        }
+    } else {
+        route_id = allocateRoute(sender, msg.id);
+        sender.recent[sender.recent_next] = RecentText{msg.id, route_id};
+        sender.recent_next = (sender.recent_next + 1) % RECENT_TEXTS;
+    }
+
+    broadcast(sender, MessageView{MsgType::Text, route_id, msg.payload});
+}
+
+// Приветствие хаба: возможностей нет (Ack на каждый Text, заголовки v1),
+// peer_session_id == 0 — границы возобновления хаб не сообщает
+[[nodiscard]]
+auto Hub::sendHello(Peer& peer) -> bool {
+    messenger::proto::Hello hello{};
+    hello.session_id = session_id_;
+    const std::string payload = messenger::proto::encode_hello(hello);
+    return sendFrame(peer, MessageView{MsgType::Ping, 0, payload});
+}
+
+void Hub::routeAck(const MessageView& msg) {
+    Route* route = findRoute(msg.id);
+    if (route == nullptr || route->acked) {
+        return;  // устаревший или повторный Ack
+    }
+
+    // Отправителю достаточно первого подтверждения доставки
+    route->acked = true;
+
+    auto sender_it = peers_.find(route->sender_fd);
+    if (sender_it == peers_.end() ||
+        sender_it->second.serial != route->sender_serial) {
+        return;  // отправитель уже отключился (fd мог быть переиспользован)
+    }
+
+    if (!sendFrame(sender_it->second,
+                   MessageView{MsgType::Ack, route->sender_msg_id, {}})) {
+        pending_drop_.push_back(route->sender_fd);
+    }
+}
+
+void Hub::broadcast(const Peer& sender, const MessageView& msg) {
+    for (auto& [peer_fd, peer] : peers_) {
+        if (peer.serial == sender.serial) {
+            continue;
+        }
+        // Typing не критичен: перегруженному участнику он не отправляется
+        if (msg.type == MsgType::Typing &&
+            peer.conn.outbound().above_high_watermark()) {
+            continue;
+        }
+        if (!sendFrame(peer, msg)) {
+            pending_drop_.push_back(peer_fd);
+        }
+    }
+}
+
+[[nodiscard]]
+auto Hub::sendFrame(Peer& peer, const MessageView& msg) -> bool {
+    // Заголовок на стеке, payload — из самого сообщения: без сборки кадра
+    const auto header = messenger::proto::encode_header(
+        messenger::net::HeaderFormat::V1, msg.type, msg.id,
+        static_cast<std::uint32_t>(msg.payload.size()));
+    const std::span<const std::uint8_t> payload{
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        reinterpret_cast<const std::uint8_t*>(msg.payload.data()),
+        msg.payload.size()};
+
+    // Full — участник не успевает принимать данные, его очередь исчерпана:
+    // он отключается, остальные участники не ждут
+    if (peer.conn.outbound().send(peer.conn.fd(), header.view(), payload) !=
+        messenger::net::OutboundQueue::Status::Ok) {
+        return false;
+    }
+    updateWriteInterest(peer);
+    return true;
+}
+
+[[nodiscard]]
+auto Hub::allocateRoute(const Peer& sender, std::uint32_t sender_msg_id)
+    -> std::uint32_t {
+    const std::uint32_t route_id = next_route_id_++;
+    if (next_route_id_ == 0) {
+        next_route_id_ = 1;  // id 0 не используется для Text
+    }
+
+    // Старый маршрут в этом слоте вытесняется: его Ack уже не ожидается
+    routes_[route_id % ROUTE_TABLE_SIZE] =
+        Route{route_id, sender.conn.fd(), sender.serial, sender_msg_id, false};
+    return route_id;
+}
+
+[[nodiscard]]
+auto Hub::findRoute(std::uint32_t route_id) -> Route* {
+    Route& route = routes_[route_id % ROUTE_TABLE_SIZE];
+    if (route.route_id != route_id || route_id == 0) {
+        return nullptr;
+    }
+    return &route;
+}
+
+void Hub::dropPeer(int peer_fd) {
+    auto peer_it = peers_.find(peer_fd);
+    if (peer_it == peers_.end()) {
+        return;
+    }
+
+    loop_.remove(peer_fd);
+    peers_.erase(peer_it);  // Socket закроет дескриптор
+    peer_count_.store(peers_.size(), std::memory_order_relaxed);
+
+    if (log_connections_) {
+        std::cout << "[Хаб: участник fd=" << peer_fd << " отключён, всего "
+                  << peers_.size() << "]\n";
+    }
+
+    // Освободился дескриптор — можно снова принимать подключения
+    if (accept_paused_) {
+        loop_.add(listener_.fd_return(), EPOLLIN);
+        accept_paused_ = false;
+    }
+}
+
+void Hub::dropPending() {
+    for (const int peer_fd : pending_drop_) {
+        dropPeer(peer_fd);
+    }
+    pending_drop_.clear();
+}
+
+void hub_loop(messenger::net::Socket listener) {
+    {
+        struct sigaction sig_action {};
+        sig_action.sa_handler = handleHubExitSignal;
+        sigemptyset(&sig_action.sa_mask);
+        sig_action.sa_flags = 0;  // epoll_wait() вернёт EINTR
+        sigaction(SIGINT, &sig_action, nullptr);   // Ctrl-C
+        sigaction(SIGTERM, &sig_action, nullptr);  // kill
+
+        struct sigaction sig_action_ign {};
+        sig_action_ign.sa_handler = SIG_IGN;  // Игнорировать SIGPIPE
+        sigemptyset(&sig_action_ign.sa_mask);
+        sig_action_ign.sa_flags = 0;
+        sigaction(SIGPIPE, &sig_action_ign, nullptr);
+    }
+
+    raiseDescriptorLimit();
+
+    Hub hub(std::move(listener));
+    std::cout << "Хаб запущен. Завершение: Ctrl-C.\n";
+    hub.run();
+    std::cout << "\nХаб остановлен.\n";
+}
+
+}  // namespace messenger::app
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "net/connection.h"
+#include "net/event_loop.h"
+#include "net/raii_socket.h"
+#include "protocol/message.hpp"
+#include "protocol/serializer.h"
+
+namespace messenger::app {
+
+// Хаб: сервер, держащий множество собеседников в одном цикле событий.
+//
+// Слушающий сокет остаётся открытым, подключения принимаются непрерывно.
+// Text и Typing рассылаются всем остальным участникам; Text уходит под
+// собственным id хаба (route id), и Ack получателя возвращается отправителю
+// уже с его исходным id. Ping от участника хаб подтверждает сам, а на
+// приветствие сеанса (protocol/hello.h) отвечает своим — без возможностей
+// и без границы возобновления: участник сразу повторяет ожидавшее Ack, не
+// дожидаясь таймаута приветствия.
+//
+// Память на соединение ограничена: состояние участника — несколько сотен
+// байт, буферы приёма и отправки освобождаются, как только в них не остаётся
+// незавершённых кадров, таблица маршрутов Ack — фиксированного размера.
+// Медленный участник копит кадры в своей очереди отправки и не задерживает
+// остальных; при переполнении очереди он отключается.
+class Hub {
+public:
+    explicit Hub(messenger::net::Socket listener, bool log_connections = true);
+    ~Hub();
+
+    Hub(const Hub&) = delete;
+    Hub& operator=(const Hub&) = delete;
+    Hub(Hub&&) = delete;
+    Hub& operator=(Hub&&) = delete;
+
+    // Цикл обработки до stop() или сигнала завершения
+    void run();
+
+    // Потокобезопасная остановка run()
+    void stop();
+
+    // Количество подключённых участников
+    [[nodiscard]]
+    auto peer_count() const -> std::size_t;
+
+private:
+    // Сколько последних Text каждого участника помнить для распознавания
+    // повторных отправок (ретраев) с тем же id
+    static constexpr std::size_t RECENT_TEXTS = 16U;
+
+    struct RecentText {
+        std::uint32_t sender_msg_id{};
+        std::uint32_t route_id{};
+    };
+
+    struct Peer {
+        // Неблокирующий сокет, буфер приёма и очередь отправки; между
+        // пробуждениями память держат только незавершённые кадры
+        messenger::net::Connection conn;
+        std::uint64_t serial{};
+        std::array<RecentText, RECENT_TEXTS> recent{};
+        std::size_t recent_next{};
+        // Подписан ли участник в epoll на EPOLLOUT
+        bool write_interest{false};
+    };
+
+    // Маршрут Ack: route id → (отправитель, его исходный id)
+    struct Route {
+        std::uint32_t route_id{};
+        int sender_fd{-1};
+        std::uint64_t sender_serial{};
+        std::uint32_t sender_msg_id{};
+        bool acked{false};
+    };
+
+    void acceptPeers();
+    [[nodiscard]]
+    auto readPeer(Peer& peer) -> bool;
+    [[nodiscard]]
+    auto flushPeer(Peer& peer) -> bool;
+    void updateWriteInterest(Peer& peer);
+    [[nodiscard]]
+    auto dispatch(Peer& peer, const messenger::proto::MessageView& msg) -> bool;
+    void routeText(Peer& sender, const messenger::proto::MessageView& msg);
+    void routeAck(const messenger::proto::MessageView& msg);
+    [[nodiscard]]
+    auto sendHello(Peer& peer) -> bool;
+    void broadcast(const Peer& sender,
+                   const messenger::proto::MessageView& msg);
+    [[nodiscard]]
+    auto sendFrame(Peer& peer, const messenger::proto::MessageView& msg)
+        -> bool;
+    [[nodiscard]]
+    auto allocateRoute(const Peer& sender, std::uint32_t sender_msg_id)
+        -> std::uint32_t;
+    [[nodiscard]]
+    auto findRoute(std::uint32_t route_id) -> Route*;
+    void dropPeer(int peer_fd);
+    void dropPending();
+
+    messenger::net::Socket listener_;
+    messenger::net::EventLoop loop_;
+    int stop_fd_{-1};
+    bool log_connections_{true};
+    bool accept_paused_{false};
+
+    std::unordered_map<int, Peer> peers_;
+    std::vector<int> pending_drop_;
+    std::atomic<std::size_t> peer_count_{0};
+    std::uint64_t next_serial_{1};
+    // Случайный id запуска хаба для приветствий: перезапуск хаба участник
+    // видит как перезапуск собеседника
+    std::uint64_t session_id_{};
+
+    std::vector<Route> routes_;
+    std::uint32_t next_route_id_{1};
+
+    // Распакованный Text разбираемого кадра; общий для всех участников —
+    // кадр обрабатывается целиком до разбора следующего
+    messenger::proto::ReceiveArena arena_;
+};
+
+// Режим хаба: приём участников на слушающем сокете и маршрутизация
+// сообщений между ними до Ctrl-C / SIGTERM
+void hub_loop(messenger::net::Socket listener);
+
+}  // namespace messenger::app
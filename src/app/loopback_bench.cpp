@@ -0,0 +1,491 @@
+#include "app/loopback_bench.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iomanip>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "app/delayed_ack.h"
+#include "app/outbox.h"
+#include "app/send_window.h"
+#include "app/session.h"
+#include "net/client_socket.h"
+#include "net/connection.h"
+#include "net/event_loop.h"
+#include "net/frame_reader.h"
+#include "net/net_api.h"
+#include "net/outbound_queue.h"
+#include "net/raii_socket.h"
+#include "net/server_socket.h"
+#include "protocol/hello.h"
+#include "protocol/message.hpp"
+#include "protocol/protocol_api.h"
+#include "protocol/sack.h"
+#include "protocol/serializer.h"
+#include "utils/latency_histogram.h"
+#include "utils/p2p_error.h"
+
+namespace messenger::app {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr double BYTES_PER_MEGABYTE = 1024.0 * 1024.0;
+constexpr double P50 = 0.5;
+constexpr double P99 = 0.99;
+constexpr double P999 = 0.999;
+
+// id Ping с приветствием: бенч других Ping не шлёт
+constexpr std::uint32_t HELLO_PING_ID = 1U;
+
+// Порт, выбранный ядром для слушающего сокета на порту 0
+[[nodiscard]]
+auto boundPort(const net::Socket& listener) -> std::uint16_t {
+    sockaddr_in addr{};
+    socklen_t addr_len = sizeof(addr);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    if (::getsockname(listener.fd_return(), reinterpret_cast<sockaddr*>(&addr),
+                      &addr_len) < 0) {
+        utils::throw_system_error("getsockname");
+    }
+    return ntohs(addr.sin_port);
+}
+
+// Конец соединения бенча: цикл событий над net::Connection, как у чата.
+// Кадры принимаются FrameReader без копирования, исходящие ждут в
+// OutboundQueue, EPOLLOUT нужен, только пока в ней есть байты
+class Endpoint {
+public:
+    explicit Endpoint(net::Socket sock)
+        : conn_(std::move(sock)),
+          session_(SessionState::generate_session_id()) {
+        // Кадры бенча идут потоком, как у чата без терминала: Nagle
+        // придерживал бы каждый следующий до ACK TCP
+        const int enabled = 1;
+        static_cast<void>(::setsockopt(conn_.fd(), IPPROTO_TCP, TCP_NODELAY,
+                                       &enabled, sizeof(enabled)));
+        loop_.add(conn_.fd(), EPOLLIN);
+        session_.begin_connection();
+    }
+
+    // Приветствие сеанса: Sack и компактные заголовки — после ответного
+    void send_hello() {
+        if (!proto::send_ping(conn_, HELLO_PING_ID,
+                              proto::encode_hello(session_.hello()))) {
+            throw std::runtime_error("бенч: приветствие не отправлено");
+        }
+    }
+
+    // Одно пробуждение цикла событий; on_frame вызывается на каждый
+    // принятый кадр. false — собеседник закрыл соединение
+    template <typename OnFrame>
+    [[nodiscard]]
+    auto poll(std::optional<Clock::time_point> deadline, OnFrame&& on_frame)
+        -> bool {
+        const bool need_write = !conn_.outbound().empty();
+        if (need_write != write_interest_) {
+            loop_.modify(conn_.fd(),
+                         need_write ? (EPOLLIN | EPOLLOUT) : EPOLLIN);
+            write_interest_ = need_write;
+        }
+        loop_.arm_timer(deadline);
+
+        for (const auto& event : loop_.wait()) {
+            if ((event.events & EPOLLOUT) != 0 &&
+                conn_.outbound().flush(conn_.fd()) ==
+                    net::OutboundQueue::Status::Closed) {
+                return false;
+            }
+            if ((event.events & ~static_cast<std::uint32_t>(EPOLLOUT)) != 0 &&
+                !readFrames(on_frame)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Приветствие собеседника: формат заголовков — со следующего кадра
+    void on_hello(const proto::MessageView& msg) {
+        const auto peer_hello = proto::decode_hello(msg.payload);
+        if (!peer_hello) {
+            return;
+        }
+        static_cast<void>(session_.on_peer_hello(*peer_hello));
+        conn_.set_header_format(
+            session_.peer_supports(proto::Hello::FEATURE_COMPACT_HEADER)
+                ? net::HeaderFormat::V2
+                : net::HeaderFormat::V1);
+        hello_received_ = true;
+    }
+
+    [[nodiscard]]
+    auto hello_received() const -> bool {
+        return hello_received_;
+    }
+
+    [[nodiscard]]
+    auto conn() -> net::Connection& {
+        return conn_;
+    }
+
+    [[nodiscard]]
+    auto session() -> SessionState& {
+        return session_;
+    }
+
+private:
+    template <typename OnFrame>
+    [[nodiscard]]
+    auto readFrames(OnFrame& on_frame) -> bool {
+        net::FrameReader& reader = conn_.reader();
+        const net::FrameReader::ReadStatus status = reader.fill(conn_.fd());
+        if (status == net::FrameReader::ReadStatus::WouldBlock) {
+            return true;
+        }
+        if (status == net::FrameReader::ReadStatus::Closed) {
+            if (reader.buffered() != 0) {
+                throw std::runtime_error("бенч: обрыв посреди кадра");
+            }
+            return false;
+        }
+
+        std::span<const std::uint8_t> frame;
+        while (true) {
+            const net::FrameReader::FrameStatus frame_status =
+                reader.next_frame(frame);
+            if (frame_status == net::FrameReader::FrameStatus::Incomplete) {
+                return true;
+            }
+            proto::MessageView msg{};
+            if (frame_status == net::FrameReader::FrameStatus::Invalid ||
+                !proto::deserialize(frame, msg, arena_)) {
+                throw std::runtime_error("бенч: повреждённый кадр");
+            }
+            on_frame(msg);
+        }
+    }
+
+    net::Connection conn_;
+    net::EventLoop loop_;
+    SessionState session_;
+    proto::ReceiveArena arena_;
+    bool write_interest_{false};
+    bool hello_received_{false};
+};
+
+// Сервер: принятые Text подтверждаются отложенным Sack, как в чате, до
+// закрытия соединения клиентом
+void serveEcho(net::Socket sock) {
+    Endpoint server(std::move(sock));
+    DelayedAck delayed_ack;
+
+    const auto flush_ack = [&] {
+        if (!delayed_ack.pending()) {
+            return;
+        }
+        delayed_ack.reset();
+        const auto boundary = server.session().last_received();
+        if (!boundary) {
+            return;
+        }
+        auto blocks = server.session().sack_blocks();
+        blocks.window = DelayedAck::receive_window(server.conn());
+        if (!proto::send_sack(server.conn(), *boundary, blocks)) {
+            throw std::runtime_error("бенч: сервер не отправил Sack");
+        }
+    };
+    server.conn().outbound().set_watermark_handler([&](bool above_high) {
+        if (!above_high && server.session().last_received()) {
+            delayed_ack.request_update(Clock::now());
+        }
+    });
+
+    const auto on_frame = [&](const proto::MessageView& msg) {
+        if (msg.type == proto::MsgType::Ping) {
+            server.on_hello(msg);
+            if (!proto::send_pong(server.conn(), msg.id)) {
+                throw std::runtime_error("бенч: сервер не отправил Pong");
+            }
+            return;
+        }
+        if (msg.type != proto::MsgType::Text ||
+            !server.session().accept(msg.id)) {
+            return;
+        }
+        if (!server.session().peer_supports(proto::Hello::FEATURE_SACK)) {
+            if (!proto::send_ack(server.conn(), msg.id)) {
+                throw std::runtime_error("бенч: сервер не отправил Ack");
+            }
+            return;
+        }
+        if (delayed_ack.on_received(Clock::now())) {
+            flush_ack();
+        }
+    };
+
+    server.send_hello();
+    while (server.poll(delayed_ack.deadline(), on_frame)) {
+        const auto deadline = delayed_ack.deadline();
+        if (deadline && Clock::now() >= *deadline) {
+            flush_ack();
+        }
+    }
+}
+
+// Клиент: Text из outbox уходят, пока позволяет окно отправки, —
+// как pumpOutbox() чата; подтверждения закрывают их кадром Sack
+class Sender {
+public:
+    Sender(net::Socket sock, const LoopbackBenchOptions& options)
+        : client_(std::move(sock)),
+          options_(options),
+          payload_(options.payload_size, 'x'),
+          outbox_(options.window),
+          send_window_(SendWindow::Options{
+              std::min(SendWindow::Options{}.initial_cwnd, options.window),
+              options.window, DelayedAck::RECEIVE_WINDOW}) {
+        if (options.rate != 0) {
+            interval_ = std::chrono::duration_cast<Clock::duration>(
+                            std::chrono::seconds(1)) /
+                        options.rate;
+        }
+    }
+
+    // Отправить все сообщения и дождаться их подтверждения
+    void run() {
+        const auto on_frame = [this](const proto::MessageView& msg) {
+            onFrame(msg);
+        };
+
+        client_.send_hello();
+        while (!client_.hello_received()) {
+            if (!client_.poll(std::nullopt, on_frame)) {
+                throw std::runtime_error(
+                    "бенч: соединение с сервером потеряно");
+            }
+        }
+
+        started_ = Clock::now();
+        pump();
+        while (acked_ < options_.messages) {
+            if (!client_.poll(nextSendTime(), on_frame)) {
+                throw std::runtime_error(
+                    "бенч: соединение с сервером потеряно");
+            }
+            pump();
+        }
+        elapsed_ = Clock::now() - started_;
+    }
+
+    // Сервер завершается, увидев закрытие соединения клиентом
+    void shutdown(int how) {
+        ::shutdown(client_.conn().fd(), how);
+    }
+
+    [[nodiscard]]
+    auto elapsed() const -> std::chrono::duration<double> {
+        return elapsed_;
+    }
+
+    [[nodiscard]]
+    auto latency() const -> const utils::LatencyHistogram& {
+        return latency_;
+    }
+
+    [[nodiscard]]
+    auto ack_frames() const -> std::uint64_t {
+        return ack_frames_;
+    }
+
+private:
+    // Срок следующего сообщения при ограниченном темпе
+    [[nodiscard]]
+    auto nextSendTime() const -> std::optional<Clock::time_point> {
+        if (options_.rate == 0 || next_id_ > options_.messages ||
+            !send_window_.can_send()) {
+            return std::nullopt;
+        }
+        return started_ + interval_ * (next_id_ - 1U);
+    }
+
+    void pump() {
+        const auto now = Clock::now();
+        while (next_id_ <= options_.messages && send_window_.can_send()) {
+            if (options_.rate != 0 && now < *nextSendTime()) {
+                return;
+            }
+            // Очередь отправки переполнена: остаток — по EPOLLOUT
+            if (!proto::send_text(client_.conn(), payload_, next_id_)) {
+                return;
+            }
+            outbox_.add(next_id_, payload_);
+            Outbox::Entry& entry = *outbox_.find(next_id_);
+            entry.sent = true;
+            entry.transmitted = true;
+            entry.sent_at = now;
+            send_window_.on_send();
+            ++next_id_;
+        }
+    }
+
+    void onFrame(const proto::MessageView& msg) {
+        if (msg.type == proto::MsgType::Ping) {
+            client_.on_hello(msg);
+            if (!proto::send_pong(client_.conn(), msg.id)) {
+                throw std::runtime_error("бенч: клиент не отправил Pong");
+            }
+            return;
+        }
+        if (msg.type == proto::MsgType::Sack) {
+            const auto blocks = proto::decode_sack(msg.payload);
+            if (!blocks) {
+                throw std::runtime_error("бенч: повреждённый Sack");
+            }
+            outbox_.settle(msg.id,
+                           std::span(blocks->ranges.data(), blocks->count),
+                           settled_);
+            for (const auto& entry : settled_) {
+                record(entry);
+            }
+            send_window_.on_ack(settled_.size());
+            send_window_.on_peer_window(blocks->window);
+            ++ack_frames_;
+            return;
+        }
+        if (msg.type == proto::MsgType::Ack) {
+            const Outbox::Entry* entry = outbox_.find(msg.id);
+            if (entry == nullptr) {
+                throw std::runtime_error("бенч: Ack с чужим id");
+            }
+            record(*entry);
+            outbox_.erase(msg.id);
+            send_window_.on_ack(1);
+            ++ack_frames_;
+        }
+    }
+
+    // Задержка отправка → подтверждение
+    void record(const Outbox::Entry& entry) {
+        const auto micros = std::chrono::duration_cast<
+            std::chrono::microseconds>(Clock::now() - entry.sent_at);
+        latency_.record(static_cast<std::uint64_t>(
+            std::max<std::int64_t>(micros.count(), 0)));
+        ++acked_;
+    }
+
+    Endpoint client_;
+    const LoopbackBenchOptions& options_;
+    const std::string payload_;
+    Outbox outbox_;
+    SendWindow send_window_;
+    std::vector<Outbox::Entry> settled_;
+    utils::LatencyHistogram latency_;
+
+    Clock::duration interval_{Clock::duration::zero()};
+    Clock::time_point started_{};
+    std::chrono::duration<double> elapsed_{};
+    std::uint32_t next_id_{1};
+    std::uint64_t acked_{0};
+    std::uint64_t ack_frames_{0};
+};
+
+}  // namespace
+
+[[nodiscard]]
+auto run_loopback_bench(const LoopbackBenchOptions& options)
+    -> LoopbackBenchReport {
+    if (options.messages == 0 || options.window == 0 ||
+        options.payload_size > net::MaxPayloadSize::value) {
+        throw std::invalid_argument("бенч: недопустимые параметры прогона");
+    }
+
+    const net::Socket listener = net::create_listen_socket(0, 1);
+    net::Socket client =
+        net::create_client_socket("127.0.0.1", boundPort(listener));
+    net::Socket server = net::accept_client(listener);
+
+    std::exception_ptr server_error;
+    std::thread server_thread(
+        [&server_error, sock = std::move(server)]() mutable {
+            try {
+                serveEcho(std::move(sock));
+            } catch (...) {
+                server_error = std::current_exception();
+            }
+        });
+
+    Sender sender(std::move(client), options);
+    try {
+        sender.run();
+    } catch (...) {
+        sender.shutdown(SHUT_RDWR);
+        server_thread.join();
+        // Ошибка сервера — причина обрыва, который увидел клиент
+        if (server_error) {
+            std::rethrow_exception(server_error);
+        }
+        throw;
+    }
+    sender.shutdown(SHUT_WR);
+    server_thread.join();
+    if (server_error) {
+        std::rethrow_exception(server_error);
+    }
+
+    const utils::LatencyHistogram& latency = sender.latency();
+    const std::chrono::duration<double> elapsed = sender.elapsed();
+    LoopbackBenchReport report;
+    report.messages = options.messages;
+    report.ack_frames = sender.ack_frames();
+    report.elapsed = elapsed;
+    report.messages_per_second =
+        static_cast<double>(options.messages) / elapsed.count();
+    report.megabytes_per_second = report.messages_per_second *
+                                  static_cast<double>(options.payload_size) /
+                                  BYTES_PER_MEGABYTE;
+    report.p50_us = latency.percentile(P50);
+    report.p99_us = latency.percentile(P99);
+    report.p999_us = latency.percentile(P999);
+    report.max_us = latency.max();
+    return report;
+}
+
+void print_loopback_report(std::ostream& out,
+                           const LoopbackBenchOptions& options,
+                           const LoopbackBenchReport& report) {
+    out << "Бенч: " << report.messages << " сообщений по "
+        << options.payload_size << " байт, темп ";
+    if (options.rate == 0) {
+        out << "без ограничения";
+    } else {
+        out << options.rate << " сообщ./с";
+    }
+    out << ", окно " << options.window << "\n";
+
+    out << std::fixed << std::setprecision(3) << "Прошло "
+        << report.elapsed.count() << " с: " << std::setprecision(0)
+        << report.messages_per_second << " сообщ./с, "
+        << std::setprecision(2) << report.megabytes_per_second
+        << " МБ/с, кадров подтверждения " << report.ack_frames << "\n";
+    out << "Задержка отправка → подтверждение, мкс: p50 " << report.p50_us
+        << ", p99 " << report.p99_us << ", p999 " << report.p999_us
+        << ", макс " << report.max_us << "\n";
+}
+
+}  // namespace messenger::app
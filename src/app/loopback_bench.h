@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+namespace messenger::app {
+
+// Нагрузочный прогон через loopback (режим «бенч»).
+//
+// В одном процессе поднимаются сервер и клиент, связанные настоящим
+// TCP-соединением через 127.0.0.1. Оба конца работают как чат: цикл
+// событий над net::Connection, обмен приветствиями сеанса, Text из outbox
+// под окном отправки (SendWindow), отложенный Sack получателя
+// (DelayedAck). Задержка — от отправки Text до кадра, подтвердившего его.
+struct LoopbackBenchOptions {
+    std::uint32_t messages{100000U};
+    // Темп отправки, сообщений в секунду; 0 — без ограничения
+    std::uint32_t rate{0};
+    std::size_t payload_size{64U};
+    // Предел окна отправки (cwnd), сообщений: без ограничения темпа
+    // задержку иначе определяет очередь в сокете
+    std::uint32_t window{64U};
+};
+
+struct LoopbackBenchReport {
+    std::uint64_t messages{0};
+    std::chrono::duration<double> elapsed{};
+    double messages_per_second{0.0};
+    double megabytes_per_second{0.0};
+    // Принятых клиентом кадров Sack/Ack: один Sack закрывает несколько
+    // сообщений
+    std::uint64_t ack_frames{0};
+    // Задержка отправка → подтверждение, мкс
+    std::uint64_t p50_us{0};
+    std::uint64_t p99_us{0};
+    std::uint64_t p999_us{0};
+    std::uint64_t max_us{0};
+};
+
+// Прогон целиком; при системной ошибке или ошибке протокола бросает
+// исключение
+[[nodiscard]]
+auto run_loopback_bench(const LoopbackBenchOptions& options)
+    -> LoopbackBenchReport;
+
+void print_loopback_report(std::ostream& out,
+                           const LoopbackBenchOptions& options,
+                           const LoopbackBenchReport& report);
+
+}  // namespace messenger::app
@@ -0,0 +1,180 @@
+#include "app/outbox.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace messenger::app {
+
+namespace {
+
+// id не позже границы по арифметике последовательных номеров (RFC 1982)
+[[nodiscard]]
+auto notAfter(std::uint32_t msg_id, std::uint32_t boundary) -> bool {
+    return boundary - msg_id < (std::uint32_t{1} << 31U);
+}
+
+}  // namespace
+
+Outbox::Outbox(std::size_t capacity)
+    : capacity_(std::max<std::size_t>(capacity, 1U)) {
+    by_id_.reserve(capacity_);
+}
+
+auto Outbox::add(std::uint32_t msg_id, std::string payload)
+    -> std::optional<Entry> {
+    erase(msg_id);
+
+    Entry entry{};
+    entry.id = msg_id;
+    entry.payload = std::make_shared<const std::string>(std::move(payload));
+    entries_.push_back(std::move(entry));
+    by_id_[msg_id] = std::prev(entries_.end());
+    ++awaiting_;
+
+    if (entries_.size() <= capacity_) {
+        return std::nullopt;
+    }
+    std::optional<Entry> evicted{std::move(entries_.front())};
+    by_id_.erase(evicted->id);
+    entries_.pop_front();
+    if (evicted->awaiting_ack) {
+        --awaiting_;
+    }
+    return evicted;
+}
+
+[[nodiscard]]
+auto Outbox::find(std::uint32_t msg_id) -> Entry* {
+    const auto found = by_id_.find(msg_id);
+    return found == by_id_.end() ? nullptr : &*found->second;
+}
+
+auto Outbox::rekey(std::uint32_t old_id, std::uint32_t new_id) -> Entry* {
+    const auto found = by_id_.find(old_id);
+    if (found == by_id_.end()) {
+        return nullptr;
+    }
+    const auto node = found->second;
+    by_id_.erase(found);
+
+    // Запись с новым id (если вдруг есть) заменяется
+    if (new_id != old_id) {
+        erase(new_id);
+    }
+    node->id = new_id;
+    by_id_[new_id] = node;
+    // Новый id — самый свежий: запись уходит в конец, список остаётся
+    // упорядоченным по id
+    entries_.splice(entries_.end(), entries_, node);
+    return &*node;
+}
+
+auto Outbox::erase(std::uint32_t msg_id) -> bool {
+    const auto found = by_id_.find(msg_id);
+    if (found == by_id_.end()) {
+        return false;
+    }
+    if (found->second->awaiting_ack) {
+        --awaiting_;
+    }
+    entries_.erase(found->second);
+    by_id_.erase(found);
+    return true;
+}
+
+void Outbox::set_awaiting_ack(Entry& entry, bool awaiting) {
+    if (entry.awaiting_ack == awaiting) {
+        return;
+    }
+    entry.awaiting_ack = awaiting;
+    if (awaiting) {
+        ++awaiting_;
+    } else {
+        --awaiting_;
+    }
+}
+
+[[nodiscard]]
+auto Outbox::awaiting_count() const -> std::size_t {
+    return awaiting_;
+}
+
+void Outbox::settle(std::uint32_t cumulative,
+                    std::span<const proto::SackRange> ranges,
+                    std::vector<Entry>& settled) {
+    settled.clear();
+
+    // Список упорядочен по id: закрытое накопительной границей — его
+    // начало. Неотправленную запись Sack подтвердить не может, даже если
+    // её id за границей, — она остаётся ждать очереди
+    for (auto node = entries_.begin();
+         node != entries_.end() && notAfter(node->id, cumulative);) {
+        node = node->sent ? settleNode(node, settled) : std::next(node);
+    }
+
+    for (const auto& range : ranges) {
+        if (!notAfter(range.first, range.last)) {
+            continue;  // перевёрнутый блок ничего не подтверждает
+        }
+        // Длинный блок дешевле сверить со списком, чем перебрать по id
+        if (range.last - range.first >= entries_.size()) {
+            for (auto node = entries_.begin(); node != entries_.end();) {
+                const bool acked = node->sent &&
+                                   notAfter(range.first, node->id) &&
+                                   notAfter(node->id, range.last);
+                node = acked ? settleNode(node, settled) : std::next(node);
+            }
+            continue;
+        }
+        for (std::uint32_t msg_id = range.first;; ++msg_id) {
+            const auto found = by_id_.find(msg_id);
+            if (found != by_id_.end() && found->second->sent) {
+                settleNode(found->second, settled);
+            }
+            if (msg_id == range.last) {
+                break;
+            }
+        }
+    }
+}
+
+auto Outbox::settleNode(std::list<Entry>::iterator node,
+                        std::vector<Entry>& settled)
+    -> std::list<Entry>::iterator {
+    if (node->awaiting_ack) {
+        --awaiting_;
+    }
+    by_id_.erase(node->id);
+    settled.push_back(std::move(*node));
+    return entries_.erase(node);
+}
+
+[[nodiscard]]
+auto Outbox::begin() const -> const_iterator {
+    return entries_.begin();
+}
+
+[[nodiscard]]
+auto Outbox::end() const -> const_iterator {
+    return entries_.end();
+}
+
+[[nodiscard]]
+auto Outbox::size() const -> std::size_t {
+    return entries_.size();
+}
+
+[[nodiscard]]
+auto Outbox::capacity() const -> std::size_t {
+    return capacity_;
+}
+
+}  // namespace messenger::app
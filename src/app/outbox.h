@@ -0,0 +1,119 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "net/timer_wheel.h"
+#include "protocol/sack.h"
+
+namespace messenger::app {
+
+// Исходящие сообщения, ещё не подтверждённые собеседником.
+//
+// Одна запись на сообщение: и состояние ожидания Ack (таймер, ретраи),
+// и текст для /повтор. Текст хранится один раз, в shared_ptr на
+// неизменяемую строку, — повторная отправка под новым id его не копирует.
+// Записи лежат в списке в порядке id (повтор под новым id переносит
+// запись в конец), а хеш-таблица ведёт id к узлу списка: поиск,
+// подтверждение одного id и смена id — O(1) в среднем. При переполнении
+// вытесняется самая старая запись.
+class Outbox {
+public:
+    using Payload = std::shared_ptr<const std::string>;
+
+    struct Entry {
+        std::uint32_t id{};
+        Payload payload;
+        // Ожидание Ack: таймер в колесе таймеров и счётчик ретраев.
+        // awaiting_ack == false — ретраи исчерпаны или отправка не
+        // удалась, сообщение ждёт /повтор. Меняется только через
+        // set_awaiting_ack(): outbox ведёт счёт ожидающих
+        bool awaiting_ack{true};
+        net::TimerWheel::TimerId timer{net::TimerWheel::NO_TIMER};
+        int retry_count{};
+        bool ping_for_ack_requested{false};
+        // Повтор по таймеру не принят переполненной очередью отправки и
+        // ждёт готовности сокета к записи
+        bool retransmit_deferred{false};
+        // Отправлено по текущему соединению и занимает место в окне
+        // отправки; false — ждёт своей очереди в outbox
+        bool sent{false};
+        // Уходило в сеть под текущим id хоть по какому-то соединению:
+        // только такое собеседник мог получить до обрыва связи
+        bool transmitted{false};
+        // Момент последней отправки: замер RTT по подтверждению
+        std::chrono::steady_clock::time_point sent_at{};
+    };
+
+    using const_iterator = std::list<Entry>::const_iterator;
+
+    explicit Outbox(std::size_t capacity);
+
+    // Добавить сообщение, ожидающее Ack. Если id уже есть,
+    // старая запись заменяется. При переполнении возвращает вытесненную
+    // самую старую запись — её таймер нужно отменить
+    auto add(std::uint32_t msg_id, std::string payload)
+        -> std::optional<Entry>;
+
+    // Запись по id или nullptr
+    [[nodiscard]]
+    auto find(std::uint32_t msg_id) -> Entry*;
+
+    // Сменить id записи (повторная отправка под новым id) и перенести её
+    // в конец. nullptr — старого id нет
+    auto rekey(std::uint32_t old_id, std::uint32_t new_id) -> Entry*;
+
+    // Удалить запись (сообщение доставлено). false — id нет
+    auto erase(std::uint32_t msg_id) -> bool;
+
+    // Начать или прекратить ожидание Ack записи
+    void set_awaiting_ack(Entry& entry, bool awaiting);
+
+    // Число записей, ждущих Ack, — O(1), без обхода
+    [[nodiscard]]
+    auto awaiting_count() const -> std::size_t;
+
+    // Удалить отправленные (sent) записи, подтверждённые кадром Sack: id
+    // не позже накопительной границы или внутри одного из блоков.
+    // Записи, ждущие очереди, не трогаются. Удалённые записи попадают в
+    // settled (прежнее содержимое стирается, ёмкость переиспользуется)
+    // в порядке id — их таймеры нужно отменить. Закрытое границей
+    // снимается с начала списка, блоки сверяются по хеш-таблице: цена —
+    // число закрытых записей плюс длина блоков, но не больше outbox
+    void settle(std::uint32_t cumulative,
+                std::span<const proto::SackRange> ranges,
+                std::vector<Entry>& settled);
+
+    // Обход в порядке id
+    [[nodiscard]]
+    auto begin() const -> const_iterator;
+    [[nodiscard]]
+    auto end() const -> const_iterator;
+
+    [[nodiscard]]
+    auto size() const -> std::size_t;
+
+    [[nodiscard]]
+    auto capacity() const -> std::size_t;
+
+private:
+    // Перенести запись в settled; возвращает следующий узел
+    auto settleNode(std::list<Entry>::iterator node,
+                    std::vector<Entry>& settled)
+        -> std::list<Entry>::iterator;
+
+    std::size_t capacity_;
+    std::size_t awaiting_{0};
+    std::list<Entry> entries_;
+    std::unordered_map<std::uint32_t, std::list<Entry>::iterator> by_id_;
+};
+
+}  // namespace messenger::app
@@ -0,0 +1,201 @@
+#include "app/outbox_log.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "app/outbox.h"
+#include "utils/async_appender.h"
+
+namespace messenger::app {
+
+namespace {
+
+// Виды записей журнала
+enum class RecordKind : std::uint8_t {
+    Add = 1,    // доп. поле — длина текста, за заголовком текст
+    Remove = 2,
+    Rekey = 3   // доп. поле — новый id
+};
+
+// [вид u8][id u32][доп. u32][контрольная сумма u32]
+constexpr std::size_t RECORD_HEADER_SIZE = 13U;
+constexpr std::size_t CHECKSUM_OFFSET = 9U;
+
+// FNV-1a, 32 бита
+constexpr std::uint32_t FNV_OFFSET = 2166136261U;
+constexpr std::uint32_t FNV_PRIME = 16777619U;
+
+[[nodiscard]]
+auto checksum(std::string_view header, std::string_view payload)
+    -> std::uint32_t {
+    std::uint32_t hash = FNV_OFFSET;
+    for (const std::string_view part : {header, payload}) {
+        for (const char byte : part) {
+            hash ^= static_cast<unsigned char>(byte);
+            hash *= FNV_PRIME;
+        }
+    }
+    return hash;
+}
+
+[[nodiscard]]
+auto encodeRecord(RecordKind kind, std::uint32_t msg_id, std::uint32_t aux,
+                  std::string_view payload) -> std::string {
+    std::string record(RECORD_HEADER_SIZE + payload.size(), '\0');
+    record[0] = static_cast<char>(kind);
+    std::memcpy(record.data() + 1, &msg_id, sizeof(msg_id));
+    std::memcpy(record.data() + 5, &aux, sizeof(aux));
+    std::memcpy(record.data() + RECORD_HEADER_SIZE, payload.data(),
+                payload.size());
+
+    const std::uint32_t sum = checksum(
+        std::string_view(record.data(), CHECKSUM_OFFSET), payload);
+    std::memcpy(record.data() + CHECKSUM_OFFSET, &sum, sizeof(sum));
+    return record;
+}
+
+}  // namespace
+
+OutboxLog::OutboxLog(std::string path, Outbox& outbox)
+    : OutboxLog(std::move(path), outbox, utils::AsyncAppender::Options{}) {}
+
+OutboxLog::OutboxLog(std::string path, Outbox& outbox,
+                     utils::AsyncAppender::Options options)
+    : path_(std::move(path)), outbox_(outbox) {
+    replay();
+    recovered_entries_ = outbox_.size();
+    writer_ = std::make_unique<utils::AsyncAppender>(path_, options);
+    checkpoint();
+}
+
+OutboxLog::~OutboxLog() = default;
+
+void OutboxLog::record_add(std::uint32_t msg_id, std::string_view payload) {
+    append(encodeRecord(RecordKind::Add, msg_id,
+                        static_cast<std::uint32_t>(payload.size()), payload));
+}
+
+void OutboxLog::record_remove(std::uint32_t msg_id) {
+    append(encodeRecord(RecordKind::Remove, msg_id, 0, {}));
+    maybeCheckpoint();
+}
+
+void OutboxLog::record_rekey(std::uint32_t old_id, std::uint32_t new_id) {
+    append(encodeRecord(RecordKind::Rekey, old_id, new_id, {}));
+}
+
+void OutboxLog::flush() {
+    writer_->flush();
+}
+
+[[nodiscard]]
+auto OutboxLog::recovered_entries() const -> std::size_t {
+    return recovered_entries_;
+}
+
+[[nodiscard]]
+auto OutboxLog::log_records() const -> std::size_t {
+    return log_records_;
+}
+
+[[nodiscard]]
+auto OutboxLog::checkpoints() const -> std::size_t {
+    return checkpoints_;
+}
+
+[[nodiscard]]
+auto OutboxLog::failed() const -> bool {
+    return writer_->failed();
+}
+
+[[nodiscard]]
+auto OutboxLog::path() const -> const std::string& {
+    return path_;
+}
+
+// Проиграть журнал в outbox до первой повреждённой или оборванной записи
+void OutboxLog::replay() {
+    std::ifstream file(path_, std::ios::binary);
+    if (!file) {
+        return;
+    }
+    const std::string contents{std::istreambuf_iterator<char>(file),
+                               std::istreambuf_iterator<char>()};
+
+    std::size_t offset = 0;
+    while (offset + RECORD_HEADER_SIZE <= contents.size()) {
+        const char* header = contents.data() + offset;
+        const auto kind = static_cast<RecordKind>(header[0]);
+        std::uint32_t msg_id = 0;
+        std::uint32_t aux = 0;
+        std::uint32_t sum = 0;
+        std::memcpy(&msg_id, header + 1, sizeof(msg_id));
+        std::memcpy(&aux, header + 5, sizeof(aux));
+        std::memcpy(&sum, header + CHECKSUM_OFFSET, sizeof(sum));
+
+        const std::size_t payload_size = kind == RecordKind::Add ? aux : 0U;
+        if (offset + RECORD_HEADER_SIZE + payload_size > contents.size()) {
+            break;
+        }
+        const std::string_view payload(header + RECORD_HEADER_SIZE,
+                                       payload_size);
+        if (checksum(std::string_view(header, CHECKSUM_OFFSET), payload) !=
+            sum) {
+            break;
+        }
+
+        switch (kind) {
+            case RecordKind::Add:
+                static_cast<void>(outbox_.add(msg_id, std::string(payload)));
+                break;
+            case RecordKind::Remove:
+                outbox_.erase(msg_id);
+                break;
+            case RecordKind::Rekey:
+                outbox_.rekey(msg_id, aux);
+                break;
+            default:
+                return;
+        }
+        offset += RECORD_HEADER_SIZE + payload_size;
+    }
+}
+
+// Контрольная точка: журнал заменяется снимком живых сообщений. Снимок
+// собирается здесь, а пишется, фиксируется и переименовывается поверх
+// журнала потоком записи — цикл чата диска не ждёт. Записи, поставленные
+// до снимка, уходят в прежний журнал и снимком уже учтены
+void OutboxLog::checkpoint() {
+    std::string snapshot;
+    for (const auto& entry : outbox_) {
+        snapshot += encodeRecord(
+            RecordKind::Add, entry.id,
+            static_cast<std::uint32_t>(entry.payload->size()), *entry.payload);
+    }
+
+    writer_->replace(std::move(snapshot));
+    log_records_ = outbox_.size();
+}
+
+void OutboxLog::maybeCheckpoint() {
+    if (log_records_ > CHECKPOINT_MIN_RECORDS &&
+        log_records_ > CHECKPOINT_RATIO * (outbox_.size() + 1)) {
+        checkpoint();
+        ++checkpoints_;
+    }
+}
+
+void OutboxLog::append(std::string record) {
+    writer_->append(std::move(record));
+    ++log_records_;
+}
+
+}  // namespace messenger::app
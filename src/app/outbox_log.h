@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "app/outbox.h"
+#include "utils/async_appender.h"
+
+namespace messenger::app {
+
+// Журнал упреждающей записи (WAL) для Outbox: неподтверждённые сообщения
+// переживают перезапуск процесса.
+//
+// Каждое изменение outbox — отправка, подтверждение, смена id — ложится
+// в файл записью [вид u8][id u32][доп. u32][контрольная сумма u32][текст].
+// Записи уходят через AsyncAppender, поэтому путь отправки не ждёт диска,
+// а fdatasync() выполняется пачками по его политике. Когда мусорных
+// записей становится намного больше живых, журнал заменяется контрольной
+// точкой: поток записи пишет снимок outbox во временный файл и атомарно
+// переименовывает его поверх журнала. Ошибка записи не бросается, а
+// видна в failed(): журнал перестаёт обновляться.
+//
+// При открытии журнал проигрывается в outbox (оборванная последняя запись
+// отбрасывается) и сразу сжимается до контрольной точки.
+class OutboxLog {
+public:
+    // Сжимать журнал, когда записей в нём больше этого числа и больше
+    // чем CHECKPOINT_RATIO × живых
+    static constexpr std::size_t CHECKPOINT_MIN_RECORDS = 1024U;
+    static constexpr std::size_t CHECKPOINT_RATIO = 4U;
+
+    // Открывает (создаёт) журнал и восстанавливает из него outbox.
+    // При системной ошибке бросает исключение
+    OutboxLog(std::string path, Outbox& outbox);
+    OutboxLog(std::string path, Outbox& outbox,
+              utils::AsyncAppender::Options options);
+
+    ~OutboxLog();
+
+    OutboxLog(const OutboxLog&) = delete;
+    OutboxLog& operator=(const OutboxLog&) = delete;
+    OutboxLog(OutboxLog&&) = delete;
+    OutboxLog& operator=(OutboxLog&&) = delete;
+
+    // Зафиксировать изменения outbox, уже применённые к нему
+    void record_add(std::uint32_t msg_id, std::string_view payload);
+    void record_remove(std::uint32_t msg_id);
+    void record_rekey(std::uint32_t old_id, std::uint32_t new_id);
+
+    // Дождаться записи всех изменений
+    void flush();
+
+    // Сколько сообщений восстановлено при открытии
+    [[nodiscard]]
+    auto recovered_entries() const -> std::size_t;
+
+    // Записей в текущем файле журнала и число контрольных точек
+    [[nodiscard]]
+    auto log_records() const -> std::size_t;
+    [[nodiscard]]
+    auto checkpoints() const -> std::size_t;
+
+    // Запись журнала или контрольной точки не удалась: изменения больше
+    // не сохраняются, файл отстаёт от outbox
+    [[nodiscard]]
+    auto failed() const -> bool;
+
+    [[nodiscard]]
+    auto path() const -> const std::string&;
+
+private:
+    void replay();
+    void checkpoint();
+    void maybeCheckpoint();
+    void append(std::string record);
+
+    std::string path_;
+    Outbox& outbox_;
+    std::unique_ptr<utils::AsyncAppender> writer_;
+
+    std::size_t recovered_entries_{0};
+    std::size_t log_records_{0};
+    std::size_t checkpoints_{0};
+};
+
+}  // namespace messenger::app
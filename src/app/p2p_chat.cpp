@@ -3,10 +3,10 @@
 // NOLINTBEGIN(modernize-deprecated-headers)
 #include <signal.h>
 // NOLINTEND(modernize-deprecated-headers)
-#include <sys/select.h>
-// NOLINTBEGIN(misc-include-cleaner)
-#include <sys/time.h>  // timeval
-// NOLINTEND(misc-include-cleaner)
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
 #include <termios.h>
 #include <unistd.h>
 
@@ -17,27 +17,56 @@
 #include <csignal>
 #include <cstdint>
 #include <cstdlib>
+#include <deque>
+#include <iomanip>
 #include <exception>
-#include <fstream>
+#include <filesystem>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <optional>
+#include <sstream>
+#include <span>
 #include <string>
 #include <string_view>
+#include <system_error>
 #include <unordered_map>
-#include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include "app/ack_retry.h"
+#include "app/delayed_ack.h"
+#include "app/file_transfer.h"
+#include "app/history_index.h"
+#include "app/history_ring.h"
+#include "app/history_store.h"
+#include "app/outbox.h"
+#include "app/outbox_log.h"
+#include "app/rtt_estimator.h"
+#include "app/send_window.h"
+#include "app/session.h"
+#include "net/connection.h"
+#include "net/event_loop.h"
+#include "net/frame_reader.h"
+#include "net/net_api.h"
+#include "net/outbound_queue.h"
+#include "net/timer_wheel.h"
 #include "net/raii_socket.h"
+#include "net/reconnect.h"
+#include "protocol/file_frames.h"
+#include "protocol/hello.h"
 #include "protocol/message.hpp"
 #include "protocol/protocol_api.h"
+#include "protocol/sack.h"
+#include "protocol/serializer.h"
+#include "utils/async_appender.h"
+#include "utils/metrics.h"
 #include "utils/p2p_error.h"
 
 namespace messenger::app {
 
 using Clock = std::chrono::steady_clock;
 
-constexpr int ACK_TIMEOUT_SECONDS = 5;
 constexpr char KEY_BACKSPACE = 127;
 
 // Отдельные параметры для ACK и Ping/Pong
@@ -47,41 +76,124 @@ constexpr int PING_INTERVAL_SECONDS = 10;
 constexpr int PING_TIMEOUT_SECONDS = 3;
 constexpr int MAX_PING_RETRIES = 3;
 
-// Макс. количество хранимых id полученных сообщений
-// При превышении старые идентификаторы удаляются для ограничения роста памяти
-constexpr std::size_t MAX_SEEN_MESSAGE_IDS = 1024U;
+// Ключ таймера Ping/Pong‑watchdog'а в колесе таймеров; ключи таймеров Ack —
+// сами msg_id (32 бита), поэтому с ним не пересекаются
+constexpr std::uint64_t PING_TIMER_KEY = std::uint64_t{1} << 32U;
+
+// Ожидание приветствия собеседника после подключения: собеседник прежних
+// версий его не пришлёт, и тогда outbox повторяется целиком
+constexpr int HELLO_TIMEOUT_SECONDS = 2;
+constexpr std::uint64_t RESUME_TIMER_KEY = PING_TIMER_KEY + 1;
+
+// Срок отложенного подтверждения (app/delayed_ack.h)
+constexpr std::uint64_t DELAYED_ACK_TIMER_KEY = PING_TIMER_KEY + 2;
+
+// Снимок метрик в текстовом формате Prometheus пишется раз в
+// METRICS_EXPORT_SECONDS и при выходе, в файл из переменной окружения
+// MESSENGER_METRICS_FILE (пустое значение отключает экспорт)
+constexpr int METRICS_EXPORT_SECONDS = 15;
+constexpr std::uint64_t METRICS_TIMER_KEY = PING_TIMER_KEY + 3;
+constexpr const char* METRICS_FILE_ENV = "MESSENGER_METRICS_FILE";
+
+// Перцентили задержек в /статистика
+constexpr double STATS_P50 = 0.5;
+constexpr double STATS_P99 = 0.99;
+constexpr double STATS_P999 = 0.999;
+
+// Размер окна дедупликации id полученных сообщений: повтор id, отстающего
+// от наибольшего не дальше окна, распознаётся как дубликат
+constexpr std::size_t DEDUP_WINDOW_SIZE = 4096U;
 
 // Лимит на количество строк истории чата
 constexpr std::size_t MAX_HISTORY_LINES = 10000U;
 
-// Лимит на размер очереди недоставленных сообщений
+// Строк истории на одной странице /история
+constexpr std::size_t HISTORY_PAGE_LINES = 20U;
+
+// Сколько последних строк истории загружается в память при запуске;
+// более старые читаются из файла по мере листания /история
+constexpr std::size_t HISTORY_STARTUP_LINES = 10U * HISTORY_PAGE_LINES;
+
+// Наибольшее число результатов /поиск
+constexpr std::size_t SEARCH_RESULT_LIMIT = 20U;
+
+// Переменная окружения с политикой fsync файлов истории и журнала outbox
+constexpr const char* HISTORY_FSYNC_ENV = "MESSENGER_HISTORY_FSYNC";
+
+// Лимит на число неподтверждённых сообщений в outbox
 constexpr std::size_t MAX_UNDELIVERED_MESSAGES = 1000U;
 
+// Окно получателя в Sack не больше окна дедупликации, иначе повтор
+// старого id мог бы выпасть из окна и быть принят заново
+static_assert(DelayedAck::RECEIVE_WINDOW <= DEDUP_WINDOW_SIZE);
+
+// Передача файлов: байт в полёте сверх подтверждённых получателем,
+// подтверждение не реже чем через столько записанных байт и вывод
+// прогресса не чаще раза в секунду
+constexpr std::uint64_t FILE_WINDOW_BYTES = 4U * 1024U * 1024U;
+constexpr std::uint64_t FILE_ACK_INTERVAL_BYTES = 256U * 1024U;
+constexpr auto FILE_PROGRESS_INTERVAL = std::chrono::seconds(1);
+
+// Режим без терминала: stdin читается блоками такого размера, и пока
+// столько ввода ждёт места в outbox, следующий блок не читается
+constexpr std::size_t PIPE_READ_BLOCK = 64U * 1024U;
+
 // Маска для выделения двух старших битов UTF‑8 байта
 constexpr unsigned char UTF8_LEAD_MASK = 0xC0U;
 
 // Значение двух старших битов для continuation‑byte (10xxxxxx)
 constexpr unsigned char UTF8_CONTINUATION_VALUE = 0x80U;
 
-// Интервал ожидания select() в микросекундах (500 мс)
-constexpr int SELECT_TIMEOUT_USEC = 500000;
-
-struct PendingAck {
-    std::uint32_t id{};
-    Clock::time_point deadline;
-    int retry_count{};
-    std::string last_payload;
-    bool ping_for_ack_requested{false};
-};
-
-struct OutgoingMessage {
-    std::uint32_t message_id{};
-    std::string payload;
-    bool delivered{};
-};
 
 // NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
-std::unordered_map<std::uint32_t, PendingAck> pending_acks{};
+// Неподтверждённые сообщения: ожидание Ack и текст для /повтор в одной
+// записи по msg_id
+Outbox outbox{MAX_UNDELIVERED_MESSAGES};
+// Записи, закрытые последним Sack: буфер переиспользуется между кадрами
+std::vector<Outbox::Entry> settled_entries;
+// id ждущих отправки записей outbox в порядке очереди. Устаревшие id
+// (запись удалена, отправлена или оставлена) отбрасываются при выборке
+std::deque<std::uint32_t> send_queue;
+// id сообщений, чей повтор по таймеру отложен переполненной очередью
+// отправки, в порядке откладывания
+std::deque<std::uint32_t> deferred_retransmits;
+
+// Журнал outbox на диске: неподтверждённые сообщения переживают перезапуск
+const std::string outbox_log_path = "chat_outbox.wal";
+std::unique_ptr<OutboxLog> outbox_log{};
+
+// Следующий id исходящего сообщения
+std::uint32_t next_message_id = 1;
+
+// Окно отправки: сообщения сверх него ждут в outbox
+SendWindow send_window{};
+
+// Оценка RTT по Pong и подтверждениям: таймаут ожидания Ack
+RttEstimator rtt_estimator{};
+
+// Буфер сжатия исходящих Text, переиспользуется между кадрами
+std::string compression_buffer;
+
+// Распакованные входящие Text: кадры разбираются в MessageView прямо из
+// буфера FrameReader, копию текста получает только история
+messenger::proto::ReceiveArena receive_arena;
+
+// Передачи файлов по номеру; принятые файлы — в каталоге
+// received_files_dir
+const std::string received_files_dir = "файлы";
+std::unordered_map<std::uint32_t, std::unique_ptr<OutgoingFile>>
+    outgoing_files{};
+std::unordered_map<std::uint32_t, std::unique_ptr<IncomingFile>>
+    incoming_files{};
+std::uint32_t next_transfer_id = 1;
+Clock::time_point last_file_progress{};
+
+// Дедлайны ожидания Ack и watchdog'а: обработка таймаутов стоит
+// O(наступивших), а не O(ожидающих Ack)
+messenger::net::TimerWheel timer_wheel{};
+messenger::net::TimerWheel::TimerId ping_timer =
+    messenger::net::TimerWheel::NO_TIMER;
+Clock::time_point ping_timer_deadline{};
 
 bool typing_sent = false;
 
@@ -91,24 +203,125 @@ std::string input_buffer;
 // Сохранённые настройки терминала
 termios orig_termios{};
 
-// Set id входящих сообщений для дедупликации
-std::unordered_set<std::uint32_t> seen_message_ids{};
+// Сеанс: id этого запуска, сеанс собеседника, окно id входящих
+// сообщений для дедупликации и непрерывная граница полученных id
+SessionState session{SessionState::generate_session_id(), DEDUP_WINDOW_SIZE};
+
+// Возобновление после подключения: ждём приветствия собеседника, чтобы
+// повторить только не дошедшие до него сообщения
+bool resume_pending = false;
+messenger::net::TimerWheel::TimerId resume_timer =
+    messenger::net::TimerWheel::NO_TIMER;
+// Момент обрыва связи: время до возобновления выводится пользователю
+std::optional<Clock::time_point> link_lost_time{};
+
+// Принятые, но ещё не подтверждённые кадром Sack сообщения
+DelayedAck delayed_ack{};
+messenger::net::TimerWheel::TimerId delayed_ack_timer =
+    messenger::net::TimerWheel::NO_TIMER;
 
 // Переменные Ping/Pong‑watchdog'а
 Clock::time_point last_ping_time = Clock::now();
 Clock::time_point last_pong_time = Clock::now();
 int ping_retry_count = 0;
 
-std::vector<OutgoingMessage> undelivered_messages{};
+// Последний Ping без ответа: Pong с его id — замер RTT. Pong на более
+// ранний Ping не замеряется
+std::uint32_t ping_sequence = 0;
+std::uint32_t outstanding_ping = 0;
+Clock::time_point outstanding_ping_time{};
+
+// Зарегистрированы ли в epoll интерес к записи в сокет и ввод пользователя
+bool write_interest = false;
+bool input_registered = false;
 
 // Для ведения истории сообщений
-std::vector<std::string> chat_history{};
-const std::string history_file_path = "chat_history.txt";
+// Последние строки истории в памяти (хвост history_store): вытеснение
+// старых строк — O(1)
+HistoryRing chat_history{MAX_HISTORY_LINES};
+
+// Постоянная история: chat_history.log и индекс chat_history.idx
+const std::string history_store_path = "chat_history";
+// Текстовая история прежних версий, переносится в history_store один раз
+const std::string legacy_history_file_path = "chat_history.txt";
+
+std::unique_ptr<HistoryStore> history_store{};
+// Полнотекстовый индекс history_store для /поиск (chat_history.fts*)
+std::unique_ptr<HistoryIndex> history_index{};
+
+// Режим без терминала (stdin — не TTY): ввод читается блоками, каждая
+// строка — сообщение; принятые сообщения копятся в pipe_output и пишутся
+// в stdout машиночитаемыми строками перед каждым ожиданием событий.
+// stdin — обычный файл или /dev/null: epoll их не принимает, такой ввод
+// всегда готов к чтению
+bool headless = false;
+bool stdin_pollable = true;
+bool stdin_eof = false;
+// Прочитанный, но ещё не поставленный в outbox ввод
+std::string pipe_input;
+std::string pipe_output;
+
+// Файл снимка метрик для textfile-коллектора node exporter; пустой —
+// экспорт отключён
+std::string metrics_file_path = "chat_metrics.prom";
+messenger::net::TimerWheel::TimerId metrics_timer =
+    messenger::net::TimerWheel::NO_TIMER;
 
 // Флаг завершения из обработчика сигналов
 volatile sig_atomic_t shutdown_requested = 0;
 // NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
 
+// Метрики чата в общем реестре (utils::metrics()): события, которые
+// иначе остаются только строками на экране
+struct ChatMetrics {
+    messenger::utils::Counter& messages_sent;
+    messenger::utils::Counter& messages_received;
+    messenger::utils::Counter& duplicates;
+    messenger::utils::Counter& retransmits;
+    messenger::utils::Counter& undelivered;
+    messenger::utils::Counter& pings_unanswered;
+    messenger::utils::Counter& links_lost;
+    messenger::utils::Counter& protocol_errors;
+    messenger::utils::Histogram& ack_rtt;
+    messenger::utils::Histogram& ping_rtt;
+};
+
+[[nodiscard]]
+auto chatMetrics() -> const ChatMetrics& {
+    auto& registry = messenger::utils::metrics();
+    static const ChatMetrics metrics{
+        registry.counter("messenger_messages_sent_total",
+                         "Сообщений отправлено"),
+        registry.counter("messenger_messages_received_total",
+                         "Сообщений получено"),
+        registry.counter("messenger_duplicate_messages_total",
+                         "Повторов входящих сообщений отброшено"),
+        registry.counter("messenger_retransmits_total",
+                         "Повторных отправок по таймауту Ack"),
+        registry.counter("messenger_undelivered_messages_total",
+                         "Сообщений не доставлено"),
+        registry.counter("messenger_pings_unanswered_total",
+                         "Ping без ответа"),
+        registry.counter("messenger_link_lost_total",
+                         "Потерь связи по Ping/Pong"),
+        registry.counter("messenger_protocol_errors_total",
+                         "Фатальных ошибок протокола"),
+        registry.histogram("messenger_ack_rtt_microseconds",
+                           "RTT по подтверждениям, мкс"),
+        registry.histogram("messenger_ping_rtt_microseconds",
+                           "RTT по Ping/Pong, мкс"),
+    };
+    return metrics;
+}
+
+[[nodiscard]]
+auto toMicroseconds(Clock::duration duration) -> std::uint64_t {
+    const auto micros =
+        std::chrono::duration_cast<std::chrono::microseconds>(duration)
+            .count();
+    return micros > 0 ? static_cast<std::uint64_t>(micros) : 0U;
+}
+
 // Включение raw‑mode терминала
 void enableRawMode() {
     if (tcgetattr(STDIN_FILENO, &orig_termios) == -1) {
@@ -159,33 +372,23 @@ void handleExitSignal([[maybe_unused]] int signal_number) {
 
 // Перерисовка строки ввода
 void clearInputLine() {  // Стереть текущую строку
-    std::cout << "\r\033[K" << std::flush;
+    if (!headless) {
+        std::cout << "\r\033[K" << std::flush;
+    }
 }
 
 void redrawInput() {  // Перерисовать вновь строку
-    std::cout << "\r> " << input_buffer << "\033[K" << std::flush;
-}
-
-[[nodiscard]]
-auto generateMessageId() -> std::uint32_t {
-    static std::uint32_t next_id = 1;
-    if (next_id == std::numeric_limits<std::uint32_t>::max()) {
-        next_id = 1;
+    if (!headless) {
+        std::cout << "\r> " << input_buffer << "\033[K" << std::flush;
     }
-    return next_id++;
 }
 
 [[nodiscard]]
-auto isDuplicate(std::uint32_t msg_id) -> bool {
-    return seen_message_ids.find(msg_id) != seen_message_ids.end();
-}
-
-void rememberMessageId(std::uint32_t msg_id) {
-    seen_message_ids.insert(msg_id);
-    // Ограничитель размера для защиты от бесконечного роста
-    if (seen_message_ids.size() > MAX_SEEN_MESSAGE_IDS) {
-        seen_message_ids.clear();
+auto generateMessageId() -> std::uint32_t {
+    if (next_message_id == std::numeric_limits<std::uint32_t>::max()) {
+        next_message_id = 1;
     }
+    return next_message_id++;
 }
 
 // Удалять UTF‑8 символы
@@ -205,41 +408,210 @@ void eraseLastUtf8Char(std::string& text) {
     text.erase(index);
 }
 
-void resendMessage(int socket_fd, OutgoingMessage& outgoing_message) {
+// (Пере)запустить таймер ожидания Ack на текущий RTO
+void armAckTimer(Outbox::Entry& entry, Clock::time_point now) {
+    timer_wheel.cancel(entry.timer);
+    entry.timer = timer_wheel.schedule(now + rtt_estimator.rto(), entry.id);
+}
+
+// Замер RTT по подтверждению сообщения. Правило Карна: повторённое
+// сообщение не замеряется
+void sampleAckRtt(const Outbox::Entry& entry, Clock::time_point now) {
+    if (entry.sent && entry.retry_count == 0 &&
+        !entry.ping_for_ack_requested) {
+        rtt_estimator.on_sample(
+            std::chrono::duration_cast<RttEstimator::Duration>(
+                now - entry.sent_at));
+        chatMetrics().ack_rtt.record(toMicroseconds(now - entry.sent_at));
+    }
+}
+
+// Сообщение покинуло полёт без подтверждения: место в окне свободно
+void leaveFlight(Outbox::Entry& entry) {
+    if (entry.sent) {
+        entry.sent = false;
+        send_window.on_drop(1);
+    }
+}
+
+// Прекратить ожидание Ack: сообщение остаётся в outbox для /повтор
+void stopAwaitingAck(Outbox::Entry& entry) {
+    timer_wheel.cancel(entry.timer);
+    entry.timer = messenger::net::TimerWheel::NO_TIMER;
+    outbox.set_awaiting_ack(entry, false);
+    entry.retransmit_deferred = false;
+    leaveFlight(entry);
+}
+
+// Поставить новое сообщение в outbox; в сеть его отправит pumpOutbox(),
+// когда позволит окно
+void queueMessage(std::uint32_t msg_id, std::string payload) {
+    chatMetrics().messages_sent.add();
+    if (Outbox::Entry* previous = outbox.find(msg_id)) {
+        timer_wheel.cancel(previous->timer);  // на случай повторного msg_id
+        leaveFlight(*previous);
+    }
+    auto evicted = outbox.add(msg_id, std::move(payload));
+    send_queue.push_back(msg_id);
+    if (outbox_log) {
+        outbox_log->record_add(msg_id, *outbox.find(msg_id)->payload);
+    }
+    if (evicted) {
+        timer_wheel.cancel(evicted->timer);
+        leaveFlight(*evicted);
+        if (outbox_log) {
+            outbox_log->record_remove(evicted->id);
+        }
+    }
+}
+
+// Взвести таймер отложенного подтверждения на его срок
+void scheduleDelayedAck() {
+    const auto deadline = delayed_ack.deadline();
+    if (deadline &&
+        delayed_ack_timer == messenger::net::TimerWheel::NO_TIMER) {
+        delayed_ack_timer =
+            timer_wheel.schedule(*deadline, DELAYED_ACK_TIMER_KEY);
+    }
+}
+
+// Отправить отложенное подтверждение: накопительная граница и блоки SACK
+// закрывают все принятые с прошлого Sack сообщения одним кадром
+void flushDelayedAck(messenger::net::Connection& conn) {
+    if (!delayed_ack.pending()) {
+        return;
+    }
+    timer_wheel.cancel(delayed_ack_timer);
+    delayed_ack_timer = messenger::net::TimerWheel::NO_TIMER;
+    delayed_ack.reset();
+
+    const auto boundary = session.last_received();
+    if (!boundary) {
+        return;
+    }
+    auto blocks = session.sack_blocks();
+    blocks.window = DelayedAck::receive_window(conn);
+    if (!messenger::proto::send_sack(conn, *boundary, blocks)) {
+        clearInputLine();
+        std::cout << "\n[Ошибка: не удалось отправить подтверждение]\n";
+        redrawInput();
+    }
+}
+
+// Канал разгрузился: собеседнику, остановленному нулевым окном, нужен
+// Sack с открытым окном, даже если новых сообщений от него не было
+void requestWindowUpdate() {
+    if (!session.last_received() ||
+        !session.peer_supports(messenger::proto::Hello::FEATURE_SACK)) {
+        return;
+    }
+    delayed_ack.request_update(Clock::now());
+    scheduleDelayedAck();
+}
+
+// Подтвердить принятый Text. Собеседнику прежней версии — Ack сразу,
+// иначе подтверждение откладывается и копится. false — Ack не отправлен
+[[nodiscard]]
+auto acknowledgeReceived(messenger::net::Connection& conn,
+                         std::uint32_t msg_id) -> bool {
+    if (!session.peer_supports(messenger::proto::Hello::FEATURE_SACK)) {
+        return messenger::proto::send_ack(conn, msg_id);
+    }
+    if (delayed_ack.on_received(Clock::now())) {
+        flushDelayedAck(conn);
+    } else {
+        scheduleDelayedAck();
+    }
+    return true;
+}
+
+// Отправка Text; отложенное подтверждение уходит попутно, перед ним.
+// Собеседнику, объявившему сжатие, длинный текст уходит сжатым
+[[nodiscard]]
+auto sendText(messenger::net::Connection& conn, std::string_view text,
+              std::uint32_t msg_id) -> bool {
+    flushDelayedAck(conn);
+    if (session.peer_supports(messenger::proto::Hello::FEATURE_COMPRESSION)) {
+        return messenger::proto::send_text_compressed(conn, text, msg_id,
+                                                      compression_buffer);
+    }
+    return messenger::proto::send_text(conn, text, msg_id);
+}
+
+// Отправить ждущие в outbox сообщения, пока позволяет окно отправки.
+// Они берутся из головы send_queue, так что цена вызова не зависит от
+// размера outbox. Пока не получено приветствие собеседника, очередь
+// стоит: возобновление решит, что из неё уже доставлено, и соберёт её
+// заново. Возвращает число отправленных
+auto pumpOutbox(messenger::net::Connection& conn) -> std::size_t {
+    if (resume_pending) {
+        return 0;
+    }
+
+    const auto now = Clock::now();
+    std::size_t sent = 0;
+    while (!send_queue.empty() && send_window.can_send()) {
+        const std::uint32_t msg_id = send_queue.front();
+        Outbox::Entry* queued = outbox.find(msg_id);
+        if (queued == nullptr || !queued->awaiting_ack || queued->sent) {
+            send_queue.pop_front();
+            continue;
+        }
+        Outbox::Entry& entry = *queued;
+        // Очередь отправки переполнена: остаток уйдёт после её разгрузки
+        if (!sendText(conn, *entry.payload, msg_id)) {
+            break;
+        }
+        send_queue.pop_front();
+        entry.sent = true;
+        entry.transmitted = true;
+        entry.sent_at = now;
+        entry.retry_count = 0;
+        entry.ping_for_ack_requested = false;
+        send_window.on_send();
+        armAckTimer(entry, now);
+        ++sent;
+    }
+    return sent;
+}
+
+void resendMessage(messenger::net::Connection& conn, Outbox::Entry& entry) {
     const std::uint32_t new_message_id = generateMessageId();
 
-    // Удалить старый pending_acks, чтобы не остались "висящие" ретраи
-    pending_acks.erase(outgoing_message.message_id);
+    // Остановить ретраи старого id, чтобы не остались "висящие" таймеры
+    stopAwaitingAck(entry);
 
-    if (!messenger::proto::send_text(socket_fd, outgoing_message.payload,
-                                     new_message_id)) {
+    if (!sendText(conn, *entry.payload, new_message_id)) {
         std::cout << "\n[Ошибка: не удалось повторно отправить сообщение]\n";
         return;
     }
 
-    outgoing_message.message_id = new_message_id;
-    outgoing_message.delivered = false;
-
-    PendingAck ack_state{};
-    ack_state.id = new_message_id;
-    ack_state.deadline =
-        Clock::now() + std::chrono::seconds(ACK_TIMEOUT_SECONDS);
-    ack_state.retry_count = 0;
-    ack_state.last_payload = outgoing_message.payload;
-    pending_acks[new_message_id] = ack_state;
+    // Тот же текст под новым id: запись переименовывается, не копируется
+    const std::uint32_t old_message_id = entry.id;
+    Outbox::Entry& resent = *outbox.rekey(old_message_id, new_message_id);
+    if (outbox_log) {
+        outbox_log->record_rekey(old_message_id, new_message_id);
+    }
+    outbox.set_awaiting_ack(resent, true);
+    resent.retry_count = 0;
+    resent.ping_for_ack_requested = false;
+    // Ручной повтор уходит сразу, вне окна, но занимает в нём место
+    resent.sent = true;
+    resent.transmitted = true;
+    resent.sent_at = Clock::now();
+    send_window.on_send();
+    armAckTimer(resent, resent.sent_at);
 
     std::cout << "\n[Повторная отправка msg_id=" << new_message_id << "]\n";
 }
 
 // Обработка команды /повтор
-void handleRepeatCommand(int socket_fd, const std::string& command_text) {
+void handleRepeatCommand(messenger::net::Connection& conn,
+                         const std::string& command_text) {
     if (command_text == "/повтор") {
         std::cout << "\nНедоставленные сообщения:\n";
-        for (const auto& outgoing_message : undelivered_messages) {
-            if (!outgoing_message.delivered) {
-                std::cout << "id=" << outgoing_message.message_id << ": "
-                          << outgoing_message.payload << '\n';
-            }
+        for (const auto& entry : outbox) {
+            std::cout << "id=" << entry.id << ": " << *entry.payload << '\n';
         }
         return;
     }
@@ -260,55 +632,790 @@ void handleRepeatCommand(int socket_fd, const std::string& command_text) {
         return;
     }
 
-    for (auto& outgoing_message : undelivered_messages) {
-        if (outgoing_message.message_id == message_id_value &&
-            !outgoing_message.delivered) {
-            resendMessage(socket_fd, outgoing_message);
-            return;
-        }
+    if (Outbox::Entry* entry = outbox.find(message_id_value)) {
+        resendMessage(conn, *entry);
+        return;
     }
 
     std::cout << "\n[Сообщение с id=" << message_id_value
               << " не найдено среди недоставленных]\n";
 }
 
-void appendToHistoryFile(const std::string& history_line) {
-    std::ofstream history_file(history_file_path, std::ios::app);
-    if (!history_file) {
+// Политика fdatasync() файлов истории и журнала outbox из переменной
+// окружения MESSENGER_HISTORY_FSYNC: none / always / <N>ms
+[[nodiscard]]
+auto durabilityOptions() -> messenger::utils::AsyncAppender::Options {
+    using messenger::utils::AsyncAppender;
+
+    AsyncAppender::Options options{};
+    // NOLINTNEXTLINE(concurrency-mt-unsafe)
+    if (const char* policy = std::getenv(HISTORY_FSYNC_ENV)) {
+        const auto parsed = AsyncAppender::parse_durability(policy);
+        if (parsed) {
+            options = *parsed;
+        } else {
+            std::cout << "[Неизвестная политика " << HISTORY_FSYNC_ENV << "="
+                      << policy << ", используется fsync раз в "
+                      << options.sync_interval.count() << " мс]\n";
+        }
+    }
+    return options;
+}
+
+// Открытие журнала outbox: сообщения, не подтверждённые до прошлого
+// завершения, возвращаются в outbox
+void openOutboxLog(const messenger::utils::AsyncAppender::Options& options) {
+    try {
+        outbox_log =
+            std::make_unique<OutboxLog>(outbox_log_path, outbox, options);
+    } catch (const std::exception& error) {
+        std::cout << "[Неподтверждённые сообщения не будут сохраняться: "
+                  << error.what() << "]\n";
+        return;
+    }
+
+    // Новые id не должны совпасть с восстановленными
+    for (const auto& entry : outbox) {
+        if (entry.id >= next_message_id &&
+            entry.id != std::numeric_limits<std::uint32_t>::max()) {
+            next_message_id = entry.id + 1;
+        }
+    }
+}
+
+// Журнал outbox не удалось дописать или сжать (диск заполнен, ошибка
+// ввода-вывода): он отключается, как поиск по истории при ошибке индекса.
+// Отставший файл удаляется — иначе следующий запуск вернул бы в outbox
+// уже доставленные сообщения
+void checkOutboxLog() {
+    if (!outbox_log || !outbox_log->failed()) {
         return;
     }
-    history_file << history_line << '\n';
+    outbox_log.reset();
+    std::error_code ignored;
+    std::filesystem::remove(outbox_log_path, ignored);
+
+    clearInputLine();
+    std::cout << "\n[Неподтверждённые сообщения больше не сохраняются: "
+                 "ошибка записи журнала]\n";
+    redrawInput();
 }
 
-void loadHistoryFromFile() {
-    std::ifstream history_file(history_file_path);
-    if (!history_file) {
+// Снимок метрик в файл metrics_file_path. Ошибка записи сообщается один
+// раз, дальше экспорт отключён
+void exportMetrics() {
+    if (metrics_file_path.empty()) {
         return;
     }
+    try {
+        messenger::utils::metrics().export_prometheus(metrics_file_path);
+    } catch (const std::exception& error) {
+        clearInputLine();
+        std::cout << "\n[Метрики не будут сохраняться: " << error.what()
+                  << "]\n";
+        redrawInput();
+        metrics_file_path.clear();
+    }
+}
 
-    std::string history_line;
-    while (std::getline(history_file, history_line)) {
-        chat_history.push_back(history_line);
+void scheduleMetricsExport(Clock::time_point now) {
+    if (metrics_file_path.empty()) {
+        return;
     }
+    metrics_timer = timer_wheel.schedule(
+        now + std::chrono::seconds(METRICS_EXPORT_SECONDS), METRICS_TIMER_KEY);
 }
 
-void showHistory() {
-    std::cout << "\nИстория сообщений:\n";
-    for (const auto& history_line : chat_history) {
-        std::cout << history_line << '\n';
+// Путь снимка метрик из переменной окружения MESSENGER_METRICS_FILE и
+// первый таймер экспорта
+void openMetricsExport() {
+    // NOLINTNEXTLINE(concurrency-mt-unsafe)
+    if (const char* path = std::getenv(METRICS_FILE_ENV)) {
+        metrics_file_path = path;
     }
+    scheduleMetricsExport(Clock::now());
 }
 
+// id очередного Ping (не 0); момент отправки запоминается для замера RTT
 [[nodiscard]]
-auto handleIncomingMessage(int sock_fd,
-                           const messenger::proto::Message& msg) -> bool {
+auto nextPingId() -> std::uint32_t {
+    if (++ping_sequence == 0) {
+        ping_sequence = 1;
+    }
+    outstanding_ping = ping_sequence;
+    outstanding_ping_time = Clock::now();
+    return ping_sequence;
+}
+
+// Наименьший id, который мы ещё можем отправить: самый ранний в outbox
+// или следующий новый. Всё до него собеседник может считать полученным
+[[nodiscard]]
+auto firstPendingId() -> std::uint32_t {
+    std::uint32_t first = next_message_id;
+    if (first == std::numeric_limits<std::uint32_t>::max()) {
+        first = 1;  // generateMessageId() перейдёт на 1
+    }
+    for (const auto& entry : outbox) {
+        if (entry.id != first && SessionState::covered_by(entry.id, first)) {
+            first = entry.id;
+        }
+    }
+    return first;
+}
+
+// Отправить приветствие сеанса: наш session_id, непрерывная граница
+// полученных от собеседника id и начало наших неподтверждённых
+[[nodiscard]]
+auto sendHello(messenger::net::Connection& conn) -> bool {
+    messenger::proto::Hello hello = session.hello();
+    hello.first_pending = firstPendingId();
+    return messenger::proto::send_ping(
+        conn, nextPingId(), messenger::proto::encode_hello(hello));
+}
+
+// Размер в мегабайтах с одним знаком после запятой
+[[nodiscard]]
+auto formatMegabytes(double bytes) -> std::string {
+    constexpr double BYTES_PER_MEGABYTE = 1024.0 * 1024.0;
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << bytes / BYTES_PER_MEGABYTE;
+    return out.str();
+}
+
+// Прогресс передачи файла; промежуточный — не чаще раза в секунду
+void reportFileProgress(std::string_view direction, const std::string& name,
+                        std::uint64_t done, std::uint64_t size, double rate) {
+    const auto now = Clock::now();
+    if (now - last_file_progress < FILE_PROGRESS_INTERVAL) {
+        return;
+    }
+    last_file_progress = now;
+
+    constexpr std::uint64_t FULL_PERCENT = 100U;
+    const std::uint64_t percent =
+        size == 0 ? FULL_PERCENT : done * FULL_PERCENT / size;
+    clearInputLine();
+    std::cout << "\n[" << direction << " " << name << ": "
+              << formatMegabytes(static_cast<double>(done)) << " из "
+              << formatMegabytes(static_cast<double>(size)) << " МБ ("
+              << percent << "%), " << formatMegabytes(rate) << " МБ/с]\n";
+    redrawInput();
+}
+
+// Файлы, изменённые или укороченные после предложения, дальше не
+// отправляются: получатель собрал бы из кусков разных версий испорченный
+// файл
+void abortChangedFiles() {
+    for (auto transfer = outgoing_files.begin();
+         transfer != outgoing_files.end();) {
+        if (!transfer->second->source_changed()) {
+            ++transfer;
+            continue;
+        }
+        clearInputLine();
+        std::cout << "\n[Ошибка: файл " << transfer->second->name()
+                  << " изменён во время отправки, передача прервана]\n";
+        redrawInput();
+        transfer = outgoing_files.erase(transfer);
+    }
+}
+
+// Отправить куски файлов, пока позволяют окно передачи и очередь
+// отправки. Следующий кусок ставится, только когда предыдущий целиком
+// ушёл в сокет: Text между кусками не ждёт за мегабайтами файла
+void pumpFiles(messenger::net::Connection& conn) {
+    abortChangedFiles();
+    for (auto& [transfer_id, transfer] : outgoing_files) {
+        while (!conn.outbound().file_pending() &&
+               !conn.outbound().above_high_watermark()) {
+            const std::size_t length = transfer->next_chunk(FILE_WINDOW_BYTES);
+            if (length == 0 ||
+                !messenger::proto::send_file_chunk(conn, transfer_id,
+                                                   transfer->fd(),
+                                                   transfer->sent(), length)) {
+                break;
+            }
+            transfer->on_chunk_sent(length);
+        }
+    }
+}
+
+// Команда /файл <путь>: предложить файл собеседнику. Куски пойдут после
+// его ответа — с начала или с места, где оборвалась прошлая передача
+void startFileTransfer(messenger::net::Connection& conn,
+                       const std::string& command_text) {
+    constexpr std::string_view COMMAND = "/файл";
+    std::string_view path = command_text;
+    path.remove_prefix(COMMAND.size());
+    while (!path.empty() && path.front() == ' ') {
+        path.remove_prefix(1);
+    }
+    if (path.empty()) {
+        std::cout << "[Использование: /файл <путь>]\n";
+        return;
+    }
+    if (!session.peer_supports(messenger::proto::Hello::FEATURE_FILES)) {
+        std::cout << "[Собеседник не поддерживает приём файлов]\n";
+        return;
+    }
+
+    std::unique_ptr<OutgoingFile> transfer;
+    try {
+        transfer =
+            std::make_unique<OutgoingFile>(next_transfer_id, std::string(path));
+    } catch (const std::exception& error) {
+        std::cout << "[Ошибка: файл не открыт: " << error.what() << "]\n";
+        return;
+    }
+
+    const std::uint32_t transfer_id = next_transfer_id++;
+    if (!messenger::proto::send_file_offer(conn, transfer_id,
+                                           transfer->offer())) {
+        std::cout << "[Ошибка: предложение файла не отправлено]\n";
+        return;
+    }
+    std::cout << "[Отправка файла " << transfer->name() << " ("
+              << formatMegabytes(static_cast<double>(transfer->size()))
+              << " МБ): ожидание ответа собеседника]\n";
+    outgoing_files.emplace(transfer_id, std::move(transfer));
+}
+
+// Все байты входящего файла приняты: .part становится файлом
+void finishIncomingFile(std::uint32_t transfer_id) {
+    const auto found = incoming_files.find(transfer_id);
+    const IncomingFile& incoming = *found->second;
+    const double rate = incoming.throughput(Clock::now());
+    clearInputLine();
+    try {
+        const std::string path = found->second->finish();
+        std::cout << "\n[Файл принят: " << path << ", "
+                  << formatMegabytes(static_cast<double>(incoming.size()))
+                  << " МБ, " << formatMegabytes(rate) << " МБ/с]\n";
+    } catch (const std::exception& error) {
+        std::cout << "\n[Ошибка: файл " << incoming.name()
+                  << " не сохранён: " << error.what() << "]\n";
+    }
+    redrawInput();
+    incoming_files.erase(found);
+}
+
+// FileOffer: открыть .part и ответить, с какого места продолжать.
+// false — повреждённый кадр
+[[nodiscard]]
+auto handleFileOffer(messenger::net::Connection& conn,
+                     const messenger::proto::MessageView& msg) -> bool {
+    const auto offer = messenger::proto::decode_file_offer(msg.payload);
+    if (!offer) {
+        return false;
+    }
+
+    auto found = incoming_files.find(msg.id);
+    if (found == incoming_files.end() || !found->second->matches(*offer)) {
+        std::unique_ptr<IncomingFile> incoming;
+        clearInputLine();
+        try {
+            incoming =
+                std::make_unique<IncomingFile>(received_files_dir, *offer);
+        } catch (const std::exception& error) {
+            // Без ответа на FileOffer отправитель кусков не шлёт
+            std::cout << "\n[Ошибка: файл " << offer->name
+                      << " не может быть принят: " << error.what() << "]\n";
+            redrawInput();
+            return true;
+        }
+        std::cout << "\n[Приём файла " << offer->name << " ("
+                  << formatMegabytes(static_cast<double>(offer->size))
+                  << " МБ)";
+        if (incoming->received() != 0) {
+            std::cout << ", продолжение с "
+                      << formatMegabytes(
+                             static_cast<double>(incoming->received()))
+                      << " МБ";
+        }
+        std::cout << "]\n";
+        redrawInput();
+        found =
+            incoming_files.insert_or_assign(msg.id, std::move(incoming)).first;
+    }
+
+    IncomingFile& incoming = *found->second;
+    if (!messenger::proto::send_file_ack(conn, msg.id, incoming.received())) {
+        clearInputLine();
+        std::cout << "\n[Ошибка: не удалось ответить на предложение файла]\n";
+        redrawInput();
+        return true;
+    }
+    incoming.on_ack_sent();
+    if (incoming.complete()) {
+        finishIncomingFile(msg.id);
+    }
+    return true;
+}
+
+// FileChunk: кусок пишется на диск прямо из буфера приёма кадров.
+// false — повреждённый кадр или кусок за дырой
+[[nodiscard]]
+auto handleFileChunk(messenger::net::Connection& conn,
+                     std::span<const std::uint8_t> frame) -> bool {
+    const auto chunk = messenger::proto::parse_file_chunk(frame);
+    if (!chunk) {
+        return false;
+    }
+    const auto found = incoming_files.find(chunk->transfer_id);
+    if (found == incoming_files.end()) {
+        return true;  // приём отменён: файл не удалось открыть или записать
+    }
+
+    IncomingFile& incoming = *found->second;
+    try {
+        if (!incoming.write(chunk->offset, chunk->data)) {
+            return false;
+        }
+    } catch (const std::system_error& error) {
+        clearInputLine();
+        std::cout << "\n[Ошибка записи файла " << incoming.name() << ": "
+                  << error.what() << "]\n";
+        redrawInput();
+        incoming_files.erase(found);
+        return true;
+    }
+
+    if (incoming.ack_due(FILE_ACK_INTERVAL_BYTES) &&
+        messenger::proto::send_file_ack(conn, chunk->transfer_id,
+                                        incoming.received())) {
+        incoming.on_ack_sent();
+    }
+    if (incoming.complete()) {
+        finishIncomingFile(chunk->transfer_id);
+        return true;
+    }
+    reportFileProgress("Приём", incoming.name(), incoming.received(),
+                       incoming.size(), incoming.throughput(Clock::now()));
+    return true;
+}
+
+// FileAck: подтверждённые байты освобождают окно передачи.
+// false — повреждённый кадр
+[[nodiscard]]
+auto handleFileAck(messenger::net::Connection& conn,
+                   const messenger::proto::MessageView& msg) -> bool {
+    const auto offset = messenger::proto::decode_file_offset(msg.payload);
+    if (!offset) {
+        return false;
+    }
+    const auto found = outgoing_files.find(msg.id);
+    if (found == outgoing_files.end()) {
+        return true;  // передача уже завершена
+    }
+
+    OutgoingFile& transfer = *found->second;
+    const bool resumed = !transfer.accepted() && *offset != 0;
+    transfer.on_ack(*offset);
+    const auto now = Clock::now();
+
+    if (transfer.complete()) {
+        clearInputLine();
+        std::cout << "\n[Файл " << transfer.name() << " отправлен: "
+                  << formatMegabytes(static_cast<double>(transfer.size()))
+                  << " МБ, " << formatMegabytes(transfer.throughput(now))
+                  << " МБ/с]\n";
+        redrawInput();
+        outgoing_files.erase(found);
+        return true;
+    }
+    if (resumed) {
+        clearInputLine();
+        std::cout << "\n[Файл " << transfer.name() << ": продолжение с "
+                  << formatMegabytes(static_cast<double>(*offset))
+                  << " МБ]\n";
+        redrawInput();
+    }
+    reportFileProgress("Отправка", transfer.name(), transfer.acked(),
+                       transfer.size(), transfer.throughput(now));
+    pumpFiles(conn);
+    return true;
+}
+
+// Связь потеряна: передачи ждут ответа на новое предложение
+void suspendFileTransfers() {
+    for (auto& [transfer_id, transfer] : outgoing_files) {
+        transfer->suspend();
+    }
+}
+
+// Новое соединение: повторить предложения прерванных передач. Получатель
+// ответит, сколько уже записано в его .part
+void offerSuspendedFiles(messenger::net::Connection& conn) {
+    if (!session.peer_supports(messenger::proto::Hello::FEATURE_FILES)) {
+        return;
+    }
+    abortChangedFiles();
+    for (const auto& [transfer_id, transfer] : outgoing_files) {
+        if (!transfer->accepted() &&
+            !messenger::proto::send_file_offer(conn, transfer_id,
+                                               transfer->offer())) {
+            clearInputLine();
+            std::cout << "\n[Ошибка: не удалось возобновить передачу "
+                      << transfer->name() << "]\n";
+            redrawInput();
+        }
+    }
+}
+
+// Связь потеряна: таймеры Ack не должны срабатывать, пока переподключение
+// не закончено, — ретраи в мёртвое соединение бессмысленны
+void suspendAckTimers() {
+    std::vector<std::uint32_t> pending_ids;
+    pending_ids.reserve(outbox.size());
+    for (const auto& entry : outbox) {
+        pending_ids.push_back(entry.id);
+    }
+    for (const std::uint32_t msg_id : pending_ids) {
+        Outbox::Entry& entry = *outbox.find(msg_id);
+        timer_wheel.cancel(entry.timer);
+        entry.timer = messenger::net::TimerWheel::NO_TIMER;
+        entry.sent = false;
+        entry.retransmit_deferred = false;
+    }
+    deferred_retransmits.clear();
+    // Что было в полёте, уйдёт заново: окно начинается сначала
+    send_window.restart();
+    timer_wheel.cancel(resume_timer);
+    resume_timer = messenger::net::TimerWheel::NO_TIMER;
+    resume_pending = false;
+    // Непосланное подтверждение заменит граница в приветствии
+    timer_wheel.cancel(delayed_ack_timer);
+    delayed_ack_timer = messenger::net::TimerWheel::NO_TIMER;
+    delayed_ack.reset();
+}
+
+// Возобновление outbox на новом соединении. Отправленные сообщения до
+// границы delivered_up_to собеседник уже получил (потерялись только
+// Ack) — они удаляются. Ни разу не отправленное граница не закрывает:
+// собеседник его получить не мог. Остальные ожидавшие Ack встают в
+// очередь на повтор с прежними id, чтобы собеседник распознал дубликат,
+// и уходят в порядке id по мере открытия окна отправки. Без границы
+// (собеседник не знает наш сеанс или не прислал приветствия)
+// повторяется всё
+void resumeOutbox(messenger::net::Connection& conn,
+                  std::optional<std::uint32_t> delivered_up_to) {
+    resume_pending = false;
+    timer_wheel.cancel(resume_timer);
+    resume_timer = messenger::net::TimerWheel::NO_TIMER;
+
+    std::vector<std::uint32_t> pending_ids;
+    pending_ids.reserve(outbox.size());
+    for (const auto& entry : outbox) {
+        pending_ids.push_back(entry.id);
+    }
+
+    std::size_t delivered = 0;
+    std::size_t queued = 0;
+    send_queue.clear();
+    for (const std::uint32_t msg_id : pending_ids) {
+        Outbox::Entry& entry = *outbox.find(msg_id);
+        if (delivered_up_to && entry.transmitted &&
+            SessionState::covered_by(msg_id, *delivered_up_to)) {
+            timer_wheel.cancel(entry.timer);
+            leaveFlight(entry);
+            outbox.erase(msg_id);
+            if (outbox_log) {
+                outbox_log->record_remove(msg_id);
+            }
+            ++delivered;
+            continue;
+        }
+        if (entry.awaiting_ack && !entry.sent) {
+            send_queue.push_back(msg_id);
+            ++queued;
+        }
+    }
+    pumpOutbox(conn);
+
+    if (!link_lost_time && delivered == 0 && queued == 0) {
+        return;  // первое подключение, повторять нечего
+    }
+    clearInputLine();
+    if (link_lost_time) {
+        const auto elapsed =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                Clock::now() - *link_lost_time);
+        std::cout << "[Сеанс возобновлён за " << elapsed.count() << " мс";
+        link_lost_time.reset();
+    } else {
+        std::cout << "[Восстановлены неподтверждённые сообщения";
+    }
+    std::cout << ": уже доставлено " << delivered
+              << ", к повторной отправке " << queued << "]\n";
+    redrawInput();
+}
+
+// Приветствие собеседника: сверка сеансов и возобновление outbox
+void handlePeerHello(messenger::net::Connection& conn,
+                     const messenger::proto::Hello& peer_hello) {
+    const SessionState::Resume resume = session.on_peer_hello(peer_hello);
+    // Компактные заголовки — со следующего кадра: приём собеседника
+    // различает формат по первому байту каждого кадра
+    conn.set_header_format(
+        session.peer_supports(messenger::proto::Hello::FEATURE_COMPACT_HEADER)
+            ? messenger::net::HeaderFormat::V2
+            : messenger::net::HeaderFormat::V1);
+    if (resume.peer_restarted) {
+        // Номера передач собеседника начаты заново; его файлы продолжатся
+        // по именам .part
+        incoming_files.clear();
+        clearInputLine();
+        std::cout << "\n[Собеседник перезапущен: нумерация его сообщений "
+                     "начата заново]\n";
+        redrawInput();
+    }
+    if (resume_pending) {
+        resumeOutbox(conn, resume.delivered_up_to);
+    }
+    offerSuspendedFiles(conn);
+}
+
+// Начало работы по новому соединению: сброс watchdog'а, приветствие и
+// ожидание приветствия собеседника
+[[nodiscard]]
+auto startSession(messenger::net::Connection& conn) -> bool {
+    const auto now = Clock::now();
+    last_ping_time = now;
+    last_pong_time = now;
+    ping_retry_count = 0;
+    typing_sent = false;
+    session.begin_connection();
+    send_window.restart();
+
+    if (!sendHello(conn)) {
+        return false;
+    }
+    resume_pending = true;
+    timer_wheel.cancel(resume_timer);
+    resume_timer = timer_wheel.schedule(
+        now + std::chrono::seconds(HELLO_TIMEOUT_SECONDS), RESUME_TIMER_KEY);
+    return true;
+}
+
+// Открытие постоянной истории
+void openHistoryStore(const messenger::utils::AsyncAppender::Options& options) {
+    try {
+        history_store =
+            std::make_unique<HistoryStore>(history_store_path, options);
+    } catch (const std::exception& error) {
+        std::cout << "[История не будет сохраняться: " << error.what()
+                  << "]\n";
+    }
+}
+
+// Однократный перенос chat_history.txt в журнал истории: после переноса
+// текстовый файл переименовывается и больше не читается
+void migrateLegacyHistory() {
+    std::error_code error;
+    if (!history_store || history_store->size() != 0 ||
+        !std::filesystem::exists(legacy_history_file_path, error)) {
+        return;
+    }
+
+    const std::size_t imported =
+        history_store->import_text_file(legacy_history_file_path);
+    std::filesystem::rename(legacy_history_file_path,
+                            legacy_history_file_path + ".migrated", error);
+    std::cout << "[История перенесена из " << legacy_history_file_path
+              << ": " << imported << " строк]\n";
+}
+
+// Открытие индекса /поиск: с диска читается только манифест, в индекс
+// дописываются записи истории после последнего сохранённого сегмента
+void openHistoryIndex() {
+    if (!history_store) {
+        return;
+    }
+    try {
+        history_index =
+            std::make_unique<HistoryIndex>(history_store_path, *history_store);
+    } catch (const std::exception& error) {
+        std::cout << "[Поиск по истории недоступен: " << error.what()
+                  << "]\n";
+    }
+}
+
+// Загрузка в память только последних строк истории: время запуска не
+// зависит от размера файла
+void loadHistoryTail() {
+    if (!history_store) {
+        return;
+    }
+    const std::size_t total = history_store->size();
+    const std::size_t first =
+        total - std::min(total, HISTORY_STARTUP_LINES);
+    for (std::size_t index = first; index < total; ++index) {
+        chat_history.push(history_store->read(index));
+    }
+}
+
+// Запись строки истории: в память и в очередь записи, диск — в фоне
+void addHistoryLine(const std::string& history_line) {
+    chat_history.push(history_line);
+    if (history_store) {
+        history_store->append(history_line);
+    }
+    if (history_index) {
+        try {
+            history_index->add(history_line);
+        } catch (const std::exception& error) {
+            history_index.reset();
+            std::cout << "\n[Поиск по истории отключён: " << error.what()
+                      << "]\n";
+        }
+    }
+}
+
+// Строка истории по номеру: свежие — из памяти, старые — из файла
+[[nodiscard]]
+auto historyLine(std::size_t index, std::size_t total) -> std::string_view {
+    const std::size_t first_in_memory = total - chat_history.size();
+    if (index >= first_in_memory) {
+        return chat_history[index - first_in_memory];
+    }
+    return history_store->read(index);
+}
+
+// Команда /поиск <слова>: последние записи истории, содержащие все слова
+void searchHistory(const std::string& command_text) {
+    const std::size_t space_pos = command_text.find(' ');
+    if (space_pos == std::string::npos ||
+        HistoryIndex::tokenize(command_text.substr(space_pos + 1)).empty()) {
+        std::cout << "\n[Формат: /поиск <слова>]\n";
+        return;
+    }
+    if (!history_index) {
+        std::cout << "\n[Поиск недоступен: история не индексируется]\n";
+        return;
+    }
+
+    const auto started = Clock::now();
+    const std::vector<std::size_t> found = history_index->search(
+        command_text.substr(space_pos + 1), SEARCH_RESULT_LIMIT);
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        Clock::now() - started);
+
+    std::cout << "\nРезультаты поиска (новые сверху):\n";
+    for (const std::size_t entry : found) {
+        std::cout << '#' << entry + 1 << ' ' << history_store->read(entry)
+                  << '\n';
+    }
+    std::cout << "[Найдено: " << found.size()
+              << (found.size() == SEARCH_RESULT_LIMIT ? " (первые)" : "")
+              << ", записей в индексе " << history_index->indexed_entries()
+              << ", " << elapsed.count() << " мкс]\n";
+}
+
+// Команда /история [N]: страница N (1 — самые новые строки) и память,
+// занятая историей
+void showHistory(const std::string& command_text) {
+    std::size_t page = 1;
+    const std::size_t space_pos = command_text.find(' ');
+    if (space_pos != std::string::npos) {
+        try {
+            page = std::stoul(command_text.substr(space_pos + 1));
+        } catch (const std::exception&) {
+            page = 0;
+        }
+        if (page == 0) {
+            std::cout << "\n[Формат: /история [номер страницы]]\n";
+            return;
+        }
+    }
+
+    const std::size_t total =
+        history_store ? history_store->size() : chat_history.size();
+    const std::size_t pages =
+        std::max<std::size_t>(1U, (total + HISTORY_PAGE_LINES - 1) /
+                                      HISTORY_PAGE_LINES);
+    page = std::min(page, pages);
+
+    // Страницы отсчитываются от конца: выводится только окно строк
+    const std::size_t skipped_newer = (page - 1) * HISTORY_PAGE_LINES;
+    const std::size_t last = total - std::min(total, skipped_newer);
+    const std::size_t first = last - std::min(last, HISTORY_PAGE_LINES);
+
+    std::cout << "\nИстория сообщений (страница " << page << " из " << pages
+              << "):\n";
+    for (std::size_t index = first; index < last; ++index) {
+        std::cout << historyLine(index, total) << '\n';
+    }
+    std::cout << "[Строк: " << total << ", в памяти " << chat_history.size()
+              << " из " << chat_history.max_lines() << ", текст "
+              << chat_history.used_bytes() << " байт, память "
+              << chat_history.memory_bytes() << " байт]\n";
+}
+
+// Принятое сообщение в режиме без терминала — строка
+// "msg<TAB>msg_id<TAB>текст". Обратная косая черта, табуляция и переводы
+// строк в тексте экранируются (\\, \t, \n, \r): одна строка вывода —
+// ровно одно сообщение
+void writePipeMessage(std::uint32_t msg_id, std::string_view text) {
+    constexpr std::string_view SPECIAL = "\\\t\n\r";
+    pipe_output += "msg\t";
+    pipe_output += std::to_string(msg_id);
+    pipe_output += '\t';
+    while (!text.empty()) {
+        const std::size_t special = text.find_first_of(SPECIAL);
+        pipe_output += text.substr(0, special);
+        if (special == std::string_view::npos) {
+            break;
+        }
+        switch (text[special]) {
+            case '\t':
+                pipe_output += "\\t";
+                break;
+            case '\n':
+                pipe_output += "\\n";
+                break;
+            case '\r':
+                pipe_output += "\\r";
+                break;
+            default:
+                pipe_output += "\\\\";
+                break;
+        }
+        text.remove_prefix(special + 1);
+    }
+    pipe_output += '\n';
+}
+
+// Накопленные строки pipe_output — в stdout. Читатель stdout закрылся
+// (EPIPE) — вывод отбрасывается, отправка продолжается
+void flushPipeOutput() {
+    std::size_t written = 0;
+    while (written < pipe_output.size()) {
+        const ssize_t ret =
+            ::write(STDOUT_FILENO, pipe_output.data() + written,
+                    pipe_output.size() - written);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        written += static_cast<std::size_t>(ret);
+    }
+    pipe_output.clear();
+}
+
+[[nodiscard]]
+auto handleIncomingMessage(messenger::net::Connection& conn,
+                           const messenger::proto::MessageView& msg) -> bool {
     using messenger::proto::MsgType;
 
     switch (msg.type) {
         case MsgType::Text: {
             // Дедупликация: если msg_id был, не показывать повторно
-            if (isDuplicate(msg.id)) {
-                if (!messenger::proto::send_ack(sock_fd, msg.id)) {
+            // (новый id сразу запоминается в окне)
+            if (!session.accept(msg.id)) {
+                chatMetrics().duplicates.add();
+                if (!acknowledgeReceived(conn, msg.id)) {
                     clearInputLine();
                     std::cout
                         << "\n[Ошибка: не удалось повторно отправить Ack]\n";
@@ -317,20 +1424,20 @@ auto handleIncomingMessage(int sock_fd,
                 return true;
             }
 
-            rememberMessageId(msg.id);
+            chatMetrics().messages_received.add();
+            std::string history_line = "[Собеседник]: ";
+            history_line += msg.payload;
+            addHistoryLine(history_line);
 
-            const std::string history_line = "[Собеседник]: " + msg.payload;
-            chat_history.push_back(history_line);
-            appendToHistoryFile(history_line);
-            if (chat_history.size() > MAX_HISTORY_LINES) {
-                chat_history.erase(chat_history.begin());
+            if (headless) {
+                writePipeMessage(msg.id, msg.payload);
+            } else {
+                clearInputLine();
+                std::cout << "\n[Собеседник]: " << msg.payload << "\n";
+                redrawInput();
             }
 
-            clearInputLine();
-            std::cout << "\n[Собеседник]: " << msg.payload << "\n";
-            redrawInput();
-
-            if (!messenger::proto::send_ack(sock_fd, msg.id)) {
+            if (!acknowledgeReceived(conn, msg.id)) {
                 std::cout << "\n[Ошибка: не удалось отправить Ack]\n";
                 redrawInput();
             }
@@ -348,7 +1455,11 @@ auto handleIncomingMessage(int sock_fd,
             return true;
 
         case MsgType::Ping: {
-            if (!messenger::proto::send_pong(sock_fd, msg.id)) {
+            if (const auto peer_hello =
+                    messenger::proto::decode_hello(msg.payload)) {
+                handlePeerHello(conn, *peer_hello);
+            }
+            if (!messenger::proto::send_pong(conn, msg.id)) {
                 clearInputLine();
                 std::cout << "\n[Ошибка: не удалось отправить Pong]\n";
                 redrawInput();
@@ -361,15 +1472,30 @@ auto handleIncomingMessage(int sock_fd,
             last_pong_time = Clock::now();
             ping_retry_count = 0;
 
-            // clearInputLine();
-            // std::cout << "\n[Собеседник: получен пакет Pong]\n";
-            // redrawInput();
-            // Здесь позже добавить логику (например, измерения RTT, если
-            // понадобится) и логирование
+            // Ответ на последний Ping — замер RTT
+            if (msg.id != 0 && msg.id == outstanding_ping) {
+                outstanding_ping = 0;
+                rtt_estimator.on_sample(
+                    std::chrono::duration_cast<RttEstimator::Duration>(
+                        last_pong_time - outstanding_ping_time));
+                chatMetrics().ping_rtt.record(
+                    toMicroseconds(last_pong_time - outstanding_ping_time));
+            }
             return true;
 
         case MsgType::Ack:
-            // Обработка Ack происходит в handle_peer отдельно
+        case MsgType::Sack:
+            // Обработка Ack и Sack происходит в handle_peer отдельно
+            return true;
+
+        case MsgType::FileOffer:
+            return handleFileOffer(conn, msg);
+
+        case MsgType::FileAck:
+            return handleFileAck(conn, msg);
+
+        case MsgType::FileChunk:
+            // Куски файлов разбираются в handle_peer без копирования
             return true;
 
         default:
@@ -380,113 +1506,182 @@ auto handleIncomingMessage(int sock_fd,
     }
 }
 
-void checkAckTimeout(int socket_fd) {
+// Повтор по таймеру не принят очередью отправки. Переполненная очередь —
+// противодавление, а не потеря связи: сообщение по-прежнему ждёт Ack,
+// таймер взводится заново, а повтор уйдёт по готовности сокета к записи.
+// false — соединение закрыто, повторять некуда
+[[nodiscard]]
+auto deferRetransmit(const messenger::net::Connection& conn,
+                     Outbox::Entry& entry, Clock::time_point now) -> bool {
+    if (conn.outbound().closed()) {
+        return false;
+    }
+    armAckTimer(entry, now);
+    entry.retransmit_deferred = true;
+    deferred_retransmits.push_back(entry.id);
+    return true;
+}
+
+// Сокет снова принимает данные: отложенные повторы уходят в порядке
+// откладывания, пока их принимает очередь отправки
+void retransmitDeferred(messenger::net::Connection& conn) {
     const auto now = Clock::now();
-    std::vector<std::uint32_t> remove_ids;
+    while (!deferred_retransmits.empty()) {
+        Outbox::Entry* entry = outbox.find(deferred_retransmits.front());
+        if (entry == nullptr || !entry->retransmit_deferred) {
+            // Подтверждено или оставлено, пока ждало
+            deferred_retransmits.pop_front();
+            continue;
+        }
+        if (!sendText(conn, *entry->payload, entry->id)) {
+            return;  // очередь снова полна — до следующего EPOLLOUT
+        }
+        deferred_retransmits.pop_front();
+        entry->retransmit_deferred = false;
+        entry->retry_count += 1;
+        chatMetrics().retransmits.add();
+        armAckTimer(*entry, now);
 
-    for (auto& pair_item : pending_acks) {
-        const std::uint32_t msg_id = pair_item.first;
-        PendingAck& ack_state = pair_item.second;
+        clearInputLine();
+        std::cout << '\n'
+                  << retransmit_notice(*entry, MAX_MESSAGE_RETRIES) << '\n';
+        redrawInput();
+    }
+}
 
-        if (now < ack_state.deadline) {
-            continue;
+// Повтор по сработавшему таймеру Ack. Переполненная очередь откладывает
+// его до готовности сокета, закрытое соединение — оставляет сообщение
+void retransmitOnTimeout(messenger::net::Connection& conn,
+                         Outbox::Entry& entry, Clock::time_point now) {
+    if (!sendText(conn, *entry.payload, entry.id)) {
+        if (deferRetransmit(conn, entry, now)) {
+            return;
         }
+        std::cout << "\n[Ошибка: сообщение не удалось повторно отправить]\n";
+        chatMetrics().undelivered.add();
+        stopAwaitingAck(entry);
+        return;
+    }
 
-        // ===== 1. Обычные ретраи до MAX_MESSAGE_RETRIES - 1 =====
-        if (ack_state.retry_count < MAX_MESSAGE_RETRIES - 1) {
-            if (!messenger::proto::send_text(socket_fd, ack_state.last_payload,
-                                             ack_state.id)) {
-                std::cout
-                    << "\n[Ошибка: сообщение не удалось повторно отправить]\n";
-                remove_ids.push_back(msg_id);
-                continue;
-            }
+    entry.retry_count += 1;
+    chatMetrics().retransmits.add();
+    armAckTimer(entry, now);
+    std::cout << '\n' << retransmit_notice(entry, MAX_MESSAGE_RETRIES) << '\n';
+}
 
-            ack_state.retry_count += 1;
-            ack_state.deadline =
-                now + std::chrono::seconds(ACK_TIMEOUT_SECONDS);
+// Обработка наступивших таймеров Ack (expired — ключи из timer_wheel)
+void checkAckTimeout(messenger::net::Connection& conn,
+                     const std::vector<std::uint64_t>& expired) {
+    const auto now = Clock::now();
+    // Повтор по таймауту — признак потери: окно отправки сужается, а RTO
+    // удваивается один раз на пачку сработавших таймеров, а не на каждое
+    // сообщение. Таймер повтора взводится уже на удвоенный RTO
+    bool lost = false;
+    const auto noteLoss = [&lost] {
+        if (!lost) {
+            rtt_estimator.on_timeout();
+            lost = true;
+        }
+    };
 
-            std::cout << "\n[Повторная отправка msg_id=" << ack_state.id
-                      << ", попытка " << ack_state.retry_count << "]\n";
+    for (const std::uint64_t timer_key : expired) {
+        if (timer_key == PING_TIMER_KEY) {
+            ping_timer = messenger::net::TimerWheel::NO_TIMER;
+            continue;
+        }
+        if (timer_key == DELAYED_ACK_TIMER_KEY) {
+            delayed_ack_timer = messenger::net::TimerWheel::NO_TIMER;
+            flushDelayedAck(conn);
+            continue;
+        }
+        if (timer_key == RESUME_TIMER_KEY) {
+            // Приветствия нет — собеседник не умеет возобновлять сеанс
+            resume_timer = messenger::net::TimerWheel::NO_TIMER;
+            resumeOutbox(conn, std::nullopt);
             continue;
         }
-
-        // ===== 2. Инициировать Ping/Pong-проверку перед последним ретраем
-        // =====
-        if (!ack_state.ping_for_ack_requested) {
-            // Форсировать отправку Ping в ближайшем цикле watchdog'а
-            last_ping_time = now - std::chrono::seconds(PING_INTERVAL_SECONDS);
-            ping_retry_count = 0;
-
-            ack_state.ping_for_ack_requested = true;
-            ack_state.deadline =
-                now + std::chrono::seconds(ACK_TIMEOUT_SECONDS);
+        if (timer_key == METRICS_TIMER_KEY) {
+            metrics_timer = messenger::net::TimerWheel::NO_TIMER;
+            exportMetrics();
+            scheduleMetricsExport(now);
             continue;
         }
 
-        // ===== 3. После успешного Ping/Pong — выполнить последний ретрай =====
-        if (ack_state.retry_count == MAX_MESSAGE_RETRIES - 1) {
-            if (!messenger::proto::send_text(socket_fd, ack_state.last_payload,
-                                             ack_state.id)) {
-                std::cout
-                    << "\n[Ошибка: сообщение не удалось отправить повторно]\n";
-                remove_ids.push_back(msg_id);
-                continue;
-            }
-
-            ack_state.retry_count += 1;  // retry_count == MAX_MESSAGE_RETRIES
-            ack_state.deadline =
-                now + std::chrono::seconds(ACK_TIMEOUT_SECONDS);
-
-            std::cout << "\n[Последняя попытка отправки msg_id=" << ack_state.id
-                      << "]\n";
+        Outbox::Entry* entry =
+            outbox.find(static_cast<std::uint32_t>(timer_key));
+        if (entry == nullptr || !entry->awaiting_ack) {
             continue;
         }
+        Outbox::Entry& ack_state = *entry;
+        ack_state.timer = messenger::net::TimerWheel::NO_TIMER;  // сработал
+        const AckTimeoutAction action =
+            ack_timeout_action(ack_state, MAX_MESSAGE_RETRIES);
+        // Потеря учитывается до повтора, даже если он будет отложен:
+        // таймер взводится уже на удвоенный RTO
+        if (counts_as_loss(action)) {
+            noteLoss();
+        }
 
-        // ===== 4. В этой точке:
-        //  - обычные ретраи исчерпаны,
-        //  - Ping/Pong-проверка уже инициирована,
-        //  - последний ретрай выполнен,
-        //  - checkPingWatchdog() не заявил о потере соединения,
-        //  - но ACK так и не пришёл.
-        std::cout << "\n[Сообщение msg_id=" << ack_state.id
-                  << " НЕ доставлено (таймаут)]\n";  // в дальнейшем логирование
+        switch (action) {
+            case AckTimeoutAction::WaitDeferred:
+                // Прошлый повтор ещё ждёт места в очереди отправки
+                armAckTimer(ack_state, now);
+                break;
 
-        for (auto& outgoing_message : undelivered_messages) {
-            if (outgoing_message.message_id == ack_state.id) {
-                outgoing_message.delivered = false;
+            case AckTimeoutAction::Retransmit:
+            case AckTimeoutAction::FinalRetransmit:
+                retransmitOnTimeout(conn, ack_state, now);
+                break;
+
+            case AckTimeoutAction::RequestPing:
+                // Форсировать отправку Ping в ближайшем цикле watchdog'а
+                // перед последним повтором
+                last_ping_time =
+                    now - std::chrono::seconds(PING_INTERVAL_SECONDS);
+                ping_retry_count = 0;
+                ack_state.ping_for_ack_requested = true;
+                armAckTimer(ack_state, now);
                 break;
-            }
-        }
 
-        remove_ids.push_back(msg_id);
+            case AckTimeoutAction::GiveUp:
+                // Повторы исчерпаны, checkPingWatchdog() не заявил о потере
+                // соединения, но Ack так и не пришёл
+                std::cout << "\n[Сообщение msg_id=" << ack_state.id
+                          << " НЕ доставлено (таймаут)]\n";
+                chatMetrics().undelivered.add();
+                stopAwaitingAck(ack_state);
+                break;
+        }
     }
 
-    for (std::uint32_t id_value : remove_ids) {
-        pending_acks.erase(id_value);
+    if (lost) {
+        send_window.on_loss();
     }
+    // Сообщения, покинувшие полёт, освободили место для очереди
+    pumpOutbox(conn);
 }
 
 [[nodiscard]]
-auto sendPing(int socket_fd) -> bool {
-    // msg_id для Ping не нужен, использовать 0
-    return messenger::proto::send_ping(socket_fd, 0);
+auto sendPing(messenger::net::Connection& conn) -> bool {
+    return messenger::proto::send_ping(conn, nextPingId());
 }
 
 [[nodiscard]]
-auto checkPingWatchdog(int socket_fd) -> bool {
+auto checkPingWatchdog(messenger::net::Connection& conn) -> bool {
     const auto now = Clock::now();
 
     // Отправлять Ping периодически, даже если пользователь молчит
     if (now - last_ping_time >= std::chrono::seconds(PING_INTERVAL_SECONDS) &&
         ping_retry_count < MAX_PING_RETRIES) {
-        if (!sendPing(socket_fd)) {
+        if (!sendPing(conn)) {
             std::cout << "\n[Ошибка: не удалось отправить Ping]\n";
             return false;
         }
         last_ping_time = now;
         if (ping_retry_count == 0) {
             last_pong_time = now;
+        } else {
+            chatMetrics().pings_unanswered.add();  // прежний Ping без Pong
         }
         ping_retry_count += 1;
     }
@@ -497,100 +1692,435 @@ auto checkPingWatchdog(int socket_fd) -> bool {
         now - last_pong_time > std::chrono::seconds(PING_TIMEOUT_SECONDS) &&
         ping_retry_count >= MAX_PING_RETRIES) {
         std::cout << "\n[Ошибка: соединение потеряно (нет Pong)]\n";
+        chatMetrics().links_lost.add();
         return false;
     }
 
     return true;
 }
 
-void wait_for_events(int sock_fd, fd_set& readfds) {
-    while (true) {
-        FD_ZERO(&readfds);
-        FD_SET(sock_fd, &readfds);
-        FD_SET(STDIN_FILENO, &readfds);
+// Ближайший дедлайн Ping/Pong‑watchdog'а (зеркало условий checkPingWatchdog)
+[[nodiscard]]
+auto nextPingDeadline() -> Clock::time_point {
+    if (ping_retry_count < MAX_PING_RETRIES) {
+        return last_ping_time + std::chrono::seconds(PING_INTERVAL_SECONDS);
+    }
+    // Ping'и исчерпаны: потеря фиксируется строго ПОСЛЕ таймаута Pong
+    return last_pong_time + std::chrono::seconds(PING_TIMEOUT_SECONDS) +
+           std::chrono::milliseconds(1);
+}
 
-        const int max_fd = std::max(sock_fd, STDIN_FILENO);
+// Перепланировать таймер watchdog'а, если его дедлайн сдвинулся (Pong,
+// отправка Ping, форсированная проверка из checkAckTimeout)
+void syncPingTimer() {
+    const Clock::time_point deadline = nextPingDeadline();
+    if (ping_timer != messenger::net::TimerWheel::NO_TIMER &&
+        deadline == ping_timer_deadline) {
+        return;
+    }
+    timer_wheel.cancel(ping_timer);
+    ping_timer = timer_wheel.schedule(deadline, PING_TIMER_KEY);
+    ping_timer_deadline = deadline;
+}
 
-        // Таймаут, чтобы периодически будиться для Ping/Ack‑таймеров
-        timeval t_v{};
-        t_v.tv_sec = 0;
-        t_v.tv_usec = SELECT_TIMEOUT_USEC;  // 500 мс
+// Команда /очередь: глубина очереди отправки, отметки противодавления и
+// окно отправки сообщений
+void showOutboundQueue(const messenger::net::Connection& conn) {
+    std::size_t queued_messages = 0;
+    for (const auto& entry : outbox) {
+        if (entry.awaiting_ack && !entry.sent) {
+            ++queued_messages;
+        }
+    }
 
-        const int ret = ::select(max_fd + 1, &readfds, nullptr, nullptr, &t_v);
+    const auto& outbound = conn.outbound();
+    const auto& limits = outbound.limits();
+    std::cout << "\n[Очередь отправки: " << outbound.queued_bytes()
+              << " байт, максимум " << outbound.peak_bytes() << " байт]\n"
+              << "[Отметки: верхняя " << limits.high_watermark
+              << ", нижняя " << limits.low_watermark << ", предел "
+              << limits.capacity << " байт]\n"
+              << "[Состояние: "
+              << (outbound.above_high_watermark()
+                      ? "перегружен, ввод приостановлен"
+                      : "норма")
+              << "]\n"
+              << "[Окно отправки: в полёте " << send_window.in_flight()
+              << " из " << send_window.window() << " (cwnd "
+              << send_window.cwnd() << ", ssthresh " << send_window.ssthresh()
+              << ", окно собеседника " << send_window.rwnd() << "), ждут "
+              << queued_messages << " сообщений]\n";
+}
 
-        if (ret < 0) {
-            if (errno == EINTR) {
-                if (shutdown_requested != 0) {
-                    FD_ZERO(&readfds);
-                    return;  // EINTR по Ctrl-C - выход и далее завершение
-                             // приложения
-                }
-                continue;  // повторить select()
+// Длительность в миллисекундах с одним знаком после запятой
+[[nodiscard]]
+auto formatMilliseconds(RttEstimator::Duration duration) -> std::string {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1)
+        << std::chrono::duration<double, std::milli>(duration).count();
+    return out.str();
+}
+
+// Команда /задержка: замеры RTT и текущий таймаут ожидания Ack
+void showRtt() {
+    std::cout << "\n[Таймаут Ack (RTO): "
+              << formatMilliseconds(rtt_estimator.rto()) << " мс";
+    if (rtt_estimator.backoff() != 0) {
+        std::cout << ", удвоен " << rtt_estimator.backoff() << " раз(а)";
+    }
+    std::cout << "]\n";
+    if (!rtt_estimator.has_samples()) {
+        std::cout << "[RTT: замеров ещё нет]\n";
+        return;
+    }
+    std::cout << "[RTT: последний " << formatMilliseconds(rtt_estimator.last())
+              << " мс, сглаженный " << formatMilliseconds(rtt_estimator.srtt())
+              << " мс, разброс " << formatMilliseconds(rtt_estimator.rttvar())
+              << " мс, минимум " << formatMilliseconds(rtt_estimator.min())
+              << " мс, замеров " << rtt_estimator.samples() << "]\n";
+}
+
+// Команда /статистика: счётчики и задержки из реестра метрик
+void showStatistics() {
+    const auto& registry = messenger::utils::metrics();
+    std::cout << "\n";
+    for (const auto& sample : registry.counters()) {
+        std::cout << "[" << sample.help << ": " << sample.value << "]\n";
+    }
+    for (const auto& sample : registry.histograms()) {
+        const auto& histogram = sample.histogram;
+        std::cout << "[" << sample.help << ": ";
+        if (histogram.count() == 0) {
+            std::cout << "замеров ещё нет]\n";
+            continue;
+        }
+        std::cout << "p50 " << histogram.percentile(STATS_P50) << ", p99 "
+                  << histogram.percentile(STATS_P99) << ", p999 "
+                  << histogram.percentile(STATS_P999) << ", макс "
+                  << histogram.max() << ", замеров " << histogram.count()
+                  << "]\n";
+    }
+    if (!metrics_file_path.empty()) {
+        std::cout << "[Снимок для Prometheus: " << metrics_file_path
+                  << ", раз в " << METRICS_EXPORT_SECONDS << " с]\n";
+    }
+}
+
+// Привести подписку epoll в соответствие с состоянием очереди отправки:
+// EPOLLOUT нужен, только пока в очереди есть недописанные байты, а ввод
+// пользователя не читается, пока очередь выше верхней отметки
+void syncInterest(messenger::net::EventLoop& loop,
+                  const messenger::net::Connection& conn) {
+    const auto& outbound = conn.outbound();
+
+    const bool need_write = !outbound.empty();
+    if (need_write != write_interest) {
+        loop.modify(conn.fd(), need_write ? (EPOLLIN | EPOLLOUT) : EPOLLIN);
+        write_interest = need_write;
+    }
+
+    bool need_input = !outbound.above_high_watermark();
+    if (headless) {
+        // Без терминала ввод не читается и после EOF, и пока прочитанный
+        // блок ждёт места в outbox
+        need_input = need_input && !stdin_eof &&
+                     pipe_input.size() < PIPE_READ_BLOCK;
+    }
+    if (need_input != input_registered) {
+        if (stdin_pollable) {
+            if (need_input) {
+                loop.add(STDIN_FILENO, EPOLLIN);
+            } else {
+                loop.remove(STDIN_FILENO);
             }
+        }
+        input_registered = need_input;
+    }
+}
+
+ReadyEvents wait_for_events(messenger::net::EventLoop& loop,
+                            const messenger::net::Connection& conn) {
+    syncInterest(loop, conn);
+
+    // Таймер взводится ровно на ближайший дедлайн колеса: между дедлайнами
+    // и событиями процесс спит, а не просыпается ради опроса таймеров
+    syncPingTimer();
+    loop.arm_timer(timer_wheel.next_deadline());
 
-            if (errno == EAGAIN) {  // некретичная ошибка
-                FD_ZERO(&readfds);
-                return;  // пробудиться без событий
+    // Принятые сообщения уходят в stdout одной записью на пробуждение
+    if (!pipe_output.empty()) {
+        flushPipeOutput();
+    }
+    // stdin, который epoll не принимает, всегда готов: без блокировки
+    const bool input_ready = input_registered && !stdin_pollable;
+
+    ReadyEvents ready{};
+    while (true) {
+        const auto& events = loop.wait(input_ready ? 0 : -1);
+
+        if (events.empty() && !loop.timer_expired() && !input_ready) {
+            if (shutdown_requested != 0) {
+                return ready;  // EINTR по Ctrl-C - выход и далее завершение
+                               // приложения
             }
-            // реальная ошибка select()
-            messenger::utils::throw_system_error("select");
+            continue;  // EINTR от другого сигнала - повторить epoll_wait()
         }
 
-        // выход с ret == 0 (таймаут) или > 0 (по событию)
-        return;
+        for (const auto& event : events) {
+            if (event.fd == conn.fd()) {
+                // EPOLLHUP/EPOLLERR тоже передаются в handle_peer: recv()
+                // сообщит о закрытии или ошибке
+                if ((event.events & ~static_cast<std::uint32_t>(EPOLLOUT)) !=
+                    0) {
+                    ready.peer = true;
+                }
+                if ((event.events & EPOLLOUT) != 0) {
+                    ready.writable = true;
+                }
+            } else if (event.fd == STDIN_FILENO) {
+                ready.user = true;
+            }
+        }
+        ready.user = ready.user || input_ready;
+        ready.timer = loop.timer_expired();
+        return ready;
     }
 }
 
-bool handle_peer(int socket_fd) {
-    messenger::proto::Message msg{};
-    bool disconnected = false;
-
-    const bool okey =
-        messenger::proto::receive_msg(socket_fd, msg, disconnected);
+// Кадр не разобран: соединение с собеседником закрывается
+void reportProtocolError() {
+    chatMetrics().protocol_errors.add();
+    clearInputLine();
+    std::cout << "\nФатальная ошибка протокола: повреждённый пакет\n";
+    redrawInput();
+}
 
-    if (!okey) {
-        clearInputLine();
-        std::cout << "\nФатальная ошибка протокола: повреждённый пакет\n";
-        redrawInput();
-        // в дальнейшем логирование и/или логика обработки
+// Обработка Sack: одним кадром закрываются все сообщения до
+// накопительной границы и внутри блоков. false — повреждённый кадр
+[[nodiscard]]
+auto settleSack(messenger::net::Connection& conn,
+                const messenger::proto::MessageView& msg) -> bool {
+    const auto blocks = messenger::proto::decode_sack(msg.payload);
+    if (!blocks) {
         return false;
     }
 
-    if (disconnected) {
-        std::cout << "\nСобеседник отключился.\n";
-        return false;
+    std::vector<Outbox::Entry>& settled = settled_entries;
+    outbox.settle(msg.id, std::span(blocks->ranges.data(), blocks->count),
+                  settled);
+    // Замер RTT — по последнему отправленному из подтверждённых: его
+    // подтверждение меньше всего задержано отложенным Sack
+    const Outbox::Entry* newest = nullptr;
+    for (const auto& entry : settled) {
+        if (newest == nullptr || entry.sent_at > newest->sent_at) {
+            newest = &entry;
+        }
+        timer_wheel.cancel(entry.timer);
+        if (outbox_log) {
+            outbox_log->record_remove(entry.id);
+        }
+    }
+    if (newest != nullptr) {
+        sampleAckRtt(*newest, Clock::now());
+    }
+    send_window.on_ack(settled.size());
+    send_window.on_peer_window(blocks->window);
+    pumpOutbox(conn);
+
+    if (settled.empty()) {
+        return true;  // повторное или устаревшее подтверждение
+    }
+    clearInputLine();
+    if (settled.size() == 1) {
+        std::cout << "\n[Сообщение msg_id=" << settled.front().id
+                  << " доставлено]\n";
+    } else {
+        std::cout << "\n[Доставлено сообщений: " << settled.size()
+                  << ", последнее msg_id=" << settled.back().id << "]\n";
+    }
+    redrawInput();
+    return true;
+}
+
+// Обработка одного принятого кадра собеседника
+[[nodiscard]]
+auto processPeerMessage(messenger::net::Connection& conn,
+                        const messenger::proto::MessageView& msg) -> bool {
+    if (msg.type == messenger::proto::MsgType::Sack) {
+        if (!settleSack(conn, msg)) {
+            reportProtocolError();
+            return false;
+        }
+        return true;
     }
 
     // Обработка Ack: проверка на ожидаемый id
     if (msg.type == messenger::proto::MsgType::Ack) {
-        auto ack_it = pending_acks.find(msg.id);
-        if (ack_it != pending_acks.end()) {
+        Outbox::Entry* entry = outbox.find(msg.id);
+        if (entry != nullptr && entry->awaiting_ack) {
             clearInputLine();
             std::cout << "\n[Сообщение msg_id=" << msg.id << " доставлено]\n";
             redrawInput();
 
-            for (auto& outgoing_message : undelivered_messages) {
-                if (outgoing_message.message_id == msg.id) {
-                    outgoing_message.delivered = true;
-                    break;
-                }
+            timer_wheel.cancel(entry->timer);
+            sampleAckRtt(*entry, Clock::now());
+            if (entry->sent) {
+                send_window.on_ack(1);
             }
-
-            pending_acks.erase(ack_it);
+            outbox.erase(msg.id);
+            if (outbox_log) {
+                outbox_log->record_remove(msg.id);
+            }
+            pumpOutbox(conn);
             return true;
         }
         // Ack с другим id — игнорируем (или можно логировать)
         return true;
     }
 
-    if (!handleIncomingMessage(socket_fd, msg)) {
+    return handleIncomingMessage(conn, msg);
+}
+
+bool handle_peer(messenger::net::Connection& conn) {
+    using messenger::net::FrameReader;
+
+    FrameReader& reader = conn.reader();
+    const FrameReader::ReadStatus status = reader.fill(conn.fd());
+
+    if (status == FrameReader::ReadStatus::WouldBlock) {
+        return true;  // ложное пробуждение — данных ещё нет
+    }
+
+    if (status == FrameReader::ReadStatus::Closed) {
+        if (reader.buffered() != 0) {
+            // Обрыв посреди кадра
+            reportProtocolError();
+            return false;
+        }
+        std::cout << "\nСобеседник отключился.\n";
         return false;
     }
 
-    return true;
+    // Разобрать все кадры, уже целиком лежащие в буфере, за одно пробуждение
+    std::span<const std::uint8_t> frame;
+    while (true) {
+        const FrameReader::FrameStatus frame_status =
+            reader.next_frame(frame);
+
+        if (frame_status == FrameReader::FrameStatus::Incomplete) {
+            return true;  // остаток кадра придёт со следующим пробуждением
+        }
+
+        // Кусок файла — на диск прямо из буфера, без копии в Message
+        constexpr auto FILE_CHUNK_TYPE =
+            static_cast<std::uint8_t>(messenger::proto::MsgType::FileChunk);
+        if (frame_status == FrameReader::FrameStatus::Ready &&
+            (frame.front() & messenger::net::TYPE_BYTE_MASK) ==
+                FILE_CHUNK_TYPE) {
+            if (!handleFileChunk(conn, frame)) {
+                reportProtocolError();
+                return false;
+            }
+            continue;
+        }
+
+        messenger::proto::MessageView msg{};
+        if (frame_status == FrameReader::FrameStatus::Invalid ||
+            !messenger::proto::deserialize(frame, msg, receive_arena)) {
+            reportProtocolError();
+            // в дальнейшем логирование и/или логика обработки
+            return false;
+        }
+
+        if (!processPeerMessage(conn, msg)) {
+            return false;
+        }
+    }
+}
+
+// Строки из pipe_input — в outbox, пока в нём меньше
+// MAX_UNDELIVERED_MESSAGES ожидающих Ack: остаток ждёт подтверждений.
+// Строка без завершающего перевода строки отправляется только по EOF
+void drainPipeInput(messenger::net::Connection& conn) {
+    std::size_t start = 0;
+    while (outbox.awaiting_count() < MAX_UNDELIVERED_MESSAGES &&
+           start < pipe_input.size()) {
+        std::size_t end = pipe_input.find('\n', start);
+        if (end == std::string::npos) {
+            if (!stdin_eof) {
+                break;
+            }
+            end = pipe_input.size();
+        }
+        std::string_view line(pipe_input.data() + start, end - start);
+        start = end + 1;
+        if (line.ends_with('\r')) {
+            line.remove_suffix(1);
+        }
+        if (line.empty()) {
+            continue;
+        }
+        if (line.size() > messenger::net::MaxPayloadSize::value) {
+            std::cout << "[Ошибка: строка длиннее "
+                      << messenger::net::MaxPayloadSize::value
+                      << " байт не отправлена]\n";
+            continue;
+        }
+
+        const std::uint32_t msg_id = generateMessageId();
+        addHistoryLine("[Я]: " + std::string(line));
+        queueMessage(msg_id, std::string(line));
+    }
+    pipe_input.erase(0, std::min(start, pipe_input.size()));
+    pumpOutbox(conn);
+}
+
+// Ввод без терминала: блок stdin в pipe_input и отправка готовых строк
+void readPipeInput(messenger::net::Connection& conn) {
+    const std::size_t buffered = pipe_input.size();
+    pipe_input.resize(buffered + PIPE_READ_BLOCK);
+    ssize_t bytes_read{0};
+    do {
+        bytes_read = ::read(STDIN_FILENO, pipe_input.data() + buffered,
+                            PIPE_READ_BLOCK);
+    } while (bytes_read < 0 && errno == EINTR && shutdown_requested == 0);
+
+    if (bytes_read < 0) {
+        pipe_input.resize(buffered);
+        if (errno == EAGAIN) {
+            return;
+        }
+        if (shutdown_requested == 0) {
+            std::cout << "[Ошибка чтения stdin]\n";
+        }
+        stdin_eof = true;
+    } else {
+        pipe_input.resize(buffered + static_cast<std::size_t>(bytes_read));
+        stdin_eof = bytes_read == 0;
+    }
+
+    drainPipeInput(conn);
+    if (stdin_eof) {
+        std::cout << "[Ввод закончился, ожидание подтверждений]\n";
+    }
 }
 
-bool handle_user(int socket_fd) {
+// Режим без терминала: весь ввод прочитан и отправлен, ни одно сообщение
+// не ждёт Ack (доставлено или признано недоставленным)
+[[nodiscard]]
+auto pipeFinished() -> bool {
+    if (!headless || !stdin_eof || !pipe_input.empty()) {
+        return false;
+    }
+    return outbox.awaiting_count() == 0;
+}
+
+bool handle_user(messenger::net::Connection& conn) {
+    if (headless) {
+        readPipeInput(conn);
+        return true;
+    }
+
     char key{};
     ssize_t bytes_read{0};
     while (true) {
@@ -637,17 +2167,68 @@ bool handle_user(int socket_fd) {
 
         if (input_buffer.starts_with("/повтор")) {
             clearInputLine();
-            handleRepeatCommand(socket_fd, input_buffer);
+            handleRepeatCommand(conn, input_buffer);
+            input_buffer.clear();
+            typing_sent = false;
+            redrawInput();
+            return true;
+        }
+
+        // Команда показать историю сообщений (постранично)
+        if (input_buffer == "/история" ||
+            input_buffer.starts_with("/история ")) {
+            clearInputLine();
+            showHistory(input_buffer);
+            input_buffer.clear();
+            typing_sent = false;
+            redrawInput();
+            return true;
+        }
+
+        // Команда поиска по истории
+        if (input_buffer == "/поиск" || input_buffer.starts_with("/поиск ")) {
+            clearInputLine();
+            searchHistory(input_buffer);
+            input_buffer.clear();
+            typing_sent = false;
+            redrawInput();
+            return true;
+        }
+
+        // Команда отправки файла
+        if (input_buffer == "/файл" || input_buffer.starts_with("/файл ")) {
+            clearInputLine();
+            startFileTransfer(conn, input_buffer);
+            input_buffer.clear();
+            typing_sent = false;
+            redrawInput();
+            return true;
+        }
+
+        // Команда показать состояние очереди отправки
+        if (input_buffer == "/очередь") {
+            clearInputLine();
+            showOutboundQueue(conn);
+            input_buffer.clear();
+            typing_sent = false;
+            redrawInput();
+            return true;
+        }
+
+        // Команда показать оценку задержки до собеседника
+        if (input_buffer == "/задержка") {
+            clearInputLine();
+            showRtt();
             input_buffer.clear();
             typing_sent = false;
             redrawInput();
             return true;
         }
 
-        // Команда показать историю сообщений
-        if (input_buffer == "/история") {
+        // Команда показать метрики чата
+        if (input_buffer == "/статистика") {
             clearInputLine();
-            showHistory();
+            showStatistics();
             input_buffer.clear();
             typing_sent = false;
             redrawInput();
@@ -656,42 +2237,35 @@ bool handle_user(int socket_fd) {
 
         // Отправка обычного сообщения
         if (!input_buffer.empty()) {
-            const std::uint32_t msg_id = generateMessageId();
-
-            if (!messenger::proto::send_text(socket_fd, input_buffer, msg_id)) {
-                std::cout
-                    << "\n[Ошибка: сообщение не удалось отправить полностью]\n";
+            if (input_buffer.size() > messenger::net::MaxPayloadSize::value) {
+                std::cout << "\n[Ошибка: сообщение длиннее "
+                          << messenger::net::MaxPayloadSize::value
+                          << " байт не может быть отправлено]\n";
+                input_buffer.clear();
+                typing_sent = false;
                 redrawInput();
-                // возможо false или логирование / помещение сообщения в очередь
-                // отправки
-            } else {
+                return true;
+            }
+
+            const std::uint32_t msg_id = generateMessageId();
+            const std::string history_line = "[Я]: " + input_buffer;
+            addHistoryLine(history_line);
+
+            // Сообщение встаёт в outbox и уходит, как только позволит окно
+            // отправки; Ack ожидается неблокирующе
+            queueMessage(msg_id, input_buffer);
+            pumpOutbox(conn);
+            if (outbox.find(msg_id)->sent) {
                 std::cout << "\n[Ожидание подтверждения доставки для msg_id="
                           << msg_id << "]\n";
-
-                const std::string history_line = "[Я]: " + input_buffer;
-                chat_history.push_back(history_line);
-                appendToHistoryFile(history_line);
-                if (chat_history.size() > MAX_HISTORY_LINES) {
-                    chat_history.erase(chat_history.begin());
-                }
-
-                // Запуск неблокирующего ожидания Ack: запомнить, что ждём его
-                PendingAck ack_state{};
-                ack_state.id = msg_id;
-                ack_state.deadline =
-                    Clock::now() + std::chrono::seconds(ACK_TIMEOUT_SECONDS);
-                ack_state.retry_count = 0;
-                ack_state.last_payload = input_buffer;
-                pending_acks[msg_id] = ack_state;
-
-                OutgoingMessage outgoing_message{};
-                outgoing_message.message_id = msg_id;
-                outgoing_message.payload = input_buffer;
-                outgoing_message.delivered = false;
-                undelivered_messages.push_back(outgoing_message);
-                if (undelivered_messages.size() > MAX_UNDELIVERED_MESSAGES) {
-                    undelivered_messages.erase(undelivered_messages.begin());
-                }
+            } else if (resume_pending) {
+                std::cout << "\n[msg_id=" << msg_id
+                          << " в очереди до возобновления сеанса]\n";
+            } else {
+                std::cout << "\n[msg_id=" << msg_id
+                          << " в очереди: окно отправки заполнено (в полёте "
+                          << send_window.in_flight() << " из "
+                          << send_window.window() << ")]\n";
             }
 
             input_buffer.clear();
@@ -718,8 +2292,9 @@ bool handle_user(int socket_fd) {
     input_buffer.push_back(key);
 
     // Отправить Typing один раз при начале ввода
-    if (!typing_sent) {
-        static_cast<void>(messenger::proto::send_typing(socket_fd, 0));
+    // (при перегруженном канале Typing не нужен — он только удлинит очередь)
+    if (!typing_sent && !conn.outbound().above_high_watermark()) {
+        static_cast<void>(messenger::proto::send_typing(conn, 0));
         typing_sent = true;
     }
 
@@ -727,8 +2302,133 @@ bool handle_user(int socket_fd) {
     return true;
 }
 
+// Чем закончилась работа по соединению
+enum class LinkEnd : std::uint8_t {
+    Exit,  // пользователь завершил чат
+    Lost   // собеседник отключился или связь потеряна
+};
+
+// Без терминала кадры идут потоком, и Nagle придерживал бы каждый
+// следующий до ACK собеседника (задержанный ACK TCP — до 40 мс).
+// Ошибка не фатальна: кадры лишь пойдут с задержкой
+void disableNagle(const messenger::net::Connection& conn) {
+    const int enabled = 1;
+    static_cast<void>(::setsockopt(conn.fd(), IPPROTO_TCP, TCP_NODELAY,
+                                   &enabled, sizeof(enabled)));
+}
+
+// Цикл событий одного соединения
+[[nodiscard]]
+auto runConnection(messenger::net::Socket sock) -> LinkEnd {
+    messenger::net::Connection conn(std::move(sock));
+    if (headless) {
+        disableNagle(conn);
+    }
+    conn.outbound().set_watermark_handler([&conn](bool above_high) {
+        clearInputLine();
+        if (above_high) {
+            std::cout << "\n[Канал перегружен: "
+                      << conn.outbound().queued_bytes()
+                      << " байт в очереди, ввод приостановлен]\n";
+        } else {
+            std::cout << "\n[Канал свободен, ввод возобновлён]\n";
+            requestWindowUpdate();
+        }
+        redrawInput();
+    });
+
+    // STDIN добавляется в syncInterest(), пока очередь ниже верхней отметки
+    messenger::net::EventLoop loop;
+    loop.add(conn.fd(), EPOLLIN);
+    write_interest = false;
+    input_registered = false;
+
+    if (!startSession(conn)) {
+        std::cout << "\n[Ошибка: не удалось отправить приветствие]\n";
+        return LinkEnd::Lost;
+    }
+
+    while (shutdown_requested == 0) {
+        // Без терминала: подтверждения освобождают место в outbox для
+        // отложенного ввода; всё отправлено и подтверждено — выход
+        if (headless) {
+            if (!pipe_input.empty()) {
+                drainPipeInput(conn);
+            }
+            if (pipeFinished()) {
+                return LinkEnd::Exit;
+            }
+        }
+
+        const ReadyEvents ready = wait_for_events(loop, conn);
+
+        if (ready.writable) {
+            // Сокет снова принимает данные — дописать очередь, повторить
+            // отложенное ею и продолжить передачу файлов
+            if (conn.outbound().flush(conn.fd()) ==
+                messenger::net::OutboundQueue::Status::Closed) {
+                // Оборванный кадр FileChunk не продолжить: переподключение,
+                // а передачу прервёт проверка файла перед новым предложением
+                std::cout << (conn.outbound().file_truncated()
+                                  ? "\n[Файл укорочен во время отправки: "
+                                    "соединение сброшено]\n"
+                                  : "\nСобеседник отключился.\n");
+                return LinkEnd::Lost;
+            }
+            retransmitDeferred(conn);
+            pumpOutbox(conn);
+            pumpFiles(conn);
+        }
+
+        if (ready.peer) {
+            if (!handle_peer(conn)) {
+                return LinkEnd::Lost;
+            }
+        }
+
+        if (ready.user) {
+            if (!handle_user(conn)) {
+                return LinkEnd::Exit;
+            }
+        }
+
+        checkOutboxLog();
+
+        if (!ready.timer) {
+            continue;
+        }
+
+        // Наступил дедлайн: обработать только сработавшие таймеры Ack
+        checkAckTimeout(conn, timer_wheel.expire(Clock::now()));
+
+        // Проверка связи через Ping/Pong‑watchdog
+        if (!checkPingWatchdog(conn)) {
+            return LinkEnd::Lost;
+        }
+    }
+    return LinkEnd::Exit;
+}
+
+// Принимает ли epoll дескриптор: обычный файл и /dev/null — нет (EPERM)
+[[nodiscard]]
+auto epollAccepts(int watched_fd) -> bool {
+    try {
+        messenger::net::EventLoop probe;
+        probe.add(watched_fd, EPOLLIN);
+    } catch (const std::system_error& error) {
+        if (error.code().value() == EPERM) {
+            return false;
+        }
+        throw;
+    }
+    return true;
+}
+
 void chat_loop(messenger::net::Socket sock) {
-    const int fd_sock = sock.fd_return();
+    chat_loop(std::move(sock), Reconnector{});
+}
+
+void chat_loop(messenger::net::Socket sock, const Reconnector& reconnect) {
 
     // Установить обработчики сигналов
     {
@@ -752,39 +2452,60 @@ void chat_loop(messenger::net::Socket sock) {
         sigaction(SIGPIPE, &sig_action_ign, nullptr);
     }
 
-    const TerminalRawGuard term_guard;
-
-    loadHistoryFromFile();
+    // stdin не терминал (скрипт, pipe, файл) — режим без терминала.
+    // Служебный вывод при этом направляет в stderr main()
+    headless = ::isatty(STDIN_FILENO) == 0;
+    std::optional<TerminalRawGuard> term_guard;
+    if (headless) {
+        stdin_pollable = epollAccepts(STDIN_FILENO);
+    } else {
+        term_guard.emplace();
+    }
 
-    std::cout << "Чат готов. Печатай сообщение и жми Enter.\n"
-              << "Команда выхода: /выход или /exit, а также Ctrl-D.\n\n";
+    const auto durability = durabilityOptions();
+    openHistoryStore(durability);
+    openOutboxLog(durability);
+    migrateLegacyHistory();
+    openHistoryIndex();
+    loadHistoryTail();
+    openMetricsExport();
+
+    if (headless) {
+        std::cout << "[Режим без терминала: строка stdin — сообщение, "
+                     "принятые сообщения — в stdout]\n";
+    } else {
+        std::cout << "Чат готов. Печатай сообщение и жми Enter.\n"
+                  << "Команда выхода: /выход или /exit, а также Ctrl-D.\n\n";
+    }
     redrawInput();
 
-    while (shutdown_requested == 0) {
-        fd_set readfds;
-        wait_for_events(fd_sock, readfds);
-
-        if (FD_ISSET(fd_sock, &readfds)) {
-            if (!handle_peer(fd_sock)) {
-                break;
-            }
-        }
-
-        if (FD_ISSET(STDIN_FILENO, &readfds)) {
-            if (!handle_user(fd_sock)) {
-                break;
-            }
-        }
-
-        // Проверить после обработки событий, истёк ли таймаут ожидания Ack
-        checkAckTimeout(fd_sock);
+    // После обрыва связи — новое соединение от reconnect; неподтверждённые
+    // сообщения, история и сеанс сохраняются
+    messenger::net::Socket current = std::move(sock);
+    while (runConnection(std::move(current)) == LinkEnd::Lost && reconnect &&
+           shutdown_requested == 0 && !pipeFinished()) {
+        suspendAckTimers();
+        suspendFileTransfers();
+        link_lost_time = Clock::now();
+        clearInputLine();
+        std::cout << "[Связь потеряна, переподключение... Ctrl-C — выход]\n";
 
-        // Проверка связи через Ping/Pong‑watchdog
-        if (!checkPingWatchdog(fd_sock)) {
+        auto next = reconnect([] { return shutdown_requested != 0; });
+        if (!next) {
             break;
         }
+        current = std::move(*next);
+        redrawInput();
     }
 
+    // Дописать и зафиксировать историю до выхода (индекс ссылается на
+    // хранилище и закрывается первым)
+    history_index.reset();
+    history_store.reset();
+    outbox_log.reset();
+    exportMetrics();
+    flushPipeOutput();
+
     std::cout << "\nЧат завершён.\n";
 }
 
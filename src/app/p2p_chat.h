@@ -1,14 +1,37 @@
 #pragma once
 
-#include <sys/select.h>
+#include <functional>
+#include <optional>
 
+#include "net/connection.h"
+#include "net/event_loop.h"
 #include "net/raii_socket.h"
+#include "net/reconnect.h"
 
 namespace messenger::app {
 
-void wait_for_events(int sock_fd, fd_set& readfds);
-bool handle_peer(int socket_fd);
-bool handle_user(int socket_fd);
+// Что разбудило цикл чата
+struct ReadyEvents {
+    bool peer{false};      // данные (или закрытие) от собеседника
+    bool writable{false};  // сокет снова принимает данные (EPOLLOUT)
+    bool user{false};      // ввод пользователя
+    bool timer{false};     // наступил дедлайн Ack/Ping‑таймеров
+};
+
+ReadyEvents wait_for_events(messenger::net::EventLoop& loop,
+                            const messenger::net::Connection& conn);
+bool handle_peer(messenger::net::Connection& conn);
+bool handle_user(messenger::net::Connection& conn);
 void chat_loop(messenger::net::Socket sock);
 
+// Источник нового соединения после обрыва связи (клиент — подключение с
+// экспоненциальной задержкой, сервер — приём на слушающем сокете).
+// std::nullopt — переподключение отменено
+using Reconnector = std::function<std::optional<messenger::net::Socket>(
+    const messenger::net::CancelCheck&)>;
+
+// Чат с переподключением: после обрыва связи сеанс возобновляется по
+// соединению от reconnect, повторяются только не дошедшие сообщения
+void chat_loop(messenger::net::Socket sock, const Reconnector& reconnect);
+
 } // namespace messenger::app
@@ -0,0 +1,94 @@
+#include "app/rtt_estimator.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace messenger::app {
+
+namespace {
+
+// Веса сглаживания из RFC 6298: alpha = 1/8, beta = 1/4
+constexpr std::int64_t SRTT_SHIFT = 3;
+constexpr std::int64_t RTTVAR_SHIFT = 2;
+// Множитель разброса в RTO
+constexpr std::int64_t RTTVAR_FACTOR = 4;
+
+}  // namespace
+
+RttEstimator::RttEstimator() : RttEstimator(Options{}) {}
+
+RttEstimator::RttEstimator(Options options)
+    : options_(options),
+      rto_(std::clamp(options.initial_rto, options.min_rto,
+                      options.max_rto)) {}
+
+void RttEstimator::on_sample(Duration rtt) {
+    rtt = std::max(rtt, Duration{0});
+    last_ = rtt;
+    min_ = samples_ == 0 ? rtt : std::min(min_, rtt);
+
+    if (samples_ == 0) {
+        srtt_ = rtt;
+        rttvar_ = rtt / 2;
+    } else {
+        const Duration error = rtt - srtt_;
+        const Duration deviation = error < Duration{0} ? -error : error;
+        rttvar_ += (deviation - rttvar_) / (std::int64_t{1} << RTTVAR_SHIFT);
+        srtt_ += error / (std::int64_t{1} << SRTT_SHIFT);
+    }
+    ++samples_;
+    backoff_ = 0;
+
+    rto_ = std::clamp(
+        srtt_ + std::max(options_.granularity, RTTVAR_FACTOR * rttvar_),
+        options_.min_rto, options_.max_rto);
+}
+
+void RttEstimator::on_timeout() {
+    if (rto_ < options_.max_rto) {
+        ++backoff_;
+    }
+    rto_ = std::min(rto_ * 2, options_.max_rto);
+}
+
+[[nodiscard]]
+auto RttEstimator::rto() const -> Duration {
+    return rto_;
+}
+
+[[nodiscard]]
+auto RttEstimator::has_samples() const -> bool {
+    return samples_ != 0;
+}
+
+[[nodiscard]]
+auto RttEstimator::samples() const -> std::uint64_t {
+    return samples_;
+}
+
+[[nodiscard]]
+auto RttEstimator::srtt() const -> Duration {
+    return srtt_;
+}
+
+[[nodiscard]]
+auto RttEstimator::rttvar() const -> Duration {
+    return rttvar_;
+}
+
+[[nodiscard]]
+auto RttEstimator::last() const -> Duration {
+    return last_;
+}
+
+[[nodiscard]]
+auto RttEstimator::min() const -> Duration {
+    return min_;
+}
+
+[[nodiscard]]
+auto RttEstimator::backoff() const -> int {
+    return backoff_;
+}
+
+}  // namespace messenger::app
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace messenger::app {
+
+// Оценка времени кругового обхода (RTT) и таймаут ожидания Ack (RTO).
+//
+// Сглаженное RTT и его разброс — по Якобсону/Карелсу, как в TCP
+// (RFC 6298): SRTT += (R - SRTT) / 8, RTTVAR += (|R - SRTT| - RTTVAR) / 4,
+// RTO = SRTT + max(G, 4 * RTTVAR) в пределах [min_rto, max_rto]. Замеры
+// дают Pong на Ping и Ack/Sack на сообщения, ушедшие один раз: по
+// правилу Карна ответ на повторенное сообщение не замеряется — неясно,
+// на какую из отправок он пришёл. Таймаут удваивает RTO до следующего
+// замера.
+class RttEstimator {
+public:
+    using Duration = std::chrono::microseconds;
+
+    struct Options {
+        // RTO до первого замера
+        Duration initial_rto{std::chrono::seconds(1)};
+        Duration min_rto{std::chrono::milliseconds(200)};
+        Duration max_rto{std::chrono::seconds(60)};
+        // Разрешение таймеров: RTO не ближе к SRTT, чем на него
+        Duration granularity{std::chrono::milliseconds(10)};
+    };
+
+    RttEstimator();
+    explicit RttEstimator(Options options);
+
+    // Новый замер RTT; сбрасывает удвоение RTO
+    void on_sample(Duration rtt);
+
+    // Сработал таймаут ожидания Ack: RTO вдвое больше (не выше max_rto).
+    // Вызывается один раз на пачку одновременно сработавших таймеров
+    void on_timeout();
+
+    // Текущий таймаут ожидания Ack с учётом удвоений
+    [[nodiscard]]
+    auto rto() const -> Duration;
+
+    // Был ли хоть один замер
+    [[nodiscard]]
+    auto has_samples() const -> bool;
+    [[nodiscard]]
+    auto samples() const -> std::uint64_t;
+    [[nodiscard]]
+    auto srtt() const -> Duration;
+    [[nodiscard]]
+    auto rttvar() const -> Duration;
+    [[nodiscard]]
+    auto last() const -> Duration;
+    [[nodiscard]]
+    auto min() const -> Duration;
+    // Сколько раз подряд удвоен RTO
+    [[nodiscard]]
+    auto backoff() const -> int;
+
+private:
+    Options options_;
+    Duration srtt_{0};
+    Duration rttvar_{0};
+    Duration last_{0};
+    Duration min_{0};
+    Duration rto_;
+    std::uint64_t samples_{0};
+    int backoff_{0};
+};
+
+}  // namespace messenger::app
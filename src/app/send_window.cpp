@@ -0,0 +1,98 @@
+#include "app/send_window.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace messenger::app {
+
+namespace {
+
+// Наименьший ssthresh после потери, как в TCP
+constexpr std::uint32_t MIN_SSTHRESH = 2U;
+
+}  // namespace
+
+SendWindow::SendWindow() : SendWindow(Options{}) {}
+
+SendWindow::SendWindow(Options options)
+    : options_(options),
+      cwnd_(std::max<std::uint32_t>(options.initial_cwnd, 1U)),
+      ssthresh_(options.max_cwnd),
+      rwnd_(options.initial_rwnd) {}
+
+[[nodiscard]]
+auto SendWindow::can_send() const -> bool {
+    return in_flight_ < window();
+}
+
+[[nodiscard]]
+auto SendWindow::window() const -> std::uint32_t {
+    return std::min(cwnd_, rwnd_);
+}
+
+void SendWindow::on_send() {
+    ++in_flight_;
+}
+
+void SendWindow::on_drop(std::size_t count) {
+    in_flight_ -= static_cast<std::uint32_t>(
+        std::min<std::size_t>(count, in_flight_));
+}
+
+void SendWindow::on_ack(std::size_t count) {
+    const auto acked = static_cast<std::uint32_t>(
+        std::min<std::size_t>(count, in_flight_));
+    in_flight_ -= acked;
+
+    for (std::uint32_t step = 0; step < acked; ++step) {
+        if (cwnd_ >= options_.max_cwnd) {
+            break;
+        }
+        if (cwnd_ < ssthresh_) {
+            ++cwnd_;  // медленный старт
+        } else if (++acked_in_round_ >= cwnd_) {
+            acked_in_round_ = 0;
+            ++cwnd_;  // аддитивное увеличение: +1 за круг
+        }
+    }
+}
+
+void SendWindow::on_loss() {
+    ssthresh_ = std::max(cwnd_ / 2U, MIN_SSTHRESH);
+    cwnd_ = std::max(cwnd_ / 2U, 1U);
+    acked_in_round_ = 0;
+}
+
+void SendWindow::on_peer_window(std::uint32_t rwnd) {
+    rwnd_ = rwnd;
+}
+
+void SendWindow::restart() {
+    in_flight_ = 0;
+    rwnd_ = options_.initial_rwnd;
+    cwnd_ = std::max<std::uint32_t>(options_.initial_cwnd, 1U);
+    acked_in_round_ = 0;
+}
+
+[[nodiscard]]
+auto SendWindow::in_flight() const -> std::uint32_t {
+    return in_flight_;
+}
+
+[[nodiscard]]
+auto SendWindow::cwnd() const -> std::uint32_t {
+    return cwnd_;
+}
+
+[[nodiscard]]
+auto SendWindow::rwnd() const -> std::uint32_t {
+    return rwnd_;
+}
+
+[[nodiscard]]
+auto SendWindow::ssthresh() const -> std::uint32_t {
+    return ssthresh_;
+}
+
+}  // namespace messenger::app
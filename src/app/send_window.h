@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace messenger::app {
+
+// Окно отправки Text: сколько сообщений может быть в полёте (отправлено,
+// но не подтверждено) одновременно.
+//
+// Окно — минимум из двух:
+//  - окна получателя (rwnd), которое собеседник объявляет в каждом Sack:
+//    быстрый отправитель не заваливает медленного получателя;
+//  - окна перегрузки (cwnd) отправителя по схеме AIMD, как в TCP
+//    (RFC 5681): после подключения медленный старт (+1 за каждое
+//    подтверждённое сообщение, рост вдвое за круг), выше порога
+//    ssthresh — +1 за круг, таймаут Ack — окно и порог вдвое меньше.
+// Сообщения сверх окна ждут в outbox и уходят по мере подтверждений, так
+// что пакетный ввод держит канал заполненным, но не переполненным.
+class SendWindow {
+public:
+    struct Options {
+        // cwnd после подключения
+        std::uint32_t initial_cwnd{4U};
+        // Верхний предел cwnd (и начальный ssthresh)
+        std::uint32_t max_cwnd{1024U};
+        // rwnd, пока собеседник не объявил своё
+        std::uint32_t initial_rwnd{256U};
+    };
+
+    SendWindow();
+    explicit SendWindow(Options options);
+
+    // Можно ли отправить ещё одно новое сообщение
+    [[nodiscard]]
+    auto can_send() const -> bool;
+
+    // min(cwnd, rwnd)
+    [[nodiscard]]
+    auto window() const -> std::uint32_t;
+
+    // Новое сообщение ушло в сеть
+    void on_send();
+
+    // Сообщения покинули полёт без подтверждения (отправка не удалась,
+    // вытеснены, ретраи исчерпаны)
+    void on_drop(std::size_t count);
+
+    // Собеседник подтвердил count сообщений из полёта: окно растёт
+    void on_ack(std::size_t count);
+
+    // Таймаут Ack — признак потери: мультипликативное уменьшение.
+    // Вызывается один раз на пачку одновременно сработавших таймеров
+    void on_loss();
+
+    // Окно, объявленное собеседником
+    void on_peer_window(std::uint32_t rwnd);
+
+    // Новое соединение: полёт пуст, медленный старт сначала, окно
+    // собеседника — по умолчанию до его первого Sack
+    void restart();
+
+    [[nodiscard]]
+    auto in_flight() const -> std::uint32_t;
+    [[nodiscard]]
+    auto cwnd() const -> std::uint32_t;
+    [[nodiscard]]
+    auto rwnd() const -> std::uint32_t;
+    [[nodiscard]]
+    auto ssthresh() const -> std::uint32_t;
+
+private:
+    Options options_;
+    std::uint32_t cwnd_;
+    std::uint32_t ssthresh_;
+    std::uint32_t rwnd_;
+    std::uint32_t in_flight_{0};
+    // Подтверждения, накопленные к следующему +1 в режиме избегания
+    // перегрузки
+    std::uint32_t acked_in_round_{0};
+};
+
+}  // namespace messenger::app
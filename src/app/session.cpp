@@ -0,0 +1,173 @@
+#include "app/session.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <random>
+
+#include "protocol/hello.h"
+#include "protocol/sack.h"
+
+namespace messenger::app {
+
+namespace {
+
+// Следующий id, который может выдать generateMessageId(): 0 и максимум
+// не выдаются никогда, после максимума счётчик переходит на 1
+[[nodiscard]]
+auto nextMessageId(std::uint32_t msg_id) -> std::uint32_t {
+    ++msg_id;
+    while (msg_id == 0 || msg_id == std::numeric_limits<std::uint32_t>::max()) {
+        ++msg_id;
+    }
+    return msg_id;
+}
+
+}  // namespace
+
+SessionState::SessionState(std::uint64_t session_id,
+                           std::size_t dedup_window_size)
+    : session_id_(session_id), seen_(dedup_window_size) {}
+
+[[nodiscard]]
+auto SessionState::accept(std::uint32_t msg_id) -> bool {
+    if (!seen_.check_and_insert(msg_id)) {
+        return false;
+    }
+
+    // Собеседник не сообщил first_pending (приветствие версии 1): граница
+    // встаёт прямо перед первым id сеанса (или перед id, с которого окно
+    // начато заново далеко позади неё)
+    if (!any_received_ || covered_by(msg_id, last_received_)) {
+        last_received_ = msg_id - 1;
+        any_received_ = true;
+    }
+    advanceBoundary();
+    return true;
+}
+
+[[nodiscard]]
+auto SessionState::hello() const -> proto::Hello {
+    proto::Hello hello{};
+    hello.session_id = session_id_;
+    hello.features = proto::Hello::SUPPORTED_FEATURES;
+    if (any_received_) {
+        hello.peer_session_id = peer_session_id_;
+        hello.last_received = last_received_;
+    }
+    return hello;
+}
+
+[[nodiscard]]
+auto SessionState::on_peer_hello(const proto::Hello& peer_hello) -> Resume {
+    Resume resume{};
+    peer_features_ = peer_hello.features;
+    if (peer_hello.session_id != peer_session_id_) {
+        resume.peer_restarted = peer_session_id_ != 0;
+        peer_session_id_ = peer_hello.session_id;
+        seen_.reset();
+        any_received_ = false;
+        last_received_ = 0;
+    }
+    if (peer_hello.peer_session_id == session_id_) {
+        resume.delivered_up_to = peer_hello.last_received;
+    }
+    // id до first_pending собеседник больше не пришлёт: граница встаёт
+    // перед ним, а не перед первым пришедшим id. Иначе Text, обогнавший
+    // ждущие в очереди отправителя сообщения с меньшими id, закрыл бы их
+    // накопительным подтверждением
+    if (peer_hello.first_pending != 0) {
+        const std::uint32_t floor = peer_hello.first_pending - 1;
+        if (!any_received_ || covered_by(last_received_, floor)) {
+            last_received_ = floor;
+            any_received_ = true;
+            advanceBoundary();
+        }
+    }
+    return resume;
+}
+
+void SessionState::begin_connection() {
+    peer_features_ = 0;
+}
+
+[[nodiscard]]
+auto SessionState::peer_supports(std::uint8_t feature) const -> bool {
+    return (peer_features_ & feature) != 0;
+}
+
+[[nodiscard]]
+auto SessionState::sack_blocks() const -> proto::SackBlocks {
+    proto::SackBlocks blocks{};
+    if (!any_received_) {
+        return blocks;
+    }
+
+    // Просмотр окна за границей: чередование дыр и принятых блоков
+    const std::uint32_t highest = seen_.highest();
+    std::uint32_t msg_id = nextMessageId(last_received_);
+    while (blocks.count < proto::SackBlocks::MAX_RANGES) {
+        while (covered_by(msg_id, highest) && !seen_.contains(msg_id)) {
+            msg_id = nextMessageId(msg_id);
+        }
+        if (!covered_by(msg_id, highest)) {
+            break;
+        }
+        // Зарезервированные id блок не разрывают
+        proto::SackRange& range = blocks.ranges.at(blocks.count++);
+        range.first = msg_id;
+        do {
+            range.last = msg_id;
+            msg_id = nextMessageId(msg_id);
+        } while (covered_by(msg_id, highest) && seen_.contains(msg_id));
+    }
+    return blocks;
+}
+
+[[nodiscard]]
+auto SessionState::session_id() const -> std::uint64_t {
+    return session_id_;
+}
+
+[[nodiscard]]
+auto SessionState::peer_session_id() const -> std::uint64_t {
+    return peer_session_id_;
+}
+
+[[nodiscard]]
+auto SessionState::last_received() const -> std::optional<std::uint32_t> {
+    if (!any_received_) {
+        return std::nullopt;
+    }
+    return last_received_;
+}
+
+void SessionState::advanceBoundary() {
+    // Граница сдвигается по уже принятым id; в сумме — O(1) на сообщение.
+    // Зарезервированные id перешагиваются, иначе после обёртки счётчика
+    // граница застряла бы перед максимумом
+    while (seen_.contains(nextMessageId(last_received_))) {
+        last_received_ = nextMessageId(last_received_);
+    }
+}
+
+[[nodiscard]]
+auto SessionState::generate_session_id() -> std::uint64_t {
+    std::random_device device;
+    std::mt19937_64 engine(
+        (static_cast<std::uint64_t>(device()) << 32U) | device());
+    std::uint64_t session_id = 0;
+    while (session_id == 0) {
+        session_id = engine();
+    }
+    return session_id;
+}
+
+[[nodiscard]]
+auto SessionState::covered_by(std::uint32_t msg_id, std::uint32_t boundary)
+    -> bool {
+    return boundary - msg_id < (std::uint32_t{1} << 31U);
+}
+
+}  // namespace messenger::app
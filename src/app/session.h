@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "app/dedup_window.h"
+#include "protocol/hello.h"
+#include "protocol/sack.h"
+
+namespace messenger::app {
+
+// Состояние сеанса для возобновления после обрыва связи.
+//
+// Каждый запуск получает случайный session_id; msg_id отправителя
+// осмыслены только вместе с ним. Для входящих сообщений хранится окно
+// дедупликации и непрерывная граница last_received: все id собеседника
+// до неё включительно получены; отсчёт она ведёт от first_pending из
+// приветствия собеседника. При каждом подключении стороны обмениваются
+// приветствиями (proto::Hello) со своей границей, и отправитель
+// повторяет только сообщения за границей собеседника, а не весь outbox.
+// Если собеседник пришёл с другим session_id (перезапущен), окно
+// дедупликации сбрасывается: его счёт id начат заново.
+class SessionState {
+public:
+    explicit SessionState(
+        std::uint64_t session_id,
+        std::size_t dedup_window_size = DedupWindow::DEFAULT_WINDOW_SIZE);
+
+    // Итог приветствия собеседника
+    struct Resume {
+        // Собеседник пришёл с другим session_id, чем в прошлый раз
+        bool peer_restarted{false};
+        // Собеседник получил все наши id до этого включительно;
+        // std::nullopt — он не знает наш сеанс (перезапуск, первое
+        // подключение), доставленным ничего считать нельзя
+        std::optional<std::uint32_t> delivered_up_to;
+    };
+
+    // Принять id входящего Text: true — новый, false — дубликат
+    [[nodiscard]]
+    auto accept(std::uint32_t msg_id) -> bool;
+
+    // Приветствие для отправки собеседнику
+    [[nodiscard]]
+    auto hello() const -> proto::Hello;
+
+    [[nodiscard]]
+    auto on_peer_hello(const proto::Hello& peer_hello) -> Resume;
+
+    // Новое соединение: возможности собеседника неизвестны, пока он не
+    // пришлёт приветствие (собеседник прежней версии не пришлёт)
+    void begin_connection();
+
+    // Поддерживает ли собеседник расширение (флаг proto::Hello::FEATURE_*)
+    [[nodiscard]]
+    auto peer_supports(std::uint8_t feature) const -> bool;
+
+    // Блоки полученных id выше непрерывной границы для кадра Sack,
+    // от младших к старшим, не больше SackBlocks::MAX_RANGES
+    [[nodiscard]]
+    auto sack_blocks() const -> proto::SackBlocks;
+
+    [[nodiscard]]
+    auto session_id() const -> std::uint64_t;
+
+    // 0 — собеседник ещё не представился
+    [[nodiscard]]
+    auto peer_session_id() const -> std::uint64_t;
+
+    // Непрерывная граница полученных id; std::nullopt — ничего не получено
+    [[nodiscard]]
+    auto last_received() const -> std::optional<std::uint32_t>;
+
+    // Случайный ненулевой id сеанса
+    [[nodiscard]]
+    static auto generate_session_id() -> std::uint64_t;
+
+    // id не позже границы по арифметике последовательных номеров
+    // (RFC 1982): переход счётчика через 2^32 не ломает сравнение
+    [[nodiscard]]
+    static auto covered_by(std::uint32_t msg_id, std::uint32_t boundary)
+        -> bool;
+
+private:
+    // Сдвинуть непрерывную границу по уже принятым id
+    void advanceBoundary();
+
+    std::uint64_t session_id_;
+    std::uint64_t peer_session_id_{0};
+    std::uint8_t peer_features_{0};
+    DedupWindow seen_;
+    bool any_received_{false};
+    std::uint32_t last_received_{0};
+};
+
+}  // namespace messenger::app
@@ -1,3 +1,6 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include <cstdint>
 #include <cstdlib>
 #include <exception>
@@ -7,10 +10,25 @@
 #include <string_view>
 #include <utility>
 
+#include "app/hub.h"
+#include "app/loopback_bench.h"
 #include "app/p2p_chat.h"
 #include "net/client_socket.h"
+#include "net/reconnect.h"
 #include "net/server_socket.h"
 
+namespace {
+
+// Чат без терминала (stdin — pipe или файл): stdout только для принятых
+// сообщений, служебный вывод — в stderr, включая сообщения о подключении
+void routeStatusToStderr() {
+    if (::isatty(STDIN_FILENO) == 0) {
+        std::cout.rdbuf(std::cerr.rdbuf());
+    }
+}
+
+}  // namespace
+
 // ---------- main() ----------
 
 int main(int argc, char* argv[]) {
@@ -24,7 +42,14 @@ int main(int argc, char* argv[]) {
                 << " сервер <порт>\n"
                 << "  "
                 << argv[0]  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-                << " клиент требуется <хост> <порт>\n";
+                << " клиент требуется <хост> <порт>\n"
+                << "  "
+                << argv[0]  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                << " хаб <порт>\n"
+                << "  "
+                << argv[0]  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                << " бенч [сообщений] [сообщений/с, 0 — без ограничения]"
+                   " [байт]\n";
             return EXIT_FAILURE;
         }
 
@@ -38,8 +63,17 @@ int main(int argc, char* argv[]) {
 
             const uint16_t port = static_cast<uint16_t>(std::stoi(
                 argv[2]));  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-            auto sock = net::create_server_socket(port);
-            app::chat_loop(std::move(sock));
+            routeStatusToStderr();
+            // Слушающий сокет остаётся открытым: клиент, потерявший связь,
+            // подключается заново и возобновляет сеанс
+            const auto listener = net::create_listen_socket(port, 1);
+            std::cout << "Ожидание подключения на порту " << port << "...\n";
+            auto sock = net::accept_client(listener);
+            app::chat_loop(std::move(sock),
+                           [&listener](const net::CancelCheck& cancelled) {
+                               return net::accept_unless_cancelled(listener,
+                                                                   cancelled);
+                           });
             std::cout << "Приложение завершено.\n";
             return EXIT_SUCCESS;
 
@@ -53,11 +87,56 @@ int main(int argc, char* argv[]) {
             const uint16_t port = static_cast<uint16_t>(std::stoi(
                 argv[3]));  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
 
+            routeStatusToStderr();
             auto sock = net::create_client_socket(host, port);
-            app::chat_loop(std::move(sock));
+            net::Backoff backoff;
+            app::chat_loop(std::move(sock),
+                           [host, port, &backoff](
+                               const net::CancelCheck& cancelled) {
+                               return net::connect_with_backoff(
+                                   host, port, backoff, cancelled);
+                           });
+            std::cout << "Приложение завершено.\n";
+            return EXIT_SUCCESS;
+
+        } else if (mode == "хаб") {
+            if (argc != 3) {
+                throw std::invalid_argument("хаб: требуется порт");
+            }
+
+            const uint16_t port = static_cast<uint16_t>(std::stoi(
+                argv[2]));  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            auto listener = net::create_listen_socket(port, SOMAXCONN);
+            std::cout << "Хаб слушает порт " << port << "\n";
+            app::hub_loop(std::move(listener));
             std::cout << "Приложение завершено.\n";
             return EXIT_SUCCESS;
 
+        } else if (mode == "бенч") {
+            if (argc > 5) {
+                throw std::invalid_argument(
+                    "бенч: [сообщений] [сообщений/с] [байт]");
+            }
+
+            // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            app::LoopbackBenchOptions options;
+            if (argc > 2) {
+                options.messages =
+                    static_cast<std::uint32_t>(std::stoul(argv[2]));
+            }
+            if (argc > 3) {
+                options.rate = static_cast<std::uint32_t>(std::stoul(argv[3]));
+            }
+            if (argc > 4) {
+                options.payload_size = std::stoul(argv[4]);
+            }
+            // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+            const app::LoopbackBenchReport report =
+                app::run_loopback_bench(options);
+            app::print_loopback_report(std::cout, options, report);
+            return EXIT_SUCCESS;
+
         } else {
             throw std::invalid_argument("Неизвестный режим: " +
                                         std::string(mode));
@@ -0,0 +1,64 @@
+#include "net/connection.h"
+
+#include <fcntl.h>
+
+#include <cstddef>
+#include <utility>
+
+#include "net/frame_header.h"
+#include "net/frame_reader.h"
+#include "net/outbound_queue.h"
+#include "net/raii_socket.h"
+#include "utils/p2p_error.h"
+
+namespace messenger::net {
+
+void set_nonblocking(int file_fd) {
+    const int flags = ::fcntl(file_fd, F_GETFL);
+    if (flags < 0) {
+        utils::throw_system_error("fcntl(F_GETFL)");
+    }
+    if ((flags & O_NONBLOCK) != 0) {
+        return;
+    }
+    if (::fcntl(file_fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        utils::throw_system_error("fcntl(F_SETFL)");
+    }
+}
+
+Connection::Connection(Socket sock, OutboundQueue::Limits limits,
+                       std::size_t read_chunk)
+    : sock_(std::move(sock)), reader_(read_chunk), outbound_(limits) {
+    set_nonblocking(sock_.fd_return());
+}
+
+[[nodiscard]]
+auto Connection::fd() const -> int {
+    return sock_.fd_return();
+}
+
+[[nodiscard]]
+auto Connection::reader() -> FrameReader& {
+    return reader_;
+}
+
+[[nodiscard]]
+auto Connection::outbound() -> OutboundQueue& {
+    return outbound_;
+}
+
+[[nodiscard]]
+auto Connection::outbound() const -> const OutboundQueue& {
+    return outbound_;
+}
+
+[[nodiscard]]
+auto Connection::header_format() const -> HeaderFormat {
+    return header_format_;
+}
+
+void Connection::set_header_format(HeaderFormat format) {
+    header_format_ = format;
+}
+
+}  // namespace messenger::net
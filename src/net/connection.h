@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+
+#include "net/frame_header.h"
+#include "net/frame_reader.h"
+#include "net/outbound_queue.h"
+#include "net/raii_socket.h"
+
+namespace messenger::net {
+
+// Соединение с собеседником: неблокирующий сокет, буферизованный приём
+// кадров и ограниченная очередь исходящих байт.
+// Сокет переводится в O_NONBLOCK при создании: медленный собеседник не
+// останавливает цикл событий, а копит данные в очереди.
+class Connection {
+public:
+    explicit Connection(Socket sock,
+                        OutboundQueue::Limits limits = OutboundQueue::Limits{},
+                        std::size_t read_chunk = FrameReader::DEFAULT_CHUNK_SIZE);
+
+    [[nodiscard]]
+    auto fd() const -> int;
+
+    [[nodiscard]]
+    auto reader() -> FrameReader&;
+
+    [[nodiscard]]
+    auto outbound() -> OutboundQueue&;
+
+    [[nodiscard]]
+    auto outbound() const -> const OutboundQueue&;
+
+    // Формат заголовков исходящих кадров: v1, пока собеседник не объявил
+    // поддержку v2. Приём понимает оба формата всегда
+    [[nodiscard]]
+    auto header_format() const -> HeaderFormat;
+    void set_header_format(HeaderFormat format);
+
+private:
+    Socket sock_;
+    FrameReader reader_;
+    OutboundQueue outbound_;
+    HeaderFormat header_format_{HeaderFormat::V1};
+};
+
+// Перевести дескриптор в неблокирующий режим.
+// При системной ошибке бросает исключение
+void set_nonblocking(int file_fd);
+
+}  // namespace messenger::net
@@ -0,0 +1,177 @@
+#include "net/event_loop.h"
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <vector>
+
+#include "utils/p2p_error.h"
+
+namespace messenger::net {
+
+namespace {
+
+// Начальный размер буфера событий epoll_wait(); растёт при заполнении
+constexpr std::size_t INITIAL_EVENT_CAPACITY = 64U;
+
+constexpr long NANOSECONDS_PER_SECOND = 1'000'000'000L;
+
+// steady_clock в libstdc++/libc++ на Linux — это CLOCK_MONOTONIC,
+// поэтому time_since_epoch() можно отдавать timerfd с TFD_TIMER_ABSTIME
+[[nodiscard]]
+auto toTimespec(EventLoop::Clock::time_point deadline) -> timespec {
+    const auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 deadline.time_since_epoch())
+                                 .count();
+
+    timespec spec{};
+    if (since_epoch <= 0) {
+        // Нулевое значение снимает таймер — взвести на минимально возможное
+        spec.tv_nsec = 1;
+        return spec;
+    }
+    spec.tv_sec = static_cast<time_t>(since_epoch / NANOSECONDS_PER_SECOND);
+    spec.tv_nsec = static_cast<long>(since_epoch % NANOSECONDS_PER_SECOND);
+    if (spec.tv_sec == 0 && spec.tv_nsec == 0) {
+        spec.tv_nsec = 1;
+    }
+    return spec;
+}
+
+}  // namespace
+
+EventLoop::EventLoop()
+    : raw_events_(INITIAL_EVENT_CAPACITY) {
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        utils::throw_system_error("epoll_create1");
+    }
+
+    timer_fd_ =
+        ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd_ < 0) {
+        ::close(epoll_fd_);
+        utils::throw_system_error("timerfd_create");
+    }
+
+    try {
+        add(timer_fd_, EPOLLIN);
+    } catch (...) {
+        ::close(timer_fd_);
+        ::close(epoll_fd_);
+        throw;
+    }
+
+    ready_.reserve(INITIAL_EVENT_CAPACITY);
+}
+
+EventLoop::~EventLoop() {
+    ::close(timer_fd_);
+    ::close(epoll_fd_);
+}
+
+void EventLoop::add(int watched_fd, std::uint32_t events) {
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = watched_fd;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, watched_fd, &event) < 0) {
+        utils::throw_system_error("epoll_ctl(ADD)");
+    }
+}
+
+void EventLoop::modify(int watched_fd, std::uint32_t events) {
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = watched_fd;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, watched_fd, &event) < 0) {
+        utils::throw_system_error("epoll_ctl(MOD)");
+    }
+}
+
+void EventLoop::remove(int watched_fd) {
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, watched_fd, nullptr) < 0) {
+        // Дескриптор мог быть уже закрыт — это не ошибка для вызывающего
+        if (errno == EBADF || errno == ENOENT) {
+            return;
+        }
+        utils::throw_system_error("epoll_ctl(DEL)");
+    }
+}
+
+void EventLoop::arm_timer(std::optional<Clock::time_point> deadline) {
+    // Тот же дедлайн уже взведён — лишний системный вызов не нужен
+    if (deadline == armed_deadline_) {
+        return;
+    }
+
+    itimerspec spec{};
+    if (deadline.has_value()) {
+        spec.it_value = toTimespec(*deadline);
+    }
+
+    if (::timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr) < 0) {
+        utils::throw_system_error("timerfd_settime");
+    }
+    armed_deadline_ = deadline;
+}
+
+[[nodiscard]]
+auto EventLoop::wait(int timeout_ms) -> const std::vector<Event>& {
+    ready_.clear();
+    timer_expired_ = false;
+
+    const int ret =
+        ::epoll_wait(epoll_fd_, raw_events_.data(),
+                     static_cast<int>(raw_events_.size()), timeout_ms);
+    ++wakeups_;
+
+    if (ret < 0) {
+        if (errno == EINTR) {
+            return ready_;  // прерваны сигналом — вызывающий решит, что делать
+        }
+        utils::throw_system_error("epoll_wait");
+    }
+
+    const auto count = static_cast<std::size_t>(ret);
+    for (std::size_t index = 0; index < count; ++index) {
+        const epoll_event& raw = raw_events_[index];
+
+        if (raw.data.fd == timer_fd_) {
+            std::uint64_t expirations{};
+            // Вычитать счётчик, чтобы timerfd перестал быть готовым
+            static_cast<void>(
+                ::read(timer_fd_, &expirations, sizeof(expirations)));
+            timer_expired_ = true;
+            armed_deadline_.reset();  // одноразовый таймер уже не взведён
+            continue;
+        }
+
+        ready_.push_back(Event{raw.data.fd, raw.events});
+    }
+
+    // Буфер заполнен целиком — вероятно, готовых больше; расширить
+    if (count == raw_events_.size()) {
+        raw_events_.resize(raw_events_.size() * 2);
+    }
+
+    return ready_;
+}
+
+[[nodiscard]]
+auto EventLoop::timer_expired() const -> bool {
+    return timer_expired_;
+}
+
+[[nodiscard]]
+auto EventLoop::wakeups() const -> std::uint64_t {
+    return wakeups_;
+}
+
+}  // namespace messenger::net
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <sys/epoll.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace messenger::net {
+
+// Реактор на epoll + timerfd.
+// Дескрипторы регистрируются один раз (без пересборки множества на каждом
+// круге, как у select()), а таймеры приложения сводятся к одному timerfd,
+// взведённому на ближайший абсолютный дедлайн. Пока дедлайнов нет и нет
+// событий — процесс спит в epoll_wait() без периодических пробуждений.
+
+class EventLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Готовность дескриптора после wait()
+    struct Event {
+        int fd{-1};
+        std::uint32_t events{};
+    };
+
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+    EventLoop(EventLoop&&) = delete;
+    EventLoop& operator=(EventLoop&&) = delete;
+
+    // Регистрация / изменение / снятие наблюдения за дескриптором.
+    // При системной ошибке бросает исключение
+    void add(int watched_fd, std::uint32_t events);
+    void modify(int watched_fd, std::uint32_t events);
+    void remove(int watched_fd);
+
+    // Взвести таймер на абсолютный дедлайн (std::nullopt — снять таймер).
+    // Дедлайн в прошлом срабатывает немедленно.
+    void arm_timer(std::optional<Clock::time_point> deadline);
+
+    // Ожидание событий (timeout_ms = -1 — без ограничения).
+    // Возвращает готовые дескрипторы; срабатывание таймера отражается
+    // в timer_expired(). При EINTR возвращает пустой список.
+    [[nodiscard]]
+    auto wait(int timeout_ms = -1) -> const std::vector<Event>&;
+
+    // Истёк ли таймер при последнем wait()
+    [[nodiscard]]
+    auto timer_expired() const -> bool;
+
+    // Количество пробуждений epoll_wait() (для диагностики и бенчмарков)
+    [[nodiscard]]
+    auto wakeups() const -> std::uint64_t;
+
+private:
+    int epoll_fd_{-1};
+    int timer_fd_{-1};
+    bool timer_expired_{false};
+    std::optional<Clock::time_point> armed_deadline_;
+    std::uint64_t wakeups_{0};
+    std::vector<epoll_event> raw_events_;
+    std::vector<Event> ready_;
+};
+
+}  // namespace messenger::net
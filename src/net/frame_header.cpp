@@ -0,0 +1,131 @@
+#include "net/frame_header.h"
+
+#include <arpa/inet.h>
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#include "net/net_api.h"
+
+namespace messenger::net {
+
+namespace {
+
+constexpr unsigned VARINT_BITS = 7U;
+constexpr std::uint8_t VARINT_MASK = 0x7FU;
+constexpr std::uint8_t VARINT_CONTINUE = 0x80U;
+// Наибольшая длина varint для u32 и допустимые биты его последнего байта
+constexpr std::size_t MAX_VARINT_SIZE = 5;
+constexpr std::uint8_t LAST_VARINT_BYTE_LIMIT = 0x0FU;
+
+void putVarint(std::uint32_t value, HeaderBytes& out) {
+    while (value > VARINT_MASK) {
+        out.data.at(out.size++) =
+            static_cast<std::uint8_t>((value & VARINT_MASK) | VARINT_CONTINUE);
+        value >>= VARINT_BITS;
+    }
+    out.data.at(out.size++) = static_cast<std::uint8_t>(value);
+}
+
+// Чтение varint с позиции pos; pos сдвигается за него
+[[nodiscard]]
+auto getVarint(std::span<const std::uint8_t> bytes, std::size_t& pos,
+               std::uint32_t& value) -> HeaderStatus {
+    value = 0;
+    for (std::size_t index = 0; index < MAX_VARINT_SIZE; ++index) {
+        if (pos == bytes.size()) {
+            return HeaderStatus::Incomplete;
+        }
+        const std::uint8_t byte = bytes[pos++];
+        if (index == MAX_VARINT_SIZE - 1 && byte > LAST_VARINT_BYTE_LIMIT) {
+            return HeaderStatus::Invalid;  // не помещается в u32
+        }
+        value |= static_cast<std::uint32_t>(byte & VARINT_MASK)
+                 << (VARINT_BITS * index);
+        if ((byte & VARINT_CONTINUE) == 0) {
+            return HeaderStatus::Ok;
+        }
+    }
+    return HeaderStatus::Invalid;
+}
+
+[[nodiscard]]
+auto getU32(const std::uint8_t* bytes) -> std::uint32_t {
+    std::array<std::uint8_t, 4> raw{};
+    std::memcpy(raw.data(), bytes, raw.size());
+    return ntohl(std::bit_cast<std::uint32_t>(raw));
+}
+
+}  // namespace
+
+[[nodiscard]]
+auto encode_frame_header(HeaderFormat format, std::uint8_t type,
+                         std::uint32_t msg_id, std::uint32_t payload_size)
+    -> HeaderBytes {
+    HeaderBytes header{};
+    if (format == HeaderFormat::V1) {
+        const auto id_bytes =
+            std::bit_cast<std::array<std::uint8_t, 4>>(htonl(msg_id));
+        const auto len_bytes =
+            std::bit_cast<std::array<std::uint8_t, 4>>(htonl(payload_size));
+        header.data[0] = type;
+        std::memcpy(&header.data[1], id_bytes.data(), id_bytes.size());
+        std::memcpy(&header.data[1 + 4], len_bytes.data(), len_bytes.size());
+        header.size = V1_HEADER_SIZE;
+        return header;
+    }
+
+    header.data[0] = static_cast<std::uint8_t>(
+        (type & TYPE_BYTE_MASK) | COMPACT_HEADER_FLAG |
+        (payload_size != 0 ? PAYLOAD_LENGTH_FLAG : 0U));
+    header.size = 1;
+    putVarint(msg_id, header);
+    if (payload_size != 0) {
+        putVarint(payload_size, header);
+    }
+    return header;
+}
+
+[[nodiscard]]
+auto parse_frame_header(std::span<const std::uint8_t> bytes,
+                        FrameHeader& out) -> HeaderStatus {
+    if (bytes.empty()) {
+        return HeaderStatus::Incomplete;
+    }
+    const std::uint8_t first = bytes.front();
+
+    if ((first & COMPACT_HEADER_FLAG) == 0) {
+        if (bytes.size() < V1_HEADER_SIZE) {
+            return HeaderStatus::Incomplete;
+        }
+        out.type = first;
+        out.id = getU32(bytes.data() + 1);
+        out.payload_size = getU32(bytes.data() + 1 + 4);
+        out.size = V1_HEADER_SIZE;
+    } else {
+        if ((first & RESERVED_HEADER_FLAGS) != 0) {
+            return HeaderStatus::Invalid;
+        }
+        std::size_t pos = 1;
+        HeaderStatus status = getVarint(bytes, pos, out.id);
+        out.payload_size = 0;
+        if (status == HeaderStatus::Ok &&
+            (first & PAYLOAD_LENGTH_FLAG) != 0) {
+            status = getVarint(bytes, pos, out.payload_size);
+        }
+        if (status != HeaderStatus::Ok) {
+            return status;
+        }
+        out.type = static_cast<std::uint8_t>(first & TYPE_BYTE_MASK);
+        out.size = pos;
+    }
+
+    return out.payload_size > MaxPayloadSize::value ? HeaderStatus::Invalid
+                                                    : HeaderStatus::Ok;
+}
+
+}  // namespace messenger::net
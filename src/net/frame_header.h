@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace messenger::net {
+
+// Заголовок кадра в двух форматах.
+//
+//   v1: [type u8][id u32][len u32] — всегда 9 байт, числа в сетевом
+//       порядке байт.
+//   v2: [флаги|type u8][id varint][len varint, если есть payload]
+//
+// Первый байт v2:
+//   0x80 — payload сжат (как в v1, protocol/compress.h)
+//   0x40 — формат v2: в v1 типы не больше 0x0F, и этот бит не встречается
+//   0x20 — есть поле длины; без него payload пустой (Ack, Ping, Pong,
+//          Typing — 2–6 байт вместо 9)
+//   0x10 — зарезервирован, должен быть 0
+//   0x0F — тип
+// varint — 7 бит на байт, младшие вперёд, старший бит — продолжение
+// (LEB128), не длиннее 5 байт. msg_id до 127 занимает байт, до 16383 — два.
+//
+// Формат различим по первому байту каждого кадра, поэтому приём понимает
+// оба без переключения. Отправлять v2 можно, только если собеседник
+// объявил его в приветствии (proto::Hello::FEATURE_COMPACT_HEADER).
+enum class HeaderFormat : std::uint8_t {
+    V1,
+    V2,
+};
+
+// Размер заголовка v1
+constexpr std::size_t V1_HEADER_SIZE = 1 + 4 + 4;
+// Наибольший размер заголовка любого формата (v2: 1 + 5 + 5)
+constexpr std::size_t MAX_HEADER_SIZE = 11;
+
+// Биты первого байта v2
+constexpr std::uint8_t COMPACT_HEADER_FLAG = 0x40U;
+constexpr std::uint8_t PAYLOAD_LENGTH_FLAG = 0x20U;
+constexpr std::uint8_t RESERVED_HEADER_FLAGS = 0x10U;
+// Тип кадра вместе с флагом сжатия — байт типа в записи v1
+constexpr std::uint8_t TYPE_BYTE_MASK = 0x8FU;
+
+// Разобранный заголовок
+struct FrameHeader {
+    // Байт типа как в v1: тип и флаг сжатия
+    std::uint8_t type{};
+    std::uint32_t id{};
+    std::uint32_t payload_size{};
+    // Длина самого заголовка, байт
+    std::size_t size{};
+};
+
+// Закодированный заголовок на стеке
+struct HeaderBytes {
+    std::array<std::uint8_t, MAX_HEADER_SIZE> data{};
+    std::size_t size{};
+
+    [[nodiscard]]
+    auto view() const -> std::span<const std::uint8_t> {
+        return {data.data(), size};
+    }
+};
+
+enum class HeaderStatus {
+    Ok,
+    Incomplete,  // заголовок ещё не пришёл целиком
+    Invalid      // зарезервированный бит, длинный varint, len сверх предела
+};
+
+// type — байт типа как в v1 (тип и флаг сжатия)
+[[nodiscard]]
+auto encode_frame_header(HeaderFormat format, std::uint8_t type,
+                         std::uint32_t msg_id, std::uint32_t payload_size)
+    -> HeaderBytes;
+
+// Разбор заголовка в начале bytes (в любом формате). payload_size больше
+// MaxPayloadSize — Invalid
+[[nodiscard]]
+auto parse_frame_header(std::span<const std::uint8_t> bytes,
+                        FrameHeader& out) -> HeaderStatus;
+
+}  // namespace messenger::net
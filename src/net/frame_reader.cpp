@@ -0,0 +1,147 @@
+#include "net/frame_reader.h"
+
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include "net/frame_header.h"
+#include "net/net_metrics.h"
+#include "utils/p2p_error.h"
+
+namespace messenger::net {
+
+FrameReader::FrameReader(std::size_t chunk_size)
+    : chunk_size_(std::max(chunk_size, MAX_HEADER_SIZE)) {}
+
+[[nodiscard]]
+auto FrameReader::fill(int socket_fd) -> ReadStatus {
+    std::size_t want = chunk_size_;
+
+    // Начатый кадр крупнее блока — сразу место под него целиком, чтобы
+    // большой payload дочитывался без лишних уплотнений
+    const std::size_t pending = buffered();
+    FrameHeader header{};
+    if (parse_frame_header({buffer_.data() + read_pos_, pending}, header) ==
+        HeaderStatus::Ok) {
+        const std::size_t frame_size = header.size + header.payload_size;
+        if (frame_size > pending) {
+            want = std::max(want, frame_size - pending);
+        }
+    }
+    reserveTail(want);
+
+    while (true) {
+        ++recv_calls_;
+        const auto ret = ::recv(socket_fd, buffer_.data() + write_pos_,
+                                buffer_.size() - write_pos_, 0);
+
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return ReadStatus::WouldBlock;
+            }
+            // Сброс соединения — такое же отключение собеседника, как FIN
+            if (errno == ECONNRESET) {
+                return ReadStatus::Closed;
+            }
+            utils::throw_system_error("recv");
+        }
+
+        if (ret == 0) {
+            return ReadStatus::Closed;
+        }
+
+        write_pos_ += static_cast<std::size_t>(ret);
+        net_metrics().received_bytes.add(static_cast<std::uint64_t>(ret));
+        return ReadStatus::Ok;
+    }
+}
+
+[[nodiscard]]
+auto FrameReader::next_frame(std::span<const std::uint8_t>& frame)
+    -> FrameStatus {
+    const std::size_t pending = buffered();
+    const std::uint8_t* begin = buffer_.data() + read_pos_;
+    FrameHeader header{};
+    const HeaderStatus status = parse_frame_header({begin, pending}, header);
+    if (status == HeaderStatus::Incomplete) {
+        return FrameStatus::Incomplete;
+    }
+    if (status == HeaderStatus::Invalid) {
+        return FrameStatus::Invalid;
+    }
+
+    const std::size_t frame_size = header.size + header.payload_size;
+    if (pending < frame_size) {
+        return FrameStatus::Incomplete;
+    }
+
+    frame = std::span<const std::uint8_t>(begin, frame_size);
+    read_pos_ += frame_size;
+    net_metrics().received_frames.add();
+
+    // Буфер опустел — следующий fill() пишет с начала без уплотнения.
+    // Байты выданного кадра при этом не затираются до fill()
+    if (read_pos_ == write_pos_) {
+        read_pos_ = 0;
+        write_pos_ = 0;
+    }
+
+    return FrameStatus::Ready;
+}
+
+[[nodiscard]]
+auto FrameReader::buffered() const -> std::size_t {
+    return write_pos_ - read_pos_;
+}
+
+[[nodiscard]]
+auto FrameReader::recv_calls() const -> std::uint64_t {
+    return recv_calls_;
+}
+
+void FrameReader::release_if_idle() {
+    if (buffered() == 0) {
+        std::vector<std::uint8_t>().swap(buffer_);
+        read_pos_ = 0;
+        write_pos_ = 0;
+    }
+}
+
+void FrameReader::reserveTail(std::size_t min_free) {
+    const std::size_t pending = buffered();
+
+    // После крупного кадра вернуться к обычному размеру блока
+    if (pending == 0 && buffer_.size() > chunk_size_ &&
+        min_free <= chunk_size_) {
+        std::vector<std::uint8_t>(chunk_size_).swap(buffer_);
+        read_pos_ = 0;
+        write_pos_ = 0;
+        return;
+    }
+
+    if (buffer_.size() - write_pos_ >= min_free) {
+        return;
+    }
+
+    // Уплотнение: перенести незавершённый кадр в начало буфера
+    if (read_pos_ > 0) {
+        std::memmove(buffer_.data(), buffer_.data() + read_pos_, pending);
+        read_pos_ = 0;
+        write_pos_ = pending;
+    }
+
+    if (buffer_.size() - write_pos_ < min_free) {
+        buffer_.resize(write_pos_ + min_free);
+    }
+}
+
+}  // namespace messenger::net
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace messenger::net {
+
+// Буферизованный приём кадров [заголовок][payload] с одного соединения;
+// заголовок в формате v1 или v2 (net/frame_header.h).
+//
+// fill() читает из сокета крупным блоком за один recv(), next_frame()
+// выдаёт все кадры, уже целиком лежащие в буфере. Так пачка мелких
+// Ack/Ping/Typing разбирается за одно пробуждение и один системный вызов
+// вместо двух recv() на каждый кадр.
+//
+// Буфер работает как кольцо с уплотнением: прочитанные байты не сдвигаются
+// после каждого кадра, а остаток незавершённого кадра переносится в начало
+// только когда в хвосте не хватает места. Кадр в буфере всегда непрерывен,
+// поэтому его можно отдавать наружу без копирования.
+class FrameReader {
+public:
+    // Размер блока чтения по умолчанию
+    static constexpr std::size_t DEFAULT_CHUNK_SIZE = 64U * 1024U;
+
+    enum class ReadStatus {
+        Ok,          // в буфер добавлены данные
+        WouldBlock,  // данных пока нет (EAGAIN)
+        Closed       // собеседник закрыл соединение
+    };
+
+    enum class FrameStatus {
+        Ready,       // кадр выдан
+        Incomplete,  // в буфере нет целого кадра
+        Invalid      // ошибка протокола (заголовок, слишком большой len)
+    };
+
+    explicit FrameReader(std::size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+    // Один recv() в свободный хвост буфера.
+    // При системной ошибке бросает исключение
+    [[nodiscard]]
+    auto fill(int socket_fd) -> ReadStatus;
+
+    // Следующий целый кадр (заголовок + payload) без копирования.
+    // frame указывает внутрь буфера и действителен до следующего fill().
+    [[nodiscard]]
+    auto next_frame(std::span<const std::uint8_t>& frame) -> FrameStatus;
+
+    // Количество принятых, но ещё не выданных байт
+    [[nodiscard]]
+    auto buffered() const -> std::size_t;
+
+    // Количество вызовов recv() (для диагностики и бенчмарков)
+    [[nodiscard]]
+    auto recv_calls() const -> std::uint64_t;
+
+    // Освободить память буфера, если в нём нет незавершённых данных:
+    // простаивающее соединение не удерживает блок чтения
+    void release_if_idle();
+
+private:
+    // Обеспечить в хвосте место хотя бы под min_free байт
+    void reserveTail(std::size_t min_free);
+
+    std::vector<std::uint8_t> buffer_;
+    std::size_t read_pos_{0};
+    std::size_t write_pos_{0};
+    std::size_t chunk_size_;
+    std::uint64_t recv_calls_{0};
+};
+
+}  // namespace messenger::net
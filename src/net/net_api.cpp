@@ -1,15 +1,20 @@
 #include "net/net_api.h"
 
 #include <arpa/inet.h>
+#include <poll.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <cerrno>
 #include <cstddef>
 #include <cstdint>
+#include <span>
 #include <vector>
 
+#include "net/net_metrics.h"
 #include "utils/p2p_error.h"
 
 namespace messenger::net {
@@ -18,6 +23,18 @@ namespace {
 
 constexpr std::size_t HEADER_SIZE = 1 + 4 + 4;
 
+// Ожидание готовности неблокирующего сокета вместо кручения на EAGAIN
+void waitReady(int socket_fd, short events) {
+    pollfd poll_fd{};
+    poll_fd.fd = socket_fd;
+    poll_fd.events = events;
+    while (::poll(&poll_fd, 1, -1) < 0) {
+        if (errno != EINTR) {
+            utils::throw_system_error("poll");
+        }
+    }
+}
+
 [[nodiscard]]
 auto recv_some(int socket_fd, std::vector<std::uint8_t>& buffer,
                std::size_t offset, std::size_t bytes_to_read) -> std::size_t {
@@ -34,7 +51,10 @@ auto recv_some(int socket_fd, std::vector<std::uint8_t>& buffer,
                 continue;
             }
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                break;
+                // Остаток кадра ещё в пути — дождаться, а не вернуть
+                // обрезанную нагрузку
+                waitReady(socket_fd, POLLIN);
+                continue;
             }
             utils::throw_system_error("recv");
         }
@@ -70,6 +90,7 @@ auto send_bytes(int socket_fd, const std::vector<std::uint8_t>& data) -> bool {
                 continue;
             }
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                waitReady(socket_fd, POLLOUT);
                 continue;
             }
             utils::throw_system_error("send");
@@ -83,6 +104,69 @@ auto send_bytes(int socket_fd, const std::vector<std::uint8_t>& data) -> bool {
         total_sent += static_cast<std::size_t>(ret);
     }
 
+    net_metrics().sent_bytes.add(total_sent);
+    net_metrics().sent_frames.add();
+    return total_sent == total_size;
+}
+
+[[nodiscard]]
+auto send_frame(int socket_fd, std::span<const std::uint8_t> header,
+                std::span<const std::uint8_t> payload) -> bool {
+    // const_cast только ради типа iovec: sendmsg() данные не изменяет
+    std::array<iovec, 2> parts{
+        // NOLINTBEGIN(cppcoreguidelines-pro-type-const-cast)
+        iovec{const_cast<std::uint8_t*>(header.data()), header.size()},
+        iovec{const_cast<std::uint8_t*>(payload.data()), payload.size()}
+        // NOLINTEND(cppcoreguidelines-pro-type-const-cast)
+    };
+    std::size_t first_part = 0;
+    const std::size_t parts_count = payload.empty() ? 1U : 2U;
+
+    const std::size_t total_size = header.size() + payload.size();
+    std::size_t total_sent = 0;
+
+    while (total_sent < total_size) {
+        msghdr message{};
+        message.msg_iov = &parts.at(first_part);
+        message.msg_iovlen = parts_count - first_part;
+
+        // MSG_NOSIGNAL: запись в закрытый сокет — ошибка, а не SIGPIPE
+        const auto ret = ::sendmsg(socket_fd, &message, MSG_NOSIGNAL);
+
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                waitReady(socket_fd, POLLOUT);
+                continue;
+            }
+            utils::throw_system_error("sendmsg");
+        }
+
+        if (ret == 0) {
+            // Соединение закрыто или недоступно
+            break;
+        }
+
+        // Продвинуть iovec на отправленное при частичной записи
+        auto sent = static_cast<std::size_t>(ret);
+        total_sent += sent;
+        while (sent > 0 && first_part < parts_count) {
+            iovec& part = parts.at(first_part);
+            if (sent >= part.iov_len) {
+                sent -= part.iov_len;
+                ++first_part;
+                continue;
+            }
+            part.iov_base = static_cast<std::uint8_t*>(part.iov_base) + sent;
+            part.iov_len -= sent;
+            sent = 0;
+        }
+    }
+
+    net_metrics().sent_bytes.add(total_sent);
+    net_metrics().sent_frames.add();
     return total_sent == total_size;
 }
 
@@ -90,8 +174,7 @@ auto send_bytes(int socket_fd, const std::vector<std::uint8_t>& data) -> bool {
 auto recv_bytes(int socket_fd, std::vector<std::uint8_t>& out) -> bool {
     out.clear();
 
-    std::vector<std::uint8_t> header(
-        HEADER_SIZE);  // вектор из HEADER_SIZE элементов
+    std::array<std::uint8_t, HEADER_SIZE> header{};
     std::size_t received_header{0};
 
     while (received_header < HEADER_SIZE) {
@@ -105,6 +188,7 @@ auto recv_bytes(int socket_fd, std::vector<std::uint8_t>& out) -> bool {
                 continue;
             }
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                waitReady(socket_fd, POLLIN);
                 continue;
             }
             utils::throw_system_error("recv");
@@ -141,19 +225,19 @@ auto recv_bytes(int socket_fd, std::vector<std::uint8_t>& out) -> bool {
     out.resize(HEADER_SIZE + static_cast<std::size_t>(payload_size));
     std::copy(header.begin(), header.end(), out.begin());
 
-    if (payload_size == 0) {
-        return true;
+    std::size_t received_payload = 0;
+    if (payload_size != 0) {
+        received_payload = recv_some(socket_fd, out, HEADER_SIZE,
+                                     static_cast<std::size_t>(payload_size));
     }
 
-    const std::size_t bytes_to_read = static_cast<std::size_t>(payload_size);
-    const std::size_t received_payload =
-        recv_some(socket_fd, out, HEADER_SIZE, bytes_to_read);
-
     // Если payload неполный (обрыв соединения), вернуть true и
     // частичный фрейм — решение валидно ли сообщение за протоколом
     const std::size_t actual_size = HEADER_SIZE + received_payload;
     out.resize(actual_size);
 
+    net_metrics().received_bytes.add(actual_size);
+    net_metrics().received_frames.add();
     return true;
 }
 
@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <span>
 #include <vector>
 
 namespace messenger::net {
@@ -9,12 +10,22 @@ namespace messenger::net {
 // Максимальный размер полезной нагрузки (1 МБ)
 using MaxPayloadSize = std::integral_constant<std::size_t, 1024U * 1024U>;
 
-// Отправка всех байтов.
+// Отправка всех байтов (блокирующая семантика).
 // Возвращает true, если все байты были отправлены.
+// На неблокирующем сокете при EAGAIN ждёт готовности через poll(),
+// а не крутится в цикле. Для цикла событий — OutboundQueue.
 // При системной ошибке бросает исключение
 [[nodiscard]]
 auto send_bytes(int socket_fd, const std::vector<std::uint8_t>& data) -> bool;
 
+// Отправка кадра из двух частей — заголовка и полезной нагрузки — одним
+// sendmsg() (scatter-gather) без сборки в промежуточный буфер: заголовок
+// берётся из буфера на стеке вызывающего, payload — из его же хранилища.
+// Семантика возврата и ошибок как у send_bytes
+[[nodiscard]]
+auto send_frame(int socket_fd, std::span<const std::uint8_t> header,
+                std::span<const std::uint8_t> payload) -> bool;
+
 // Приём одного фрейма [type][id][len][payload].
 // out очищается в начале.
 // Семантика:
@@ -0,0 +1,22 @@
+#include "net/net_metrics.h"
+
+#include "utils/metrics.h"
+
+namespace messenger::net {
+
+[[nodiscard]]
+auto net_metrics() -> const NetMetrics& {
+    static const NetMetrics metrics{
+        utils::metrics().counter("messenger_net_sent_bytes_total",
+                                 "Байт отправлено в сокеты"),
+        utils::metrics().counter("messenger_net_sent_frames_total",
+                                 "Кадров поставлено на отправку"),
+        utils::metrics().counter("messenger_net_received_bytes_total",
+                                 "Байт принято из сокетов"),
+        utils::metrics().counter("messenger_net_received_frames_total",
+                                 "Кадров принято"),
+    };
+    return metrics;
+}
+
+}  // namespace messenger::net
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "utils/metrics.h"
+
+namespace messenger::net {
+
+// Счётчики сетевого уровня в общем реестре (utils::metrics()): байты и
+// кадры через сокеты — и блокирующим путём (send_bytes, send_frame,
+// recv_bytes), и неблокирующим (OutboundQueue, FrameReader)
+struct NetMetrics {
+    utils::Counter& sent_bytes;
+    utils::Counter& sent_frames;
+    utils::Counter& received_bytes;
+    utils::Counter& received_frames;
+};
+
+[[nodiscard]]
+auto net_metrics() -> const NetMetrics&;
+
+}  // namespace messenger::net
@@ -0,0 +1,321 @@
+#include "net/outbound_queue.h"
+
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "net/net_metrics.h"
+#include "utils/p2p_error.h"
+
+namespace messenger::net {
+
+namespace {
+
+// Результат одной неблокирующей записи
+struct WriteResult {
+    std::size_t written{0};
+    bool closed{false};
+};
+
+// Неблокирующая запись нескольких частей одним sendmsg()
+[[nodiscard]]
+auto writeParts(int socket_fd, std::span<iovec> parts) -> WriteResult {
+    msghdr message{};
+    message.msg_iov = parts.data();
+    message.msg_iovlen = parts.size();
+
+    while (true) {
+        const auto ret =
+            ::sendmsg(socket_fd, &message, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (ret >= 0) {
+            net_metrics().sent_bytes.add(static_cast<std::uint64_t>(ret));
+            return WriteResult{static_cast<std::size_t>(ret), false};
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return WriteResult{0, false};
+        }
+        if (errno == EPIPE || errno == ECONNRESET) {
+            return WriteResult{0, true};
+        }
+        utils::throw_system_error("sendmsg");
+    }
+}
+
+}  // namespace
+
+OutboundQueue::OutboundQueue() : OutboundQueue(Limits{}) {}
+
+OutboundQueue::OutboundQueue(Limits limits) : limits_(limits) {}
+
+[[nodiscard]]
+auto OutboundQueue::send(int socket_fd, std::span<const std::uint8_t> header,
+                         std::span<const std::uint8_t> payload) -> Status {
+    const std::size_t frame_size = header.size() + payload.size();
+
+    // Очередь не пуста — писать напрямую нельзя, иначе нарушится порядок
+    if (!empty()) {
+        if (queued_bytes() + frame_size > limits_.capacity) {
+            return Status::Full;
+        }
+        append(header);
+        append(payload);
+        updateWatermark();
+        net_metrics().sent_frames.add();
+        return Status::Ok;
+    }
+
+    // const_cast только ради типа iovec: sendmsg() данные не изменяет
+    std::array<iovec, 2> parts{
+        // NOLINTBEGIN(cppcoreguidelines-pro-type-const-cast)
+        iovec{const_cast<std::uint8_t*>(header.data()), header.size()},
+        iovec{const_cast<std::uint8_t*>(payload.data()), payload.size()}
+        // NOLINTEND(cppcoreguidelines-pro-type-const-cast)
+    };
+    const std::size_t parts_count = payload.empty() ? 1U : 2U;
+
+    const WriteResult result =
+        writeParts(socket_fd, std::span<iovec>(parts.data(), parts_count));
+    if (result.closed) {
+        closed_ = true;
+        return Status::Closed;
+    }
+    if (result.written == frame_size) {
+        net_metrics().sent_frames.add();
+        return Status::Ok;  // быстрый путь: без копирования в очередь
+    }
+
+    // Ничего не ушло и кадр не помещается — отказ целиком
+    if (result.written == 0 && frame_size > limits_.capacity) {
+        return Status::Full;
+    }
+
+    // Остаток начатого кадра ставится в очередь обязательно, даже сверх
+    // capacity: оборванный кадр рассинхронизировал бы поток
+    if (result.written < header.size()) {
+        append(header.subspan(result.written));
+        append(payload);
+    } else {
+        append(payload.subspan(result.written - header.size()));
+    }
+    updateWatermark();
+    net_metrics().sent_frames.add();
+    return Status::Ok;
+}
+
+[[nodiscard]]
+auto OutboundQueue::send_file(int socket_fd,
+                              std::span<const std::uint8_t> header,
+                              int file_fd, std::uint64_t offset,
+                              std::size_t length) -> Status {
+    if (file_pending()) {
+        return Status::Full;
+    }
+    const std::size_t frame_size = header.size() + length;
+
+    if (!empty()) {
+        if (queued_bytes() + frame_size > limits_.capacity) {
+            return Status::Full;
+        }
+        append(header);
+        file_ = FileSegment{file_fd, offset, length};
+        updateWatermark();
+        net_metrics().sent_frames.add();
+        return Status::Ok;
+    }
+
+    // NOLINTBEGIN(cppcoreguidelines-pro-type-const-cast)
+    std::array<iovec, 1> parts{
+        iovec{const_cast<std::uint8_t*>(header.data()), header.size()}};
+    // NOLINTEND(cppcoreguidelines-pro-type-const-cast)
+    const WriteResult result = writeParts(socket_fd, parts);
+    if (result.closed) {
+        closed_ = true;
+        return Status::Closed;
+    }
+    if (result.written == 0 && frame_size > limits_.capacity) {
+        return Status::Full;
+    }
+
+    append(header.subspan(result.written));
+    file_ = FileSegment{file_fd, offset, length};
+    // Заголовок ушёл целиком — байты файла следом, без очереди
+    if (head_ == buffer_.size()) {
+        if (!writeFile(socket_fd)) {
+            closed_ = true;
+            return Status::Closed;
+        }
+    }
+    updateWatermark();
+    net_metrics().sent_frames.add();
+    return Status::Ok;
+}
+
+[[nodiscard]]
+auto OutboundQueue::closed() const -> bool {
+    return closed_;
+}
+
+[[nodiscard]]
+auto OutboundQueue::file_truncated() const -> bool {
+    return file_truncated_;
+}
+
+[[nodiscard]]
+auto OutboundQueue::file_pending() const -> bool {
+    return file_.remaining != 0;
+}
+
+[[nodiscard]]
+auto OutboundQueue::flush(int socket_fd) -> Status {
+    while (!empty()) {
+        if (head_ == buffer_.size()) {
+            // Байты до участка файла дописаны — очередь за ним
+            if (!writeFile(socket_fd)) {
+                closed_ = true;
+                return Status::Closed;
+            }
+            if (file_pending()) {
+                break;
+            }
+            continue;
+        }
+
+        std::array<iovec, 1> parts{
+            iovec{buffer_.data() + head_, buffer_.size() - head_}};
+        const WriteResult result = writeParts(socket_fd, parts);
+        if (result.closed) {
+            closed_ = true;
+            return Status::Closed;
+        }
+        if (result.written == 0) {
+            break;  // сокет снова заполнен — ждать следующего EPOLLOUT
+        }
+        head_ += result.written;
+    }
+
+    if (empty()) {
+        buffer_.clear();
+        head_ = 0;
+    } else if (head_ > buffer_.size() / 2) {
+        // Уплотнение, чтобы буфер не рос за счёт уже отправленного
+        buffer_.erase(buffer_.begin(),
+                      buffer_.begin() + static_cast<std::ptrdiff_t>(head_));
+        head_ = 0;
+    }
+
+    updateWatermark();
+    return Status::Ok;
+}
+
+[[nodiscard]]
+auto OutboundQueue::empty() const -> bool {
+    return head_ == buffer_.size() && !file_pending();
+}
+
+[[nodiscard]]
+auto OutboundQueue::queued_bytes() const -> std::size_t {
+    return buffer_.size() - head_ + file_.remaining + after_file_.size();
+}
+
+[[nodiscard]]
+auto OutboundQueue::peak_bytes() const -> std::size_t {
+    return peak_;
+}
+
+[[nodiscard]]
+auto OutboundQueue::above_high_watermark() const -> bool {
+    return above_high_;
+}
+
+[[nodiscard]]
+auto OutboundQueue::limits() const -> const Limits& {
+    return limits_;
+}
+
+void OutboundQueue::set_watermark_handler(WatermarkHandler handler) {
+    watermark_handler_ = std::move(handler);
+}
+
+void OutboundQueue::release_if_idle() {
+    if (empty()) {
+        std::vector<std::uint8_t>().swap(buffer_);
+        head_ = 0;
+    }
+}
+
+void OutboundQueue::append(std::span<const std::uint8_t> bytes) {
+    std::vector<std::uint8_t>& target =
+        file_pending() ? after_file_ : buffer_;
+    target.insert(target.end(), bytes.begin(), bytes.end());
+}
+
+[[nodiscard]]
+auto OutboundQueue::writeFile(int socket_fd) -> bool {
+    while (file_pending()) {
+        auto offset = static_cast<off_t>(file_.offset);
+        const ssize_t sent =
+            ::sendfile(socket_fd, file_.fd, &offset, file_.remaining);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;  // дописать по следующему EPOLLOUT
+            }
+            if (errno == EPIPE || errno == ECONNRESET) {
+                return false;
+            }
+            utils::throw_system_error("sendfile");
+        }
+        if (sent == 0) {
+            // Файл укоротили во время отправки. Кадр уже обещал
+            // собеседнику length байт, а подменные байты выдали бы
+            // испорченный файл за принятый: поток кадров обрывается
+            file_truncated_ = true;
+            return false;
+        }
+        net_metrics().sent_bytes.add(static_cast<std::uint64_t>(sent));
+        file_.offset += static_cast<std::uint64_t>(sent);
+        file_.remaining -= static_cast<std::size_t>(sent);
+    }
+    finishFile();
+    return true;
+}
+
+void OutboundQueue::finishFile() {
+    buffer_.insert(buffer_.end(), after_file_.begin(), after_file_.end());
+    after_file_.clear();
+    file_ = FileSegment{};
+}
+
+void OutboundQueue::updateWatermark() {
+    const std::size_t depth = queued_bytes();
+    if (depth > peak_) {
+        peak_ = depth;
+    }
+
+    if (!above_high_ && depth >= limits_.high_watermark) {
+        above_high_ = true;
+        if (watermark_handler_) {
+            watermark_handler_(true);
+        }
+    } else if (above_high_ && depth <= limits_.low_watermark) {
+        above_high_ = false;
+        if (watermark_handler_) {
+            watermark_handler_(false);
+        }
+    }
+}
+
+}  // namespace messenger::net
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+namespace messenger::net {
+
+// Ограниченная очередь исходящих байт одного соединения.
+//
+// Кадр сначала пишется в неблокирующий сокет напрямую; не поместившийся
+// остаток копируется в очередь и дописывается flush() по готовности сокета
+// к записи (EPOLLOUT). Вместо кручения на EAGAIN вызывающий получает явные
+// сигналы противодавления: переход через верхнюю отметку (high watermark)
+// и возврат ниже нижней (low watermark) с гистерезисом.
+//
+// Полезная нагрузка кадра может быть участком файла (send_file): байты
+// уходят из page cache в сокет через sendfile(), минуя память процесса.
+// Недописанный остаток участка занимает место в очереди между байтами,
+// поставленными до и после него, так что порядок кадров сохраняется.
+// Если файл укоротили во время отправки, обещанные заголовком байты
+// взять негде: кадр не добивается подменными байтами, а соединение
+// считается закрытым (file_truncated()).
+class OutboundQueue {
+public:
+    struct Limits {
+        // Жёсткий предел очереди: кадр сверх него не принимается
+        std::size_t capacity{4U * 1024U * 1024U};
+        // Переход в состояние «перегружен»
+        std::size_t high_watermark{1024U * 1024U};
+        // Возврат в обычное состояние
+        std::size_t low_watermark{256U * 1024U};
+    };
+
+    enum class Status {
+        Ok,      // кадр отправлен или поставлен в очередь / очередь дописана
+        Full,    // кадр не принят: очередь достигла capacity
+        Closed   // собеседник закрыл соединение (EPIPE/ECONNRESET)
+    };
+
+    // Вызывается при переходе через отметки: true — выше high,
+    // false — снова ниже low
+    using WatermarkHandler = std::function<void(bool above_high)>;
+
+    OutboundQueue();
+    explicit OutboundQueue(Limits limits);
+
+    // Отправка кадра [header][payload]. Кадр принимается целиком или
+    // (Status::Full) не принимается вовсе — поток не рассинхронизируется.
+    // При системной ошибке бросает исключение
+    [[nodiscard]]
+    auto send(int socket_fd, std::span<const std::uint8_t> header,
+              std::span<const std::uint8_t> payload) -> Status;
+
+    // Отправка кадра [header][length байт файла с offset]. В очереди может
+    // ждать только один участок файла: пока он не дописан, следующий
+    // не принимается (Status::Full). При системной ошибке бросает
+    // исключение
+    [[nodiscard]]
+    auto send_file(int socket_fd, std::span<const std::uint8_t> header,
+                   int file_fd, std::uint64_t offset, std::size_t length)
+        -> Status;
+
+    // Собеседник закрыл соединение (хоть раз вернулся Status::Closed):
+    // отказ в отправке — потеря связи, а не противодавление
+    [[nodiscard]]
+    auto closed() const -> bool;
+
+    // Соединение закрыто потому, что файл укоротили посреди участка:
+    // кадр FileChunk оборван, и отправленное им собеседнику не доверять
+    [[nodiscard]]
+    auto file_truncated() const -> bool;
+
+    // Ждёт ли в очереди участок файла
+    [[nodiscard]]
+    auto file_pending() const -> bool;
+
+    // Дописать очередь, пока сокет принимает данные.
+    // При системной ошибке бросает исключение
+    [[nodiscard]]
+    auto flush(int socket_fd) -> Status;
+
+    [[nodiscard]]
+    auto empty() const -> bool;
+
+    // Текущая глубина очереди в байтах, включая недописанный участок файла
+    [[nodiscard]]
+    auto queued_bytes() const -> std::size_t;
+
+    // Максимальная глубина очереди за время жизни соединения
+    [[nodiscard]]
+    auto peak_bytes() const -> std::size_t;
+
+    [[nodiscard]]
+    auto above_high_watermark() const -> bool;
+
+    [[nodiscard]]
+    auto limits() const -> const Limits&;
+
+    void set_watermark_handler(WatermarkHandler handler);
+
+    // Освободить память пустой очереди
+    void release_if_idle();
+
+private:
+    // Участок файла, ещё не записанный в сокет
+    struct FileSegment {
+        int fd{-1};
+        std::uint64_t offset{0};
+        std::size_t remaining{0};
+    };
+
+    void append(std::span<const std::uint8_t> bytes);
+    void updateWatermark();
+    // Записать участок файла, пока сокет принимает данные. false —
+    // собеседник закрыл соединение или файл укоротили
+    [[nodiscard]]
+    auto writeFile(int socket_fd) -> bool;
+    // Участок дописан: байты, поставленные после него, идут следом
+    void finishFile();
+
+    Limits limits_;
+    // Байты до участка файла (или все, если участка нет)
+    std::vector<std::uint8_t> buffer_;
+    std::size_t head_{0};
+    FileSegment file_;
+    // Байты, поставленные после участка файла
+    std::vector<std::uint8_t> after_file_;
+    std::size_t peak_{0};
+    bool above_high_{false};
+    bool closed_{false};
+    bool file_truncated_{false};
+    WatermarkHandler watermark_handler_;
+};
+
+}  // namespace messenger::net
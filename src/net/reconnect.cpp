@@ -0,0 +1,123 @@
+#include "net/reconnect.h"
+
+#include <poll.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+#include "net/client_socket.h"
+#include "net/raii_socket.h"
+#include "net/server_socket.h"
+#include "utils/p2p_error.h"
+
+namespace messenger::net {
+
+namespace {
+
+// Шаг, с которым паузы и ожидание accept() проверяют отмену
+constexpr std::chrono::milliseconds CANCEL_POLL_STEP{100};
+
+// Пауза, прерываемая отменой. false — ожидание отменено
+[[nodiscard]]
+auto sleepUnlessCancelled(Backoff::Delay delay, const CancelCheck& cancelled)
+    -> bool {
+    const auto deadline = std::chrono::steady_clock::now() + delay;
+    while (!cancelled()) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            return true;
+        }
+        std::this_thread::sleep_for(
+            std::min<std::chrono::steady_clock::duration>(deadline - now,
+                                                          CANCEL_POLL_STEP));
+    }
+    return false;
+}
+
+}  // namespace
+
+Backoff::Backoff() : Backoff(Options{}) {}
+
+Backoff::Backoff(Options options)
+    : options_(options),
+      base_(options.initial),
+      random_(std::random_device{}()) {}
+
+[[nodiscard]]
+auto Backoff::next_delay() -> Delay {
+    const Delay base = base_;
+    base_ = std::min(base_ * 2, options_.max);
+    ++attempts_;
+
+    // Equal jitter: половина базы гарантирована, половина — случайна
+    const auto half = base.count() / 2;
+    std::uniform_int_distribution<Delay::rep> jitter(0, base.count() - half);
+    return Delay{half + jitter(random_)};
+}
+
+void Backoff::reset() {
+    base_ = options_.initial;
+    attempts_ = 0;
+}
+
+[[nodiscard]]
+auto Backoff::attempts() const -> std::uint32_t {
+    return attempts_;
+}
+
+[[nodiscard]]
+auto Backoff::options() const -> const Options& {
+    return options_;
+}
+
+[[nodiscard]]
+auto connect_with_backoff(std::string_view host, std::uint16_t port,
+                          Backoff& backoff, const CancelCheck& cancelled)
+    -> std::optional<Socket> {
+    while (!cancelled()) {
+        try {
+            Socket sock = create_client_socket(host, port);
+            backoff.reset();
+            return sock;
+        } catch (const std::system_error& error) {
+            const Backoff::Delay delay = backoff.next_delay();
+            std::cout << "[Не удалось подключиться: " << error.what()
+                      << ", повтор через " << delay.count() << " мс]\n";
+            if (!sleepUnlessCancelled(delay, cancelled)) {
+                break;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+[[nodiscard]]
+auto accept_unless_cancelled(const Socket& listener,
+                             const CancelCheck& cancelled)
+    -> std::optional<Socket> {
+    pollfd listener_poll{listener.fd_return(), POLLIN, 0};
+    while (!cancelled()) {
+        const int ready = ::poll(&listener_poll, 1,
+                                 static_cast<int>(CANCEL_POLL_STEP.count()));
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            utils::throw_system_error("poll");
+        }
+        if (ready > 0) {
+            return accept_client(listener);
+        }
+    }
+    return std::nullopt;
+}
+
+}  // namespace messenger::net
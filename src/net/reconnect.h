@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <random>
+#include <string_view>
+
+#include "net/raii_socket.h"
+
+namespace messenger::net {
+
+// Проверка отмены ожидания (Ctrl-C): опрашивается между попытками и
+// во время пауз
+using CancelCheck = std::function<bool()>;
+
+// Экспоненциальная задержка между попытками подключения.
+//
+// База удваивается после каждой неудачной попытки от initial до max;
+// фактическая задержка берётся случайно из [база/2, база] ("equal
+// jitter"), чтобы клиенты, потерявшие связь одновременно, не стучались
+// к серверу синхронно.
+class Backoff {
+public:
+    using Delay = std::chrono::milliseconds;
+
+    struct Options {
+        Delay initial{std::chrono::milliseconds(200)};
+        Delay max{std::chrono::seconds(10)};
+    };
+
+    Backoff();
+    explicit Backoff(Options options);
+
+    // Задержка перед следующей попыткой; база удваивается
+    [[nodiscard]]
+    auto next_delay() -> Delay;
+
+    // Связь восстановлена: следующая серия попыток начнётся с initial
+    void reset();
+
+    // Попыток с последнего reset()
+    [[nodiscard]]
+    auto attempts() const -> std::uint32_t;
+
+    [[nodiscard]]
+    auto options() const -> const Options&;
+
+private:
+    Options options_;
+    Delay base_;
+    std::uint32_t attempts_{0};
+    std::minstd_rand random_;
+};
+
+// Подключение к host:port с повторами через backoff, пока сервер не
+// примет соединение или cancelled() не вернёт true (тогда std::nullopt).
+// После успеха backoff сбрасывается. Недопустимый хост — исключение
+[[nodiscard]]
+auto connect_with_backoff(std::string_view host, std::uint16_t port,
+                          Backoff& backoff, const CancelCheck& cancelled)
+    -> std::optional<Socket>;
+
+// Ожидание следующего клиента на слушающем сокете с проверкой отмены.
+// При системной ошибке бросает исключение
+[[nodiscard]]
+auto accept_unless_cancelled(const Socket& listener,
+                             const CancelCheck& cancelled)
+    -> std::optional<Socket>;
+
+}  // namespace messenger::net
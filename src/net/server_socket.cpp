@@ -14,16 +14,16 @@
 
 namespace messenger::net {
 
-// ---------- Создание серверного сокета ----------
+// ---------- Создание слушающего сокета ----------
 
-Socket create_server_socket(uint16_t port) {
+Socket create_listen_socket(uint16_t port, int backlog) {
     const int server_fd = ::socket(AF_INET, SOCK_STREAM, 0);
     if (server_fd < 0) {
         utils::throw_system_error("socket");
     }
 
     // Передача владение в RAII сразу после проверки
-    const Socket server_socket(server_fd);
+    Socket server_socket(server_fd);
 
     int option_value = 1;
     // NOLINTNEXTLINE(misc-include-cleaner)
@@ -43,17 +43,21 @@ Socket create_server_socket(uint16_t port) {
         utils::throw_system_error("bind");
     }
 
-    if (listen(server_socket.fd_return(), 1) < 0) {
+    if (listen(server_socket.fd_return(), backlog) < 0) {
         utils::throw_system_error("listen");
     }
 
-    std::cout << "Ожидание подключения на порту " << port << "...\n";
+    return server_socket;
+}
 
+// ---------- Приём клиента на слушающем сокете ----------
+
+Socket accept_client(const Socket& listener) {
     sockaddr_in client_addr{};
     socklen_t client_len = sizeof(client_addr);
     const int client_fd =
         // NOLINTNEXTLINE(cppcoreguidelines-pro-type-cstyle-cast)
-        accept(server_socket.fd_return(), (sockaddr*)&client_addr, &client_len);
+        accept(listener.fd_return(), (sockaddr*)&client_addr, &client_len);
     if (client_fd < 0) {
         utils::throw_system_error("accept");
     }
@@ -64,4 +68,14 @@ Socket create_server_socket(uint16_t port) {
     return Socket(client_fd);
 }
 
+// ---------- Создание серверного сокета ----------
+
+Socket create_server_socket(uint16_t port) {
+    const Socket server_socket = create_listen_socket(port, 1);
+
+    std::cout << "Ожидание подключения на порту " << port << "...\n";
+
+    return accept_client(server_socket);
+}
+
 }  // namespace messenger::net
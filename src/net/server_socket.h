@@ -6,6 +6,13 @@
 
 namespace messenger::net {
 
+// Слушающий сокет на порту (SO_REUSEADDR, bind, listen с очередью backlog)
+Socket create_listen_socket(uint16_t port, int backlog);
+
+// Ожидание и приём очередного клиента на слушающем сокете
+Socket accept_client(const Socket& listener);
+
+// Ожидание и приём одного клиента (режим точка-точка)
 Socket create_server_socket(uint16_t port);
 
 } // namespace messenger::net
\ No newline at end of file
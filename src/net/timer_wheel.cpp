@@ -0,0 +1,272 @@
+#include "net/timer_wheel.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace messenger::net {
+
+namespace {
+
+constexpr unsigned ID_INDEX_BITS = 32U;
+constexpr std::uint64_t ID_INDEX_MASK = 0xFFFF'FFFFULL;
+
+}  // namespace
+
+TimerWheel::TimerWheel(Clock::duration tick, Clock::time_point start)
+    : tick_(tick), start_(start) {
+    heads_.fill(NIL);
+}
+
+[[nodiscard]]
+auto TimerWheel::schedule(Clock::time_point deadline, std::uint64_t key)
+    -> TimerId {
+    const std::uint32_t index = allocateNode();
+    Node& node = nodes_[index];
+    node.key = key;
+    node.tick = std::max(tickOf(deadline), current_tick_);
+    place(index);
+    ++active_;
+    return (static_cast<TimerId>(node.generation) << ID_INDEX_BITS) | index;
+}
+
+auto TimerWheel::cancel(TimerId timer_id) -> bool {
+    const auto index = static_cast<std::uint32_t>(timer_id & ID_INDEX_MASK);
+    const auto generation =
+        static_cast<std::uint32_t>(timer_id >> ID_INDEX_BITS);
+    if (index >= nodes_.size() || nodes_[index].generation != generation ||
+        nodes_[index].slot == NIL) {
+        return false;  // NO_TIMER, уже сработал или уже отменён
+    }
+
+    unlink(index);
+    releaseNode(index);
+    --active_;
+    return true;
+}
+
+[[nodiscard]]
+auto TimerWheel::expire(Clock::time_point now)
+    -> const std::vector<std::uint64_t>& {
+    expired_.clear();
+    if (now < start_) {
+        return expired_;
+    }
+    const auto target_tick =
+        static_cast<std::uint64_t>((now - start_) / tick_);
+
+    // Переход сразу к следующему тику, где есть что делать: пустые тики
+    // и пустые слоты не перебираются
+    while (true) {
+        const std::optional<std::uint64_t> event_tick = nextEventTick();
+        if (!event_tick || *event_tick > target_tick) {
+            break;
+        }
+        current_tick_ = *event_tick;
+
+        // Осыпание сверху вниз: слот уровня level обрабатывается, когда
+        // все младшие разряды текущего тика нулевые
+        constexpr std::uint64_t ALL_LEVELS_MASK =
+            (std::uint64_t{1} << (LEVEL_BITS * LEVELS)) - 1U;
+        if ((current_tick_ & ALL_LEVELS_MASK) == 0) {
+            cascade(OVERFLOW_SLOT);
+        }
+        for (std::size_t level = LEVELS - 1; level > 0; --level) {
+            const unsigned shift = LEVEL_BITS * static_cast<unsigned>(level);
+            if ((current_tick_ & ((std::uint64_t{1} << shift) - 1U)) == 0) {
+                cascade(level * SLOTS +
+                        static_cast<std::size_t>((current_tick_ >> shift) &
+                                                 (SLOTS - 1U)));
+            }
+        }
+
+        expireSlot(static_cast<std::size_t>(current_tick_ & (SLOTS - 1U)));
+        current_tick_ += 1;
+    }
+
+    current_tick_ = std::max(current_tick_, target_tick + 1);
+    return expired_;
+}
+
+[[nodiscard]]
+auto TimerWheel::next_deadline() const -> std::optional<Clock::time_point> {
+    const std::optional<std::uint64_t> event_tick = nextEventTick();
+    if (!event_tick) {
+        return std::nullopt;
+    }
+    return start_ + tick_ * static_cast<Clock::rep>(*event_tick);
+}
+
+[[nodiscard]]
+auto TimerWheel::size() const -> std::size_t {
+    return active_;
+}
+
+[[nodiscard]]
+auto TimerWheel::tickOf(Clock::time_point deadline) const -> std::uint64_t {
+    if (deadline <= start_) {
+        return 0;
+    }
+    // Округление вверх: таймер не срабатывает раньше дедлайна
+    const Clock::duration since_start = deadline - start_;
+    return static_cast<std::uint64_t>(
+        (since_start + tick_ - Clock::duration{1}) / tick_);
+}
+
+[[nodiscard]]
+auto TimerWheel::nextEventTick() const -> std::optional<std::uint64_t> {
+    std::optional<std::uint64_t> best;
+
+    for (std::size_t level = 0; level < LEVELS; ++level) {
+        const unsigned shift = LEVEL_BITS * static_cast<unsigned>(level);
+        const auto digit =
+            static_cast<unsigned>((current_tick_ >> shift) & (SLOTS - 1U));
+
+        // Слот текущего разряда ещё актуален, только если его тик не
+        // начат: на нулевом уровне всегда, на верхних — на границе блока
+        const bool at_boundary =
+            level == 0 ||
+            (current_tick_ & ((std::uint64_t{1} << shift) - 1U)) == 0;
+        const unsigned first = at_boundary ? digit : digit + 1U;
+        if (first >= SLOTS) {
+            continue;
+        }
+
+        const std::uint64_t pending = occupied_[level] >> first;
+        if (pending == 0) {
+            continue;
+        }
+        const auto slot_digit =
+            first + static_cast<unsigned>(std::countr_zero(pending));
+        const unsigned block_shift = shift + LEVEL_BITS;
+        const std::uint64_t candidate =
+            ((current_tick_ >> block_shift) << block_shift) |
+            (static_cast<std::uint64_t>(slot_digit) << shift);
+        if (!best || candidate < *best) {
+            best = candidate;
+        }
+    }
+
+    if (heads_[OVERFLOW_SLOT] != NIL) {
+        // Список переполнения разбирается на границе блока верхнего уровня
+        constexpr unsigned TOP_SHIFT = LEVEL_BITS * LEVELS;
+        constexpr std::uint64_t TOP_MASK = (std::uint64_t{1} << TOP_SHIFT) - 1U;
+        const std::uint64_t candidate =
+            (current_tick_ & TOP_MASK) == 0
+                ? current_tick_
+                : ((current_tick_ >> TOP_SHIFT) + 1U) << TOP_SHIFT;
+        if (!best || candidate < *best) {
+            best = candidate;
+        }
+    }
+
+    return best;
+}
+
+[[nodiscard]]
+auto TimerWheel::allocateNode() -> std::uint32_t {
+    if (free_head_ != NIL) {
+        const std::uint32_t index = free_head_;
+        free_head_ = nodes_[index].next;
+        return index;
+    }
+    nodes_.emplace_back();
+    return static_cast<std::uint32_t>(nodes_.size() - 1);
+}
+
+void TimerWheel::place(std::uint32_t index) {
+    const std::uint64_t tick = nodes_[index].tick;
+
+    // Уровень — старший разряд, которым тик таймера отличается от текущего
+    for (std::size_t level = 0; level < LEVELS; ++level) {
+        const unsigned shift = LEVEL_BITS * static_cast<unsigned>(level);
+        const unsigned block_shift = shift + LEVEL_BITS;
+        if ((tick >> block_shift) == (current_tick_ >> block_shift)) {
+            link(index, level * SLOTS + static_cast<std::size_t>(
+                                            (tick >> shift) & (SLOTS - 1U)));
+            return;
+        }
+    }
+    link(index, OVERFLOW_SLOT);
+}
+
+void TimerWheel::link(std::uint32_t index, std::size_t slot) {
+    Node& node = nodes_[index];
+    node.slot = static_cast<std::uint32_t>(slot);
+    node.prev = NIL;
+    node.next = heads_[slot];
+    if (node.next != NIL) {
+        nodes_[node.next].prev = index;
+    }
+    heads_[slot] = index;
+
+    if (slot < OVERFLOW_SLOT) {
+        occupied_[slot / SLOTS] |= std::uint64_t{1} << (slot % SLOTS);
+    }
+}
+
+void TimerWheel::unlink(std::uint32_t index) {
+    const Node& node = nodes_[index];
+    if (node.prev != NIL) {
+        nodes_[node.prev].next = node.next;
+    } else {
+        heads_[node.slot] = node.next;
+    }
+    if (node.next != NIL) {
+        nodes_[node.next].prev = node.prev;
+    }
+
+    if (node.slot < OVERFLOW_SLOT && heads_[node.slot] == NIL) {
+        occupied_[node.slot / SLOTS] &=
+            ~(std::uint64_t{1} << (node.slot % SLOTS));
+    }
+}
+
+void TimerWheel::releaseNode(std::uint32_t index) {
+    Node& node = nodes_[index];
+    node.slot = NIL;
+    // Новое поколение делает недействительными выданные TimerId узла;
+    // 0 пропускается, чтобы id не совпал с NO_TIMER
+    node.generation += 1;
+    if (node.generation == 0) {
+        node.generation = 1;
+    }
+    node.next = free_head_;
+    free_head_ = index;
+}
+
+void TimerWheel::cascade(std::size_t slot) {
+    // Список снимается со слота целиком: таймеры из списка переполнения
+    // могут снова попасть в тот же слот
+    std::uint32_t index = heads_[slot];
+    heads_[slot] = NIL;
+    if (slot < OVERFLOW_SLOT) {
+        occupied_[slot / SLOTS] &= ~(std::uint64_t{1} << (slot % SLOTS));
+    }
+
+    while (index != NIL) {
+        const std::uint32_t next = nodes_[index].next;
+        place(index);
+        index = next;
+    }
+}
+
+void TimerWheel::expireSlot(std::size_t slot) {
+    std::uint32_t index = heads_[slot];
+    heads_[slot] = NIL;
+    occupied_[0] &= ~(std::uint64_t{1} << slot);
+
+    while (index != NIL) {
+        const std::uint32_t next = nodes_[index].next;
+        expired_.push_back(nodes_[index].key);
+        releaseNode(index);
+        --active_;
+        index = next;
+    }
+}
+
+}  // namespace messenger::net
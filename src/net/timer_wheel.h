@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace messenger::net {
+
+// Иерархическое колесо таймеров.
+//
+// Время делится на тики; номер тика дедлайна раскладывается на 4 разряда
+// по 6 бит, и таймер лежит на уровне старшего разряда, которым он
+// отличается от текущего тика. Когда текущий тик доходит до слота
+// верхнего уровня, его таймеры «осыпаются» на нижние уровни; на нулевом
+// уровне слот содержит только таймеры своего тика. Поэтому:
+//   - schedule() и cancel() — O(1), без аллокаций после прогрева;
+//   - expire() обрабатывает только наступившие таймеры и осыпающиеся
+//     слоты, а не все ожидающие;
+//   - next_deadline() — O(уровней) по битовым маскам занятых слотов.
+//
+// Узлы таймеров лежат в одном массиве (slab) и связаны индексами; TimerId
+// содержит поколение узла, так что отмена уже сработавшего или отменённого
+// таймера безопасна. Таймер никогда не срабатывает раньше своего дедлайна
+// и позже — не более чем на один тик.
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimerId = std::uint64_t;
+
+    // Идентификатор «таймера нет»: cancel() его игнорирует
+    static constexpr TimerId NO_TIMER = 0;
+
+    // Размер тика по умолчанию
+    static constexpr Clock::duration DEFAULT_TICK =
+        std::chrono::milliseconds(10);
+
+    explicit TimerWheel(Clock::duration tick = DEFAULT_TICK,
+                        Clock::time_point start = Clock::now());
+
+    // Запланировать таймер с ключом key (возвращается из expire()).
+    // Дедлайн в прошлом сработает при ближайшем expire()
+    [[nodiscard]]
+    auto schedule(Clock::time_point deadline, std::uint64_t key) -> TimerId;
+
+    // Отменить таймер. false — таймер уже сработал или отменён
+    auto cancel(TimerId timer_id) -> bool;
+
+    // Продвинуть время до now и вернуть ключи наступивших таймеров.
+    // Ссылка действительна до следующего вызова expire()
+    [[nodiscard]]
+    auto expire(Clock::time_point now) -> const std::vector<std::uint64_t>&;
+
+    // Момент, когда колесу нужно следующее expire() (std::nullopt — таймеров
+    // нет). Для таймеров верхних уровней это момент осыпания слота, поэтому
+    // он может наступить раньше самого дедлайна — тогда expire() вернёт
+    // пустой список.
+    [[nodiscard]]
+    auto next_deadline() const -> std::optional<Clock::time_point>;
+
+    // Количество ожидающих таймеров
+    [[nodiscard]]
+    auto size() const -> std::size_t;
+
+private:
+    static constexpr unsigned LEVEL_BITS = 6U;
+    static constexpr std::size_t SLOTS = std::size_t{1} << LEVEL_BITS;
+    static constexpr std::size_t LEVELS = 4U;
+    // Тики за пределами всех уровней (десятки часов при тике 10 мс)
+    // ждут в отдельном списке переполнения
+    static constexpr std::size_t OVERFLOW_SLOT = LEVELS * SLOTS;
+    static constexpr std::uint32_t NIL = UINT32_MAX;
+
+    struct Node {
+        std::uint64_t key{};
+        std::uint64_t tick{};
+        std::uint32_t prev{NIL};
+        std::uint32_t next{NIL};
+        std::uint32_t generation{1};
+        std::uint32_t slot{NIL};  // NIL — узел свободен
+    };
+
+    [[nodiscard]]
+    auto tickOf(Clock::time_point deadline) const -> std::uint64_t;
+    [[nodiscard]]
+    auto nextEventTick() const -> std::optional<std::uint64_t>;
+    [[nodiscard]]
+    auto allocateNode() -> std::uint32_t;
+    void place(std::uint32_t index);
+    void link(std::uint32_t index, std::size_t slot);
+    void unlink(std::uint32_t index);
+    void releaseNode(std::uint32_t index);
+    void cascade(std::size_t slot);
+    void expireSlot(std::size_t slot);
+
+    Clock::duration tick_;
+    Clock::time_point start_;
+    // Ближайший ещё не обработанный тик
+    std::uint64_t current_tick_{0};
+
+    std::vector<Node> nodes_;
+    std::uint32_t free_head_{NIL};
+    std::size_t active_{0};
+
+    std::array<std::uint32_t, OVERFLOW_SLOT + 1> heads_{};
+    std::array<std::uint64_t, LEVELS> occupied_{};
+
+    std::vector<std::uint64_t> expired_;
+};
+
+}  // namespace messenger::net
@@ -0,0 +1,263 @@
+#include "protocol/compress.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace messenger::proto {
+
+namespace {
+
+// Размер поля исходного размера перед блоком
+constexpr std::size_t ORIGINAL_SIZE_BYTES = 4U;
+
+// Правила блочного формата LZ4
+constexpr std::size_t MIN_MATCH = 4U;
+// Последние байты блока — всегда литералы
+constexpr std::size_t LAST_LITERALS = 5U;
+// Совпадение не начинается ближе к концу блока
+constexpr std::size_t MATCH_FIND_LIMIT = 12U;
+constexpr std::size_t MAX_OFFSET = 0xFFFFU;
+// Длина в токене (4 бита); 15 — продолжение отдельными байтами
+constexpr std::size_t RUN_MASK = 15U;
+constexpr unsigned TOKEN_SHIFT = 4U;
+constexpr std::size_t LENGTH_BYTE_MAX = 255U;
+
+// Хеш-таблица последних позиций 4-байтовых последовательностей
+constexpr unsigned HASH_LOG = 12U;
+constexpr std::uint32_t HASH_MULTIPLIER = 2654435761U;
+// Пропуск в длинных несжимаемых участках: шаг растёт на 1 за каждые
+// 2^SKIP_SHIFT байт без совпадения
+constexpr unsigned SKIP_SHIFT = 6U;
+
+constexpr unsigned BYTE_BITS = 8U;
+constexpr unsigned BYTE_MASK = 0xFFU;
+
+[[nodiscard]]
+auto byteAt(std::string_view data, std::size_t pos) -> std::uint8_t {
+    return static_cast<std::uint8_t>(data[pos]);
+}
+
+[[nodiscard]]
+auto read32(std::string_view data, std::size_t pos) -> std::uint32_t {
+    std::uint32_t value = 0;
+    std::memcpy(&value, data.data() + pos, sizeof(value));
+    return value;
+}
+
+[[nodiscard]]
+auto hashOf(std::uint32_t sequence) -> std::size_t {
+    return (sequence * HASH_MULTIPLIER) >> (32U - HASH_LOG);
+}
+
+// Запись блока LZ4 в заранее выделенный out
+class BlockWriter {
+public:
+    BlockWriter(std::string& out, std::size_t pos) : out_(out), pos_(pos) {}
+
+    void byte(std::size_t value) {
+        out_[pos_++] = static_cast<char>(value & BYTE_MASK);
+    }
+
+    // Продолжение длины, не поместившейся в 4 бита токена
+    void length(std::size_t value) {
+        if (value < RUN_MASK) {
+            return;
+        }
+        value -= RUN_MASK;
+        for (; value >= LENGTH_BYTE_MAX; value -= LENGTH_BYTE_MAX) {
+            byte(LENGTH_BYTE_MAX);
+        }
+        byte(value);
+    }
+
+    // Последовательность: литералы [anchor, anchor + literals) и
+    // совпадение длиной match со смещением offset (match == 0 — только
+    // литералы, последняя последовательность блока)
+    void sequence(std::string_view input, std::size_t anchor,
+                  std::size_t literals, std::size_t offset,
+                  std::size_t match) {
+        const std::size_t match_code = match == 0 ? 0 : match - MIN_MATCH;
+        byte((std::min(literals, RUN_MASK) << TOKEN_SHIFT) |
+             std::min(match_code, RUN_MASK));
+        length(literals);
+        std::memcpy(out_.data() + pos_, input.data() + anchor, literals);
+        pos_ += literals;
+        if (match == 0) {
+            return;
+        }
+        byte(offset);
+        byte(offset >> BYTE_BITS);
+        length(match_code);
+    }
+
+    [[nodiscard]]
+    auto pos() const -> std::size_t {
+        return pos_;
+    }
+
+private:
+    std::string& out_;
+    std::size_t pos_;
+};
+
+// Продолжение длины при чтении. false — блок оборван
+[[nodiscard]]
+auto readLength(std::string_view input, std::size_t& pos, std::size_t& value)
+    -> bool {
+    if (value != RUN_MASK) {
+        return true;
+    }
+    std::size_t extra = LENGTH_BYTE_MAX;
+    while (extra == LENGTH_BYTE_MAX) {
+        if (pos >= input.size()) {
+            return false;
+        }
+        extra = byteAt(input, pos++);
+        value += extra;
+    }
+    return true;
+}
+
+}  // namespace
+
+[[nodiscard]]
+auto compress_payload(std::string_view input, std::string& out) -> bool {
+    const std::size_t size = input.size();
+    if (size < COMPRESSION_THRESHOLD) {
+        return false;
+    }
+
+    // Худший случай блока LZ4: литералы плюс байт длины на каждые 255
+    out.resize(ORIGINAL_SIZE_BYTES + size + (size / LENGTH_BYTE_MAX) + 16U);
+    for (std::size_t index = 0; index < ORIGINAL_SIZE_BYTES; ++index) {
+        const unsigned shift =
+            static_cast<unsigned>(ORIGINAL_SIZE_BYTES - 1 - index) *
+            BYTE_BITS;
+        out[index] = static_cast<char>((size >> shift) & BYTE_MASK);
+    }
+    BlockWriter writer(out, ORIGINAL_SIZE_BYTES);
+
+    std::array<std::uint32_t, std::size_t{1} << HASH_LOG> table{};
+    const std::size_t match_end = size - LAST_LITERALS;
+    std::size_t anchor = 0;
+    std::size_t pos = 1;
+    table[hashOf(read32(input, 0))] = 0;
+
+    while (pos + MATCH_FIND_LIMIT <= size) {
+        const std::uint32_t sequence = read32(input, pos);
+        std::uint32_t& slot = table[hashOf(sequence)];
+        std::size_t candidate = slot;
+        slot = static_cast<std::uint32_t>(pos);
+        if (candidate >= pos || pos - candidate > MAX_OFFSET ||
+            read32(input, candidate) != sequence) {
+            pos += 1 + ((pos - anchor) >> SKIP_SHIFT);
+            continue;
+        }
+
+        // Совпадение расширяется назад, в ещё не записанные литералы...
+        while (pos > anchor && candidate > 0 &&
+               input[pos - 1] == input[candidate - 1]) {
+            --pos;
+            --candidate;
+        }
+        // ...и вперёд, не заходя в обязательные последние литералы
+        std::size_t match = MIN_MATCH;
+        while (pos + match < match_end &&
+               input[candidate + match] == input[pos + match]) {
+            ++match;
+        }
+
+        writer.sequence(input, anchor, pos - anchor, pos - candidate, match);
+        pos += match;
+        anchor = pos;
+        if (pos + MATCH_FIND_LIMIT <= size) {
+            table[hashOf(read32(input, pos - 2))] =
+                static_cast<std::uint32_t>(pos - 2);
+        }
+    }
+    writer.sequence(input, anchor, size - anchor, 0, 0);
+
+    if (writer.pos() >= size) {
+        return false;  // несжимаемые данные: выгоднее отправить как есть
+    }
+    out.resize(writer.pos());
+    return true;
+}
+
+[[nodiscard]]
+auto decompress_payload(std::string_view input, std::size_t max_size,
+                        std::string& out) -> bool {
+    if (input.size() < ORIGINAL_SIZE_BYTES) {
+        return false;
+    }
+    std::size_t original_size = 0;
+    for (std::size_t index = 0; index < ORIGINAL_SIZE_BYTES; ++index) {
+        original_size = (original_size << BYTE_BITS) | byteAt(input, index);
+    }
+    if (original_size > max_size) {
+        return false;
+    }
+
+    out.resize(original_size);
+    std::size_t in_pos = ORIGINAL_SIZE_BYTES;
+    std::size_t out_pos = 0;
+    while (true) {
+        if (in_pos >= input.size()) {
+            return false;
+        }
+        const std::uint8_t token = byteAt(input, in_pos++);
+
+        std::size_t literals = token >> TOKEN_SHIFT;
+        if (!readLength(input, in_pos, literals) ||
+            literals > input.size() - in_pos ||
+            literals > original_size - out_pos) {
+            return false;
+        }
+        std::memcpy(out.data() + out_pos, input.data() + in_pos, literals);
+        in_pos += literals;
+        out_pos += literals;
+
+        // Последняя последовательность — без совпадения
+        if (in_pos == input.size()) {
+            return out_pos == original_size;
+        }
+
+        if (input.size() - in_pos < 2) {
+            return false;
+        }
+        const std::size_t offset =
+            byteAt(input, in_pos) |
+            (static_cast<std::size_t>(byteAt(input, in_pos + 1)) << BYTE_BITS);
+        in_pos += 2;
+        if (offset == 0 || offset > out_pos) {
+            return false;
+        }
+
+        std::size_t match = token & RUN_MASK;
+        if (!readLength(input, in_pos, match)) {
+            return false;
+        }
+        match += MIN_MATCH;
+        if (match > original_size - out_pos) {
+            return false;
+        }
+        if (offset >= match) {
+            std::memcpy(out.data() + out_pos, out.data() + out_pos - offset,
+                        match);
+            out_pos += match;
+            continue;
+        }
+        // Совпадение перекрывает само себя (повтор короткого фрагмента):
+        // только побайтно
+        for (std::size_t index = 0; index < match; ++index, ++out_pos) {
+            out[out_pos] = out[out_pos - offset];
+        }
+    }
+}
+
+}  // namespace messenger::proto
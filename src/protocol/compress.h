@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace messenger::proto {
+
+// Сжатие полезной нагрузки Text.
+//
+// Кодек — блочный формат LZ4 (последовательности "литералы + ссылка
+// назад на совпадение", смещение до 64 КБ): сжатие и распаковка в один
+// проход без энтропийного кодирования, сотни МБ/с на ядро. Вставленные
+// логи и трассировки стека сжимаются в разы, обычная реплика чата —
+// почти никак, поэтому полезная нагрузка короче COMPRESSION_THRESHOLD не
+// сжимается вовсе.
+//
+// Сжатая полезная нагрузка: исходный размер u32 в сетевом порядке байт,
+// затем блок LZ4. Кадр со сжатой нагрузкой отмечен флагом
+// COMPRESSED_FLAG в байте типа; отправитель ставит его, только если
+// собеседник объявил proto::Hello::FEATURE_COMPRESSION.
+
+// Старший бит байта типа кадра: полезная нагрузка сжата
+constexpr std::uint8_t COMPRESSED_FLAG = 0x80U;
+
+// Полезная нагрузка короче не сжимается: выигрыш меньше затрат
+constexpr std::size_t COMPRESSION_THRESHOLD = 512U;
+
+// Сжать input в out (буфер переиспользуется между вызовами). false —
+// input короче порога или не сжимается; тогда он отправляется как есть
+[[nodiscard]]
+auto compress_payload(std::string_view input, std::string& out) -> bool;
+
+// Распаковать сжатую полезную нагрузку в out. false — повреждённый блок
+// или исходный размер больше max_size (защита от "бомбы")
+[[nodiscard]]
+auto decompress_payload(std::string_view input, std::size_t max_size,
+                        std::string& out) -> bool;
+
+}  // namespace messenger::proto
@@ -0,0 +1,110 @@
+#include "protocol/file_frames.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "net/frame_header.h"
+#include "protocol/message.hpp"
+
+namespace messenger::proto {
+
+namespace {
+
+constexpr unsigned BYTE_BITS = 8U;
+constexpr unsigned BYTE_MASK = 0xFFU;
+
+[[nodiscard]]
+auto getOffset(std::span<const std::uint8_t> bytes) -> std::uint64_t {
+    std::uint64_t value = 0;
+    for (std::size_t index = 0; index < FILE_OFFSET_SIZE; ++index) {
+        value = (value << BYTE_BITS) | bytes[index];
+    }
+    return value;
+}
+
+[[nodiscard]]
+auto asBytes(std::string_view text) -> std::span<const std::uint8_t> {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return {reinterpret_cast<const std::uint8_t*>(text.data()), text.size()};
+}
+
+// Простое имя файла: без каталогов и ссылок на них
+[[nodiscard]]
+auto plainFileName(std::string_view name) -> bool {
+    return !name.empty() && name.size() <= MAX_FILE_NAME_SIZE &&
+           name != "." && name != ".." &&
+           name.find('/') == std::string_view::npos &&
+           name.find('\0') == std::string_view::npos;
+}
+
+}  // namespace
+
+[[nodiscard]]
+auto encode_file_offset(std::uint64_t offset) -> FileOffsetBytes {
+    FileOffsetBytes bytes{};
+    for (std::size_t index = FILE_OFFSET_SIZE; index-- > 0;) {
+        bytes.at(index) = static_cast<std::uint8_t>(offset & BYTE_MASK);
+        offset >>= BYTE_BITS;
+    }
+    return bytes;
+}
+
+[[nodiscard]]
+auto decode_file_offset(std::string_view payload)
+    -> std::optional<std::uint64_t> {
+    if (payload.size() != FILE_OFFSET_SIZE) {
+        return std::nullopt;
+    }
+    return getOffset(asBytes(payload));
+}
+
+[[nodiscard]]
+auto encode_file_offer(const FileOffer& offer) -> std::string {
+    const FileOffsetBytes size = encode_file_offset(offer.size);
+    const FileOffsetBytes modified = encode_file_offset(offer.modified_ns);
+    std::string out(size.begin(), size.end());
+    out.append(modified.begin(), modified.end());
+    out += offer.name;
+    return out;
+}
+
+[[nodiscard]]
+auto decode_file_offer(std::string_view payload) -> std::optional<FileOffer> {
+    if (payload.size() < FILE_OFFER_HEADER_SIZE) {
+        return std::nullopt;
+    }
+    FileOffer offer{};
+    offer.size = getOffset(asBytes(payload));
+    offer.modified_ns = getOffset(asBytes(payload).subspan(FILE_OFFSET_SIZE));
+    const std::string_view name = payload.substr(FILE_OFFER_HEADER_SIZE);
+    if (!plainFileName(name)) {
+        return std::nullopt;
+    }
+    offer.name = std::string(name);
+    return offer;
+}
+
+[[nodiscard]]
+auto parse_file_chunk(std::span<const std::uint8_t> frame)
+    -> std::optional<FileChunkView> {
+    net::FrameHeader header{};
+    if (net::parse_frame_header(frame, header) != net::HeaderStatus::Ok ||
+        header.type != static_cast<std::uint8_t>(MsgType::FileChunk) ||
+        header.payload_size < FILE_OFFSET_SIZE ||
+        header.size + header.payload_size != frame.size()) {
+        return std::nullopt;
+    }
+
+    FileChunkView chunk{};
+    chunk.transfer_id = header.id;
+    chunk.offset = getOffset(frame.subspan(header.size));
+    chunk.data = frame.subspan(header.size + FILE_OFFSET_SIZE);
+    return chunk;
+}
+
+}  // namespace messenger::proto
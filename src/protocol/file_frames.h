@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace messenger::proto {
+
+// Передача файлов (команда /файл) отдельными кадрами.
+//
+//   FileOffer: id — номер передачи; payload — размер файла u64 |
+//              время изменения файла u64 (нс) | имя
+//   FileChunk: id — номер передачи; payload — смещение u64 | байты файла
+//   FileAck:   id — номер передачи; payload — смещение u64: получатель
+//              записал на диск все байты до него
+//
+// Числа — в сетевом порядке байт. Файл любого размера идёт кусками по
+// FILE_CHUNK_SIZE, каждый кусок — обычный кадр в пределах MaxPayloadSize,
+// поэтому передача не мешает Text: между кусками уходят сообщения чата.
+// FileAck в ответ на FileOffer сообщает, с какого места продолжить:
+// после обрыва связи передача возобновляется с последнего записанного
+// куска, а не с начала. Размер и время изменения опознают содержимое:
+// .part другой версии файла получатель не продолжает, а начинает заново.
+
+// Размер поля смещения, байт
+constexpr std::size_t FILE_OFFSET_SIZE = sizeof(std::uint64_t);
+
+// Байт файла в одном FileChunk
+constexpr std::size_t FILE_CHUNK_SIZE = 64U * 1024U;
+
+// Имя файла в FileOffer, байт (как NAME_MAX)
+constexpr std::size_t MAX_FILE_NAME_SIZE = 255U;
+
+// Байт до имени в FileOffer: размер и время изменения
+constexpr std::size_t FILE_OFFER_HEADER_SIZE = 2U * FILE_OFFSET_SIZE;
+
+struct FileOffer {
+    std::uint64_t size{};
+    std::string name;
+    // Время изменения исходного файла, нс от эпохи
+    std::uint64_t modified_ns{};
+};
+
+// Кусок файла внутри принятого кадра: data указывает в буфер приёма
+// и действителен, пока действителен кадр
+struct FileChunkView {
+    std::uint32_t transfer_id{};
+    std::uint64_t offset{};
+    std::span<const std::uint8_t> data;
+};
+
+using FileOffsetBytes = std::array<std::uint8_t, FILE_OFFSET_SIZE>;
+
+[[nodiscard]]
+auto encode_file_offset(std::uint64_t offset) -> FileOffsetBytes;
+
+// std::nullopt — полезная нагрузка не из одного смещения
+[[nodiscard]]
+auto decode_file_offset(std::string_view payload)
+    -> std::optional<std::uint64_t>;
+
+[[nodiscard]]
+auto encode_file_offer(const FileOffer& offer) -> std::string;
+
+// std::nullopt — нет размера и времени изменения или имя пустое, длиннее
+// MAX_FILE_NAME_SIZE либо не является простым именем файла (содержит '/',
+// "." или "..")
+[[nodiscard]]
+auto decode_file_offer(std::string_view payload) -> std::optional<FileOffer>;
+
+// Разбор целого кадра FileChunk (заголовок + payload) без копирования.
+// std::nullopt — не FileChunk или нет смещения
+[[nodiscard]]
+auto parse_file_chunk(std::span<const std::uint8_t> frame)
+    -> std::optional<FileChunkView>;
+
+}  // namespace messenger::proto
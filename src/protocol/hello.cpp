@@ -0,0 +1,89 @@
+#include "protocol/hello.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace messenger::proto {
+
+namespace {
+
+constexpr std::string_view HELLO_MAGIC = "MSGR";
+
+constexpr std::size_t VERSION_OFFSET = 4U;
+constexpr std::size_t FEATURES_OFFSET = 5U;
+constexpr std::size_t SESSION_OFFSET = 8U;
+constexpr std::size_t PEER_SESSION_OFFSET = 16U;
+constexpr std::size_t LAST_RECEIVED_OFFSET = 24U;
+constexpr std::size_t FIRST_PENDING_OFFSET = 28U;
+
+// Первая версия формата: её приветствия разбираются без first_pending
+constexpr std::uint8_t FIRST_VERSION = 1;
+
+constexpr unsigned BYTE_BITS = 8U;
+constexpr unsigned BYTE_MASK = 0xFFU;
+
+// Запись / чтение беззнакового числа в сетевом порядке байт
+template <typename Unsigned>
+void putBigEndian(std::string& out, std::size_t offset, Unsigned value) {
+    for (std::size_t index = sizeof(Unsigned); index-- > 0;) {
+        out[offset + index] = static_cast<char>(value & BYTE_MASK);
+        value = static_cast<Unsigned>(value >> BYTE_BITS);
+    }
+}
+
+template <typename Unsigned>
+[[nodiscard]]
+auto getBigEndian(std::string_view in, std::size_t offset) -> Unsigned {
+    Unsigned value = 0;
+    for (std::size_t index = 0; index < sizeof(Unsigned); ++index) {
+        value = static_cast<Unsigned>(
+            (value << BYTE_BITS) |
+            static_cast<unsigned char>(in[offset + index]));
+    }
+    return value;
+}
+
+}  // namespace
+
+[[nodiscard]]
+auto encode_hello(const Hello& hello) -> std::string {
+    std::string out(Hello::ENCODED_SIZE, '\0');
+    out.replace(0, HELLO_MAGIC.size(), HELLO_MAGIC);
+    out[VERSION_OFFSET] = static_cast<char>(Hello::VERSION);
+    out[FEATURES_OFFSET] = static_cast<char>(hello.features);
+    putBigEndian(out, SESSION_OFFSET, hello.session_id);
+    putBigEndian(out, PEER_SESSION_OFFSET, hello.peer_session_id);
+    putBigEndian(out, LAST_RECEIVED_OFFSET, hello.last_received);
+    putBigEndian(out, FIRST_PENDING_OFFSET, hello.first_pending);
+    return out;
+}
+
+[[nodiscard]]
+auto decode_hello(std::string_view payload) -> std::optional<Hello> {
+    if (payload.size() < Hello::V1_ENCODED_SIZE ||
+        !payload.starts_with(HELLO_MAGIC)) {
+        return std::nullopt;
+    }
+    const auto version = static_cast<std::uint8_t>(payload[VERSION_OFFSET]);
+    if (version < FIRST_VERSION) {
+        return std::nullopt;
+    }
+
+    Hello hello{};
+    hello.features = static_cast<std::uint8_t>(payload[FEATURES_OFFSET]);
+    hello.session_id = getBigEndian<std::uint64_t>(payload, SESSION_OFFSET);
+    hello.peer_session_id =
+        getBigEndian<std::uint64_t>(payload, PEER_SESSION_OFFSET);
+    hello.last_received =
+        getBigEndian<std::uint32_t>(payload, LAST_RECEIVED_OFFSET);
+    if (version >= Hello::VERSION && payload.size() >= Hello::ENCODED_SIZE) {
+        hello.first_pending =
+            getBigEndian<std::uint32_t>(payload, FIRST_PENDING_OFFSET);
+    }
+    return hello;
+}
+
+}  // namespace messenger::proto
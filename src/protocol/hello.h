@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace messenger::proto {
+
+// Приветствие сеанса: полезная нагрузка первого Ping после подключения.
+//
+//   "MSGR" | версия u8 | флаги возможностей u8 | резерв u16 |
+//   session_id u64 | peer_session_id u64 | last_received u32 |
+//   first_pending u32 (с версии 2)
+//
+// Числа — в сетевом порядке байт. Собеседник прежних версий отвечает на
+// такой Ping обычным Pong и полезную нагрузку не читает, поэтому
+// приветствие не ломает совместимость: его отсутствие означает, что
+// собеседник возобновлять сеанс не умеет.
+struct Hello {
+    // Версия формата приветствия
+    static constexpr std::uint8_t VERSION = 2;
+
+    // Размер закодированного приветствия, байт
+    static constexpr std::size_t ENCODED_SIZE = 32U;
+    // Размер приветствия версии 1, без first_pending
+    static constexpr std::size_t V1_ENCODED_SIZE = 28U;
+
+    // Флаг возможности: подтверждения кадром Sack вместо Ack на каждое
+    // сообщение
+    static constexpr std::uint8_t FEATURE_SACK = 0x01U;
+    // Флаг возможности: приём сжатых Text (protocol/compress.h)
+    static constexpr std::uint8_t FEATURE_COMPRESSION = 0x02U;
+    // Флаг возможности: приём файлов (protocol/file_frames.h)
+    static constexpr std::uint8_t FEATURE_FILES = 0x04U;
+    // Флаг возможности: приём заголовков кадров v2 (net/frame_header.h)
+    static constexpr std::uint8_t FEATURE_COMPACT_HEADER = 0x08U;
+    // Возможности этой версии
+    static constexpr std::uint8_t SUPPORTED_FEATURES =
+        FEATURE_SACK | FEATURE_COMPRESSION | FEATURE_FILES |
+        FEATURE_COMPACT_HEADER;
+
+    // Случайный id запуска отправителя: с ним связана нумерация его msg_id
+    std::uint64_t session_id{};
+    // Сеанс собеседника, к которому относится last_received (0 — от
+    // собеседника ещё ничего не получено)
+    std::uint64_t peer_session_id{};
+    // Все msg_id собеседника до этого включительно получены
+    std::uint32_t last_received{};
+    // Наименьший msg_id отправителя, который ещё может прийти: id до него
+    // доставлены или оставлены отправителем. С него получатель начинает
+    // непрерывную границу. 0 (такой id не выдаётся) — не сообщается
+    std::uint32_t first_pending{};
+    // Битовая маска поддерживаемых расширений протокола
+    std::uint8_t features{};
+};
+
+[[nodiscard]]
+auto encode_hello(const Hello& hello) -> std::string;
+
+// std::nullopt — полезная нагрузка не является приветствием (пустой Ping
+// watchdog'а, чужой формат). Байты сверх ENCODED_SIZE допускаются:
+// их может дописать следующая версия. Приветствие версии 1 разбирается
+// с first_pending == 0
+[[nodiscard]]
+auto decode_hello(std::string_view payload) -> std::optional<Hello>;
+
+}  // namespace messenger::proto
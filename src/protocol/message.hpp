@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace messenger::proto {
 
@@ -10,7 +11,12 @@ enum class MsgType : std::uint8_t {
     Typing = 0x02,
     Ack = 0x03,
     Ping = 0x04,
-    Pong = 0x05
+    Pong = 0x05,
+    Sack = 0x06,  // накопительное и выборочное подтверждение (sack.h)
+    // Передача файлов (file_frames.h)
+    FileOffer = 0x07,
+    FileChunk = 0x08,
+    FileAck = 0x09
 };
 
 struct Message {
@@ -19,4 +25,14 @@ struct Message {
     std::string payload;
 };
 
+// Принятое сообщение без копии полезной нагрузки: payload указывает в
+// буфер приёма кадров (или в ReceiveArena, serializer.h) и действителен
+// до разбора следующего кадра. Владеющая строка нужна только тому, что
+// хранит текст дольше — истории
+struct MessageView {
+    MsgType type;
+    std::uint32_t id;
+    std::string_view payload;
+};
+
 }  // namespace messenger::proto
@@ -1,53 +1,222 @@
 #include "protocol/protocol_api.h"
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "net/connection.h"
+#include "net/frame_header.h"
 #include "net/net_api.h"
+#include "net/outbound_queue.h"
+#include "protocol/compress.h"
+#include "protocol/file_frames.h"
 #include "protocol/message.hpp"
+#include "protocol/sack.h"
 #include "protocol/serializer.h"
 
 namespace messenger::proto {
 
+namespace {
+
+// Запись готового кадра: блокирующая по дескриптору...
+[[nodiscard]]
+auto writeFrame(int socket_fd, std::span<const std::uint8_t> header,
+                std::span<const std::uint8_t> payload) -> bool {
+    return messenger::net::send_frame(socket_fd, header, payload);
+}
+
+// ...или неблокирующая через очередь соединения
+[[nodiscard]]
+auto writeFrame(messenger::net::Connection& conn,
+                std::span<const std::uint8_t> header,
+                std::span<const std::uint8_t> payload) -> bool {
+    return conn.outbound().send(conn.fd(), header, payload) ==
+           messenger::net::OutboundQueue::Status::Ok;
+}
+
+// Формат заголовков: блокирующая отправка по дескриптору — всегда v1,
+// соединение — согласованный с собеседником
+[[nodiscard]]
+auto headerFormat(int /*socket_fd*/) -> messenger::net::HeaderFormat {
+    return messenger::net::HeaderFormat::V1;
+}
+
 [[nodiscard]]
-auto send_text(int socket_fd, const std::string& text,
+auto headerFormat(const messenger::net::Connection& conn)
+    -> messenger::net::HeaderFormat {
+    return conn.header_format();
+}
+
+// Кадр без полезной нагрузки: только заголовок со стека
+template <typename Target>
+[[nodiscard]]
+auto sendControl(Target& target, MsgType type, std::uint32_t msg_id) -> bool {
+    const auto header = encode_header(headerFormat(target), type, msg_id, 0);
+    return writeFrame(target, header.view(), {});
+}
+
+template <typename Target>
+[[nodiscard]]
+auto sendPayload(Target& target, MsgType type, std::string_view bytes,
+                 std::uint32_t msg_id, bool compressed = false) -> bool {
+    if (bytes.size() > messenger::net::MaxPayloadSize::value) {
+        return false;  // собеседник всё равно отверг бы такой кадр
+    }
+
+    // Заголовок — со стека, payload — прямо из памяти вызывающего
+    const auto header =
+        encode_header(headerFormat(target), type, msg_id,
+                      static_cast<std::uint32_t>(bytes.size()), compressed);
+    const std::span<const std::uint8_t> payload(
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        reinterpret_cast<const std::uint8_t*>(bytes.data()), bytes.size());
+    return writeFrame(target, header.view(), payload);
+}
+
+template <typename Target>
+[[nodiscard]]
+auto sendText(Target& target, std::string_view text,
+              std::uint32_t msg_id) -> bool {
+    return sendPayload(target, MsgType::Text, text, msg_id);
+}
+
+}  // namespace
+
+[[nodiscard]]
+auto send_text(int socket_fd, std::string_view text,
+               std::uint32_t msg_id) -> bool {
+    return sendText(socket_fd, text, msg_id);
+}
+
+[[nodiscard]]
+auto send_text(messenger::net::Connection& conn, std::string_view text,
                std::uint32_t msg_id) -> bool {
-    const Message msg{MsgType::Text, msg_id, text};
-    const auto bytes = serialize(msg);
-    return messenger::net::send_bytes(socket_fd, bytes);
+    return sendText(conn, text, msg_id);
+}
+
+[[nodiscard]]
+auto send_text_compressed(messenger::net::Connection& conn,
+                          std::string_view text, std::uint32_t msg_id,
+                          std::string& compression_buffer) -> bool {
+    // Предел размера — для исходного текста: собеседник распаковывает
+    // не больше MaxPayloadSize
+    if (text.size() > messenger::net::MaxPayloadSize::value) {
+        return false;
+    }
+    if (!compress_payload(text, compression_buffer)) {
+        return sendText(conn, text, msg_id);
+    }
+    return sendPayload(conn, MsgType::Text, compression_buffer, msg_id, true);
 }
 
 // NOLINTBEGIN(bugprone-easily-swappable-parameters)
 [[nodiscard]]
 auto send_typing(int socket_fd, std::uint32_t msg_id) -> bool {
-    const Message msg{MsgType::Typing, msg_id, ""};
-    auto bytes = serialize(msg);
-    return net::send_bytes(socket_fd, bytes);
+    return sendControl(socket_fd, MsgType::Typing, msg_id);
 }
 
 [[nodiscard]]
 auto send_ping(int socket_fd, std::uint32_t msg_id) -> bool {
-    const Message msg{MsgType::Ping, msg_id, std::string{}};
-    auto bytes = serialize(msg);
-    return messenger::net::send_bytes(socket_fd, bytes);
+    return sendControl(socket_fd, MsgType::Ping, msg_id);
 }
 
 [[nodiscard]]
 auto send_pong(int socket_fd, std::uint32_t msg_id) -> bool {
-    const Message msg{MsgType::Pong, msg_id, std::string{}};
-    auto bytes = serialize(msg);
-    return messenger::net::send_bytes(socket_fd, bytes);
+    return sendControl(socket_fd, MsgType::Pong, msg_id);
 }
 
 [[nodiscard]]
 auto send_ack(int socket_fd, std::uint32_t msg_id) -> bool {
-    const Message msg{MsgType::Ack, msg_id, std::string{}};
-    auto bytes = serialize(msg);
-    return messenger::net::send_bytes(socket_fd, bytes);
+    return sendControl(socket_fd, MsgType::Ack, msg_id);
 }
 // NOLINTEND(bugprone-easily-swappable-parameters)
 
+[[nodiscard]]
+auto send_typing(messenger::net::Connection& conn,
+                 std::uint32_t msg_id) -> bool {
+    return sendControl(conn, MsgType::Typing, msg_id);
+}
+
+[[nodiscard]]
+auto send_ping(messenger::net::Connection& conn, std::uint32_t msg_id) -> bool {
+    return sendControl(conn, MsgType::Ping, msg_id);
+}
+
+[[nodiscard]]
+auto send_ping(messenger::net::Connection& conn, std::uint32_t msg_id,
+               std::string_view payload) -> bool {
+    return sendPayload(conn, MsgType::Ping, payload, msg_id);
+}
+
+[[nodiscard]]
+auto send_pong(messenger::net::Connection& conn, std::uint32_t msg_id) -> bool {
+    return sendControl(conn, MsgType::Pong, msg_id);
+}
+
+[[nodiscard]]
+auto send_ack(messenger::net::Connection& conn, std::uint32_t msg_id) -> bool {
+    return sendControl(conn, MsgType::Ack, msg_id);
+}
+
+[[nodiscard]]
+auto send_sack(messenger::net::Connection& conn, std::uint32_t cumulative,
+               const SackBlocks& blocks) -> bool {
+    SackPayload payload{};
+    return sendPayload(conn, MsgType::Sack, encode_sack(blocks, payload),
+                       cumulative);
+}
+
+[[nodiscard]]
+auto send_file_offer(messenger::net::Connection& conn,
+                     std::uint32_t transfer_id, const FileOffer& offer)
+    -> bool {
+    return sendPayload(conn, MsgType::FileOffer, encode_file_offer(offer),
+                       transfer_id);
+}
+
+[[nodiscard]]
+auto send_file_chunk(messenger::net::Connection& conn,
+                     std::uint32_t transfer_id, int file_fd,
+                     std::uint64_t offset, std::size_t length) -> bool {
+    if (FILE_OFFSET_SIZE + length > messenger::net::MaxPayloadSize::value) {
+        return false;
+    }
+
+    // Заголовок кадра и смещение — одним блоком на стеке
+    std::array<std::uint8_t,
+               messenger::net::MAX_HEADER_SIZE + FILE_OFFSET_SIZE>
+        prefix{};
+    const auto header =
+        encode_header(conn.header_format(), MsgType::FileChunk, transfer_id,
+                      static_cast<std::uint32_t>(FILE_OFFSET_SIZE + length));
+    const auto header_bytes = header.view();
+    const FileOffsetBytes offset_bytes = encode_file_offset(offset);
+    std::copy(header_bytes.begin(), header_bytes.end(), prefix.begin());
+    std::copy(offset_bytes.begin(), offset_bytes.end(),
+              prefix.begin() + static_cast<std::ptrdiff_t>(header.size));
+
+    return conn.outbound().send_file(
+               conn.fd(),
+               std::span(prefix).first(header.size + FILE_OFFSET_SIZE),
+               file_fd, offset, length) ==
+           messenger::net::OutboundQueue::Status::Ok;
+}
+
+[[nodiscard]]
+auto send_file_ack(messenger::net::Connection& conn, std::uint32_t transfer_id,
+                   std::uint64_t offset) -> bool {
+    const FileOffsetBytes payload = encode_file_offset(offset);
+    const auto header =
+        encode_header(conn.header_format(), MsgType::FileAck, transfer_id,
+                      static_cast<std::uint32_t>(payload.size()));
+    return writeFrame(conn, header.view(), payload);
+}
+
 [[nodiscard]]
 auto receive_msg(int socket_fd, Message& out, bool& disconnected) -> bool {
     std::vector<std::uint8_t> raw;
@@ -69,4 +238,17 @@ auto receive_msg(int socket_fd, Message& out, bool& disconnected) -> bool {
     return deserialize(raw, out);
 }
 
+[[nodiscard]]
+auto receive_msg(int socket_fd, ReceiveArena& arena, MessageView& out,
+                 bool& disconnected) -> bool {
+    // recv_bytes очищает вектор, не освобождая ёмкость
+    if (!net::recv_bytes(socket_fd, arena.frame)) {
+        disconnected = false;
+        return false;
+    }
+
+    disconnected = arena.frame.empty();
+    return disconnected || deserialize(arena.frame, out, arena);
+}
+
 }  // namespace messenger::proto
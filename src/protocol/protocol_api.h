@@ -1,17 +1,25 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "net/connection.h"
+#include "protocol/file_frames.h"
 #include "protocol/message.hpp"
+#include "protocol/sack.h"
+#include "protocol/serializer.h"
 
 namespace messenger::proto {
 
-// Формирование байтов для отправки
+// Отправка кадров. Заголовок формируется на стеке, payload уходит прямо из
+// памяти вызывающего (sendmsg с двумя iovec) — без промежуточных аллокаций
+// и копий. Text длиннее MaxPayloadSize не отправляется (false).
 
 [[nodiscard]]
-auto send_text(int socket_fd, const std::string& text, std::uint32_t msg_id) -> bool;
+auto send_text(int socket_fd, std::string_view text, std::uint32_t msg_id) -> bool;
 
 // NOLINTBEGIN(bugprone-easily-swappable-parameters)
 [[nodiscard]]
@@ -27,6 +35,65 @@ auto send_pong(int socket_fd, std::uint32_t msg_id) -> bool;
 auto send_ack(int socket_fd, std::uint32_t msg_id) -> bool;
 // NOLINTEND(bugprone-easily-swappable-parameters)
 
+// То же через неблокирующее соединение: кадр пишется в сокет сразу, а
+// не поместившийся остаток — в очередь соединения (дописывается по
+// EPOLLOUT). false — очередь переполнена или соединение закрыто.
+
+[[nodiscard]]
+auto send_text(messenger::net::Connection& conn, std::string_view text,
+               std::uint32_t msg_id) -> bool;
+
+// Text со сжатием (protocol/compress.h), если оно выгодно; короткий или
+// несжимаемый текст уходит как есть. Только собеседнику, объявившему
+// Hello::FEATURE_COMPRESSION. compression_buffer переиспользуется между
+// вызовами — сжатие не выделяет память на каждый кадр
+[[nodiscard]]
+auto send_text_compressed(messenger::net::Connection& conn,
+                          std::string_view text, std::uint32_t msg_id,
+                          std::string& compression_buffer) -> bool;
+
+[[nodiscard]]
+auto send_typing(messenger::net::Connection& conn, std::uint32_t msg_id) -> bool;
+
+[[nodiscard]]
+auto send_ping(messenger::net::Connection& conn, std::uint32_t msg_id) -> bool;
+
+// Ping с полезной нагрузкой (приветствие сеанса, см. protocol/hello.h)
+[[nodiscard]]
+auto send_ping(messenger::net::Connection& conn, std::uint32_t msg_id,
+               std::string_view payload) -> bool;
+
+[[nodiscard]]
+auto send_pong(messenger::net::Connection& conn, std::uint32_t msg_id) -> bool;
+
+[[nodiscard]]
+auto send_ack(messenger::net::Connection& conn, std::uint32_t msg_id) -> bool;
+
+// Накопительное подтверждение до cumulative с блоками SACK; полезная
+// нагрузка кодируется на стеке
+[[nodiscard]]
+auto send_sack(messenger::net::Connection& conn, std::uint32_t cumulative,
+               const SackBlocks& blocks) -> bool;
+
+// Предложение файла: размер и имя (file_frames.h)
+[[nodiscard]]
+auto send_file_offer(messenger::net::Connection& conn,
+                     std::uint32_t transfer_id, const FileOffer& offer)
+    -> bool;
+
+// Кусок файла: length байт с offset уходят из файла в сокет через
+// sendfile(), минуя память процесса. false — очередь занята предыдущим
+// куском или переполнена, соединение закрыто
+[[nodiscard]]
+auto send_file_chunk(messenger::net::Connection& conn,
+                     std::uint32_t transfer_id, int file_fd,
+                     std::uint64_t offset, std::size_t length) -> bool;
+
+// Подтверждение: все байты передачи до offset записаны
+[[nodiscard]]
+auto send_file_ack(messenger::net::Connection& conn, std::uint32_t transfer_id,
+                   std::uint64_t offset) -> bool;
+
 // Приём одного сообщения с сокета.
 //
 // Возвращает:
@@ -40,5 +107,11 @@ auto send_ack(int socket_fd, std::uint32_t msg_id) -> bool;
 [[nodiscard]]
 auto receive_msg(int socket_fd, Message& out, bool& disconnected) -> bool;
 
+// То же без аллокаций на кадр: кадр принимается в arena.frame, out
+// указывает в arena и действителен до следующего приёма в неё же
+[[nodiscard]]
+auto receive_msg(int socket_fd, ReceiveArena& arena, MessageView& out,
+                 bool& disconnected) -> bool;
+
 } // namespace messenger::proto
 
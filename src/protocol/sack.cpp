@@ -0,0 +1,66 @@
+#include "protocol/sack.h"
+
+#include <arpa/inet.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+
+namespace messenger::proto {
+
+namespace {
+
+constexpr std::size_t ID_SIZE = sizeof(std::uint32_t);
+
+void putId(char* out, std::uint32_t msg_id) {
+    const std::uint32_t network = htonl(msg_id);
+    std::memcpy(out, &network, ID_SIZE);
+}
+
+[[nodiscard]]
+auto getId(const char* in) -> std::uint32_t {
+    std::uint32_t network = 0;
+    std::memcpy(&network, in, ID_SIZE);
+    return ntohl(network);
+}
+
+}  // namespace
+
+[[nodiscard]]
+auto encode_sack(const SackBlocks& blocks, SackPayload& out)
+    -> std::string_view {
+    putId(out.data(), blocks.window);
+    std::size_t size = SACK_WINDOW_SIZE;
+    for (std::size_t index = 0; index < blocks.count; ++index) {
+        putId(&out.at(size), blocks.ranges.at(index).first);
+        putId(&out.at(size + ID_SIZE), blocks.ranges.at(index).last);
+        size += SACK_RANGE_SIZE;
+    }
+    return std::string_view{out.data(), size};
+}
+
+[[nodiscard]]
+auto decode_sack(std::string_view payload) -> std::optional<SackBlocks> {
+    if (payload.size() < SACK_WINDOW_SIZE) {
+        return std::nullopt;
+    }
+    const std::size_t ranges_size = payload.size() - SACK_WINDOW_SIZE;
+    if (ranges_size % SACK_RANGE_SIZE != 0 ||
+        ranges_size / SACK_RANGE_SIZE > SackBlocks::MAX_RANGES) {
+        return std::nullopt;
+    }
+
+    SackBlocks blocks{};
+    blocks.window = getId(payload.data());
+    for (std::size_t offset = SACK_WINDOW_SIZE; offset < payload.size();
+         offset += SACK_RANGE_SIZE) {
+        SackRange& range = blocks.ranges.at(blocks.count++);
+        range.first = getId(payload.data() + offset);
+        range.last = getId(payload.data() + offset + ID_SIZE);
+    }
+    return blocks;
+}
+
+}  // namespace messenger::proto
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace messenger::proto {
+
+// Накопительное и выборочное подтверждение (кадр MsgType::Sack).
+//
+// Поле id кадра — накопительная граница: получены все msg_id до неё
+// включительно. Полезная нагрузка — окно получателя (сколько сообщений
+// он готов держать в полёте) и до MAX_RANGES блоков [first, last] с id
+// выше границы, полученными через дыру, — как SACK в TCP (RFC 2018).
+// Все числа — u32 в сетевом порядке байт. Один кадр подтверждает сколько
+// угодно сообщений вместо Ack на каждое.
+
+// Блок подряд полученных id, границы включительно
+struct SackRange {
+    std::uint32_t first{};
+    std::uint32_t last{};
+};
+
+struct SackBlocks {
+    static constexpr std::size_t MAX_RANGES = 4U;
+
+    // Окно получателя, сообщений
+    std::uint32_t window{};
+    std::array<SackRange, MAX_RANGES> ranges{};
+    std::size_t count{0};
+};
+
+// Размер окна и одного блока в кадре, байт
+constexpr std::size_t SACK_WINDOW_SIZE = sizeof(std::uint32_t);
+constexpr std::size_t SACK_RANGE_SIZE = 2U * sizeof(std::uint32_t);
+
+// Буфер закодированного Sack на стеке
+using SackPayload =
+    std::array<char, SACK_WINDOW_SIZE +
+                         (SackBlocks::MAX_RANGES * SACK_RANGE_SIZE)>;
+
+// Закодировать окно и блоки в out; возвращает занятую часть out
+[[nodiscard]]
+auto encode_sack(const SackBlocks& blocks, SackPayload& out)
+    -> std::string_view;
+
+// std::nullopt — нет окна, длина блоков не кратна блоку или блоков
+// больше MAX_RANGES
+[[nodiscard]]
+auto decode_sack(std::string_view payload) -> std::optional<SackBlocks>;
+
+}  // namespace messenger::proto
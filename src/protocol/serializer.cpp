@@ -6,18 +6,19 @@
 #include <array>
 #include <bit>
 #include <cstdint>
-#include <cstring>
+#include <span>
+#include <string_view>
 #include <vector>
 
+#include "net/frame_header.h"
+#include "net/net_api.h"
+#include "protocol/compress.h"
 #include "protocol/message.hpp"
 
 namespace messenger::proto {
 
 namespace {
 
-// [type(1)][id_host(4)][len(4)][payload]
-constexpr std::size_t HEADER_SIZE = 1 + 4 + 4;
-
 [[nodiscard]]
 auto msgTypeValid(MsgType type) -> bool {
     switch (type) {
@@ -26,37 +27,79 @@ auto msgTypeValid(MsgType type) -> bool {
         case MsgType::Ack:
         case MsgType::Ping:
         case MsgType::Pong:
+        case MsgType::Sack:
+        case MsgType::FileOffer:
+        case MsgType::FileChunk:
+        case MsgType::FileAck:
             return true;
         default:
             return false;
     }
 }
 
-}  // namespace
-
+// Заголовок и границы кадра. out.payload — байты после заголовка как
+// есть, compressed — их ещё нужно распаковать
 [[nodiscard]]
-auto serialize(const Message& msg) -> std::vector<std::uint8_t> {
-    const auto payload_size = static_cast<std::uint32_t>(msg.payload.size());
+auto parseFrame(std::span<const std::uint8_t> buffer, MessageView& out,
+                bool& compressed) -> bool {
+    net::FrameHeader header{};
+    if (net::parse_frame_header(buffer, header) != net::HeaderStatus::Ok) {
+        return false;
+    }
 
-    const std::uint32_t id_net = htonl(msg.id);
-    const std::uint32_t payload_size_net = htonl(payload_size);
+    compressed = (header.type & COMPRESSED_FLAG) != 0;
+    const auto type = static_cast<MsgType>(
+        static_cast<std::uint8_t>(header.type & ~COMPRESSED_FLAG));
+    if (!msgTypeValid(type) || (compressed && type != MsgType::Text)) {
+        return false;
+    }
 
-    const auto id_bytes = std::bit_cast<std::array<std::uint8_t, 4>>(id_net);
+    if (buffer.size() != header.size + header.payload_size) {
+        return false;
+    }
 
-    const auto len_bytes =
-        std::bit_cast<std::array<std::uint8_t, 4>>(payload_size_net);
+    out.type = type;
+    out.id = header.id;
+    out.payload = std::string_view(
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        reinterpret_cast<const char*>(buffer.data() + header.size),
+        header.payload_size);
+    return true;
+}
 
-    std::vector<std::uint8_t> buffer;
-    buffer.reserve(HEADER_SIZE + payload_size);
+}  // namespace
 
-    // Тип
-    buffer.push_back(static_cast<std::uint8_t>(msg.type));
+[[nodiscard]]
+auto peek_payload_size(std::span<const std::uint8_t> header) -> std::uint32_t {
+    std::array<std::uint8_t, 4> len_bytes{};
+    std::copy_n(header.begin() + 1 + 4, 4, len_bytes.begin());
+    return ntohl(std::bit_cast<std::uint32_t>(len_bytes));
+}
 
-    // ID (4 байта)
-    buffer.insert(buffer.end(), id_bytes.begin(), id_bytes.end());
+[[nodiscard]]
+auto encode_header(net::HeaderFormat format, MsgType type,
+                   std::uint32_t msg_id, std::uint32_t payload_size,
+                   bool compressed) -> net::HeaderBytes {
+    auto type_byte = static_cast<std::uint8_t>(type);
+    if (compressed) {
+        type_byte |= COMPRESSED_FLAG;
+    }
+    return net::encode_frame_header(format, type_byte, msg_id, payload_size);
+}
+
+[[nodiscard]]
+auto serialize(const Message& msg, net::HeaderFormat format)
+    -> std::vector<std::uint8_t> {
+    const auto payload_size = static_cast<std::uint32_t>(msg.payload.size());
+    const net::HeaderBytes header =
+        encode_header(format, msg.type, msg.id, payload_size);
+
+    std::vector<std::uint8_t> buffer;
+    buffer.reserve(header.size + payload_size);
 
-    // Длина (4 байта)
-    buffer.insert(buffer.end(), len_bytes.begin(), len_bytes.end());
+    // Заголовок
+    const auto header_bytes = header.view();
+    buffer.insert(buffer.end(), header_bytes.begin(), header_bytes.end());
 
     // Полезная нагрузка
     buffer.insert(buffer.end(), msg.payload.begin(), msg.payload.end());
@@ -65,41 +108,40 @@ auto serialize(const Message& msg) -> std::vector<std::uint8_t> {
 }
 
 [[nodiscard]]
-auto deserialize(const std::vector<std::uint8_t>& buffer,
-                 Message& out) -> bool {
-    if (buffer.size() < HEADER_SIZE) {
+auto deserialize(std::span<const std::uint8_t> buffer, Message& out) -> bool {
+    MessageView view{};
+    bool compressed = false;
+    if (!parseFrame(buffer, view, compressed)) {
         return false;
     }
 
-    const auto type = static_cast<MsgType>(buffer.front());
-    if (!msgTypeValid(type)) {
-        return false;
-    }
+    out.type = view.type;
+    out.id = view.id;
 
-    // ID
-    std::array<std::uint8_t, 4> id_bytes{};
-    std::copy_n(buffer.begin() + 1, 4, id_bytes.begin());
-    const auto id_net = std::bit_cast<std::uint32_t>(id_bytes);
-    const std::uint32_t id_host = ntohl(id_net);
+    if (compressed) {
+        return decompress_payload(view.payload, net::MaxPayloadSize::value,
+                                  out.payload);
+    }
 
-    // Длина payload
-    std::array<std::uint8_t, 4> len_bytes{};
-    std::copy_n(buffer.begin() + 1 + 4, 4, len_bytes.begin());
-    const auto payload_size_net = std::bit_cast<std::uint32_t>(len_bytes);
-    const std::uint32_t payload_size = ntohl(payload_size_net);
+    out.payload.assign(view.payload);
+    return true;
+}
 
-    if (buffer.size() != HEADER_SIZE + payload_size) {
+[[nodiscard]]
+auto deserialize(std::span<const std::uint8_t> buffer, MessageView& out,
+                 ReceiveArena& arena) -> bool {
+    bool compressed = false;
+    if (!parseFrame(buffer, out, compressed)) {
         return false;
     }
 
-    out.type = type;
-    out.id = id_host;
-
-    const auto* payload_bytes = buffer.data() + HEADER_SIZE;
-
-    out.payload.resize(payload_size);
-    std::memcpy(out.payload.data(), payload_bytes, payload_size);
-
+    if (compressed) {
+        if (!decompress_payload(out.payload, net::MaxPayloadSize::value,
+                                arena.inflated)) {
+            return false;
+        }
+        out.payload = arena.inflated;
+    }
     return true;
 }
 
@@ -1,19 +1,60 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <span>
+#include <string>
 #include <vector>
 
+#include "net/frame_header.h"
 #include "protocol/message.hpp"
 
 namespace messenger::proto {
 
+// Память, в которую указывает MessageView: принятый кадр (receive_msg) и
+// распакованный Text. Живёт столько же, сколько соединение, и
+// переиспользуется от кадра к кадру: после первых кадров приём не
+// выделяет память
+struct ReceiveArena {
+    std::vector<std::uint8_t> frame;
+    std::string inflated;
+};
+
+// Размер заголовка кадра v1 [type(1)][id(4)][len(4)]; формат v2 с
+// varint-полями — net/frame_header.h
+constexpr std::size_t HEADER_SIZE = net::V1_HEADER_SIZE;
+
+// Длина полезной нагрузки из заголовка кадра v1.
+// header должен содержать не меньше HEADER_SIZE байт.
+[[nodiscard]]
+auto peek_payload_size(std::span<const std::uint8_t> header) -> std::uint32_t;
+
+// Заголовок кадра в буфере фиксированного размера (на стеке): payload
+// отправляется отдельно, без копирования в общий буфер. v2 — только
+// собеседнику, объявившему Hello::FEATURE_COMPACT_HEADER.
+// compressed — payload сжат (флаг COMPRESSED_FLAG в байте типа)
+[[nodiscard]]
+auto encode_header(net::HeaderFormat format, MsgType type,
+                   std::uint32_t msg_id, std::uint32_t payload_size,
+                   bool compressed = false) -> net::HeaderBytes;
+
 // Сериализация: Message -> bytes
 [[nodiscard]]
-auto serialize(const Message& msg) -> std::vector<std::uint8_t>;
+auto serialize(const Message& msg,
+               net::HeaderFormat format = net::HeaderFormat::V1)
+    -> std::vector<std::uint8_t>;
 
 // Десериализация: bytes -> Message
-// Возвращает true, если буфер корректен и out заполнен.
+// Возвращает true, если буфер корректен и out заполнен. Заголовок — в
+// любом из форматов. Сжатый Text распаковывается; сжатие других типов —
+// ошибка протокола.
+[[nodiscard]]
+auto deserialize(std::span<const std::uint8_t> buffer, Message& out) -> bool;
+
+// То же без копирования: out.payload указывает в buffer, а у сжатого
+// Text — в arena.inflated
 [[nodiscard]]
-auto deserialize(const std::vector<std::uint8_t>& buffer, Message& out) -> bool;
+auto deserialize(std::span<const std::uint8_t> buffer, MessageView& out,
+                 ReceiveArena& arena) -> bool;
 
 } // namespace messenger::proto
@@ -0,0 +1,316 @@
+#include "utils/async_appender.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include "utils/file_io.h"
+#include "utils/p2p_error.h"
+
+namespace messenger::utils {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Предел одной пачки: при непрерывном потоке записей пачка не растёт
+// бесконечно
+constexpr std::size_t MAX_BATCH_BYTES = 256U * 1024U;
+
+// Наибольший сон простаивающего потока записи
+constexpr auto IDLE_RECHECK = std::chrono::seconds(60);
+
+}  // namespace
+
+AsyncAppender::AsyncAppender(std::string path)
+    : AsyncAppender(std::move(path), Options{}) {}
+
+AsyncAppender::AsyncAppender(std::string path, Options options)
+    : path_(std::move(path)),
+      options_(options),
+      queue_(options.queue_capacity) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    file_fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                      FILE_MODE);
+    if (file_fd_ < 0) {
+        throw_system_error("open");
+    }
+
+    writer_ = std::thread([this] { run(); });
+}
+
+AsyncAppender::~AsyncAppender() {
+    flush();
+
+    {
+        const std::lock_guard<std::mutex> lock(wake_mutex_);
+        stop_requested_.store(true, std::memory_order_release);
+    }
+    wake_cv_.notify_one();
+    writer_.join();
+
+    ::close(file_fd_);
+}
+
+void AsyncAppender::append(std::string record) {
+    push(Item{std::move(record)});
+}
+
+void AsyncAppender::replace(std::string contents) {
+    push(Item{std::move(contents), true});
+}
+
+void AsyncAppender::push(Item item) {
+    drainHeld();  // сохранить порядок: сначала придержанные
+
+    if (held_.empty() && queue_.try_push(std::move(item))) {
+        ++submitted_;
+    } else {
+        held_.push_back(std::move(item));
+    }
+    wakeWriter();
+}
+
+void AsyncAppender::flush() {
+    // Придержанные записи дожидаются места в очереди
+    while (!held_.empty()) {
+        drainHeld();
+        wakeWriter();
+        if (!held_.empty()) {
+            std::this_thread::yield();
+        }
+    }
+
+    std::uint64_t processed = processed_.load(std::memory_order_acquire);
+    while (processed < submitted_) {
+        processed_.wait(processed, std::memory_order_acquire);
+        processed = processed_.load(std::memory_order_acquire);
+    }
+}
+
+[[nodiscard]]
+auto AsyncAppender::parse_durability(std::string_view text)
+    -> std::optional<Options> {
+    Options options{};
+    if (text == "none") {
+        options.durability = Durability::None;
+        return options;
+    }
+    if (text == "always") {
+        options.durability = Durability::Always;
+        return options;
+    }
+
+    if (text.ends_with("ms")) {
+        text.remove_suffix(2);
+    }
+    std::int64_t interval_ms = 0;
+    const auto [end, error] =
+        std::from_chars(text.data(), text.data() + text.size(), interval_ms);
+    if (error != std::errc{} || end != text.data() + text.size() ||
+        interval_ms <= 0) {
+        return std::nullopt;
+    }
+    options.durability = Durability::Interval;
+    options.sync_interval = std::chrono::milliseconds(interval_ms);
+    return options;
+}
+
+[[nodiscard]]
+auto AsyncAppender::path() const -> const std::string& {
+    return path_;
+}
+
+[[nodiscard]]
+auto AsyncAppender::written_records() const -> std::uint64_t {
+    return written_records_.load(std::memory_order_relaxed);
+}
+
+[[nodiscard]]
+auto AsyncAppender::write_batches() const -> std::uint64_t {
+    return write_batches_.load(std::memory_order_relaxed);
+}
+
+[[nodiscard]]
+auto AsyncAppender::sync_count() const -> std::uint64_t {
+    return sync_count_.load(std::memory_order_relaxed);
+}
+
+[[nodiscard]]
+auto AsyncAppender::failed() const -> bool {
+    return failed_.load(std::memory_order_relaxed);
+}
+
+void AsyncAppender::run() {
+    std::string batch;
+    Item item;
+    bool dirty = false;
+    Clock::time_point last_sync = Clock::now();
+
+    while (true) {
+        // Забрать всё накопившееся одной пачкой; замена файла завершает
+        // пачку — записи за ней пойдут уже в новый файл
+        batch.clear();
+        std::uint64_t records = 0;
+        bool replaces_file = false;
+        while (batch.size() < MAX_BATCH_BYTES && queue_.try_pop(item)) {
+            if (item.replaces_file) {
+                replaces_file = true;
+                break;
+            }
+            batch += item.bytes;
+            ++records;
+        }
+
+        if (records != 0 || replaces_file) {
+            if (records != 0 && !failed() && writeBatch(batch)) {
+                written_records_.fetch_add(records, std::memory_order_relaxed);
+                write_batches_.fetch_add(1, std::memory_order_relaxed);
+                dirty = true;
+            }
+            if (replaces_file) {
+                // Прежний файл заменяется целиком: его несинхронизированные
+                // данные больше не нужны
+                replaceFile(item.bytes);
+                dirty = false;
+                ++records;
+            }
+
+            const Clock::time_point now = Clock::now();
+            if (dirty &&
+                (options_.durability == Durability::Always ||
+                 (options_.durability == Durability::Interval &&
+                  now - last_sync >= options_.sync_interval))) {
+                sync();
+                dirty = false;
+                last_sync = now;
+            }
+
+            processed_.fetch_add(records, std::memory_order_release);
+            processed_.notify_all();
+            continue;  // пока писали, могли прийти новые записи
+        }
+
+        if (stop_requested_.load(std::memory_order_acquire)) {
+            // Записи, поставленные перед остановкой, уже видны
+            if (!queue_.empty()) {
+                continue;
+            }
+            if (dirty && options_.durability != Durability::None) {
+                sync();
+            }
+            return;
+        }
+
+        // Сон до новой записи, остановки или срока фиксации интервала
+        const bool sync_pending =
+            dirty && options_.durability == Durability::Interval;
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            writer_sleeping_.store(true, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            const auto ready = [this] {
+                return !queue_.empty() ||
+                       stop_requested_.load(std::memory_order_acquire);
+            };
+            // Без отложенной фиксации сон ограничен только страховочной
+            // перепроверкой очереди
+            const Clock::time_point wake_at =
+                sync_pending ? last_sync + options_.sync_interval
+                             : Clock::now() + IDLE_RECHECK;
+            wake_cv_.wait_until(lock, wake_at, ready);
+            writer_sleeping_.store(false, std::memory_order_relaxed);
+        }
+
+        const Clock::time_point now = Clock::now();
+        if (sync_pending && now - last_sync >= options_.sync_interval) {
+            sync();
+            dirty = false;
+            last_sync = now;
+        }
+    }
+}
+
+void AsyncAppender::drainHeld() {
+    std::size_t pushed = 0;
+    while (pushed < held_.size() && queue_.try_push(std::move(held_[pushed]))) {
+        ++pushed;
+    }
+    submitted_ += pushed;
+    held_.erase(held_.begin(),
+                held_.begin() + static_cast<std::ptrdiff_t>(pushed));
+}
+
+void AsyncAppender::wakeWriter() {
+    // Парный барьер к записи writer_sleeping_ в run(): либо поток записи
+    // увидит новую запись в очереди, либо здесь будет видно, что он спит
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (writer_sleeping_.load(std::memory_order_seq_cst)) {
+        const std::lock_guard<std::mutex> lock(wake_mutex_);
+        wake_cv_.notify_one();
+    }
+}
+
+[[nodiscard]]
+auto AsyncAppender::writeBatch(const std::string& batch) -> bool {
+    std::size_t offset = 0;
+    while (offset < batch.size()) {
+        const ssize_t written =
+            ::write(file_fd_, batch.data() + offset, batch.size() - offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            failed_.store(true, std::memory_order_relaxed);
+            return false;
+        }
+        offset += static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+void AsyncAppender::replaceFile(const std::string& contents) {
+    if (failed()) {
+        return;
+    }
+    try {
+        replace_file_synced(path_, contents);
+    } catch (const std::system_error&) {
+        failed_.store(true, std::memory_order_relaxed);
+        return;
+    }
+
+    // Дальнейшие записи — в новый файл; прежний дескриптор указывает на
+    // файл, вытесненный переименованием
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    const int file_fd = ::open(path_.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (file_fd < 0) {
+        failed_.store(true, std::memory_order_relaxed);
+        return;
+    }
+    ::close(file_fd_);
+    file_fd_ = file_fd;
+    sync_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AsyncAppender::sync() {
+    if (::fdatasync(file_fd_) == 0) {
+        sync_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+}  // namespace messenger::utils
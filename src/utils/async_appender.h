@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "utils/spsc_queue.h"
+
+namespace messenger::utils {
+
+// Фоновая дозапись в файл с групповой фиксацией (group commit).
+//
+// Записи передаются из одного потока (например, цикла чата) через
+// lock-free очередь в поток записи. Тот забирает всё накопившееся,
+// пишет одной операцией write() и вызывает fdatasync() по выбранной
+// политике — один раз на пачку, а не на каждую запись. Поток-производитель
+// никогда не ждёт диска: при заполненной очереди записи придерживаются
+// у него и уходят при следующих append(). Замена файла целиком
+// (контрольная точка журнала) тоже выполняется потоком записи, в порядке
+// очереди.
+class AsyncAppender {
+public:
+    // Политика долговечности
+    enum class Durability {
+        None,      // без fdatasync(): данные в page cache ядра
+        Interval,  // fdatasync() не реже раза в sync_interval
+        Always     // fdatasync() после каждой пачки записей
+    };
+
+    struct Options {
+        Durability durability{Durability::Interval};
+        std::chrono::milliseconds sync_interval{1000};
+        // Ёмкость очереди, записей
+        std::size_t queue_capacity{1024U};
+    };
+
+    // Открывает (создаёт) файл на дозапись и запускает поток записи.
+    // При системной ошибке бросает исключение
+    explicit AsyncAppender(std::string path);
+    AsyncAppender(std::string path, Options options);
+
+    // Дописывает все принятые записи, фиксирует их и останавливает поток
+    ~AsyncAppender();
+
+    AsyncAppender(const AsyncAppender&) = delete;
+    AsyncAppender& operator=(const AsyncAppender&) = delete;
+    AsyncAppender(AsyncAppender&&) = delete;
+    AsyncAppender& operator=(AsyncAppender&&) = delete;
+
+    // Поставить запись (байты как есть, разделитель — забота вызывающего).
+    // Только из одного потока-производителя; не блокируется на диске
+    void append(std::string record);
+
+    // Заменить файл содержимым contents (через временный файл и
+    // переименование, см. utils/file_io.h): записи, поставленные раньше,
+    // уходят в прежний файл, поставленные позже — в новый. Не блокируется.
+    // При ошибке файл остаётся прежним, а failed() становится true
+    void replace(std::string contents);
+
+    // Дождаться, пока поток записи обработает все поставленные записи
+    // (fdatasync() — по политике). Блокирует вызывающего: для завершения
+    // и тестов, не для цикла чата
+    void flush();
+
+    // Разбор политики: "none", "always" или интервал в мс ("500", "500ms").
+    // std::nullopt — строка не распознана
+    [[nodiscard]]
+    static auto parse_durability(std::string_view text)
+        -> std::optional<Options>;
+
+    [[nodiscard]]
+    auto path() const -> const std::string&;
+
+    // Статистика потока записи
+    [[nodiscard]]
+    auto written_records() const -> std::uint64_t;
+    [[nodiscard]]
+    auto write_batches() const -> std::uint64_t;
+    [[nodiscard]]
+    auto sync_count() const -> std::uint64_t;
+
+    // Была ли ошибка записи или замены файла (последующие записи
+    // отбрасываются)
+    [[nodiscard]]
+    auto failed() const -> bool;
+
+private:
+    // Элемент очереди: запись для дозаписи или новое содержимое файла
+    struct Item {
+        std::string bytes;
+        bool replaces_file{false};
+    };
+
+    void run();
+    void push(Item item);
+    void drainHeld();
+    void wakeWriter();
+    [[nodiscard]]
+    auto writeBatch(const std::string& batch) -> bool;
+    void sync();
+    void replaceFile(const std::string& contents);
+
+    std::string path_;
+    Options options_;
+    int file_fd_{-1};
+
+    SpscQueue<Item> queue_;
+    // Записи, не поместившиеся в очередь (принадлежат производителю)
+    std::vector<Item> held_;
+
+    // Усыпление потока записи: производитель берёт мьютекс, только если
+    // поток записи действительно спит
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::atomic<bool> writer_sleeping_{false};
+    std::atomic<bool> stop_requested_{false};
+
+    // Поставлено в очередь (только производитель) / обработано потоком
+    // записи, успешно или нет
+    std::uint64_t submitted_{0};
+    std::atomic<std::uint64_t> processed_{0};
+
+    std::atomic<std::uint64_t> written_records_{0};
+    std::atomic<std::uint64_t> write_batches_{0};
+    std::atomic<std::uint64_t> sync_count_{0};
+    std::atomic<bool> failed_{false};
+
+    std::thread writer_;
+};
+
+}  // namespace messenger::utils
@@ -0,0 +1,83 @@
+#include "utils/file_io.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "utils/p2p_error.h"
+
+namespace messenger::utils {
+
+[[nodiscard]]
+auto read_file(const std::string& path) -> std::optional<std::string> {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    const int file_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file_fd < 0) {
+        return std::nullopt;
+    }
+    std::string contents;
+    std::array<char, 4096> chunk{};
+    while (true) {
+        const ssize_t got = ::read(file_fd, chunk.data(), chunk.size());
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            break;
+        }
+        contents.append(chunk.data(), static_cast<std::size_t>(got));
+    }
+    ::close(file_fd);
+    return contents;
+}
+
+void write_file_synced(const std::string& path, std::string_view contents) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    const int file_fd = ::open(path.c_str(),
+                               O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                               FILE_MODE);
+    if (file_fd < 0) {
+        throw_system_error("open");
+    }
+
+    std::size_t offset = 0;
+    while (offset < contents.size()) {
+        const ssize_t written = ::write(file_fd, contents.data() + offset,
+                                        contents.size() - offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ::close(file_fd);
+            throw_system_error("write");
+        }
+        offset += static_cast<std::size_t>(written);
+    }
+    if (::fdatasync(file_fd) < 0) {
+        ::close(file_fd);
+        throw_system_error("fdatasync");
+    }
+    ::close(file_fd);
+}
+
+void replace_file_synced(const std::string& path, std::string_view contents) {
+    const std::string temp_path = path + ".tmp";
+    try {
+        write_file_synced(temp_path, contents);
+        if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+            throw_system_error("rename");
+        }
+    } catch (...) {
+        static_cast<void>(::unlink(temp_path.c_str()));
+        throw;
+    }
+}
+
+}  // namespace messenger::utils
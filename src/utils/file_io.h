@@ -0,0 +1,28 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace messenger::utils {
+
+// Права создаваемых файлов: rw-r--r--
+inline constexpr mode_t FILE_MODE = 0644;
+
+// Прочитать файл целиком. std::nullopt — файл не открылся (например,
+// его нет)
+[[nodiscard]]
+auto read_file(const std::string& path) -> std::optional<std::string>;
+
+// Записать файл целиком и зафиксировать его на диске (fdatasync).
+// При системной ошибке бросает исключение
+void write_file_synced(const std::string& path, std::string_view contents);
+
+// Заменить файл целиком: запись в <path>.tmp, fdatasync() и атомарное
+// переименование поверх path — после сбоя виден старый или новый файл.
+// При ошибке path не тронут, временный файл удалён, бросается исключение
+void replace_file_synced(const std::string& path, std::string_view contents);
+
+}  // namespace messenger::utils
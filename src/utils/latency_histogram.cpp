@@ -0,0 +1,116 @@
+#include "utils/latency_histogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace messenger::utils {
+
+void LatencyHistogram::record(std::uint64_t value) {
+    ++counts_.at(bucket_index(value));
+    min_ = count_ == 0 ? value : std::min(min_, value);
+    max_ = std::max(max_, value);
+    sum_ += value;
+    ++count_;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    if (other.count_ == 0) {
+        return;
+    }
+    for (std::size_t index = 0; index < BUCKETS; ++index) {
+        counts_.at(index) += other.counts_.at(index);
+    }
+    min_ = count_ == 0 ? other.min_ : std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    sum_ += other.sum_;
+    count_ += other.count_;
+}
+
+void LatencyHistogram::reset() {
+    *this = LatencyHistogram{};
+}
+
+[[nodiscard]]
+auto LatencyHistogram::count() const -> std::uint64_t {
+    return count_;
+}
+
+[[nodiscard]]
+auto LatencyHistogram::min() const -> std::uint64_t {
+    return min_;
+}
+
+[[nodiscard]]
+auto LatencyHistogram::max() const -> std::uint64_t {
+    return max_;
+}
+
+[[nodiscard]]
+auto LatencyHistogram::sum() const -> std::uint64_t {
+    return sum_;
+}
+
+[[nodiscard]]
+auto LatencyHistogram::mean() const -> double {
+    return count_ == 0
+               ? 0.0
+               : static_cast<double>(sum_) / static_cast<double>(count_);
+}
+
+[[nodiscard]]
+auto LatencyHistogram::percentile(double quantile) const -> std::uint64_t {
+    if (count_ == 0) {
+        return 0;
+    }
+    // Номер замера (с 1), на который приходится перцентиль
+    const auto rank = static_cast<std::uint64_t>(
+        std::ceil(std::clamp(quantile, 0.0, 1.0) *
+                  static_cast<double>(count_)));
+    const std::uint64_t target = std::clamp<std::uint64_t>(rank, 1, count_);
+
+    std::uint64_t seen = 0;
+    for (std::size_t index = 0; index < BUCKETS; ++index) {
+        seen += counts_.at(index);
+        if (seen >= target) {
+            return std::min(bucket_upper_bound(index), max_);
+        }
+    }
+    return max_;
+}
+
+[[nodiscard]]
+auto LatencyHistogram::bucket_count(std::size_t index) const
+    -> std::uint64_t {
+    return counts_.at(index);
+}
+
+// Корзины 0..SUB_BUCKETS-1 — точные значения 0..31. Дальше группа g
+// (с 1) покрывает [2^(g+4), 2^(g+5)) корзинами шириной 2^(g-1)
+[[nodiscard]]
+auto LatencyHistogram::bucket_upper_bound(std::size_t index)
+    -> std::uint64_t {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    const std::size_t group = index / SUB_BUCKETS;
+    const std::uint64_t sub = index % SUB_BUCKETS;
+    const std::uint64_t width = std::uint64_t{1} << (group - 1U);
+    return ((SUB_BUCKETS + sub) << (group - 1U)) + (width - 1U);
+}
+
+[[nodiscard]]
+auto LatencyHistogram::bucket_index(std::uint64_t value) -> std::size_t {
+    if (value < SUB_BUCKETS) {
+        return static_cast<std::size_t>(value);
+    }
+    const auto group =
+        static_cast<std::size_t>(std::bit_width(value)) - SUB_BUCKET_BITS;
+    const auto sub = static_cast<std::size_t>(value >> (group - 1U)) -
+                     SUB_BUCKETS;
+    return group * SUB_BUCKETS + sub;
+}
+
+}  // namespace messenger::utils
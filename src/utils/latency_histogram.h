@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace messenger::utils {
+
+// Гистограмма задержек с логарифмически-линейными корзинами (как HDR).
+//
+// Каждая степень двойки делится на SUB_BUCKETS равных корзин, поэтому
+// относительная погрешность любого перцентиля не больше 1/SUB_BUCKETS
+// (~3%) во всём диапазоне uint64 — и для микросекунд, и для минут.
+// Память фиксирована, record() не выделяет память и стоит несколько
+// инструкций. Единица измерения — на усмотрение вызывающего.
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 5U;
+    static constexpr std::size_t SUB_BUCKETS = std::size_t{1}
+                                               << SUB_BUCKET_BITS;
+    static constexpr std::size_t BUCKETS =
+        (64U - SUB_BUCKET_BITS + 1U) * SUB_BUCKETS;
+
+    void record(std::uint64_t value);
+
+    // Добавить замеры другой гистограммы (например, другого потока)
+    void merge(const LatencyHistogram& other);
+
+    void reset();
+
+    [[nodiscard]]
+    auto count() const -> std::uint64_t;
+    [[nodiscard]]
+    auto min() const -> std::uint64_t;
+    [[nodiscard]]
+    auto max() const -> std::uint64_t;
+    [[nodiscard]]
+    auto sum() const -> std::uint64_t;
+    [[nodiscard]]
+    auto mean() const -> double;
+
+    // Значение, которого не превышает доля quantile замеров (0..1):
+    // верхняя граница корзины, не больше max(). 0 — замеров нет
+    [[nodiscard]]
+    auto percentile(double quantile) const -> std::uint64_t;
+
+    // Корзины для экспорта: число замеров в корзине index и наибольшее
+    // попадающее в неё значение
+    [[nodiscard]]
+    auto bucket_count(std::size_t index) const -> std::uint64_t;
+    [[nodiscard]]
+    static auto bucket_upper_bound(std::size_t index) -> std::uint64_t;
+    [[nodiscard]]
+    static auto bucket_index(std::uint64_t value) -> std::size_t;
+
+private:
+    std::array<std::uint64_t, BUCKETS> counts_{};
+    std::uint64_t count_{0};
+    std::uint64_t sum_{0};
+    std::uint64_t min_{0};
+    std::uint64_t max_{0};
+};
+
+}  // namespace messenger::utils
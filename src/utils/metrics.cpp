@@ -0,0 +1,151 @@
+#include "utils/metrics.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "utils/latency_histogram.h"
+
+namespace messenger::utils {
+
+namespace {
+
+// Квантили summary в экспорте Prometheus
+constexpr std::array<std::string_view, 4> QUANTILE_LABELS{"0.5", "0.9",
+                                                          "0.99", "0.999"};
+constexpr std::array<double, 4> QUANTILES{0.5, 0.9, 0.99, 0.999};
+
+// Поиск метрики по имени; новая — в конец списка
+template <typename Entry>
+[[nodiscard]]
+auto findOrAdd(std::vector<std::unique_ptr<Entry>>& entries,
+               std::string_view name, std::string_view help) -> Entry& {
+    for (const auto& entry : entries) {
+        if (entry->name == name) {
+            return *entry;
+        }
+    }
+    auto entry = std::make_unique<Entry>();
+    entry->name = std::string(name);
+    entry->help = std::string(help);
+    entries.push_back(std::move(entry));
+    return *entries.back();
+}
+
+void writeHeader(std::ostream& out, const std::string& name,
+                 const std::string& help, std::string_view type) {
+    out << "# HELP " << name << ' ' << help << '\n'
+        << "# TYPE " << name << ' ' << type << '\n';
+}
+
+}  // namespace
+
+[[nodiscard]]
+auto Counter::value() const -> std::uint64_t {
+    std::uint64_t total = 0;
+    for (const Shard& shard : shards_) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void Histogram::record(std::uint64_t value) {
+    Shard& shard = shards_.at(metric_shard() % SHARDS);
+    const std::lock_guard lock(shard.mutex);
+    shard.histogram.record(value);
+}
+
+[[nodiscard]]
+auto Histogram::snapshot() const -> LatencyHistogram {
+    LatencyHistogram merged;
+    for (const Shard& shard : shards_) {
+        const std::lock_guard lock(shard.mutex);
+        merged.merge(shard.histogram);
+    }
+    return merged;
+}
+
+[[nodiscard]]
+auto MetricsRegistry::counter(std::string_view name, std::string_view help)
+    -> Counter& {
+    const std::lock_guard lock(mutex_);
+    return findOrAdd(counters_, name, help).metric;
+}
+
+[[nodiscard]]
+auto MetricsRegistry::histogram(std::string_view name, std::string_view help)
+    -> Histogram& {
+    const std::lock_guard lock(mutex_);
+    return findOrAdd(histograms_, name, help).metric;
+}
+
+[[nodiscard]]
+auto MetricsRegistry::counters() const -> std::vector<CounterSample> {
+    const std::lock_guard lock(mutex_);
+    std::vector<CounterSample> samples;
+    samples.reserve(counters_.size());
+    for (const auto& entry : counters_) {
+        samples.push_back({entry->name, entry->help, entry->metric.value()});
+    }
+    return samples;
+}
+
+[[nodiscard]]
+auto MetricsRegistry::histograms() const -> std::vector<HistogramSample> {
+    const std::lock_guard lock(mutex_);
+    std::vector<HistogramSample> samples;
+    samples.reserve(histograms_.size());
+    for (const auto& entry : histograms_) {
+        samples.push_back(
+            {entry->name, entry->help, entry->metric.snapshot()});
+    }
+    return samples;
+}
+
+void MetricsRegistry::write_prometheus(std::ostream& out) const {
+    for (const CounterSample& sample : counters()) {
+        writeHeader(out, sample.name, sample.help, "counter");
+        out << sample.name << ' ' << sample.value << '\n';
+    }
+    for (const HistogramSample& sample : histograms()) {
+        writeHeader(out, sample.name, sample.help, "summary");
+        for (std::size_t index = 0; index < QUANTILES.size(); ++index) {
+            out << sample.name << "{quantile=\"" << QUANTILE_LABELS.at(index)
+                << "\"} " << sample.histogram.percentile(QUANTILES.at(index))
+                << '\n';
+        }
+        out << sample.name << "_sum " << sample.histogram.sum() << '\n'
+            << sample.name << "_count " << sample.histogram.count() << '\n';
+    }
+}
+
+void MetricsRegistry::export_prometheus(const std::string& path) const {
+    const std::string temp_path = path + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::trunc);
+        write_prometheus(out);
+        out.flush();
+        if (!out) {
+            throw std::runtime_error(temp_path + ": ошибка записи");
+        }
+    }
+    std::filesystem::rename(temp_path, path);
+}
+
+[[nodiscard]]
+auto metrics() -> MetricsRegistry& {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+}  // namespace messenger::utils
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "utils/latency_histogram.h"
+
+namespace messenger::utils {
+
+// Номер шарда метрик для текущего потока: потоки получают шарды по
+// кругу при первом обращении. В заголовке — чтобы Counter::add()
+// встраивался целиком
+[[nodiscard]]
+inline auto metric_shard() -> std::size_t {
+    static std::atomic<std::size_t> next_shard{0};
+    thread_local const std::size_t shard =
+        next_shard.fetch_add(1, std::memory_order_relaxed);
+    return shard;
+}
+
+// Монотонный счётчик.
+//
+// Каждый поток пишет в свой шард на отдельной кэш-линии — relaxed
+// fetch_add без общей линии между потоками. Сумма шардов собирается
+// только при чтении (/статистика, экспорт).
+class Counter {
+public:
+    static constexpr std::size_t SHARDS = 8U;
+
+    void add(std::uint64_t delta = 1) {
+        shards_.at(metric_shard() % SHARDS)
+            .value.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]]
+    auto value() const -> std::uint64_t;
+
+private:
+    // Размер кэш-линии для разнесения шардов
+    static constexpr std::size_t CACHE_LINE = 64U;
+
+    struct alignas(CACHE_LINE) Shard {
+        std::atomic<std::uint64_t> value{0};
+    };
+    std::array<Shard, SHARDS> shards_{};
+};
+
+// Гистограмма задержек (LatencyHistogram) с шардами по потокам: замер —
+// захват мьютекса своего шарда, который другие потоки не трогают.
+// Единица — в имени метрики (..._microseconds)
+class Histogram {
+public:
+    static constexpr std::size_t SHARDS = 4U;
+
+    void record(std::uint64_t value);
+
+    // Все шарды одной гистограммой
+    [[nodiscard]]
+    auto snapshot() const -> LatencyHistogram;
+
+private:
+    struct Shard {
+        mutable std::mutex mutex;
+        LatencyHistogram histogram;
+    };
+    std::array<Shard, SHARDS> shards_{};
+};
+
+// Реестр метрик процесса.
+//
+// Метрики регистрируются по имени при первом обращении и живут столько
+// же, сколько реестр: ссылку можно держать и обновлять без поиска.
+// Снимок отдаётся для вывода (/статистика) и в текстовом формате
+// Prometheus — файлом для textfile-коллектора node exporter.
+class MetricsRegistry {
+public:
+    struct CounterSample {
+        std::string name;
+        std::string help;
+        std::uint64_t value{0};
+    };
+
+    struct HistogramSample {
+        std::string name;
+        std::string help;
+        LatencyHistogram histogram;
+    };
+
+    MetricsRegistry() = default;
+    ~MetricsRegistry() = default;
+
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+    MetricsRegistry(MetricsRegistry&&) = delete;
+    MetricsRegistry& operator=(MetricsRegistry&&) = delete;
+
+    // Метрика с именем name; повторный вызов возвращает ту же
+    [[nodiscard]]
+    auto counter(std::string_view name, std::string_view help) -> Counter&;
+    [[nodiscard]]
+    auto histogram(std::string_view name, std::string_view help)
+        -> Histogram&;
+
+    // Снимок в порядке регистрации
+    [[nodiscard]]
+    auto counters() const -> std::vector<CounterSample>;
+    [[nodiscard]]
+    auto histograms() const -> std::vector<HistogramSample>;
+
+    // Текстовый формат Prometheus: счётчики — counter, гистограммы —
+    // summary с квантилями 0.5, 0.9, 0.99, 0.999
+    void write_prometheus(std::ostream& out) const;
+
+    // Запись в path через временный файл и rename(): сборщик не увидит
+    // файл наполовину. При ошибке записи бросает исключение
+    void export_prometheus(const std::string& path) const;
+
+private:
+    template <typename Metric>
+    struct Named {
+        std::string name;
+        std::string help;
+        Metric metric;
+    };
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Named<Counter>>> counters_;
+    std::vector<std::unique_ptr<Named<Histogram>>> histograms_;
+};
+
+// Общий реестр процесса
+[[nodiscard]]
+auto metrics() -> MetricsRegistry&;
+
+}  // namespace messenger::utils
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace messenger::utils {
+
+// Ограниченная lock-free очередь «один производитель — один потребитель».
+//
+// Кольцо фиксированной ёмкости (степень двойки) выделяется один раз;
+// производитель двигает только tail_, потребитель — только head_, поэтому
+// синхронизация сводится к паре acquire/release без блокировок.
+// Индексы лежат в разных кэш-линиях, чтобы потоки не делили линию.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(std::size_t capacity)
+        : slots_(std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity)),
+          mask_(slots_.size() - 1) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+    SpscQueue(SpscQueue&&) = delete;
+    SpscQueue& operator=(SpscQueue&&) = delete;
+    ~SpscQueue() = default;
+
+    // Только поток-производитель. false — очередь заполнена, value не тронут
+    [[nodiscard]]
+    auto try_push(T&& value) -> bool {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ == slots_.size()) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ == slots_.size()) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Только поток-потребитель. false — очередь пуста
+    [[nodiscard]]
+    auto try_pop(T& value) -> bool {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) {
+                return false;
+            }
+        }
+        value = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Приблизительно (точно — только из потока-потребителя)
+    [[nodiscard]]
+    auto empty() const -> bool {
+        return head_.load(std::memory_order_acquire) ==
+               tail_.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]]
+    auto capacity() const -> std::size_t {
+        return slots_.size();
+    }
+
+private:
+    // Размер кэш-линии для разнесения индексов
+    static constexpr std::size_t CACHE_LINE = 64U;
+
+    std::vector<T> slots_;
+    std::size_t mask_;
+
+    // Поля потребителя
+    alignas(CACHE_LINE) std::atomic<std::size_t> head_{0};
+    std::size_t tail_cache_{0};
+
+    // Поля производителя
+    alignas(CACHE_LINE) std::atomic<std::size_t> tail_{0};
+    std::size_t head_cache_{0};
+};
+
+}  // namespace messenger::utils
@@ -1,18 +1,30 @@
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <gtest/gtest.h>
 #include <netinet/in.h>
 #include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <cerrno>
 #include <chrono>
+#include <csignal>
 #include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <streambuf>
@@ -23,14 +35,74 @@
 #include <utility>
 #include <vector>
 
+#include "app/ack_retry.h"
+#include "app/dedup_window.h"
+#include "app/file_transfer.h"
+#include "app/history_index.h"
+#include "app/history_ring.h"
+#include "app/history_store.h"
+#include "app/hub.h"
+#include "app/loopback_bench.h"
+#include "app/outbox.h"
+#include "app/outbox_log.h"
+#include "app/rtt_estimator.h"
+#include "app/send_window.h"
+#include "app/session.h"
 // #include "app/p2p_chat.h"
 #include "net/client_socket.h"
+#include "net/connection.h"
+#include "net/event_loop.h"
+#include "net/frame_header.h"
+#include "net/frame_reader.h"
+#include "net/net_api.h"
+#include "net/net_metrics.h"
+#include "net/outbound_queue.h"
 #include "net/raii_socket.h"
+#include "net/reconnect.h"
 #include "net/server_socket.h"
+#include "net/timer_wheel.h"
+#include "protocol/compress.h"
+#include "protocol/file_frames.h"
+#include "protocol/hello.h"
+#include "protocol/message.hpp"
+#include "protocol/protocol_api.h"
+#include "protocol/sack.h"
+#include "protocol/serializer.h"
+#include "utils/async_appender.h"
+#include "utils/latency_histogram.h"
+#include "utils/metrics.h"
 #include "utils/p2p_error.h"
+#include "utils/spsc_queue.h"
 
 using namespace messenger;
 
+// ============= Счётчик выделений памяти =============
+// Замена глобальных operator new/delete: тесты путей без аллокаций
+// сравнивают значение счётчика до и после вызова
+
+namespace {
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+std::atomic<std::size_t> allocation_count{0};
+}  // namespace
+
+// NOLINTBEGIN(cppcoreguidelines-no-malloc,misc-new-delete-overloads)
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t /*size*/) noexcept {
+    std::free(memory);
+}
+// NOLINTEND(cppcoreguidelines-no-malloc,misc-new-delete-overloads)
+
 // ============= Тест для функции throw_system_error =============
 TEST(ThrowSystemErrorTest, ThrowsSystemErrorWithCorrectMessageAndErrno) {
     errno = EINVAL;  // задать errno для теста
@@ -331,6 +403,3292 @@ TEST_F(CreateServerSocketTest, ServerReceivesData) {
     server.join();
 }
 
+// ============= Тесты класса EventLoop =============
+
+// ------------- Фикстура: пара соединённых сокетов -------------
+class EventLoopTest : public ::testing::Test {
+protected:
+    int sock_user{};
+    int sock_peer{};
+
+    void SetUp() override {
+        std::array<int, 2> sock_p{};
+        ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, sock_p.data()), 0);
+        sock_user = sock_p[0];
+        sock_peer = sock_p[1];
+    }
+
+    void TearDown() override {
+        ::close(sock_user);
+        ::close(sock_peer);
+    }
+};
+
+// Готовый к чтению дескриптор попадает в список событий
+TEST_F(EventLoopTest, ReportsReadableDescriptor) {
+    EventLoop loop;
+    loop.add(sock_user, EPOLLIN);
+
+    const char msg = 'A';
+    ASSERT_EQ(::send(sock_peer, &msg, 1, 0), 1);
+
+    const auto& events = loop.wait(1000);
+    ASSERT_EQ(events.size(), 1U);
+    EXPECT_EQ(events.front().fd, sock_user);
+    EXPECT_TRUE((events.front().events & EPOLLIN) != 0U);
+    EXPECT_FALSE(loop.timer_expired());
+}
+
+// Таймер будит цикл не раньше дедлайна
+TEST_F(EventLoopTest, TimerFiresAtDeadline) {
+    EventLoop loop;
+    const auto start = EventLoop::Clock::now();
+    const auto deadline = start + std::chrono::milliseconds(30);
+    loop.arm_timer(deadline);
+
+    const auto& events = loop.wait(1000);
+
+    EXPECT_TRUE(events.empty());
+    EXPECT_TRUE(loop.timer_expired());
+    EXPECT_GE(EventLoop::Clock::now(), deadline);
+}
+
+// Дедлайн в прошлом срабатывает немедленно
+TEST_F(EventLoopTest, PastDeadlineFiresImmediately) {
+    EventLoop loop;
+    loop.arm_timer(EventLoop::Clock::now() - std::chrono::seconds(1));
+
+    static_cast<void>(loop.wait(1000));
+
+    EXPECT_TRUE(loop.timer_expired());
+}
+
+// Снятый таймер не будит цикл
+TEST_F(EventLoopTest, DisarmedTimerDoesNotWake) {
+    EventLoop loop;
+    loop.arm_timer(EventLoop::Clock::now() + std::chrono::milliseconds(10));
+    loop.arm_timer(std::nullopt);
+
+    const auto& events = loop.wait(50);
+
+    EXPECT_TRUE(events.empty());
+    EXPECT_FALSE(loop.timer_expired());
+}
+
+// Снятый с наблюдения дескриптор больше не сообщает о готовности
+TEST_F(EventLoopTest, RemovedDescriptorIsNotReported) {
+    EventLoop loop;
+    loop.add(sock_user, EPOLLIN);
+    loop.remove(sock_user);
+
+    const char msg = 'A';
+    ASSERT_EQ(::send(sock_peer, &msg, 1, 0), 1);
+
+    EXPECT_TRUE(loop.wait(50).empty());
+}
+
+// ============= Тесты колеса таймеров =============
+
+class TimerWheelTest : public ::testing::Test {
+protected:
+    using Clock = net::TimerWheel::Clock;
+
+    Clock::time_point start = Clock::now();
+    net::TimerWheel wheel{std::chrono::milliseconds(10), start};
+
+    auto at(std::chrono::milliseconds offset) const -> Clock::time_point {
+        return start + offset;
+    }
+};
+
+// Таймер срабатывает не раньше дедлайна и не позже следующего тика
+TEST_F(TimerWheelTest, FiresAtDeadlineNotEarlier) {
+    static_cast<void>(wheel.schedule(at(std::chrono::milliseconds(25)), 7));
+
+    EXPECT_TRUE(wheel.expire(at(std::chrono::milliseconds(20))).empty());
+    EXPECT_EQ(wheel.next_deadline(), at(std::chrono::milliseconds(30)));
+
+    const auto& expired = wheel.expire(at(std::chrono::milliseconds(30)));
+    EXPECT_EQ(expired, std::vector<std::uint64_t>{7});
+    EXPECT_EQ(wheel.size(), 0U);
+    EXPECT_FALSE(wheel.next_deadline().has_value());
+}
+
+// Отменённый таймер не срабатывает, повторная отмена безопасна
+TEST_F(TimerWheelTest, CancelledTimerDoesNotFire) {
+    const auto first = wheel.schedule(at(std::chrono::milliseconds(50)), 1);
+    static_cast<void>(wheel.schedule(at(std::chrono::milliseconds(50)), 2));
+
+    EXPECT_TRUE(wheel.cancel(first));
+    EXPECT_FALSE(wheel.cancel(first));
+    EXPECT_FALSE(wheel.cancel(net::TimerWheel::NO_TIMER));
+
+    EXPECT_EQ(wheel.expire(at(std::chrono::milliseconds(60))),
+              std::vector<std::uint64_t>{2});
+}
+
+// Узел сработавшего таймера переиспользуется, старый id недействителен
+TEST_F(TimerWheelTest, StaleIdDoesNotCancelReusedNode) {
+    const auto old_id = wheel.schedule(at(std::chrono::milliseconds(10)), 1);
+    static_cast<void>(wheel.expire(at(std::chrono::milliseconds(10))));
+
+    static_cast<void>(wheel.schedule(at(std::chrono::milliseconds(40)), 2));
+    EXPECT_FALSE(wheel.cancel(old_id));
+    EXPECT_EQ(wheel.expire(at(std::chrono::milliseconds(40))),
+              std::vector<std::uint64_t>{2});
+}
+
+// Дальние дедлайны (все уровни и список переполнения) осыпаются вниз и
+// срабатывают по порядку
+TEST_F(TimerWheelTest, CascadesFarDeadlinesInOrder) {
+    const std::vector<std::chrono::milliseconds> offsets{
+        std::chrono::milliseconds(5'000),          // уровень 1
+        std::chrono::milliseconds(600'000),        // уровень 2
+        std::chrono::milliseconds(3'600'000),      // уровень 3
+        std::chrono::milliseconds(200'000'000)};   // переполнение
+    for (std::size_t index = 0; index < offsets.size(); ++index) {
+        static_cast<void>(wheel.schedule(at(offsets[index]), index));
+    }
+
+    for (std::size_t index = 0; index < offsets.size(); ++index) {
+        EXPECT_TRUE(wheel.expire(at(offsets[index]) -
+                                 std::chrono::milliseconds(10))
+                        .empty());
+        EXPECT_EQ(wheel.expire(at(offsets[index])),
+                  std::vector<std::uint64_t>{index});
+    }
+    EXPECT_EQ(wheel.size(), 0U);
+}
+
+// Дедлайн в прошлом срабатывает при ближайшем expire()
+TEST_F(TimerWheelTest, PastDeadlineFiresOnNextExpire) {
+    static_cast<void>(wheel.expire(at(std::chrono::milliseconds(1000))));
+    static_cast<void>(wheel.schedule(at(std::chrono::milliseconds(0)), 9));
+
+    EXPECT_LE(wheel.next_deadline(), at(std::chrono::milliseconds(1010)));
+    EXPECT_EQ(wheel.expire(at(std::chrono::milliseconds(1010))),
+              std::vector<std::uint64_t>{9});
+}
+
+// Сверка со списком дедлайнов: каждый таймер срабатывает ровно на тике,
+// следующем за дедлайном, вне зависимости от шага expire()
+TEST_F(TimerWheelTest, MatchesReferenceModel) {
+    std::uint64_t seed = 12345;
+    auto next_random = [&seed](std::uint64_t bound) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (seed >> 33U) % bound;
+    };
+
+    struct Expected {
+        std::int64_t fire_ms{};
+        net::TimerWheel::TimerId timer_id{};
+        bool cancelled{false};
+    };
+    std::vector<Expected> model;
+
+    std::int64_t now_ms = 0;
+    while (now_ms < 20'000'000) {
+        for (int step = 0; step < 8; ++step) {
+            const auto delay = static_cast<std::int64_t>(
+                next_random(4) == 0 ? next_random(20'000'000)
+                                    : next_random(10'000));
+            const std::int64_t deadline_ms = now_ms + delay;
+            const auto timer_id = wheel.schedule(
+                at(std::chrono::milliseconds(deadline_ms)), model.size());
+            // Срабатывание — на границе тика, не раньше дедлайна
+            model.push_back({(deadline_ms + 9) / 10 * 10, timer_id, false});
+        }
+        if (!model.empty()) {
+            Expected& victim = model[next_random(model.size())];
+            victim.cancelled = victim.cancelled ||
+                               wheel.cancel(victim.timer_id);
+        }
+
+        now_ms += static_cast<std::int64_t>(next_random(100'000) + 1);
+        for (const std::uint64_t key :
+             wheel.expire(at(std::chrono::milliseconds(now_ms)))) {
+            Expected& fired = model[key];
+            ASSERT_FALSE(fired.cancelled);
+            ASSERT_LE(fired.fire_ms, now_ms);
+            fired.cancelled = true;  // больше срабатывать не должен
+        }
+        // Ни один наступивший таймер не остался в колесе
+        for (const Expected& entry : model) {
+            ASSERT_TRUE(entry.cancelled || entry.fire_ms > now_ms);
+        }
+    }
+}
+
+// ============= Тесты класса FrameReader =============
+
+// Та же пара соединённых сокетов
+class FrameReaderTest : public EventLoopTest {};
+
+// Пачка мелких кадров разбирается за один recv()
+TEST_F(FrameReaderTest, ParsesBurstWithSingleRecv) {
+    std::vector<std::uint8_t> burst;
+    for (std::uint32_t msg_id = 1; msg_id <= 50; ++msg_id) {
+        const auto bytes =
+            proto::serialize(proto::Message{proto::MsgType::Ack, msg_id, {}});
+        burst.insert(burst.end(), bytes.begin(), bytes.end());
+    }
+    ASSERT_EQ(::send(sock_peer, burst.data(), burst.size(), 0),
+              static_cast<ssize_t>(burst.size()));
+
+    FrameReader reader;
+    ASSERT_EQ(reader.fill(sock_user), FrameReader::ReadStatus::Ok);
+
+    std::span<const std::uint8_t> frame;
+    for (std::uint32_t msg_id = 1; msg_id <= 50; ++msg_id) {
+        ASSERT_EQ(reader.next_frame(frame), FrameReader::FrameStatus::Ready);
+        proto::Message msg{};
+        ASSERT_TRUE(proto::deserialize(frame, msg));
+        EXPECT_EQ(msg.type, proto::MsgType::Ack);
+        EXPECT_EQ(msg.id, msg_id);
+    }
+    EXPECT_EQ(reader.next_frame(frame), FrameReader::FrameStatus::Incomplete);
+    EXPECT_EQ(reader.recv_calls(), 1U);
+}
+
+// Кадр, разрезанный между чтениями, собирается целиком
+TEST_F(FrameReaderTest, ReassemblesSplitFrame) {
+    const auto bytes = proto::serialize(
+        proto::Message{proto::MsgType::Text, 3, std::string(1000, 'x')});
+
+    FrameReader reader(64);
+    ASSERT_EQ(::send(sock_peer, bytes.data(), 5, 0), 5);
+    ASSERT_EQ(reader.fill(sock_user), FrameReader::ReadStatus::Ok);
+
+    std::span<const std::uint8_t> frame;
+    EXPECT_EQ(reader.next_frame(frame), FrameReader::FrameStatus::Incomplete);
+
+    ASSERT_EQ(::send(sock_peer, bytes.data() + 5, bytes.size() - 5, 0),
+              static_cast<ssize_t>(bytes.size() - 5));
+    while (reader.buffered() < bytes.size()) {
+        ASSERT_EQ(reader.fill(sock_user), FrameReader::ReadStatus::Ok);
+    }
+
+    ASSERT_EQ(reader.next_frame(frame), FrameReader::FrameStatus::Ready);
+    proto::Message msg{};
+    ASSERT_TRUE(proto::deserialize(frame, msg));
+    EXPECT_EQ(msg.payload, std::string(1000, 'x'));
+}
+
+// Слишком большая длина — ошибка протокола
+TEST_F(FrameReaderTest, RejectsOversizedLength) {
+    const std::array<std::uint8_t, 9> header{0x01, 0, 0, 0, 1,
+                                             0xFF, 0xFF, 0xFF, 0xFF};
+    ASSERT_EQ(::send(sock_peer, header.data(), header.size(), 0), 9);
+
+    FrameReader reader;
+    ASSERT_EQ(reader.fill(sock_user), FrameReader::ReadStatus::Ok);
+    std::span<const std::uint8_t> frame;
+    EXPECT_EQ(reader.next_frame(frame), FrameReader::FrameStatus::Invalid);
+}
+
+// Закрытие соединения и освобождение буфера простаивающего соединения
+TEST_F(FrameReaderTest, DetectsCloseAndReleasesBuffer) {
+    FrameReader reader;
+    ::shutdown(sock_peer, SHUT_WR);
+    EXPECT_EQ(reader.fill(sock_user), FrameReader::ReadStatus::Closed);
+    reader.release_if_idle();
+    EXPECT_EQ(reader.buffered(), 0U);
+}
+
+// Сброс TCP-соединения (RST) — отключение, а не исключение
+TEST_F(FrameReaderTest, TreatsConnectionResetAsClose) {
+    const Socket listener(::socket(AF_INET, SOCK_STREAM, 0));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    // NOLINTBEGIN(cppcoreguidelines-pro-type-cstyle-cast)
+    ASSERT_EQ(::bind(listener.fd_return(), (sockaddr*)&addr, addr_len), 0);
+    ASSERT_EQ(::listen(listener.fd_return(), 1), 0);
+    ASSERT_EQ(
+        ::getsockname(listener.fd_return(), (sockaddr*)&addr, &addr_len), 0);
+
+    const int client_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(client_fd, 0);
+    ASSERT_EQ(::connect(client_fd, (sockaddr*)&addr, addr_len), 0);
+    // NOLINTEND(cppcoreguidelines-pro-type-cstyle-cast)
+    const Socket server(::accept(listener.fd_return(), nullptr, nullptr));
+    ASSERT_GE(server.fd_return(), 0);
+
+    // Закрытие с нулевым linger отправляет RST вместо FIN
+    const linger reset{1, 0};
+    ASSERT_EQ(
+        ::setsockopt(client_fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset)),
+        0);
+    ::close(client_fd);
+
+    FrameReader reader;
+    EXPECT_EQ(reader.fill(server.fd_return()), FrameReader::ReadStatus::Closed);
+}
+
+// ============= Тесты заголовка кадра v2 =============
+
+// Границы varint: id и длина любого размера проходят туда и обратно,
+// кадр без payload — без поля длины
+TEST(FrameHeaderTest, RoundTripsVarintBoundaries) {
+    const std::vector<std::uint32_t> ids{
+        0,     1,     127, 128,
+        16383, 16384, std::numeric_limits<std::uint32_t>::max()};
+    const std::vector<std::uint32_t> sizes{
+        0, 1, 127, 128,
+        static_cast<std::uint32_t>(net::MaxPayloadSize::value)};
+    for (const std::uint32_t msg_id : ids) {
+        for (const std::uint32_t size : sizes) {
+            const auto header = net::encode_frame_header(
+                net::HeaderFormat::V2, 0x81, msg_id, size);
+            net::FrameHeader parsed{};
+            ASSERT_EQ(net::parse_frame_header(header.view(), parsed),
+                      net::HeaderStatus::Ok);
+            EXPECT_EQ(parsed.type, 0x81);
+            EXPECT_EQ(parsed.id, msg_id);
+            EXPECT_EQ(parsed.payload_size, size);
+            EXPECT_EQ(parsed.size, header.size);
+
+            // Заголовок, оборванный на любом байте, ещё не пришёл
+            for (std::size_t cut = 0; cut < header.size; ++cut) {
+                EXPECT_EQ(net::parse_frame_header(
+                              header.view().first(cut), parsed),
+                          net::HeaderStatus::Incomplete);
+            }
+        }
+    }
+
+    EXPECT_EQ(net::encode_frame_header(net::HeaderFormat::V2, 0x03, 100, 0)
+                  .size,
+              2U);
+    EXPECT_EQ(net::encode_frame_header(net::HeaderFormat::V2, 0x01, 1000, 120)
+                  .size,
+              4U);
+    EXPECT_EQ(net::encode_frame_header(net::HeaderFormat::V1, 0x03, 100, 0)
+                  .size,
+              proto::HEADER_SIZE);
+}
+
+// Зарезервированный бит, varint длиннее u32 и len сверх предела —
+// ошибка протокола
+TEST(FrameHeaderTest, RejectsMalformedCompactHeader) {
+    net::FrameHeader parsed{};
+    const std::array<std::uint8_t, 2> reserved{0x53, 0x01};
+    EXPECT_EQ(net::parse_frame_header(reserved, parsed),
+              net::HeaderStatus::Invalid);
+
+    const std::array<std::uint8_t, 6> overlong{0x43, 0x80, 0x80,
+                                               0x80, 0x80, 0x10};
+    EXPECT_EQ(net::parse_frame_header(overlong, parsed),
+              net::HeaderStatus::Invalid);
+
+    const auto oversized = net::encode_frame_header(
+        net::HeaderFormat::V2, 0x01, 1,
+        static_cast<std::uint32_t>(net::MaxPayloadSize::value + 1));
+    EXPECT_EQ(net::parse_frame_header(oversized.view(), parsed),
+              net::HeaderStatus::Invalid);
+
+    // Флаг сжатия на не-Text отвергается и в v2
+    const auto header = proto::encode_header(net::HeaderFormat::V2,
+                                             proto::MsgType::Ack, 1, 0, true);
+    proto::Message msg{};
+    EXPECT_FALSE(proto::deserialize(header.view(), msg));
+}
+
+// Оба формата разбираются из одного потока вперемешку: формат кадра
+// виден по первому байту
+TEST_F(FrameReaderTest, ReadsMixedHeaderFormats) {
+    const std::vector<proto::Message> messages{
+        {proto::MsgType::Ping, 7, "приветствие"},
+        {proto::MsgType::Text, 300, std::string(2000, 't')},
+        {proto::MsgType::Ack, 300, {}},
+        {proto::MsgType::Typing, 0, {}}};
+    std::vector<std::uint8_t> stream;
+    std::size_t v1_bytes = 0;
+    for (std::size_t index = 0; index < messages.size(); ++index) {
+        const auto bytes = proto::serialize(
+            messages[index], index % 2 == 0 ? net::HeaderFormat::V1
+                                            : net::HeaderFormat::V2);
+        stream.insert(stream.end(), bytes.begin(), bytes.end());
+        v1_bytes += proto::serialize(messages[index]).size();
+    }
+    EXPECT_EQ(v1_bytes - stream.size(), (9U - 5U) + (9U - 2U));
+
+    // Поток приходит по 3 байта: заголовки v2 режутся посередине varint
+    FrameReader reader(64);
+    std::span<const std::uint8_t> frame;
+    std::size_t received = 0;
+    for (std::size_t offset = 0; offset < stream.size(); offset += 3) {
+        const std::size_t length = std::min<std::size_t>(3, stream.size() -
+                                                                offset);
+        ASSERT_EQ(::send(sock_peer, stream.data() + offset, length, 0),
+                  static_cast<ssize_t>(length));
+        ASSERT_EQ(reader.fill(sock_user), FrameReader::ReadStatus::Ok);
+        while (reader.next_frame(frame) == FrameReader::FrameStatus::Ready) {
+            proto::Message msg{};
+            ASSERT_TRUE(proto::deserialize(frame, msg));
+            ASSERT_LT(received, messages.size());
+            EXPECT_EQ(msg.type, messages[received].type);
+            EXPECT_EQ(msg.id, messages[received].id);
+            EXPECT_EQ(msg.payload, messages[received].payload);
+            ++received;
+        }
+    }
+    EXPECT_EQ(received, messages.size());
+}
+
+// Соединение отправляет v2 после согласования, в том числе сжатый Text
+// и куски файлов; приветствие объявляет поддержку v2
+TEST_F(FrameReaderTest, ConnectionSendsNegotiatedFormat) {
+    net::Connection conn{net::Socket(sock_user)};
+    sock_user = -1;  // дескриптором теперь владеет Connection
+    EXPECT_EQ(conn.header_format(), net::HeaderFormat::V1);
+    conn.set_header_format(net::HeaderFormat::V2);
+
+    std::string buffer;
+    const std::string text = std::string(1000, 'a') + std::string(1000, 'b');
+    ASSERT_TRUE(proto::send_ack(conn, 5));
+    ASSERT_TRUE(proto::send_text_compressed(conn, text, 6, buffer));
+
+    std::vector<std::uint8_t> bytes(64);
+    ASSERT_EQ(::recv(sock_peer, bytes.data(), 2, MSG_WAITALL), 2);
+    bytes.resize(2);
+    proto::Message msg{};
+    ASSERT_TRUE(proto::deserialize(bytes, msg));
+    EXPECT_EQ(msg.type, proto::MsgType::Ack);
+    EXPECT_EQ(msg.id, 5U);
+
+    FrameReader reader;
+    std::span<const std::uint8_t> frame;
+    ASSERT_EQ(reader.fill(sock_peer), FrameReader::ReadStatus::Ok);
+    ASSERT_EQ(reader.next_frame(frame), FrameReader::FrameStatus::Ready);
+    EXPECT_EQ(frame.front(), proto::COMPRESSED_FLAG |
+                                 net::COMPACT_HEADER_FLAG |
+                                 net::PAYLOAD_LENGTH_FLAG |
+                                 static_cast<std::uint8_t>(
+                                     proto::MsgType::Text));
+    ASSERT_TRUE(proto::deserialize(frame, msg));
+    EXPECT_EQ(msg.payload, text);
+
+    app::SessionState state(1);
+    EXPECT_NE(state.hello().features &
+                  proto::Hello::FEATURE_COMPACT_HEADER,
+              0);
+}
+
+// ============= Тесты пути отправки без копирования =============
+
+// Та же пара соединённых сокетов
+class SendPathTest : public EventLoopTest {};
+
+// Text до MaxPayloadSize уходит без единой аллокации
+TEST_F(SendPathTest, SendTextDoesNotAllocate) {
+    const std::string text(16U * 1024U, 'x');
+
+    const std::size_t before = allocation_count.load();
+    const bool sent = proto::send_text(sock_user, text, 1);
+    const std::size_t allocations = allocation_count.load() - before;
+
+    ASSERT_TRUE(sent);
+    EXPECT_EQ(allocations, 0U);
+
+    std::vector<std::uint8_t> frame;
+    ASSERT_TRUE(net::recv_bytes(sock_peer, frame));
+    proto::Message msg{};
+    ASSERT_TRUE(proto::deserialize(frame, msg));
+    EXPECT_EQ(msg.type, proto::MsgType::Text);
+    EXPECT_EQ(msg.payload, text);
+}
+
+// Управляющие кадры тоже отправляются без аллокаций
+TEST_F(SendPathTest, ControlFramesDoNotAllocate) {
+    const std::size_t before = allocation_count.load();
+    ASSERT_TRUE(proto::send_ack(sock_user, 7));
+    ASSERT_TRUE(proto::send_ping(sock_user, 0));
+    ASSERT_TRUE(proto::send_typing(sock_user, 0));
+    EXPECT_EQ(allocation_count.load() - before, 0U);
+}
+
+// Для сравнения: прежний путь serialize + send_bytes аллоцирует на кадр
+TEST_F(SendPathTest, SerializePathAllocatesPerFrame) {
+    const proto::Message msg{proto::MsgType::Text, 1, std::string(256, 'x')};
+
+    const std::size_t before = allocation_count.load();
+    const auto bytes = proto::serialize(msg);
+    ASSERT_TRUE(net::send_bytes(sock_user, bytes));
+    EXPECT_GE(allocation_count.load() - before, 1U);
+}
+
+// Заголовок на стеке совпадает с заголовком serialize()
+TEST(EncodeHeaderTest, MatchesSerializedHeader) {
+    const proto::Message msg{proto::MsgType::Ack, 0x01020304U, "abc"};
+    const auto bytes = proto::serialize(msg);
+    const auto header =
+        proto::encode_header(net::HeaderFormat::V1, msg.type, msg.id, 3);
+
+    ASSERT_GE(bytes.size(), header.size);
+    const auto header_bytes = header.view();
+    EXPECT_TRUE(
+        std::equal(header_bytes.begin(), header_bytes.end(), bytes.begin()));
+}
+
+// Text длиннее MaxPayloadSize не отправляется
+TEST_F(SendPathTest, RejectsOversizedText) {
+    const std::string text(net::MaxPayloadSize::value + 1, 'x');
+    EXPECT_FALSE(proto::send_text(sock_user, text, 1));
+}
+
+// ============= Тесты сжатия полезной нагрузки =============
+
+namespace {
+// Вставленный лог: строки с повторяющейся структурой
+auto logLikeText(std::size_t lines) -> std::string {
+    std::string text;
+    for (std::size_t line = 0; line < lines; ++line) {
+        text += "2024-05-01 12:00:" + std::to_string(line % 60) +
+                " [INFO] worker-" + std::to_string(line % 4) +
+                " handled request id=" + std::to_string(line * 7919) +
+                " status=200\n";
+    }
+    return text;
+}
+}  // namespace
+
+// Лог сжимается в разы и распаковывается побайтно точно, включая длинные
+// серии (длины сверх 4 бит токена) и перекрывающиеся совпадения
+TEST(CompressionTest, RoundTripsCompressibleText) {
+    const std::vector<std::string> inputs{
+        logLikeText(200), std::string(5000, 'a'),
+        "prefix " + std::string(300, 'x') + logLikeText(20) + "abcabcabc"};
+
+    for (const auto& input : inputs) {
+        std::string packed;
+        ASSERT_TRUE(proto::compress_payload(input, packed));
+        EXPECT_LT(packed.size() * 3, input.size());
+
+        std::string unpacked;
+        ASSERT_TRUE(proto::decompress_payload(
+            packed, net::MaxPayloadSize::value, unpacked));
+        EXPECT_EQ(unpacked, input);
+    }
+}
+
+// Короткий и несжимаемый текст не сжимается: выгоднее отправить как есть
+TEST(CompressionTest, SkipsSmallAndIncompressiblePayloads) {
+    std::string packed;
+    EXPECT_FALSE(proto::compress_payload(
+        std::string(proto::COMPRESSION_THRESHOLD - 1, 'a'), packed));
+
+    std::string noise(4096, '\0');
+    std::uint32_t seed = 12345;
+    for (char& byte : noise) {
+        seed = seed * 1103515245U + 12345U;
+        byte = static_cast<char>(seed >> 24U);
+    }
+    EXPECT_FALSE(proto::compress_payload(noise, packed));
+}
+
+// Повреждённый блок и "бомба" с огромным исходным размером отвергаются
+TEST(CompressionTest, RejectsCorruptBlocks) {
+    const std::string input = logLikeText(100);
+    std::string packed;
+    ASSERT_TRUE(proto::compress_payload(input, packed));
+    std::string unpacked;
+
+    EXPECT_FALSE(proto::decompress_payload(
+        std::string_view(packed).substr(0, packed.size() / 2),
+        net::MaxPayloadSize::value, unpacked));
+    EXPECT_FALSE(proto::decompress_payload(packed, input.size() - 1,
+                                           unpacked));
+
+    // Исходный размер не совпадает с распакованным
+    std::string wrong_size = packed;
+    wrong_size[3] = static_cast<char>(wrong_size[3] + 1);
+    EXPECT_FALSE(proto::decompress_payload(
+        wrong_size, net::MaxPayloadSize::value, unpacked));
+
+    // Ссылка назад за начало вывода
+    const std::string bad_offset("\0\0\0\x08\x00\x01\x00", 7);
+    EXPECT_FALSE(proto::decompress_payload(
+        bad_offset, net::MaxPayloadSize::value, unpacked));
+}
+
+// Сжатый Text помечен флагом в байте типа и распаковывается при разборе
+// кадра; короткий Text уходит без флага; флаг на других типах — ошибка
+TEST(CompressionTest, CompressedTextFrameRoundTrips) {
+    std::array<int, 2> fds{};
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()), 0);
+    net::Connection conn{net::Socket(fds[0])};
+    const net::Socket peer(fds[1]);
+    std::string buffer;
+
+    const std::string text = logLikeText(300);
+    ASSERT_TRUE(proto::send_text_compressed(conn, text, 7, buffer));
+    ASSERT_TRUE(proto::send_text_compressed(conn, "привет", 8, buffer));
+
+    std::vector<std::uint8_t> raw;
+    ASSERT_TRUE(net::recv_bytes(peer.fd_return(), raw));
+    EXPECT_EQ(raw.front(), static_cast<std::uint8_t>(proto::MsgType::Text) |
+                               proto::COMPRESSED_FLAG);
+    EXPECT_LT(raw.size(), text.size() / 3);
+    proto::Message msg{};
+    ASSERT_TRUE(proto::deserialize(raw, msg));
+    EXPECT_EQ(msg.type, proto::MsgType::Text);
+    EXPECT_EQ(msg.id, 7U);
+    EXPECT_EQ(msg.payload, text);
+
+    ASSERT_TRUE(net::recv_bytes(peer.fd_return(), raw));
+    EXPECT_EQ(raw.front(), static_cast<std::uint8_t>(proto::MsgType::Text));
+    ASSERT_TRUE(proto::deserialize(raw, msg));
+    EXPECT_EQ(msg.payload, "привет");
+
+    const auto header = proto::encode_header(
+        net::HeaderFormat::V1, proto::MsgType::Ack, 1, 0, true);
+    EXPECT_FALSE(proto::deserialize(header.view(), msg));
+
+    app::SessionState state(1);
+    EXPECT_NE(state.hello().features & proto::Hello::FEATURE_COMPRESSION, 0);
+}
+
+// ============= Тесты приёма без копирования =============
+
+// Та же пара соединённых сокетов
+class ReceivePathTest : public EventLoopTest {
+protected:
+    // Пачка управляющих кадров; Ping — с полезной нагрузкой длиннее
+    // SSO-буфера std::string, как приветствие сеанса
+    [[nodiscard]]
+    static auto controlBurst() -> std::vector<std::uint8_t> {
+        const std::array<proto::Message, 5> messages{
+            proto::Message{proto::MsgType::Ack, 1, {}},
+            proto::Message{proto::MsgType::Ping, 2, std::string(40, 'h')},
+            proto::Message{proto::MsgType::Pong, 2, {}},
+            proto::Message{proto::MsgType::Typing, 0, {}},
+            proto::Message{proto::MsgType::Ack, 3, {}}};
+        std::vector<std::uint8_t> burst;
+        for (const auto& msg : messages) {
+            const auto bytes = proto::serialize(msg);
+            burst.insert(burst.end(), bytes.begin(), bytes.end());
+        }
+        return burst;
+    }
+};
+
+// Ack/Ping/Pong/Typing разбираются из буфера FrameReader без аллокаций
+TEST_F(ReceivePathTest, ControlFramesDoNotAllocate) {
+    const std::vector<std::uint8_t> burst = controlBurst();
+    FrameReader reader;
+    proto::ReceiveArena arena;
+    std::span<const std::uint8_t> frame;
+    proto::MessageView msg{};
+
+    // Первая пачка — прогрев: буфер приёма выделяется один раз
+    for (int round = 0; round < 2; ++round) {
+        ASSERT_EQ(::send(sock_peer, burst.data(), burst.size(), 0),
+                  static_cast<ssize_t>(burst.size()));
+
+        const std::size_t before = allocation_count.load();
+        ASSERT_EQ(reader.fill(sock_user), FrameReader::ReadStatus::Ok);
+        std::size_t frames = 0;
+        while (reader.next_frame(frame) == FrameReader::FrameStatus::Ready) {
+            ASSERT_TRUE(proto::deserialize(frame, msg, arena));
+            ++frames;
+        }
+        const std::size_t allocations = allocation_count.load() - before;
+
+        EXPECT_EQ(frames, 5U);
+        if (round == 1) {
+            EXPECT_EQ(allocations, 0U);
+        }
+    }
+    EXPECT_EQ(msg.type, proto::MsgType::Ack);
+    EXPECT_EQ(msg.id, 3U);
+}
+
+// payload указывает в кадр, распакованный Text — в арену
+TEST_F(ReceivePathTest, ViewPointsIntoFrameOrArena) {
+    const auto plain = proto::serialize(
+        proto::Message{proto::MsgType::Ping, 9, std::string(40, 'p')});
+    proto::ReceiveArena arena;
+    proto::MessageView msg{};
+    ASSERT_TRUE(proto::deserialize(plain, msg, arena));
+    EXPECT_EQ(msg.payload, std::string(40, 'p'));
+    EXPECT_EQ(static_cast<const void*>(msg.payload.data()),
+              static_cast<const void*>(plain.data() + proto::HEADER_SIZE));
+
+    net::Connection conn{net::Socket(::dup(sock_user))};
+    std::string buffer;
+    const std::string text = logLikeText(300);
+    ASSERT_TRUE(proto::send_text_compressed(conn, text, 7, buffer));
+    ASSERT_TRUE(proto::send_text_compressed(conn, text, 8, buffer));
+
+    bool disconnected = true;
+    ASSERT_TRUE(proto::receive_msg(sock_peer, arena, msg, disconnected));
+    EXPECT_FALSE(disconnected);
+    EXPECT_EQ(msg.id, 7U);
+    EXPECT_EQ(msg.payload, text);
+    EXPECT_EQ(msg.payload.data(), arena.inflated.data());
+
+    // Второй кадр — в уже выделенную память арены
+    const std::size_t before = allocation_count.load();
+    ASSERT_TRUE(proto::receive_msg(sock_peer, arena, msg, disconnected));
+    EXPECT_EQ(allocation_count.load() - before, 0U);
+    EXPECT_EQ(msg.id, 8U);
+    EXPECT_EQ(msg.payload, text);
+
+    ::shutdown(sock_user, SHUT_WR);
+    ASSERT_TRUE(proto::receive_msg(sock_peer, arena, msg, disconnected));
+    EXPECT_TRUE(disconnected);
+}
+
+// ============= Тесты очереди отправки и противодавления =============
+
+// Та же пара сокетов; пишущая сторона неблокирующая
+class OutboundQueueTest : public EventLoopTest {
+protected:
+    // Малые отметки, чтобы быстро заполнить буфер сокета
+    static constexpr net::OutboundQueue::Limits SMALL_LIMITS{
+        512U * 1024U, 64U * 1024U, 16U * 1024U};
+    static constexpr std::size_t CHUNK = 16U * 1024U;
+
+    std::vector<std::uint8_t> payload = std::vector<std::uint8_t>(CHUNK, 'x');
+    std::vector<bool> transitions;
+
+    void SetUp() override {
+        EventLoopTest::SetUp();
+        net::set_nonblocking(sock_user);
+    }
+
+    // Отправлять кадры, пока очередь не перейдёт верхнюю отметку
+    auto fillAboveHigh(net::OutboundQueue& queue) -> std::size_t {
+        std::size_t frames = 0;
+        while (!queue.above_high_watermark() && frames < 10000U) {
+            const auto header = proto::encode_header(
+                net::HeaderFormat::V1, proto::MsgType::Text,
+                static_cast<std::uint32_t>(frames + 1),
+                static_cast<std::uint32_t>(payload.size()));
+            EXPECT_EQ(queue.send(sock_user, header.view(), payload),
+                      net::OutboundQueue::Status::Ok);
+            ++frames;
+        }
+        return frames;
+    }
+};
+
+// Когда сокет перестаёт принимать данные, кадры копятся в очереди и
+// срабатывает верхняя отметка
+TEST_F(OutboundQueueTest, QueuesWhenSocketIsFull) {
+    net::OutboundQueue queue(SMALL_LIMITS);
+    queue.set_watermark_handler(
+        [this](bool above_high) { transitions.push_back(above_high); });
+
+    fillAboveHigh(queue);
+
+    EXPECT_TRUE(queue.above_high_watermark());
+    EXPECT_GE(queue.queued_bytes(), SMALL_LIMITS.high_watermark);
+    EXPECT_EQ(queue.peak_bytes(), queue.queued_bytes());
+    EXPECT_EQ(transitions, std::vector<bool>{true});
+}
+
+// Кадр сверх capacity не принимается и не портит поток
+TEST_F(OutboundQueueTest, RejectsFrameBeyondCapacity) {
+    net::OutboundQueue queue(SMALL_LIMITS);
+    fillAboveHigh(queue);
+
+    const std::vector<std::uint8_t> big(SMALL_LIMITS.capacity, 'y');
+    const auto header =
+        proto::encode_header(net::HeaderFormat::V1, proto::MsgType::Text, 1,
+                             static_cast<std::uint32_t>(big.size()));
+    const std::size_t before = queue.queued_bytes();
+
+    EXPECT_EQ(queue.send(sock_user, header.view(), big),
+              net::OutboundQueue::Status::Full);
+    EXPECT_EQ(queue.queued_bytes(), before);
+    // Переполнение — противодавление, а не потеря связи
+    EXPECT_FALSE(queue.closed());
+}
+
+// flush() по мере чтения собеседником опустошает очередь, поток кадров
+// приходит целым, нижняя отметка снимает перегрузку
+TEST_F(OutboundQueueTest, FlushDrainsQueueInOrder) {
+    net::OutboundQueue queue(SMALL_LIMITS);
+    queue.set_watermark_handler(
+        [this](bool above_high) { transitions.push_back(above_high); });
+
+    const std::size_t frames_sent = fillAboveHigh(queue);
+
+    net::FrameReader reader;
+    std::span<const std::uint8_t> frame;
+    std::size_t frames_received = 0;
+    while (frames_received < frames_sent) {
+        ASSERT_EQ(queue.flush(sock_user), net::OutboundQueue::Status::Ok);
+        ASSERT_EQ(reader.fill(sock_peer), net::FrameReader::ReadStatus::Ok);
+        while (reader.next_frame(frame) ==
+               net::FrameReader::FrameStatus::Ready) {
+            proto::Message msg{};
+            ASSERT_TRUE(proto::deserialize(frame, msg));
+            EXPECT_EQ(msg.id, frames_received + 1);
+            EXPECT_EQ(msg.payload.size(), CHUNK);
+            ++frames_received;
+        }
+    }
+
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.above_high_watermark());
+    EXPECT_EQ(transitions, (std::vector<bool>{true, false}));
+}
+
+// Закрытый собеседник — Status::Closed, а не исключение или SIGPIPE
+TEST_F(OutboundQueueTest, ReportsClosedPeer) {
+    net::OutboundQueue queue;
+    ::close(sock_peer);
+    sock_peer = -1;
+
+    const auto header =
+        proto::encode_header(net::HeaderFormat::V1, proto::MsgType::Ping, 0, 0);
+    EXPECT_FALSE(queue.closed());
+    EXPECT_EQ(queue.send(sock_user, header.view(), {}),
+              net::OutboundQueue::Status::Closed);
+    EXPECT_TRUE(queue.closed());
+}
+
+// Connection переводит сокет в O_NONBLOCK и отправляет через очередь
+TEST_F(OutboundQueueTest, ConnectionSendsThroughQueue) {
+    net::Connection conn{net::Socket(sock_user)};
+    const int connection_fd = sock_user;
+    sock_user = -1;  // дескриптором теперь владеет Connection
+
+    EXPECT_NE(::fcntl(connection_fd, F_GETFL) & O_NONBLOCK, 0);
+    ASSERT_TRUE(proto::send_text(conn, "Привет", 5));
+    EXPECT_TRUE(conn.outbound().empty());
+
+    std::vector<std::uint8_t> bytes;
+    ASSERT_TRUE(net::recv_bytes(sock_peer, bytes));
+    proto::Message msg{};
+    ASSERT_TRUE(proto::deserialize(bytes, msg));
+    EXPECT_EQ(msg.id, 5U);
+    EXPECT_EQ(msg.payload, "Привет");
+}
+
+// Кадр, пришедший двумя записями, recv_bytes на неблокирующем сокете
+// дочитывает целиком, а не обрезает нагрузку на EAGAIN
+TEST_F(OutboundQueueTest, RecvBytesWaitsForSplitFrame) {
+    net::set_nonblocking(sock_peer);
+    const std::string text(1000, 'z');
+    const std::vector<std::uint8_t> frame = proto::serialize(
+        proto::Message{proto::MsgType::Text, 9, text});
+    const std::size_t first_part = frame.size() / 2;
+
+    ASSERT_EQ(::send(sock_user, frame.data(), first_part, 0),
+              static_cast<ssize_t>(first_part));
+    std::thread writer([this, &frame, first_part] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        static_cast<void>(::send(sock_user, frame.data() + first_part,
+                                 frame.size() - first_part, 0));
+    });
+
+    std::vector<std::uint8_t> bytes;
+    const bool received = net::recv_bytes(sock_peer, bytes);
+    writer.join();
+    ASSERT_TRUE(received);
+    EXPECT_EQ(bytes, frame);
+}
+
+// ============= Тесты передачи файлов =============
+
+// FileOffer переносит размер, время изменения и имя; имена с каталогами
+// отвергаются
+TEST(FileFramesTest, OfferRoundTripsAndRejectsPaths) {
+    const proto::FileOffer offer{5ULL << 32U, "отчёт.pdf",
+                                 1700000000123456789ULL};
+    const auto decoded =
+        proto::decode_file_offer(proto::encode_file_offer(offer));
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_EQ(decoded->size, offer.size);
+    EXPECT_EQ(decoded->name, offer.name);
+    EXPECT_EQ(decoded->modified_ns, offer.modified_ns);
+
+    const std::vector<std::string> bad_names{
+        "",  ".", "..", "../x", "a/b", "/etc/passwd", std::string("a\0b", 3),
+        std::string(proto::MAX_FILE_NAME_SIZE + 1, 'a')};
+    for (const auto& name : bad_names) {
+        EXPECT_FALSE(
+            proto::decode_file_offer(proto::encode_file_offer({1, name})))
+            << name;
+    }
+    EXPECT_FALSE(proto::decode_file_offer("123456789012345").has_value());
+    EXPECT_FALSE(proto::decode_file_offset("123456789").has_value());
+}
+
+// FileChunk разбирается прямо в кадре: номер, смещение и байты
+TEST(FileFramesTest, ParsesChunkWithoutCopy) {
+    const std::string data = "содержимое";
+    const auto offset = proto::encode_file_offset(70000);
+    const auto header = proto::encode_header(
+        net::HeaderFormat::V1, proto::MsgType::FileChunk, 3,
+        static_cast<std::uint32_t>(offset.size() + data.size()));
+    const auto header_bytes = header.view();
+    std::vector<std::uint8_t> frame(header_bytes.begin(), header_bytes.end());
+    frame.insert(frame.end(), offset.begin(), offset.end());
+    frame.insert(frame.end(), data.begin(), data.end());
+
+    const auto chunk = proto::parse_file_chunk(frame);
+    ASSERT_TRUE(chunk.has_value());
+    EXPECT_EQ(chunk->transfer_id, 3U);
+    EXPECT_EQ(chunk->offset, 70000U);
+    EXPECT_EQ(chunk->data.data(), &frame.at(proto::HEADER_SIZE +
+                                            proto::FILE_OFFSET_SIZE));
+    EXPECT_EQ(std::string(chunk->data.begin(), chunk->data.end()), data);
+
+    EXPECT_FALSE(proto::parse_file_chunk(
+                     std::span(frame).first(proto::HEADER_SIZE + 4))
+                     .has_value());
+    frame.front() = static_cast<std::uint8_t>(proto::MsgType::Text);
+    EXPECT_FALSE(proto::parse_file_chunk(frame).has_value());
+}
+
+// Отправитель держит в полёте не больше окна и продолжает с места,
+// названного получателем в ответе на FileOffer
+TEST(OutgoingFileTest, HonoursWindowAndResumePoint) {
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() /
+        ("messenger_outgoing_" + std::to_string(::getpid()));
+    const std::size_t size = 3U * proto::FILE_CHUNK_SIZE + 100U;
+    std::ofstream(path, std::ios::binary) << std::string(size, 'f');
+
+    {
+        app::OutgoingFile file(1, path.string());
+        EXPECT_EQ(file.offer().size, size);
+        EXPECT_EQ(file.offer().name, path.filename().string());
+        EXPECT_EQ(file.next_chunk(size), 0U);  // ответа ещё нет
+
+        const std::uint64_t window = 2U * proto::FILE_CHUNK_SIZE;
+        file.on_ack(100);
+        EXPECT_EQ(file.sent(), 100U);
+        EXPECT_EQ(file.next_chunk(window), proto::FILE_CHUNK_SIZE);
+        file.on_chunk_sent(proto::FILE_CHUNK_SIZE);
+        file.on_chunk_sent(file.next_chunk(window));
+        EXPECT_EQ(file.next_chunk(window), 0U);  // окно заполнено
+
+        file.on_ack(100 + proto::FILE_CHUNK_SIZE);
+        EXPECT_EQ(file.next_chunk(window), proto::FILE_CHUNK_SIZE);
+
+        // Обрыв: неподтверждённое пойдёт заново с места из ответа
+        file.suspend();
+        EXPECT_FALSE(file.accepted());
+        EXPECT_EQ(file.sent(), 100 + proto::FILE_CHUNK_SIZE);
+        file.on_ack(size - 10);
+        EXPECT_EQ(file.next_chunk(window), 10U);
+        file.on_ack(size);
+        EXPECT_TRUE(file.complete());
+    }
+
+    // Файл укоротили после предложения
+    {
+        app::OutgoingFile file(3, path.string());
+        EXPECT_FALSE(file.source_changed());
+        std::filesystem::resize_file(path, size / 2);
+        EXPECT_TRUE(file.source_changed());
+    }
+
+    EXPECT_THROW(app::OutgoingFile(2, path.string() + ".нет"),
+                 std::system_error);
+    EXPECT_THROW(app::OutgoingFile(2, path.parent_path().string()),
+                 std::runtime_error);
+    std::filesystem::remove(path);
+}
+
+class FileTransferTest : public EventLoopTest {
+protected:
+    std::filesystem::path dir = std::filesystem::temp_directory_path() /
+                                ("messenger_files_" +
+                                 std::to_string(::getpid()));
+    std::filesystem::path source = dir / "исходный.bin";
+
+    void SetUp() override {
+        EventLoopTest::SetUp();
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+    }
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+        EventLoopTest::TearDown();
+    }
+
+    // Файл с неповторяющимся содержимым
+    [[nodiscard]]
+    auto writeSource(std::size_t size) const -> std::string {
+        std::string content(size, '\0');
+        std::uint32_t seed = 7;
+        for (char& byte : content) {
+            seed = seed * 1103515245U + 12345U;
+            byte = static_cast<char>(seed >> 24U);
+        }
+        std::ofstream(source, std::ios::binary) << content;
+        return content;
+    }
+
+    [[nodiscard]]
+    static auto readFile(const std::filesystem::path& path) -> std::string {
+        std::ifstream file(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(file), {}};
+    }
+
+    [[nodiscard]]
+    static auto asBytes(std::string_view text)
+        -> std::span<const std::uint8_t> {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        return {reinterpret_cast<const std::uint8_t*>(text.data()),
+                text.size()};
+    }
+};
+
+// Кусок файла уходит через sendfile(); Text, отправленный, пока кусок
+// ждёт места в сокете, приходит строго после него
+TEST_F(FileTransferTest, TextAfterPendingChunkKeepsFrameOrder) {
+    const std::string content = writeSource(proto::FILE_CHUNK_SIZE);
+    app::OutgoingFile outgoing(4, source.string());
+
+    net::Connection conn{net::Socket(sock_user)};
+    sock_user = -1;  // дескриптором теперь владеет Connection
+
+    // Заполнить сокет, чтобы кусок файла встал в очередь
+    const std::string filler(4096, 'x');
+    std::size_t frames_sent = 0;
+    while (conn.outbound().empty()) {
+        ASSERT_TRUE(proto::send_text(conn, filler, 1));
+        ++frames_sent;
+    }
+    ASSERT_TRUE(proto::send_file_chunk(conn, 4, outgoing.fd(), 0,
+                                       content.size()));
+    ASSERT_TRUE(conn.outbound().file_pending());
+    ASSERT_TRUE(proto::send_text(conn, "после файла", 9));
+    // Следующий кусок ждёт, пока уйдёт предыдущий
+    EXPECT_FALSE(proto::send_file_chunk(conn, 4, outgoing.fd(), 0, 1));
+    frames_sent += 2;
+
+    net::FrameReader reader;
+    std::span<const std::uint8_t> frame;
+    std::vector<std::uint8_t> types;
+    while (types.size() < frames_sent) {
+        ASSERT_NE(conn.outbound().flush(conn.fd()),
+                  net::OutboundQueue::Status::Closed);
+        ASSERT_EQ(reader.fill(sock_peer), net::FrameReader::ReadStatus::Ok);
+        while (reader.next_frame(frame) ==
+               net::FrameReader::FrameStatus::Ready) {
+            types.push_back(frame.front());
+            if (frame.front() ==
+                static_cast<std::uint8_t>(proto::MsgType::FileChunk)) {
+                const auto chunk = proto::parse_file_chunk(frame);
+                ASSERT_TRUE(chunk.has_value());
+                EXPECT_EQ(chunk->transfer_id, 4U);
+                EXPECT_EQ(chunk->offset, 0U);
+                EXPECT_EQ(std::string(chunk->data.begin(), chunk->data.end()),
+                          content);
+                continue;
+            }
+            proto::Message msg{};
+            ASSERT_TRUE(proto::deserialize(frame, msg));
+            EXPECT_EQ(msg.payload,
+                      types.size() == frames_sent ? "после файла" : filler);
+        }
+    }
+
+    ASSERT_EQ(types.size(), frames_sent);
+    EXPECT_EQ(types[frames_sent - 2],
+              static_cast<std::uint8_t>(proto::MsgType::FileChunk));
+    EXPECT_TRUE(conn.outbound().empty());
+}
+
+// Получатель продолжает с размера .part, повтор уже записанного
+// пропускает, дыру отвергает; готовый файл получает свободное имя
+TEST_F(FileTransferTest, IncomingFileResumesFromPartFile) {
+    const std::string content = writeSource(1000);
+    const proto::FileOffer offer{content.size(), "принятый.bin", 42};
+    const std::string received_dir = (dir / "файлы").string();
+
+    {
+        app::IncomingFile incoming(received_dir, offer);
+        EXPECT_EQ(incoming.received(), 0U);
+        ASSERT_TRUE(incoming.write(0, asBytes(content).first(300)));
+        EXPECT_FALSE(incoming.ack_due(500));
+        EXPECT_TRUE(incoming.ack_due(300));
+    }  // обрыв связи
+
+    app::IncomingFile incoming(received_dir, offer);
+    EXPECT_EQ(incoming.received(), 300U);
+    EXPECT_TRUE(incoming.matches(offer));
+    EXPECT_FALSE(incoming.matches({offer.size + 1, offer.name, 42}));
+    EXPECT_FALSE(incoming.matches({offer.size, offer.name, 43}));
+
+    EXPECT_FALSE(incoming.write(400, asBytes(content).subspan(400)));
+    ASSERT_TRUE(incoming.write(200, asBytes(content).subspan(200, 300)));
+    EXPECT_FALSE(incoming.write(500, asBytes(content)));  // за концом
+    ASSERT_TRUE(incoming.write(500, asBytes(content).subspan(500)));
+    ASSERT_TRUE(incoming.complete());
+    EXPECT_TRUE(incoming.ack_due(proto::FILE_CHUNK_SIZE));
+
+    std::ofstream(dir / "файлы" / offer.name) << "занято";
+    const std::string path = incoming.finish();
+    EXPECT_EQ(path, received_dir + "/" + offer.name + ".1");
+    EXPECT_EQ(readFile(path), content);
+    EXPECT_FALSE(std::filesystem::exists(received_dir + "/" + offer.name +
+                                         ".part"));
+    EXPECT_FALSE(std::filesystem::exists(received_dir + "/" + offer.name +
+                                         ".part.offer"));
+}
+
+// .part другой версии файла (или без сохранённого предложения) не
+// продолжается: приём начинается заново
+TEST_F(FileTransferTest, IncomingFileRestartsForChangedSource) {
+    const std::string content = writeSource(1000);
+    const proto::FileOffer offer{content.size(), "принятый.bin", 42};
+    const std::string received_dir = (dir / "файлы").string();
+
+    {
+        app::IncomingFile incoming(received_dir, offer);
+        ASSERT_TRUE(incoming.write(0, asBytes(content).first(300)));
+    }
+    {
+        // Тот же размер, но файл изменён после прошлого предложения
+        app::IncomingFile incoming(received_dir,
+                                   {offer.size, offer.name, 43});
+        EXPECT_EQ(incoming.received(), 0U);
+        ASSERT_TRUE(incoming.write(0, asBytes(content).first(200)));
+    }
+
+    std::filesystem::remove(received_dir + "/" + offer.name + ".part.offer");
+    app::IncomingFile incoming(received_dir, {offer.size, offer.name, 43});
+    EXPECT_EQ(incoming.received(), 0U);
+}
+
+// Файл укоротили посреди участка: кадр не добивается нулями, соединение
+// считается закрытым
+TEST_F(FileTransferTest, TruncatedSourceClosesQueue) {
+    const std::string content = writeSource(1000);
+    app::OutgoingFile outgoing(5, source.string());
+    net::OutboundQueue queue;
+
+    const std::array<std::uint8_t, 4> header{1, 2, 3, 4};
+    EXPECT_EQ(queue.send_file(sock_user, header, outgoing.fd(), 0,
+                              content.size() + 100),
+              net::OutboundQueue::Status::Closed);
+    EXPECT_TRUE(queue.file_truncated());
+    EXPECT_TRUE(queue.closed());
+}
+
+// ============= Тесты окна дедупликации =============
+
+// Новый id принимается, повтор — нет
+TEST(DedupWindowTest, RejectsRepeatedId) {
+    app::DedupWindow window;
+    EXPECT_TRUE(window.check_and_insert(1));
+    EXPECT_TRUE(window.check_and_insert(2));
+    EXPECT_FALSE(window.check_and_insert(1));
+    EXPECT_FALSE(window.check_and_insert(2));
+    EXPECT_TRUE(window.contains(1));
+    EXPECT_FALSE(window.contains(3));
+}
+
+// Размер окна округляется до степени двойки
+TEST(DedupWindowTest, RoundsWindowSizeToPowerOfTwo) {
+    EXPECT_EQ(app::DedupWindow(1).window_size(), 64U);
+    EXPECT_EQ(app::DedupWindow(1000).window_size(), 1024U);
+}
+
+// id, пришедшие не по порядку в пределах окна, распознаются по отдельности
+TEST(DedupWindowTest, AcceptsReorderedIdsInsideWindow) {
+    app::DedupWindow window(64);
+    EXPECT_TRUE(window.check_and_insert(100));
+    EXPECT_TRUE(window.check_and_insert(90));
+    EXPECT_TRUE(window.check_and_insert(95));
+    EXPECT_FALSE(window.check_and_insert(90));
+    EXPECT_FALSE(window.check_and_insert(100));
+    EXPECT_TRUE(window.check_and_insert(99));
+}
+
+// Дубликаты распознаются и сразу после заполнения окна (прежний
+// unordered_set в этот момент очищался и пропускал повторы)
+TEST(DedupWindowTest, KeepsRecentIdsAfterWindowSlides) {
+    app::DedupWindow window(1024);
+    for (std::uint32_t msg_id = 1; msg_id <= 5000; ++msg_id) {
+        ASSERT_TRUE(window.check_and_insert(msg_id));
+    }
+    for (std::uint32_t msg_id = 5000 - 1023; msg_id <= 5000; ++msg_id) {
+        EXPECT_FALSE(window.check_and_insert(msg_id));
+    }
+}
+
+// Сдвиг окна освобождает биты: id, совпадающий по модулю окна со старым,
+// не считается дубликатом
+TEST(DedupWindowTest, SlidingClearsReusedBits) {
+    app::DedupWindow window(64);
+    EXPECT_TRUE(window.check_and_insert(10));
+    EXPECT_TRUE(window.check_and_insert(60));
+    EXPECT_TRUE(window.check_and_insert(74));   // 74 mod 64 == 10
+    EXPECT_TRUE(window.check_and_insert(300));  // скачок дальше окна
+    EXPECT_FALSE(window.contains(60));
+    EXPECT_TRUE(window.check_and_insert(290));
+}
+
+// Переход счётчика generateMessageId через максимум не ломает окно
+TEST(DedupWindowTest, HandlesCounterWrap) {
+    app::DedupWindow window(64);
+    const std::uint32_t last = std::numeric_limits<std::uint32_t>::max() - 1U;
+
+    EXPECT_TRUE(window.check_and_insert(last - 1U));
+    EXPECT_TRUE(window.check_and_insert(last));
+    EXPECT_TRUE(window.check_and_insert(1));  // после обёртки
+    EXPECT_TRUE(window.check_and_insert(2));
+
+    EXPECT_FALSE(window.check_and_insert(last));
+    EXPECT_FALSE(window.check_and_insert(1));
+    EXPECT_TRUE(window.contains(last - 1U));
+}
+
+// Граница сеанса перешагивает зарезервированные 0 и максимум: после
+// обёртки счётчика она идёт дальше, а Sack не тащит дыру через 2^32
+TEST(SessionStateTest, BoundaryStepsOverReservedIdsOnWrap) {
+    app::SessionState state(1);
+    const std::uint32_t last = std::numeric_limits<std::uint32_t>::max() - 1U;
+
+    ASSERT_TRUE(state.accept(last - 1U));
+    ASSERT_TRUE(state.accept(last));
+    EXPECT_EQ(state.last_received(), last);
+
+    ASSERT_TRUE(state.accept(1));  // после обёртки
+    ASSERT_TRUE(state.accept(2));
+    EXPECT_EQ(state.last_received(), 2U);
+    EXPECT_EQ(state.sack_blocks().count, 0U);
+
+    // Дыра сразу после обёртки: блок начинается с принятого id
+    app::SessionState gapped(2);
+    ASSERT_TRUE(gapped.accept(last));
+    ASSERT_TRUE(gapped.accept(2));
+    ASSERT_TRUE(gapped.accept(3));
+    EXPECT_EQ(gapped.last_received(), last);
+    const proto::SackBlocks blocks = gapped.sack_blocks();
+    ASSERT_EQ(blocks.count, 1U);
+    EXPECT_EQ(blocks.ranges[0].first, 2U);
+    EXPECT_EQ(blocks.ranges[0].last, 3U);
+
+    ASSERT_TRUE(gapped.accept(1));
+    EXPECT_EQ(gapped.last_received(), 3U);
+}
+
+// id далеко позади окна — перезапуск собеседника: окно начинается заново
+TEST(DedupWindowTest, RestartsOnIdFarBehindWindow) {
+    app::DedupWindow window(64);
+    for (std::uint32_t msg_id = 1000; msg_id < 1010; ++msg_id) {
+        ASSERT_TRUE(window.check_and_insert(msg_id));
+    }
+
+    EXPECT_TRUE(window.check_and_insert(1));
+    EXPECT_TRUE(window.check_and_insert(2));
+    EXPECT_FALSE(window.check_and_insert(1));
+}
+
+// Проверка не аллоцирует память
+TEST(DedupWindowTest, CheckDoesNotAllocate) {
+    app::DedupWindow window;
+
+    const std::size_t before = allocation_count.load();
+    for (std::uint32_t msg_id = 1; msg_id <= 100000; ++msg_id) {
+        static_cast<void>(window.check_and_insert(msg_id));
+        static_cast<void>(window.check_and_insert(msg_id));
+    }
+    EXPECT_EQ(allocation_count.load() - before, 0U);
+}
+
+// ============= Тесты outbox неподтверждённых сообщений =============
+
+// Поиск и подтверждение по id, обход в порядке отправки
+TEST(OutboxTest, FindsAndErasesById) {
+    app::Outbox outbox(10);
+    EXPECT_FALSE(outbox.add(1, "раз").has_value());
+    EXPECT_FALSE(outbox.add(2, "два").has_value());
+    EXPECT_FALSE(outbox.add(3, "три").has_value());
+
+    ASSERT_NE(outbox.find(2), nullptr);
+    EXPECT_EQ(*outbox.find(2)->payload, "два");
+    EXPECT_TRUE(outbox.find(2)->awaiting_ack);
+    EXPECT_EQ(outbox.find(4), nullptr);
+
+    EXPECT_TRUE(outbox.erase(2));
+    EXPECT_FALSE(outbox.erase(2));
+
+    std::vector<std::uint32_t> order;
+    for (const auto& entry : outbox) {
+        order.push_back(entry.id);
+    }
+    EXPECT_EQ(order, (std::vector<std::uint32_t>{1, 3}));
+}
+
+// Переполнение вытесняет самую старую запись и возвращает её
+TEST(OutboxTest, EvictsOldestWhenFull) {
+    app::Outbox outbox(2);
+    static_cast<void>(outbox.add(1, "раз"));
+    static_cast<void>(outbox.add(2, "два"));
+
+    const auto evicted = outbox.add(3, "три");
+    ASSERT_TRUE(evicted.has_value());
+    EXPECT_EQ(evicted->id, 1U);
+    EXPECT_EQ(outbox.size(), 2U);
+    EXPECT_EQ(outbox.find(1), nullptr);
+}
+
+// Смена id переносит запись в конец (порядок списка — порядок id) и
+// сохраняет тот же текст без копии
+TEST(OutboxTest, RekeyKeepsSharedPayload) {
+    app::Outbox outbox(10);
+    static_cast<void>(outbox.add(1, "раз"));
+    static_cast<void>(outbox.add(2, "два"));
+    const app::Outbox::Payload payload = outbox.find(1)->payload;
+
+    app::Outbox::Entry* entry = outbox.rekey(1, 7);
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(entry->id, 7U);
+    EXPECT_EQ(entry->payload.get(), payload.get());
+    EXPECT_EQ(outbox.find(1), nullptr);
+    EXPECT_EQ(outbox.find(7), entry);
+    EXPECT_EQ(outbox.begin()->id, 2U);
+    EXPECT_EQ(std::next(outbox.begin())->id, 7U);
+    EXPECT_EQ(outbox.rekey(1, 8), nullptr);
+}
+
+// Счёт ждущих Ack ведётся при добавлении, вытеснении, подтверждении и
+// прекращении ожидания, без обхода outbox
+TEST(OutboxTest, CountsEntriesAwaitingAck) {
+    app::Outbox outbox(3);
+    for (std::uint32_t msg_id = 1; msg_id <= 3; ++msg_id) {
+        static_cast<void>(outbox.add(msg_id, "m"));
+    }
+    EXPECT_EQ(outbox.awaiting_count(), 3U);
+
+    outbox.set_awaiting_ack(*outbox.find(1), false);
+    outbox.set_awaiting_ack(*outbox.find(1), false);
+    EXPECT_EQ(outbox.awaiting_count(), 2U);
+
+    // Вытесняется запись 1, уже не ждавшая Ack
+    static_cast<void>(outbox.add(4, "m"));
+    EXPECT_EQ(outbox.awaiting_count(), 3U);
+
+    EXPECT_TRUE(outbox.erase(2));
+    outbox.find(3)->sent = true;
+    std::vector<app::Outbox::Entry> settled;
+    outbox.settle(3, {}, settled);
+    EXPECT_EQ(outbox.awaiting_count(), 1U);
+
+    outbox.set_awaiting_ack(*outbox.find(4), false);
+    EXPECT_EQ(outbox.awaiting_count(), 0U);
+    outbox.set_awaiting_ack(*outbox.find(4), true);
+    EXPECT_EQ(outbox.awaiting_count(), 1U);
+}
+
+// Повторный id заменяет запись, а не дублирует её
+TEST(OutboxTest, AddReplacesSameId) {
+    app::Outbox outbox(10);
+    static_cast<void>(outbox.add(5, "старый"));
+    static_cast<void>(outbox.add(5, "новый"));
+    EXPECT_EQ(outbox.size(), 1U);
+    EXPECT_EQ(*outbox.find(5)->payload, "новый");
+}
+
+// Один Sack закрывает записи до границы и внутри блоков, остальные
+// остаются ждать
+TEST(OutboxTest, SettlesCumulativeAndSelectiveRanges) {
+    app::Outbox outbox(100);
+    for (std::uint32_t msg_id = 1; msg_id <= 10; ++msg_id) {
+        static_cast<void>(outbox.add(msg_id, "m" + std::to_string(msg_id)));
+        outbox.find(msg_id)->sent = true;
+    }
+
+    const std::array<proto::SackRange, 2> ranges{
+        proto::SackRange{6, 7}, proto::SackRange{9, 9}};
+    std::vector<app::Outbox::Entry> settled;
+    outbox.settle(3, ranges, settled);
+
+    std::vector<std::uint32_t> settled_ids;
+    for (const auto& entry : settled) {
+        settled_ids.push_back(entry.id);
+    }
+    EXPECT_EQ(settled_ids, (std::vector<std::uint32_t>{1, 2, 3, 6, 7, 9}));
+
+    std::vector<std::uint32_t> left;
+    for (const auto& entry : outbox) {
+        left.push_back(entry.id);
+    }
+    EXPECT_EQ(left, (std::vector<std::uint32_t>{4, 5, 8, 10}));
+    EXPECT_EQ(outbox.find(3), nullptr);
+    ASSERT_NE(outbox.find(8), nullptr);
+
+    // Повторный Sack ничего не закрывает
+    outbox.settle(3, ranges, settled);
+    EXPECT_TRUE(settled.empty());
+
+    // Блок длиннее outbox сверяется со списком, а не перебором id
+    const std::array<proto::SackRange, 1> wide{
+        proto::SackRange{8, 0x7FFFFFFFU}};
+    outbox.settle(3, wide, settled);
+    settled_ids.clear();
+    for (const auto& entry : settled) {
+        settled_ids.push_back(entry.id);
+    }
+    EXPECT_EQ(settled_ids, (std::vector<std::uint32_t>{8, 10}));
+}
+
+// Sack закрывает только отправленное: запись, ждущая очереди, и запись,
+// повторённая под новым id, переживают кадр, чья граница покрывает их id
+TEST(OutboxTest, SettleKeepsQueuedAndRekeyedEntries) {
+    app::Outbox outbox(100);
+    for (std::uint32_t msg_id = 1; msg_id <= 4; ++msg_id) {
+        static_cast<void>(outbox.add(msg_id, "m" + std::to_string(msg_id)));
+    }
+    outbox.find(1)->sent = true;
+    outbox.find(3)->sent = true;
+    // Запись 2 повторена под id 9 и снова ждёт очереди; 4 не отправлялась
+    ASSERT_NE(outbox.rekey(2, 9), nullptr);
+
+    std::vector<app::Outbox::Entry> settled;
+    outbox.settle(9, {}, settled);
+    std::vector<std::uint32_t> settled_ids;
+    for (const auto& entry : settled) {
+        settled_ids.push_back(entry.id);
+    }
+    EXPECT_EQ(settled_ids, (std::vector<std::uint32_t>{1, 3}));
+
+    std::vector<std::uint32_t> left;
+    for (const auto& entry : outbox) {
+        left.push_back(entry.id);
+    }
+    EXPECT_EQ(left, (std::vector<std::uint32_t>{4, 9}));
+}
+
+// ============= Тесты окна отправки =============
+
+namespace {
+// Заполнить окно до отказа; возвращает число отправленных
+auto fillWindow(app::SendWindow& window) -> std::uint32_t {
+    std::uint32_t sent = 0;
+    while (window.can_send()) {
+        window.on_send();
+        ++sent;
+    }
+    return sent;
+}
+}  // namespace
+
+// Медленный старт: каждое подтверждение — +1, окно вдвое за круг
+TEST(SendWindowTest, SlowStartDoublesPerRound) {
+    app::SendWindow window(app::SendWindow::Options{4, 1024, 256});
+    EXPECT_EQ(fillWindow(window), 4U);
+    EXPECT_FALSE(window.can_send());
+
+    window.on_ack(4);
+    EXPECT_EQ(window.cwnd(), 8U);
+    EXPECT_EQ(window.in_flight(), 0U);
+    EXPECT_EQ(fillWindow(window), 8U);
+
+    window.on_ack(8);
+    EXPECT_EQ(window.cwnd(), 16U);
+}
+
+// Потеря: окно и порог вдвое; выше порога — +1 за круг
+TEST(SendWindowTest, LossHalvesAndCongestionAvoidanceGrowsLinearly) {
+    app::SendWindow window(app::SendWindow::Options{16, 1024, 256});
+    static_cast<void>(fillWindow(window));
+    window.on_loss();
+    EXPECT_EQ(window.cwnd(), 8U);
+    EXPECT_EQ(window.ssthresh(), 8U);
+
+    // Подтверждения сверх порога: +1 только после cwnd подтверждений
+    window.on_ack(7);
+    EXPECT_EQ(window.cwnd(), 8U);
+    window.on_ack(1);
+    EXPECT_EQ(window.cwnd(), 9U);
+
+    // Окно не опускается ниже одного сообщения
+    for (int loss = 0; loss < 10; ++loss) {
+        window.on_loss();
+    }
+    EXPECT_EQ(window.cwnd(), 1U);
+    EXPECT_EQ(window.ssthresh(), 2U);
+}
+
+// Окно собеседника ограничивает отправку независимо от cwnd
+TEST(SendWindowTest, PeerWindowLimitsSending) {
+    app::SendWindow window(app::SendWindow::Options{64, 1024, 256});
+    window.on_peer_window(3);
+    EXPECT_EQ(window.window(), 3U);
+    EXPECT_EQ(fillWindow(window), 3U);
+
+    // Нулевое окно останавливает отправку даже с пустым полётом
+    window.on_ack(3);
+    window.on_peer_window(0);
+    EXPECT_FALSE(window.can_send());
+
+    window.on_peer_window(100);
+    EXPECT_EQ(fillWindow(window), 67U);  // cwnd 64 + 3 подтверждения
+}
+
+// Сообщения, покинувшие полёт без подтверждения, не растят окно;
+// новое соединение начинает медленный старт заново
+TEST(SendWindowTest, DropDoesNotGrowAndRestartResets) {
+    app::SendWindow window(app::SendWindow::Options{4, 1024, 256});
+    static_cast<void>(fillWindow(window));
+    window.on_drop(2);
+    EXPECT_EQ(window.in_flight(), 2U);
+    EXPECT_EQ(window.cwnd(), 4U);
+
+    // Лишние подтверждения не уводят полёт ниже нуля
+    window.on_ack(10);
+    EXPECT_EQ(window.in_flight(), 0U);
+    EXPECT_EQ(window.cwnd(), 6U);
+
+    window.on_peer_window(1);
+    static_cast<void>(fillWindow(window));
+    window.restart();
+    EXPECT_EQ(window.in_flight(), 0U);
+    EXPECT_EQ(window.cwnd(), 4U);
+    EXPECT_EQ(window.rwnd(), 256U);
+}
+
+// ============= Тесты оценки RTT =============
+
+// Первый замер задаёт SRTT и разброс R/2, следующие сглаживаются с
+// весами 1/8 и 1/4 (RFC 6298)
+TEST(RttEstimatorTest, SmoothsSamplesLikeJacobsonKarels) {
+    using std::chrono::milliseconds;
+    using std::chrono::microseconds;
+    app::RttEstimator rtt;
+    EXPECT_FALSE(rtt.has_samples());
+    EXPECT_EQ(rtt.rto(), milliseconds(1000));
+
+    rtt.on_sample(milliseconds(100));
+    EXPECT_EQ(rtt.srtt(), milliseconds(100));
+    EXPECT_EQ(rtt.rttvar(), milliseconds(50));
+    EXPECT_EQ(rtt.rto(), milliseconds(300));
+
+    rtt.on_sample(milliseconds(200));
+    EXPECT_EQ(rtt.srtt(), microseconds(112500));
+    EXPECT_EQ(rtt.rttvar(), microseconds(62500));
+    EXPECT_EQ(rtt.rto(), microseconds(362500));
+    EXPECT_EQ(rtt.last(), milliseconds(200));
+    EXPECT_EQ(rtt.min(), milliseconds(100));
+    EXPECT_EQ(rtt.samples(), 2U);
+}
+
+// В локальной сети RTO сходится к нижнему пределу, а не к прежним 5 с
+TEST(RttEstimatorTest, ConvergesToMinimumOnFastLink) {
+    app::RttEstimator rtt;
+    for (int sample = 0; sample < 50; ++sample) {
+        rtt.on_sample(std::chrono::microseconds(300));
+    }
+    EXPECT_EQ(rtt.rto(), std::chrono::milliseconds(200));
+
+    // Нестабильный канал: разброс раздвигает RTO над SRTT
+    app::RttEstimator jittery;
+    for (int sample = 0; sample < 50; ++sample) {
+        jittery.on_sample(std::chrono::milliseconds(sample % 2 == 0 ? 50
+                                                                    : 450));
+    }
+    EXPECT_GT(jittery.rto(), jittery.srtt() + std::chrono::milliseconds(600));
+}
+
+// Таймаут удваивает RTO до max_rto; новый замер снимает удвоение
+TEST(RttEstimatorTest, TimeoutBacksOffUntilNextSample) {
+    using std::chrono::milliseconds;
+    app::RttEstimator rtt(app::RttEstimator::Options{
+        milliseconds(1000), milliseconds(200), milliseconds(3000),
+        milliseconds(10)});
+    rtt.on_sample(milliseconds(100));
+    rtt.on_timeout();
+    EXPECT_EQ(rtt.rto(), milliseconds(600));
+    rtt.on_timeout();
+    rtt.on_timeout();
+    rtt.on_timeout();
+    EXPECT_EQ(rtt.rto(), milliseconds(3000));
+    rtt.on_timeout();  // предел: удвоений больше нет
+    EXPECT_EQ(rtt.rto(), milliseconds(3000));
+    EXPECT_EQ(rtt.backoff(), 4);
+
+    rtt.on_sample(milliseconds(100));
+    EXPECT_EQ(rtt.backoff(), 0);
+    EXPECT_LT(rtt.rto(), milliseconds(600));
+}
+
+// ============= Тесты повторов по таймауту Ack =============
+
+// Обычные повторы, проверка связи, последний повтор, отказ; отложенный
+// повтор ждёт, но его таймаут — тоже потеря
+TEST(AckRetryTest, WalksRetriesAndCountsDeferredTimeoutAsLoss) {
+    using app::AckTimeoutAction;
+    constexpr int MAX_RETRIES = 3;
+    app::Outbox::Entry entry{};
+    entry.id = 7;
+
+    EXPECT_EQ(app::ack_timeout_action(entry, MAX_RETRIES),
+              AckTimeoutAction::Retransmit);
+    entry.retry_count = 2;
+    EXPECT_EQ(app::ack_timeout_action(entry, MAX_RETRIES),
+              AckTimeoutAction::RequestPing);
+    entry.ping_for_ack_requested = true;
+    EXPECT_EQ(app::ack_timeout_action(entry, MAX_RETRIES),
+              AckTimeoutAction::FinalRetransmit);
+    entry.retry_count = 3;
+    EXPECT_EQ(app::ack_timeout_action(entry, MAX_RETRIES),
+              AckTimeoutAction::GiveUp);
+
+    entry.retry_count = 0;
+    entry.retransmit_deferred = true;
+    EXPECT_EQ(app::ack_timeout_action(entry, MAX_RETRIES),
+              AckTimeoutAction::WaitDeferred);
+
+    EXPECT_TRUE(app::counts_as_loss(AckTimeoutAction::Retransmit));
+    EXPECT_TRUE(app::counts_as_loss(AckTimeoutAction::FinalRetransmit));
+    EXPECT_TRUE(app::counts_as_loss(AckTimeoutAction::WaitDeferred));
+    EXPECT_FALSE(app::counts_as_loss(AckTimeoutAction::RequestPing));
+    EXPECT_FALSE(app::counts_as_loss(AckTimeoutAction::GiveUp));
+}
+
+// Последний повтор объявляется как последний, в том числе отложенный
+TEST(AckRetryTest, AnnouncesFinalRetransmit) {
+    constexpr int MAX_RETRIES = 3;
+    app::Outbox::Entry entry{};
+    entry.id = 7;
+    entry.retry_count = 2;
+    EXPECT_EQ(app::retransmit_notice(entry, MAX_RETRIES),
+              "[Повторная отправка msg_id=7, попытка 2]");
+    entry.retry_count = 3;
+    EXPECT_EQ(app::retransmit_notice(entry, MAX_RETRIES),
+              "[Последняя попытка отправки msg_id=7]");
+}
+
+// ============= Тесты гистограммы задержек =============
+
+// Перцентили — с погрешностью не больше ширины корзины (1/32)
+TEST(LatencyHistogramTest, PercentilesWithinBucketError) {
+    utils::LatencyHistogram histogram;
+    for (std::uint64_t value = 1; value <= 100000; ++value) {
+        histogram.record(value);
+    }
+
+    EXPECT_EQ(histogram.count(), 100000U);
+    EXPECT_EQ(histogram.min(), 1U);
+    EXPECT_EQ(histogram.max(), 100000U);
+    EXPECT_DOUBLE_EQ(histogram.mean(), 50000.5);
+    for (const double quantile : {0.5, 0.9, 0.99, 0.999}) {
+        const double exact = quantile * 100000.0;
+        const auto value = static_cast<double>(histogram.percentile(quantile));
+        EXPECT_GE(value, exact);
+        EXPECT_LE(value, exact * (1.0 + 1.0 / 32.0)) << quantile;
+    }
+    EXPECT_EQ(histogram.percentile(1.0), 100000U);
+}
+
+// Границы корзин: точные малые значения и весь диапазон uint64
+TEST(LatencyHistogramTest, BucketsCoverWholeRange) {
+    using utils::LatencyHistogram;
+    for (std::uint64_t value = 0; value < 32; ++value) {
+        EXPECT_EQ(LatencyHistogram::bucket_index(value), value);
+    }
+    EXPECT_EQ(LatencyHistogram::bucket_upper_bound(
+                  LatencyHistogram::bucket_index(64)),
+              65U);
+    const std::uint64_t top = std::numeric_limits<std::uint64_t>::max();
+    EXPECT_EQ(LatencyHistogram::bucket_index(top),
+              LatencyHistogram::BUCKETS - 1);
+    EXPECT_EQ(LatencyHistogram::bucket_upper_bound(
+                  LatencyHistogram::BUCKETS - 1),
+              top);
+
+    // Верхняя граница каждой корзины попадает в неё же, следующее
+    // значение — в следующую
+    for (std::size_t index = 0; index + 1 < LatencyHistogram::BUCKETS;
+         ++index) {
+        const std::uint64_t upper =
+            LatencyHistogram::bucket_upper_bound(index);
+        ASSERT_EQ(LatencyHistogram::bucket_index(upper), index);
+        ASSERT_EQ(LatencyHistogram::bucket_index(upper + 1), index + 1);
+    }
+}
+
+TEST(LatencyHistogramTest, MergesAndResets) {
+    utils::LatencyHistogram first;
+    utils::LatencyHistogram second;
+    EXPECT_EQ(first.percentile(0.5), 0U);
+
+    first.record(10);
+    second.record(1000);
+    second.record(3);
+    first.merge(second);
+
+    EXPECT_EQ(first.count(), 3U);
+    EXPECT_EQ(first.min(), 3U);
+    EXPECT_EQ(first.max(), 1000U);
+    EXPECT_EQ(first.percentile(0.5), 10U);
+
+    first.reset();
+    EXPECT_EQ(first.count(), 0U);
+    EXPECT_EQ(first.bucket_count(utils::LatencyHistogram::bucket_index(10)),
+              0U);
+}
+
+// Прогон через loopback: все сообщения подтверждены, перцентили
+// упорядочены
+TEST(LoopbackBenchTest, DeliversAllMessagesAndReportsLatency) {
+    app::LoopbackBenchOptions options;
+    options.messages = 2000;
+    options.payload_size = 128;
+    options.window = 16;
+
+    const app::LoopbackBenchReport report = app::run_loopback_bench(options);
+
+    EXPECT_EQ(report.messages, 2000U);
+    // Подтверждения идут отложенным Sack, а не Ack на каждое сообщение
+    EXPECT_GT(report.ack_frames, 0U);
+    EXPECT_LT(report.ack_frames, report.messages);
+    EXPECT_GT(report.messages_per_second, 0.0);
+    EXPECT_GT(report.megabytes_per_second, 0.0);
+    EXPECT_LE(report.p50_us, report.p99_us);
+    EXPECT_LE(report.p99_us, report.p999_us);
+    EXPECT_LE(report.p999_us, report.max_us);
+
+    std::ostringstream out;
+    app::print_loopback_report(out, options, report);
+    EXPECT_NE(out.str().find("p999"), std::string::npos);
+}
+
+// ============= Тесты реестра метрик =============
+
+// Счётчик с шардами по потокам: ни одно приращение не теряется
+TEST(MetricsTest, CounterSumsAllThreads) {
+    utils::Counter counter;
+    std::vector<std::thread> threads;
+    for (int thread_index = 0; thread_index < 8; ++thread_index) {
+        threads.emplace_back([&counter] {
+            for (int i = 0; i < 10000; ++i) {
+                counter.add();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    counter.add(5);
+
+    EXPECT_EQ(counter.value(), 80005U);
+}
+
+TEST(MetricsTest, RegistryReturnsSameMetricByName) {
+    utils::MetricsRegistry registry;
+    utils::Counter& first = registry.counter("test_total", "Первый");
+    utils::Counter& second = registry.counter("test_total", "Второй");
+    EXPECT_EQ(&first, &second);
+
+    utils::Histogram& histogram = registry.histogram("test_us", "Задержка");
+    histogram.record(10);
+    histogram.record(1000);
+    first.add(3);
+
+    const auto counters = registry.counters();
+    ASSERT_EQ(counters.size(), 1U);
+    EXPECT_EQ(counters.front().help, "Первый");
+    EXPECT_EQ(counters.front().value, 3U);
+
+    const auto histograms = registry.histograms();
+    ASSERT_EQ(histograms.size(), 1U);
+    EXPECT_EQ(histograms.front().histogram.count(), 2U);
+    EXPECT_EQ(histograms.front().histogram.max(), 1000U);
+}
+
+// Текстовый формат Prometheus и запись файла через rename()
+TEST(MetricsTest, ExportsPrometheusText) {
+    utils::MetricsRegistry registry;
+    registry.counter("test_frames_total", "Кадров").add(7);
+    registry.histogram("test_rtt_microseconds", "RTT").record(100);
+
+    std::ostringstream out;
+    registry.write_prometheus(out);
+    const std::string text = out.str();
+    EXPECT_NE(text.find("# HELP test_frames_total Кадров\n"
+                        "# TYPE test_frames_total counter\n"
+                        "test_frames_total 7\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("# TYPE test_rtt_microseconds summary\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("test_rtt_microseconds{quantile=\"0.99\"} 100\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("test_rtt_microseconds_sum 100\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("test_rtt_microseconds_count 1\n"),
+              std::string::npos);
+
+    const std::string path =
+        (std::filesystem::temp_directory_path() /
+         ("messenger_metrics_" + std::to_string(::getpid()) + ".prom"))
+            .string();
+    registry.export_prometheus(path);
+    std::ifstream file(path);
+    const std::string contents{std::istreambuf_iterator<char>(file),
+                               std::istreambuf_iterator<char>()};
+    EXPECT_EQ(contents, text);
+    EXPECT_FALSE(std::filesystem::exists(path + ".tmp"));
+    std::filesystem::remove(path);
+}
+
+// send_bytes/recv_bytes считают байты и кадры в общем реестре
+TEST(MetricsTest, NetMetricsCountFrames) {
+    std::array<int, 2> sock_pair{-1, -1};
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, sock_pair.data()), 0);
+    const net::Socket sender(sock_pair[0]);
+    const net::Socket receiver(sock_pair[1]);
+
+    const net::NetMetrics& metrics = net::net_metrics();
+    const std::uint64_t sent_bytes = metrics.sent_bytes.value();
+    const std::uint64_t sent_frames = metrics.sent_frames.value();
+    const std::uint64_t received_bytes = metrics.received_bytes.value();
+    const std::uint64_t received_frames = metrics.received_frames.value();
+
+    const auto frame = proto::serialize(
+        proto::Message{proto::MsgType::Text, 1, std::string(100, 'x')});
+    ASSERT_TRUE(net::send_bytes(sender.fd_return(), frame));
+    std::vector<std::uint8_t> received;
+    ASSERT_TRUE(net::recv_bytes(receiver.fd_return(), received));
+
+    EXPECT_EQ(metrics.sent_bytes.value() - sent_bytes, frame.size());
+    EXPECT_EQ(metrics.sent_frames.value() - sent_frames, 1U);
+    EXPECT_EQ(metrics.received_bytes.value() - received_bytes, frame.size());
+    EXPECT_EQ(metrics.received_frames.value() - received_frames, 1U);
+}
+
+// ============= Тесты журнала outbox =============
+
+class OutboxLogTest : public ::testing::Test {
+protected:
+    std::string path = (std::filesystem::temp_directory_path() /
+                        ("messenger_outbox_" + std::to_string(::getpid()) +
+                         ".wal"))
+                           .string();
+
+    void SetUp() override {
+        std::filesystem::remove(path);
+    }
+    void TearDown() override {
+        std::filesystem::remove(path);
+        std::filesystem::remove(path + ".tmp");
+    }
+
+    [[nodiscard]]
+    static auto fastOptions() -> utils::AsyncAppender::Options {
+        utils::AsyncAppender::Options options{};
+        options.durability = utils::AsyncAppender::Durability::None;
+        return options;
+    }
+
+    [[nodiscard]]
+    static auto contents(const app::Outbox& outbox)
+        -> std::vector<std::pair<std::uint32_t, std::string>> {
+        std::vector<std::pair<std::uint32_t, std::string>> result;
+        for (const auto& entry : outbox) {
+            result.emplace_back(entry.id, *entry.payload);
+        }
+        return result;
+    }
+};
+
+// Неподтверждённые сообщения восстанавливаются в порядке отправки,
+// подтверждённые — нет, смена id учитывается
+TEST_F(OutboxLogTest, RecoversUnackedMessages) {
+    {
+        app::Outbox outbox(100);
+        app::OutboxLog log(path, outbox, fastOptions());
+        EXPECT_EQ(log.recovered_entries(), 0U);
+
+        for (std::uint32_t msg_id = 1; msg_id <= 4; ++msg_id) {
+            static_cast<void>(
+                outbox.add(msg_id, "сообщение " + std::to_string(msg_id)));
+            log.record_add(msg_id, *outbox.find(msg_id)->payload);
+        }
+        outbox.erase(2);
+        log.record_remove(2);
+        outbox.rekey(3, 10);
+        log.record_rekey(3, 10);
+    }
+
+    app::Outbox outbox(100);
+    const app::OutboxLog log(path, outbox, fastOptions());
+    EXPECT_EQ(log.recovered_entries(), 3U);
+    EXPECT_EQ(contents(outbox),
+              (std::vector<std::pair<std::uint32_t, std::string>>{
+                  {1, "сообщение 1"},
+                  {4, "сообщение 4"},
+                  {10, "сообщение 3"}}));
+}
+
+// Оборванная последняя запись отбрасывается, предыдущие сохраняются
+TEST_F(OutboxLogTest, IgnoresTornTail) {
+    {
+        app::Outbox outbox(100);
+        app::OutboxLog log(path, outbox, fastOptions());
+        static_cast<void>(outbox.add(1, "целое"));
+        log.record_add(1, "целое");
+        static_cast<void>(outbox.add(2, "оборванное"));
+        log.record_add(2, "оборванное");
+    }
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+
+    app::Outbox outbox(100);
+    const app::OutboxLog log(path, outbox, fastOptions());
+    EXPECT_EQ(contents(outbox),
+              (std::vector<std::pair<std::uint32_t, std::string>>{
+                  {1, "целое"}}));
+}
+
+// Журнал сжимается контрольными точками и не растёт с числом
+// подтверждённых сообщений
+TEST_F(OutboxLogTest, CheckpointsKeepLogCompact) {
+    {
+        app::Outbox outbox(100);
+        app::OutboxLog log(path, outbox, fastOptions());
+        for (std::uint32_t msg_id = 1; msg_id <= 10000; ++msg_id) {
+            static_cast<void>(outbox.add(msg_id, std::string(100, 'x')));
+            log.record_add(msg_id, *outbox.find(msg_id)->payload);
+            if (msg_id > 2) {
+                outbox.erase(msg_id - 2);
+                log.record_remove(msg_id - 2);
+            }
+        }
+        EXPECT_GT(log.checkpoints(), 0U);
+        EXPECT_LE(log.log_records(),
+                  app::OutboxLog::CHECKPOINT_MIN_RECORDS + 1);
+        log.flush();
+        EXPECT_LT(std::filesystem::file_size(path), 200U * 1024U);
+    }
+
+    app::Outbox outbox(100);
+    const app::OutboxLog log(path, outbox, fastOptions());
+    EXPECT_EQ(contents(outbox).size(), 2U);
+    EXPECT_EQ(outbox.begin()->id, 9999U);
+}
+
+// Сбой контрольной точки не бросает исключение из record_remove(): журнал
+// помечается отказавшим, прежний файл остаётся целым
+TEST_F(OutboxLogTest, FailedCheckpointLeavesLogIntact) {
+    {
+        app::Outbox outbox(100);
+        app::OutboxLog log(path, outbox, fastOptions());
+        log.flush();
+        std::filesystem::create_directory(path + ".tmp");
+
+        std::uint32_t msg_id = 1;
+        while (log.checkpoints() == 0) {
+            static_cast<void>(outbox.add(msg_id, "x"));
+            log.record_add(msg_id, "x");
+            outbox.erase(msg_id);
+            EXPECT_NO_THROW(log.record_remove(msg_id));
+            ++msg_id;
+        }
+        log.flush();
+        EXPECT_TRUE(log.failed());
+    }
+    std::filesystem::remove(path + ".tmp");
+
+    // Все записи до отказа проигрываются: подтверждённых не осталось
+    app::Outbox outbox(100);
+    const app::OutboxLog log(path, outbox, fastOptions());
+    EXPECT_FALSE(log.failed());
+    EXPECT_TRUE(contents(outbox).empty());
+}
+
+// ============= Тесты переподключения и возобновления сеанса =============
+
+// Приветствие кодируется и разбирается без потерь; пустой Ping и чужая
+// полезная нагрузка приветствием не считаются
+TEST(HelloTest, RoundTripsAndRejectsForeignPayload) {
+    proto::Hello hello{};
+    hello.session_id = 0x0102030405060708ULL;
+    hello.peer_session_id = 0xF1F2F3F4F5F6F7F8ULL;
+    hello.last_received = 0xDEADBEEFU;
+    hello.first_pending = 0xC0FFEEU;
+    hello.features = 0x5AU;
+
+    const std::string encoded = proto::encode_hello(hello);
+    ASSERT_EQ(encoded.size(), proto::Hello::ENCODED_SIZE);
+    EXPECT_EQ(encoded.substr(0, 4), "MSGR");
+
+    const auto decoded = proto::decode_hello(encoded);
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_EQ(decoded->session_id, hello.session_id);
+    EXPECT_EQ(decoded->peer_session_id, hello.peer_session_id);
+    EXPECT_EQ(decoded->last_received, hello.last_received);
+    EXPECT_EQ(decoded->first_pending, hello.first_pending);
+    EXPECT_EQ(decoded->features, hello.features);
+
+    // Расширение следующей версии не мешает разбору
+    EXPECT_TRUE(proto::decode_hello(encoded + "ext").has_value());
+
+    // Приветствие версии 1 — без first_pending
+    std::string first_version =
+        encoded.substr(0, proto::Hello::V1_ENCODED_SIZE);
+    first_version[4] = '\x01';
+    const auto old_hello = proto::decode_hello(first_version);
+    ASSERT_TRUE(old_hello.has_value());
+    EXPECT_EQ(old_hello->session_id, hello.session_id);
+    EXPECT_EQ(old_hello->first_pending, 0U);
+
+    EXPECT_FALSE(proto::decode_hello("").has_value());
+    EXPECT_FALSE(proto::decode_hello(encoded.substr(0, 20)).has_value());
+    std::string foreign = encoded;
+    foreign[0] = 'X';
+    EXPECT_FALSE(proto::decode_hello(foreign).has_value());
+}
+
+// Граница непрерывно полученных id сдвигается только через закрытые дыры
+TEST(SessionStateTest, TracksContiguousBoundary) {
+    app::SessionState state(1);
+    EXPECT_FALSE(state.last_received().has_value());
+
+    EXPECT_TRUE(state.accept(1));
+    EXPECT_TRUE(state.accept(2));
+    EXPECT_TRUE(state.accept(4));
+    EXPECT_EQ(state.last_received(), 2U);
+
+    EXPECT_TRUE(state.accept(3));
+    EXPECT_EQ(state.last_received(), 4U);
+
+    EXPECT_FALSE(state.accept(2));
+    EXPECT_EQ(state.last_received(), 4U);
+}
+
+// Граница отсчитывается от first_pending из приветствия, а не от первого
+// пришедшего id: сообщение, обогнавшее очередь отправителя, не закрывает
+// ждущие в ней меньшие id
+TEST(SessionStateTest, BoundaryStartsFromPeerFirstPending) {
+    app::SessionState state(1);
+    proto::Hello peer{};
+    peer.session_id = 2;
+    peer.first_pending = 5;
+    static_cast<void>(state.on_peer_hello(peer));
+    EXPECT_EQ(state.last_received(), 4U);
+
+    // Повтор под новым id 9 ушёл раньше очереди 5..8
+    EXPECT_TRUE(state.accept(9));
+    EXPECT_EQ(state.last_received(), 4U);
+    const proto::SackBlocks blocks = state.sack_blocks();
+    ASSERT_EQ(blocks.count, 1U);
+    EXPECT_EQ(blocks.ranges[0].first, 9U);
+
+    for (std::uint32_t msg_id = 5; msg_id <= 8; ++msg_id) {
+        EXPECT_TRUE(state.accept(msg_id));
+    }
+    EXPECT_EQ(state.last_received(), 9U);
+
+    // Переподключение: граница не откатывается назад
+    peer.first_pending = 7;
+    static_cast<void>(state.on_peer_hello(peer));
+    EXPECT_EQ(state.last_received(), 9U);
+    peer.first_pending = 20;
+    static_cast<void>(state.on_peer_hello(peer));
+    EXPECT_EQ(state.last_received(), 19U);
+}
+
+// Собеседник того же сеанса сообщает границу: доставленное не повторяется
+TEST(SessionStateTest, ResumeReportsDeliveredBoundary) {
+    app::SessionState sender(0xAAU);
+    app::SessionState receiver(0xBBU);
+
+    // Первое подключение: стороны ещё не знают друг друга
+    EXPECT_FALSE(receiver.on_peer_hello(sender.hello()).delivered_up_to);
+    EXPECT_FALSE(sender.on_peer_hello(receiver.hello()).delivered_up_to);
+
+    for (std::uint32_t msg_id = 1; msg_id <= 3; ++msg_id) {
+        ASSERT_TRUE(receiver.accept(msg_id));
+    }
+
+    // Переподключение: получатель помнит сеанс отправителя
+    const auto resume = sender.on_peer_hello(receiver.hello());
+    EXPECT_FALSE(resume.peer_restarted);
+    ASSERT_TRUE(resume.delivered_up_to.has_value());
+    EXPECT_EQ(*resume.delivered_up_to, 3U);
+
+    EXPECT_TRUE(app::SessionState::covered_by(3, 3));
+    EXPECT_FALSE(app::SessionState::covered_by(4, 3));
+    // Переход счётчика через 2^32
+    EXPECT_TRUE(app::SessionState::covered_by(0xFFFFFFFFU, 2));
+}
+
+// Перезапущенный собеседник начинает нумерацию заново: прежние id не
+// считаются дубликатами, а его граница о нашем сеансе не говорит
+TEST(SessionStateTest, PeerRestartResetsDedup) {
+    app::SessionState state(0xAAU);
+    proto::Hello first{};
+    first.session_id = 0x11U;
+    EXPECT_FALSE(state.on_peer_hello(first).peer_restarted);
+    ASSERT_TRUE(state.accept(1));
+    ASSERT_TRUE(state.accept(2));
+
+    proto::Hello restarted{};
+    restarted.session_id = 0x22U;
+    const auto resume = state.on_peer_hello(restarted);
+    EXPECT_TRUE(resume.peer_restarted);
+    EXPECT_FALSE(resume.delivered_up_to.has_value());
+    EXPECT_FALSE(state.last_received().has_value());
+
+    EXPECT_TRUE(state.accept(1));
+    EXPECT_EQ(state.hello().peer_session_id, 0x22U);
+    EXPECT_EQ(state.hello().last_received, 1U);
+}
+
+// Блоки SACK описывают полученные id за непрерывной границей
+TEST(SessionStateTest, SackBlocksDescribeGapsAboveBoundary) {
+    app::SessionState state(1);
+    for (const std::uint32_t msg_id : {1U, 2U, 4U, 5U, 7U, 10U}) {
+        ASSERT_TRUE(state.accept(msg_id));
+    }
+    EXPECT_EQ(state.last_received(), 2U);
+
+    const proto::SackBlocks blocks = state.sack_blocks();
+    ASSERT_EQ(blocks.count, 3U);
+    EXPECT_EQ(blocks.ranges[0].first, 4U);
+    EXPECT_EQ(blocks.ranges[0].last, 5U);
+    EXPECT_EQ(blocks.ranges[1].first, 7U);
+    EXPECT_EQ(blocks.ranges[1].last, 7U);
+    EXPECT_EQ(blocks.ranges[2].first, 10U);
+    EXPECT_EQ(blocks.ranges[2].last, 10U);
+
+    // Блоков не больше MAX_RANGES: дальние ждут следующего Sack
+    for (const std::uint32_t msg_id : {12U, 14U, 16U}) {
+        ASSERT_TRUE(state.accept(msg_id));
+    }
+    EXPECT_EQ(state.sack_blocks().count, proto::SackBlocks::MAX_RANGES);
+
+    // Без дыр блоков нет
+    app::SessionState contiguous(2);
+    ASSERT_TRUE(contiguous.accept(1));
+    EXPECT_EQ(contiguous.sack_blocks().count, 0U);
+}
+
+// Возможности собеседника известны только из его приветствия на текущем
+// соединении
+TEST(SessionStateTest, PeerFeaturesComeFromHello) {
+    app::SessionState state(1);
+    EXPECT_FALSE(state.peer_supports(proto::Hello::FEATURE_SACK));
+    EXPECT_NE(state.hello().features & proto::Hello::FEATURE_SACK, 0);
+
+    proto::Hello peer{};
+    peer.session_id = 2;
+    peer.features = proto::Hello::FEATURE_SACK;
+    static_cast<void>(state.on_peer_hello(peer));
+    EXPECT_TRUE(state.peer_supports(proto::Hello::FEATURE_SACK));
+
+    state.begin_connection();
+    EXPECT_FALSE(state.peer_supports(proto::Hello::FEATURE_SACK));
+}
+
+// Кадр Sack доходит до собеседника целиком и без аллокаций на отправке
+TEST(SackFrameTest, RoundTripsThroughConnection) {
+    std::array<int, 2> fds{};
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()), 0);
+    net::Connection conn{net::Socket(fds[0])};
+    const net::Socket peer(fds[1]);
+
+    proto::SackBlocks blocks{};
+    blocks.ranges[0] = {5, 9};
+    blocks.ranges[1] = {0xFFFFFFF0U, 0xFFFFFFFFU};
+    blocks.count = 2;
+    blocks.window = 256;
+
+    const std::size_t before = allocation_count.load();
+    ASSERT_TRUE(proto::send_sack(conn, 3, blocks));
+    EXPECT_EQ(allocation_count.load(), before);
+
+    proto::Message msg{};
+    bool disconnected = false;
+    ASSERT_TRUE(proto::receive_msg(peer.fd_return(), msg, disconnected));
+    EXPECT_EQ(msg.type, proto::MsgType::Sack);
+    EXPECT_EQ(msg.id, 3U);
+    EXPECT_EQ(msg.payload.size(),
+              proto::SACK_WINDOW_SIZE + 2 * proto::SACK_RANGE_SIZE);
+
+    const auto decoded = proto::decode_sack(msg.payload);
+    ASSERT_TRUE(decoded.has_value());
+    ASSERT_EQ(decoded->count, 2U);
+    EXPECT_EQ(decoded->window, 256U);
+    EXPECT_EQ(decoded->ranges[0].first, 5U);
+    EXPECT_EQ(decoded->ranges[0].last, 9U);
+    EXPECT_EQ(decoded->ranges[1].first, 0xFFFFFFF0U);
+    EXPECT_EQ(decoded->ranges[1].last, 0xFFFFFFFFU);
+
+    EXPECT_FALSE(proto::decode_sack("abc").has_value());
+    EXPECT_FALSE(proto::decode_sack("abcdef").has_value());
+    const std::string too_many_ranges(
+        proto::SACK_WINDOW_SIZE + (5 * proto::SACK_RANGE_SIZE), '\0');
+    EXPECT_FALSE(proto::decode_sack(too_many_ranges).has_value());
+}
+
+// Задержка удваивается до предела, лежит в [база/2, база] и
+// сбрасывается после успешного подключения
+TEST(BackoffTest, GrowsExponentiallyWithJitterAndResets) {
+    using std::chrono::milliseconds;
+    net::Backoff backoff({milliseconds(100), milliseconds(1000)});
+
+    const std::array<milliseconds, 6> bases{
+        milliseconds(100), milliseconds(200), milliseconds(400),
+        milliseconds(800), milliseconds(1000), milliseconds(1000)};
+    for (const auto base : bases) {
+        const auto delay = backoff.next_delay();
+        EXPECT_GE(delay, base / 2);
+        EXPECT_LE(delay, base);
+    }
+    EXPECT_EQ(backoff.attempts(), bases.size());
+
+    backoff.reset();
+    EXPECT_EQ(backoff.attempts(), 0U);
+    EXPECT_LE(backoff.next_delay(), milliseconds(100));
+}
+
+// Стенд времени возобновления: сервер пропадает на OUTAGE, клиент
+// переподключается по backoff, стороны обмениваются приветствиями, и
+// повторить нужно только сообщение, не дошедшее до обрыва.
+// Время от обрыва до возобновления пишется в свойство time_to_resume_ms
+TEST(ReconnectTest, MeasuresTimeToResumeAfterDroppedLink) {
+    using std::chrono::milliseconds;
+    const uint16_t port = 55557;
+    const milliseconds outage{150};
+    const net::CancelCheck never = [] { return false; };
+
+    // Обмен приветствиями по блокирующему сокету
+    const auto exchangeHello = [](int socket_fd, app::SessionState& state)
+        -> std::optional<app::SessionState::Resume> {
+        const auto frame = proto::serialize(proto::Message{
+            proto::MsgType::Ping, 0, proto::encode_hello(state.hello())});
+        if (::send(socket_fd, frame.data(), frame.size(), 0) !=
+            static_cast<ssize_t>(frame.size())) {
+            return std::nullopt;
+        }
+        proto::Message msg{};
+        bool disconnected = false;
+        if (!proto::receive_msg(socket_fd, msg, disconnected) ||
+            disconnected || msg.type != proto::MsgType::Ping) {
+            return std::nullopt;
+        }
+        const auto peer_hello = proto::decode_hello(msg.payload);
+        if (!peer_hello) {
+            return std::nullopt;
+        }
+        return state.on_peer_hello(*peer_hello);
+    };
+
+    app::SessionState client(0xC1U);
+    app::SessionState server(0x5EU);
+
+    // До обрыва: стороны знакомы, сервер получил id 1 и 2, id 3 — нет
+    static_cast<void>(server.on_peer_hello(client.hello()));
+    static_cast<void>(client.on_peer_hello(server.hello()));
+    ASSERT_TRUE(server.accept(1));
+    ASSERT_TRUE(server.accept(2));
+
+    const auto dropped = std::chrono::steady_clock::now();
+
+    std::optional<app::SessionState::Resume> server_resume;
+    std::thread server_thread([&] {
+        std::this_thread::sleep_for(outage);
+        const auto listener = net::create_listen_socket(port, 1);
+        auto sock = net::accept_unless_cancelled(listener, never);
+        if (sock) {
+            server_resume = exchangeHello(sock->fd_return(), server);
+        }
+    });
+
+    net::Backoff backoff({milliseconds(10), milliseconds(100)});
+    auto sock = net::connect_with_backoff("127.0.0.1", port, backoff, never);
+    ASSERT_TRUE(sock.has_value());
+    const auto client_resume = exchangeHello(sock->fd_return(), client);
+    const auto time_to_resume =
+        std::chrono::duration_cast<milliseconds>(
+            std::chrono::steady_clock::now() - dropped);
+    server_thread.join();
+
+    ASSERT_TRUE(client_resume.has_value());
+    ASSERT_TRUE(server_resume.has_value());
+    EXPECT_FALSE(client_resume->peer_restarted);
+    ASSERT_TRUE(client_resume->delivered_up_to.has_value());
+    EXPECT_EQ(*client_resume->delivered_up_to, 2U);  // повторить только id 3
+    EXPECT_EQ(backoff.attempts(), 0U);  // сброшен после подключения
+
+    ::testing::Test::RecordProperty(
+        "time_to_resume_ms", static_cast<int>(time_to_resume.count()));
+    EXPECT_GE(time_to_resume, outage);
+    // Простой сверх недоступности сервера — не больше одной задержки
+    // backoff (до 100 мс) и обмена приветствиями
+    EXPECT_LT(time_to_resume, outage + milliseconds(1000));
+}
+
+// ============= Тесты кольцевой истории =============
+
+// Строки выдаются от старой к новой
+TEST(HistoryRingTest, KeepsInsertionOrder) {
+    app::HistoryRing ring(10);
+    EXPECT_TRUE(ring.empty());
+    ring.push("[Я]: раз");
+    ring.push("[Собеседник]: два");
+    ring.push("");
+
+    ASSERT_EQ(ring.size(), 3U);
+    EXPECT_EQ(ring[0], "[Я]: раз");
+    EXPECT_EQ(ring[1], "[Собеседник]: два");
+    EXPECT_EQ(ring[2], "");
+}
+
+// Сверх max_lines вытесняются самые старые строки
+TEST(HistoryRingTest, EvictsOldestBeyondMaxLines) {
+    app::HistoryRing ring(3);
+    for (int line = 1; line <= 5; ++line) {
+        ring.push("строка " + std::to_string(line));
+    }
+
+    ASSERT_EQ(ring.size(), 3U);
+    EXPECT_EQ(ring[0], "строка 3");
+    EXPECT_EQ(ring[2], "строка 5");
+}
+
+// При заполнении арены строки переходят в её начало, вытесняя старые, а
+// содержимое оставшихся строк не портится
+TEST(HistoryRingTest, WrapsArenaAndEvictsByBytes) {
+    app::HistoryRing ring(1000, 100);
+    for (int line = 0; line < 50; ++line) {
+        ring.push(std::string(30, static_cast<char>('a' + line % 26)));
+    }
+
+    EXPECT_LE(ring.used_bytes(), 100U);
+    ASSERT_EQ(ring.size(), 3U);
+    EXPECT_EQ(ring[0], std::string(30, static_cast<char>('a' + 47 % 26)));
+    EXPECT_EQ(ring[1], std::string(30, static_cast<char>('a' + 48 % 26)));
+    EXPECT_EQ(ring[2], std::string(30, static_cast<char>('a' + 49 % 26)));
+}
+
+// Рост арены переносит строки, не меняя их содержимого и порядка
+TEST(HistoryRingTest, GrowsArenaPreservingLines) {
+    app::HistoryRing ring(100000);
+    const std::size_t initial = ring.memory_bytes();
+
+    for (int line = 0; line < 20000; ++line) {
+        ring.push("сообщение " + std::to_string(line));
+    }
+
+    EXPECT_GT(ring.memory_bytes(), initial);
+    ASSERT_EQ(ring.size(), 20000U);
+    EXPECT_EQ(ring[0], "сообщение 0");
+    EXPECT_EQ(ring[12345], "сообщение 12345");
+    EXPECT_EQ(ring[19999], "сообщение 19999");
+}
+
+// Строка длиннее арены обрезается до её размера
+TEST(HistoryRingTest, TruncatesLineLongerThanArena) {
+    app::HistoryRing ring(10, 16);
+    ring.push("короткая");
+    ring.push(std::string(40, 'x'));
+
+    ASSERT_EQ(ring.size(), 1U);
+    EXPECT_EQ(ring[0], std::string(16, 'x'));
+}
+
+// Полная история в 10000 строк занимает одну арену и кольцо описателей,
+// и после заполнения добавление строк не аллоцирует память
+TEST(HistoryRingTest, FullHistoryDoesNotAllocate) {
+    constexpr std::size_t LINES = 10000U;
+    const std::string line = "[Собеседник]: " + std::string(80, 'x');
+
+    app::HistoryRing ring(LINES);
+    for (std::size_t index = 0; index < LINES * 2; ++index) {
+        ring.push(line);
+    }
+    ASSERT_EQ(ring.size(), LINES);
+    EXPECT_EQ(ring.used_bytes(), LINES * line.size());
+    EXPECT_LE(ring.memory_bytes(), 4U * LINES * line.size());
+
+    const std::size_t before = allocation_count.load();
+    for (std::size_t index = 0; index < LINES; ++index) {
+        ring.push(line);
+    }
+    EXPECT_EQ(allocation_count.load() - before, 0U);
+    EXPECT_EQ(ring[LINES - 1], line);
+}
+
+// ============= Тесты фоновой записи истории =============
+
+// Порядок сохраняется, заполненная очередь отказывает без потери записи
+TEST(SpscQueueTest, PreservesOrderAndReportsFull) {
+    utils::SpscQueue<std::string> queue(4);
+    EXPECT_EQ(queue.capacity(), 4U);
+
+    for (int index = 0; index < 4; ++index) {
+        ASSERT_TRUE(queue.try_push(std::to_string(index)));
+    }
+    std::string extra = "extra";
+    EXPECT_FALSE(queue.try_push(std::move(extra)));
+
+    std::string value;
+    for (int index = 0; index < 4; ++index) {
+        ASSERT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(value, std::to_string(index));
+    }
+    EXPECT_FALSE(queue.try_pop(value));
+    EXPECT_TRUE(queue.empty());
+}
+
+// Производитель и потребитель в разных потоках: ни потерь, ни перестановок
+TEST(SpscQueueTest, TransfersAcrossThreads) {
+    constexpr std::uint64_t COUNT = 100000;
+    utils::SpscQueue<std::uint64_t> queue(64);
+
+    std::thread consumer([&queue] {
+        std::uint64_t expected = 0;
+        std::uint64_t value = 0;
+        while (expected < COUNT) {
+            if (queue.try_pop(value)) {
+                ASSERT_EQ(value, expected);
+                ++expected;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    for (std::uint64_t value = 0; value < COUNT;) {
+        std::uint64_t copy = value;
+        if (queue.try_push(std::move(copy))) {
+            ++value;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+}
+
+class AsyncAppenderTest : public ::testing::Test {
+protected:
+    std::filesystem::path path = std::filesystem::temp_directory_path() /
+                                 ("messenger_appender_" +
+                                  std::to_string(::getpid()) + ".txt");
+
+    void SetUp() override {
+        std::filesystem::remove(path);
+    }
+    void TearDown() override {
+        std::filesystem::remove(path);
+    }
+
+    auto readLines() const -> std::vector<std::string> {
+        std::ifstream file(path);
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(file, line)) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+};
+
+// Все записи попадают в файл по порядку, пачками, даже сверх ёмкости
+// очереди
+TEST_F(AsyncAppenderTest, WritesAllRecordsInOrder) {
+    constexpr int COUNT = 5000;
+    utils::AsyncAppender::Options options{};
+    options.durability = utils::AsyncAppender::Durability::None;
+    options.queue_capacity = 16;
+
+    utils::AsyncAppender appender(path.string(), options);
+    for (int index = 0; index < COUNT; ++index) {
+        appender.append("строка " + std::to_string(index) + "\n");
+    }
+    appender.flush();
+
+    EXPECT_EQ(appender.written_records(), static_cast<std::uint64_t>(COUNT));
+    EXPECT_LE(appender.write_batches(), appender.written_records());
+    EXPECT_EQ(appender.sync_count(), 0U);
+    EXPECT_FALSE(appender.failed());
+
+    const auto lines = readLines();
+    ASSERT_EQ(lines.size(), static_cast<std::size_t>(COUNT));
+    for (int index = 0; index < COUNT; ++index) {
+        EXPECT_EQ(lines[static_cast<std::size_t>(index)],
+                  "строка " + std::to_string(index));
+    }
+}
+
+// Политика always: fdatasync() на каждую пачку, а не на каждую запись
+TEST_F(AsyncAppenderTest, AlwaysSyncsOncePerBatch) {
+    utils::AsyncAppender::Options options{};
+    options.durability = utils::AsyncAppender::Durability::Always;
+
+    utils::AsyncAppender appender(path.string(), options);
+    for (int index = 0; index < 1000; ++index) {
+        appender.append("x\n");
+    }
+    appender.flush();
+
+    EXPECT_EQ(appender.written_records(), 1000U);
+    EXPECT_EQ(appender.sync_count(), appender.write_batches());
+}
+
+// Интервальная политика фиксирует данные и без новых записей
+TEST_F(AsyncAppenderTest, IntervalSyncsAfterDeadline) {
+    utils::AsyncAppender::Options options{};
+    options.sync_interval = std::chrono::milliseconds(20);
+
+    utils::AsyncAppender appender(path.string(), options);
+    appender.append("первая\n");
+    appender.flush();
+
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (appender.sync_count() == 0 &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_GE(appender.sync_count(), 1U);
+}
+
+// Постановка записи не аллоцирует сверх самой строки и не ждёт диска
+TEST_F(AsyncAppenderTest, AppendDoesNotAllocate) {
+    utils::AsyncAppender::Options options{};
+    options.durability = utils::AsyncAppender::Durability::None;
+    utils::AsyncAppender appender(path.string(), options);
+
+    std::vector<std::string> records(100, std::string(100, 'x'));
+    const std::size_t before = allocation_count.load();
+    for (auto& record : records) {
+        appender.append(std::move(record));
+    }
+    const std::size_t allocations = allocation_count.load() - before;
+    appender.flush();
+
+    // Пачка потока записи может вырасти — это его аллокации, не наши;
+    // главное, что append() не копирует строки
+    EXPECT_LT(allocations, 10U);
+}
+
+// Замена файла — в порядке очереди: записи до неё теряются вместе с
+// прежним файлом, записи после дописываются в новый
+TEST_F(AsyncAppenderTest, ReplacesFileInQueueOrder) {
+    utils::AsyncAppender::Options options{};
+    options.durability = utils::AsyncAppender::Durability::None;
+    utils::AsyncAppender appender(path.string(), options);
+
+    appender.append("старая\n");
+    appender.replace("снимок\n");
+    appender.append("новая\n");
+    appender.flush();
+
+    EXPECT_FALSE(appender.failed());
+    EXPECT_EQ(readLines(), (std::vector<std::string>{"снимок", "новая"}));
+    EXPECT_FALSE(std::filesystem::exists(path.string() + ".tmp"));
+}
+
+// Неудачная замена не трогает прежний файл и останавливает запись
+TEST_F(AsyncAppenderTest, FailedReplaceKeepsOldFile) {
+    utils::AsyncAppender::Options options{};
+    options.durability = utils::AsyncAppender::Durability::None;
+    utils::AsyncAppender appender(path.string(), options);
+    // Каталог на месте временного файла: open() не удастся и root'у
+    const std::string temp_path = path.string() + ".tmp";
+    std::filesystem::create_directory(temp_path);
+
+    appender.append("старая\n");
+    appender.replace("снимок\n");
+    appender.append("новая\n");
+    appender.flush();
+    std::filesystem::remove(temp_path);
+
+    EXPECT_TRUE(appender.failed());
+    EXPECT_EQ(readLines(), (std::vector<std::string>{"старая"}));
+}
+
+// Разбор MESSENGER_HISTORY_FSYNC
+TEST(AsyncAppenderOptionsTest, ParsesDurabilityPolicy) {
+    using utils::AsyncAppender;
+
+    EXPECT_EQ(AsyncAppender::parse_durability("none")->durability,
+              AsyncAppender::Durability::None);
+    EXPECT_EQ(AsyncAppender::parse_durability("always")->durability,
+              AsyncAppender::Durability::Always);
+
+    const auto interval = AsyncAppender::parse_durability("250ms");
+    ASSERT_TRUE(interval.has_value());
+    EXPECT_EQ(interval->durability, AsyncAppender::Durability::Interval);
+    EXPECT_EQ(interval->sync_interval, std::chrono::milliseconds(250));
+    EXPECT_EQ(AsyncAppender::parse_durability("100")->sync_interval,
+              std::chrono::milliseconds(100));
+
+    EXPECT_FALSE(AsyncAppender::parse_durability("").has_value());
+    EXPECT_FALSE(AsyncAppender::parse_durability("0").has_value());
+    EXPECT_FALSE(AsyncAppender::parse_durability("often").has_value());
+}
+
+// ============= Тесты постоянной истории =============
+
+class HistoryStoreTest : public ::testing::Test {
+protected:
+    std::filesystem::path base = std::filesystem::temp_directory_path() /
+                                 ("messenger_store_" +
+                                  std::to_string(::getpid()));
+    std::filesystem::path log_path = base.string() + ".log";
+    std::filesystem::path index_path = base.string() + ".idx";
+    std::filesystem::path text_path = base.string() + ".txt";
+
+    void SetUp() override {
+        removeFiles();
+    }
+    void TearDown() override {
+        removeFiles();
+    }
+
+    void removeFiles() const {
+        std::filesystem::remove(log_path);
+        std::filesystem::remove(index_path);
+        std::filesystem::remove(text_path);
+    }
+
+    [[nodiscard]]
+    static auto fastOptions() -> utils::AsyncAppender::Options {
+        utils::AsyncAppender::Options options{};
+        options.durability = utils::AsyncAppender::Durability::None;
+        return options;
+    }
+
+    void fill(std::size_t count) const {
+        app::HistoryStore store(base.string(), fastOptions());
+        for (std::size_t index = 0; index < count; ++index) {
+            store.append("строка " + std::to_string(index));
+        }
+    }
+};
+
+// Записи переживают повторное открытие и читаются по номеру
+TEST_F(HistoryStoreTest, ReopensAndReadsByIndex) {
+    fill(1000);
+
+    app::HistoryStore store(base.string(), fastOptions());
+    ASSERT_EQ(store.size(), 1000U);
+    EXPECT_EQ(store.recovered_entries(), 0U);
+    EXPECT_EQ(store.read(0), "строка 0");
+    EXPECT_EQ(store.read(999), "строка 999");
+    EXPECT_EQ(store.read(1000), "");
+}
+
+// Записи текущего сеанса читаются и до закрытия хранилища
+TEST_F(HistoryStoreTest, ReadsEntriesAppendedInSession) {
+    app::HistoryStore store(base.string(), fastOptions());
+    store.append("");
+    store.append("первая");
+    EXPECT_EQ(store.read(1), "первая");
+
+    store.append("вторая");
+    ASSERT_EQ(store.size(), 3U);
+    EXPECT_EQ(store.read(0), "");
+    EXPECT_EQ(store.read(2), "вторая");
+}
+
+// Недописанные записи читаются из памяти, не дожидаясь фоновой записи,
+// и остаются верными, когда их копии сменяет отображение файлов
+TEST_F(HistoryStoreTest, ReadsUnwrittenEntriesWithoutFlush) {
+    utils::AsyncAppender::Options options{};
+    options.durability = utils::AsyncAppender::Durability::Always;
+    app::HistoryStore store(base.string(), options);
+
+    constexpr std::size_t COUNT = 1000;
+    for (std::size_t index = 0; index < COUNT; ++index) {
+        store.append("строка " + std::to_string(index));
+        ASSERT_EQ(store.read(index), "строка " + std::to_string(index));
+    }
+
+    store.flush();
+    for (std::size_t index = 0; index < COUNT; ++index) {
+        ASSERT_EQ(store.read(index), "строка " + std::to_string(index));
+    }
+}
+
+// Оборванная запись журнала отрезается, смещение на неё отбрасывается
+TEST_F(HistoryStoreTest, DropsTornLogRecord) {
+    fill(10);
+    std::filesystem::resize_file(log_path,
+                                 std::filesystem::file_size(log_path) - 3);
+
+    {
+        app::HistoryStore store(base.string(), fastOptions());
+        ASSERT_EQ(store.size(), 9U);
+        EXPECT_EQ(store.read(8), "строка 8");
+        store.append("после сбоя");
+    }
+
+    app::HistoryStore store(base.string(), fastOptions());
+    ASSERT_EQ(store.size(), 10U);
+    EXPECT_EQ(store.read(9), "после сбоя");
+}
+
+// Смещения, не попавшие в индекс, досчитываются по журналу
+TEST_F(HistoryStoreTest, RebuildsMissingIndexTail) {
+    fill(10);
+    std::filesystem::resize_file(
+        index_path, std::filesystem::file_size(index_path) - 4 * 8 - 5);
+
+    app::HistoryStore store(base.string(), fastOptions());
+    EXPECT_EQ(store.recovered_entries(), 5U);
+    ASSERT_EQ(store.size(), 10U);
+    for (std::size_t index = 0; index < 10; ++index) {
+        EXPECT_EQ(store.read(index), "строка " + std::to_string(index));
+    }
+}
+
+// Файл чужого формата не перезаписывается
+TEST_F(HistoryStoreTest, RejectsForeignFile) {
+    {
+        std::ofstream foreign(log_path);
+        foreign << "[Я]: это не журнал\n";
+    }
+    EXPECT_THROW(app::HistoryStore(base.string(), fastOptions()),
+                 std::runtime_error);
+}
+
+// Перенос текстовой истории: по строке на запись
+TEST_F(HistoryStoreTest, ImportsTextHistory) {
+    {
+        std::ofstream text(text_path);
+        text << "[Я]: раз\n[Собеседник]: два\n";
+    }
+
+    {
+        app::HistoryStore store(base.string(), fastOptions());
+        EXPECT_EQ(store.import_text_file(text_path.string()), 2U);
+    }
+
+    app::HistoryStore store(base.string(), fastOptions());
+    ASSERT_EQ(store.size(), 2U);
+    EXPECT_EQ(store.read(0), "[Я]: раз");
+    EXPECT_EQ(store.read(1), "[Собеседник]: два");
+}
+
+// ============= Тесты поиска по истории =============
+
+// Слова UTF-8 в нижнем регистре, пунктуация и эмодзи — разделители
+TEST(HistoryIndexTokenizeTest, SplitsAndLowercasesUtf8) {
+    const auto words =
+        app::HistoryIndex::tokenize("[Я]: Привет, МИР! Ёлка-2024 😀Hello");
+    const std::vector<std::string> expected{"я",    "привет", "мир", "ёлка",
+                                            "2024", "hello"};
+    EXPECT_EQ(words, expected);
+    EXPECT_TRUE(app::HistoryIndex::tokenize(" ,.!? «» — ").empty());
+}
+
+class HistoryIndexTest : public ::testing::Test {
+protected:
+    std::string base = (std::filesystem::temp_directory_path() /
+                        ("messenger_index_" + std::to_string(::getpid())))
+                           .string();
+
+    void SetUp() override {
+        removeFiles();
+    }
+    void TearDown() override {
+        removeFiles();
+    }
+
+    // Журнал, индекс истории и все файлы поискового индекса
+    void removeFiles() const {
+        const std::filesystem::path base_path(base);
+        const std::string prefix = base_path.filename().string() + ".";
+        for (const auto& file : std::filesystem::directory_iterator(
+                 base_path.parent_path())) {
+            if (file.path().filename().string().starts_with(prefix)) {
+                std::filesystem::remove(file.path());
+            }
+        }
+    }
+
+    [[nodiscard]]
+    static auto fastOptions() -> utils::AsyncAppender::Options {
+        utils::AsyncAppender::Options options{};
+        options.durability = utils::AsyncAppender::Durability::None;
+        return options;
+    }
+
+    [[nodiscard]]
+    static auto smallSegments() -> app::HistoryIndex::Options {
+        app::HistoryIndex::Options options{};
+        options.flush_entries = 16;
+        options.merge_fanout = 2;
+        return options;
+    }
+
+    static void append(app::HistoryStore& store, app::HistoryIndex& index,
+                       const std::string& line) {
+        store.append(line);
+        index.add(line);
+    }
+};
+
+// Находятся записи со всеми словами запроса, от новых к старым
+TEST_F(HistoryIndexTest, FindsEntriesWithAllWordsNewestFirst) {
+    app::HistoryStore store(base, fastOptions());
+    app::HistoryIndex index(base, store);
+
+    append(store, index, "[Я]: встреча завтра в офисе");
+    append(store, index, "[Собеседник]: Завтра не могу");
+    append(store, index, "[Я]: тогда встреча в пятницу");
+    append(store, index, "[Собеседник]: ВСТРЕЧА в пятницу, ок");
+
+    EXPECT_EQ(index.search("встреча", 10),
+              (std::vector<std::size_t>{3, 2, 0}));
+    EXPECT_EQ(index.search("Встреча ПЯТНИЦУ", 10),
+              (std::vector<std::size_t>{3, 2}));
+    EXPECT_EQ(index.search("встреча", 1), (std::vector<std::size_t>{3}));
+    EXPECT_TRUE(index.search("отпуск", 10).empty());
+    EXPECT_TRUE(index.search("!!!", 10).empty());
+}
+
+// Сброшенные сегменты сливаются, результаты не зависят от того, где
+// лежит запись — в памяти или в сегменте на диске
+TEST_F(HistoryIndexTest, SearchesAcrossMergedSegments) {
+    app::HistoryStore store(base, fastOptions());
+    app::HistoryIndex index(base, store, smallSegments());
+
+    for (int line = 0; line < 200; ++line) {
+        append(store, index,
+               "сообщение " + std::to_string(line) +
+                   (line % 10 == 0 ? " важное" : ""));
+    }
+
+    // 12 сегментов по 16 записей при слиянии по два — по числу единиц
+    // в двоичной записи 12
+    index.flush();
+    EXPECT_EQ(index.segment_count(), 2U);
+    const auto found = index.search("важное", 100);
+    ASSERT_EQ(found.size(), 20U);
+    EXPECT_EQ(found.front(), 190U);
+    EXPECT_EQ(found.back(), 0U);
+    EXPECT_EQ(index.search("сообщение 77", 10),
+              (std::vector<std::size_t>{77}));
+}
+
+// Замороженный сегмент ищется и до, и после публикации его файла
+TEST_F(HistoryIndexTest, FrozenSegmentStaysSearchable) {
+    app::HistoryStore store(base, fastOptions());
+    app::HistoryIndex index(base, store, smallSegments());
+
+    for (int line = 0; line < 16; ++line) {
+        append(store, index, "строка " + std::to_string(line));
+    }
+    EXPECT_EQ(index.search("строка 3", 10), (std::vector<std::size_t>{3}));
+
+    index.flush();
+    EXPECT_EQ(index.segment_count(), 1U);
+    EXPECT_EQ(index.search("строка 3", 10), (std::vector<std::size_t>{3}));
+    EXPECT_TRUE(std::filesystem::exists(base + ".fts"));
+}
+
+// Ошибка потока записи всплывает исключением при следующем add()
+TEST_F(HistoryIndexTest, ReportsWriterErrorOnNextAdd) {
+    app::HistoryStore store(base, fastOptions());
+    app::HistoryIndex index(base, store, smallSegments());
+    // Каталог на месте файла первого сегмента
+    std::filesystem::create_directory(base + ".fts.1");
+
+    for (int line = 0; line < 16; ++line) {
+        append(store, index, "строка " + std::to_string(line));
+    }
+    index.flush();
+    EXPECT_EQ(index.segment_count(), 0U);
+    EXPECT_EQ(index.search("строка 3", 10), (std::vector<std::size_t>{3}));
+    EXPECT_THROW(index.add("ещё одна"), std::runtime_error);
+
+    std::filesystem::remove(base + ".fts.1");
+}
+
+// Индекс переживает перезапуск: сохранённые сегменты не перестраиваются,
+// дочитываются только записи после них
+TEST_F(HistoryIndexTest, PersistsAndCatchesUpAfterReopen) {
+    {
+        app::HistoryStore store(base, fastOptions());
+        app::HistoryIndex index(base, store, smallSegments());
+        for (int line = 0; line < 40; ++line) {
+            append(store, index, "строка " + std::to_string(line));
+        }
+    }
+    {
+        // Записи, добавленные без индекса
+        app::HistoryStore store(base, fastOptions());
+        store.append("без индекса");
+    }
+
+    app::HistoryStore store(base, fastOptions());
+    app::HistoryIndex index(base, store, smallSegments());
+    EXPECT_EQ(index.indexed_entries(), 41U);
+    EXPECT_EQ(index.search("строка 5", 10), (std::vector<std::size_t>{5}));
+    EXPECT_EQ(index.search("строка 39", 10), (std::vector<std::size_t>{39}));
+    EXPECT_EQ(index.search("индекса", 10), (std::vector<std::size_t>{40}));
+}
+
+// Повреждённый манифест — индекс строится заново по истории
+TEST_F(HistoryIndexTest, RebuildsFromCorruptManifest) {
+    {
+        app::HistoryStore store(base, fastOptions());
+        app::HistoryIndex index(base, store, smallSegments());
+        for (int line = 0; line < 40; ++line) {
+            append(store, index, "строка " + std::to_string(line));
+        }
+    }
+    {
+        std::ofstream manifest(base + ".fts", std::ios::trunc);
+        manifest << "мусор";
+    }
+
+    app::HistoryStore store(base, fastOptions());
+    app::HistoryIndex index(base, store, smallSegments());
+    EXPECT_EQ(index.indexed_entries(), 40U);
+    EXPECT_EQ(index.search("строка 17", 10), (std::vector<std::size_t>{17}));
+}
+
+// ============= Тесты режима хаба =============
+
+// ------------- Фикстура: хаб в отдельном потоке -------------
+class HubTest : public ::testing::Test {
+protected:
+    uint16_t port = 55556;
+    std::unique_ptr<messenger::app::Hub> hub;
+    std::thread hub_thread;
+
+    void SetUp() override {
+        hub = std::make_unique<messenger::app::Hub>(
+            create_listen_socket(port, SOMAXCONN), false);
+        hub_thread = std::thread([this] { hub->run(); });
+    }
+
+    void TearDown() override {
+        hub->stop();
+        hub_thread.join();
+    }
+
+    // Подключение участника с таймаутом приёма, чтобы тест не зависал
+    [[nodiscard]]
+    auto connectPeer() const -> Socket {
+        Socket client = create_client_socket("127.0.0.1", port);
+        timeval time_v{};
+        time_v.tv_sec = 2;
+        setsockopt(client.fd_return(), SOL_SOCKET, SO_RCVTIMEO, &time_v,
+                   sizeof(time_v));
+        return client;
+    }
+
+    // Ожидание, пока хаб примет заданное число участников
+    [[nodiscard]]
+    auto waitPeers(std::size_t count) const -> bool {
+        for (int attempt = 0; attempt < 1000; ++attempt) {
+            if (hub->peer_count() == count) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return false;
+    }
+};
+
+// Text одного участника получают все остальные
+TEST_F(HubTest, RoutesTextToOtherPeers) {
+    const Socket alice = connectPeer();
+    const Socket bob = connectPeer();
+    const Socket carol = connectPeer();
+    ASSERT_TRUE(waitPeers(3));
+
+    ASSERT_TRUE(proto::send_text(alice.fd_return(), "привет", 7));
+
+    for (const Socket* receiver : {&bob, &carol}) {
+        proto::Message msg{};
+        bool disconnected = false;
+        ASSERT_TRUE(proto::receive_msg(receiver->fd_return(), msg, disconnected));
+        ASSERT_FALSE(disconnected);
+        EXPECT_EQ(msg.type, proto::MsgType::Text);
+        EXPECT_EQ(msg.payload, "привет");
+        EXPECT_NE(msg.id, 0U);
+    }
+}
+
+// Ack получателя возвращается отправителю с исходным id
+TEST_F(HubTest, RoutesAckBackWithSenderId) {
+    const Socket alice = connectPeer();
+    const Socket bob = connectPeer();
+    ASSERT_TRUE(waitPeers(2));
+
+    ASSERT_TRUE(proto::send_text(alice.fd_return(), "ping?", 42));
+
+    proto::Message forwarded{};
+    bool disconnected = false;
+    ASSERT_TRUE(
+        proto::receive_msg(bob.fd_return(), forwarded, disconnected));
+    ASSERT_EQ(forwarded.type, proto::MsgType::Text);
+
+    ASSERT_TRUE(proto::send_ack(bob.fd_return(), forwarded.id));
+
+    proto::Message ack{};
+    ASSERT_TRUE(proto::receive_msg(alice.fd_return(), ack, disconnected));
+    EXPECT_EQ(ack.type, proto::MsgType::Ack);
+    EXPECT_EQ(ack.id, 42U);
+}
+
+// Ретрай уже подтверждённого Text не рассылается повторно — хаб сам
+// повторяет Ack отправителю
+TEST_F(HubTest, RetransmittedTextAfterAckIsAckedByHub) {
+    const Socket alice = connectPeer();
+    const Socket bob = connectPeer();
+    ASSERT_TRUE(waitPeers(2));
+
+    ASSERT_TRUE(proto::send_text(alice.fd_return(), "раз", 5));
+    proto::Message forwarded{};
+    bool disconnected = false;
+    ASSERT_TRUE(
+        proto::receive_msg(bob.fd_return(), forwarded, disconnected));
+    ASSERT_TRUE(proto::send_ack(bob.fd_return(), forwarded.id));
+
+    proto::Message ack{};
+    ASSERT_TRUE(proto::receive_msg(alice.fd_return(), ack, disconnected));
+    ASSERT_EQ(ack.id, 5U);
+
+    // Повтор того же id
+    ASSERT_TRUE(proto::send_text(alice.fd_return(), "раз", 5));
+    ASSERT_TRUE(proto::receive_msg(alice.fd_return(), ack, disconnected));
+    EXPECT_EQ(ack.type, proto::MsgType::Ack);
+    EXPECT_EQ(ack.id, 5U);
+}
+
+// Typing рассылается, Ping подтверждается самим хабом
+TEST_F(HubTest, BroadcastsTypingAndAnswersPing) {
+    const Socket alice = connectPeer();
+    const Socket bob = connectPeer();
+    ASSERT_TRUE(waitPeers(2));
+
+    ASSERT_TRUE(proto::send_typing(alice.fd_return(), 0));
+    proto::Message msg{};
+    bool disconnected = false;
+    ASSERT_TRUE(proto::receive_msg(bob.fd_return(), msg, disconnected));
+    EXPECT_EQ(msg.type, proto::MsgType::Typing);
+
+    ASSERT_TRUE(proto::send_ping(alice.fd_return(), 9));
+    ASSERT_TRUE(proto::receive_msg(alice.fd_return(), msg, disconnected));
+    EXPECT_EQ(msg.type, proto::MsgType::Pong);
+    EXPECT_EQ(msg.id, 9U);
+}
+
+// На приветствие участника хаб отвечает своим приветствием без
+// возможностей, затем Pong: участник не ждёт таймаута приветствия
+TEST_F(HubTest, AnswersHelloWithOwnHello) {
+    const Socket alice = connectPeer();
+    ASSERT_TRUE(waitPeers(1));
+
+    proto::Hello hello{};
+    hello.session_id = 42;
+    hello.features = proto::Hello::SUPPORTED_FEATURES;
+    const auto frame = proto::serialize(
+        proto::Message{proto::MsgType::Ping, 7, proto::encode_hello(hello)});
+    ASSERT_EQ(::send(alice.fd_return(), frame.data(), frame.size(), 0),
+              static_cast<ssize_t>(frame.size()));
+
+    proto::Message msg{};
+    bool disconnected = false;
+    ASSERT_TRUE(proto::receive_msg(alice.fd_return(), msg, disconnected));
+    ASSERT_EQ(msg.type, proto::MsgType::Ping);
+    const auto hub_hello = proto::decode_hello(msg.payload);
+    ASSERT_TRUE(hub_hello.has_value());
+    EXPECT_NE(hub_hello->session_id, 0U);
+    EXPECT_EQ(hub_hello->peer_session_id, 0U);
+    EXPECT_EQ(hub_hello->features, 0U);
+
+    ASSERT_TRUE(proto::receive_msg(alice.fd_return(), msg, disconnected));
+    EXPECT_EQ(msg.type, proto::MsgType::Pong);
+    EXPECT_EQ(msg.id, 7U);
+}
+
+// Отключение участника уменьшает их число
+TEST_F(HubTest, TracksDisconnectedPeers) {
+    const Socket alice = connectPeer();
+    {
+        const Socket bob = connectPeer();
+        ASSERT_TRUE(waitPeers(2));
+    }
+    EXPECT_TRUE(waitPeers(1));
+}
+
+// Хаб держит множество одновременных простаивающих соединений
+TEST_F(HubTest, HoldsManyIdlePeers) {
+    constexpr std::size_t PEERS = 2000U;
+    std::vector<Socket> clients;
+    clients.reserve(PEERS);
+    for (std::size_t index = 0; index < PEERS; ++index) {
+        const int sock = ::socket(AF_INET, SOCK_STREAM, 0);
+        ASSERT_GE(sock, 0);
+        clients.emplace_back(sock);
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-cstyle-cast)
+        ASSERT_EQ(::connect(sock, (sockaddr*)&addr, sizeof(addr)), 0);
+    }
+
+    EXPECT_TRUE(waitPeers(PEERS));
+}
+
+// ============= Сквозной тест режима без терминала =============
+
+#ifdef MESSENGER_BINARY
+namespace {
+
+// Дочерний messenger: убивается, если тест прервался раньше его выхода
+class ChildProcess {
+public:
+    explicit ChildProcess(pid_t pid) : pid_(pid) {}
+    ChildProcess(const ChildProcess&) = delete;
+    auto operator=(const ChildProcess&) -> ChildProcess& = delete;
+    ChildProcess(ChildProcess&&) = delete;
+    auto operator=(ChildProcess&&) -> ChildProcess& = delete;
+
+    ~ChildProcess() {
+        if (running()) {
+            ::kill(pid_, SIGKILL);
+            ::waitpid(pid_, nullptr, 0);
+        }
+    }
+
+    // Процесс ещё работает (без ожидания)
+    [[nodiscard]]
+    auto running() -> bool {
+        if (exited_) {
+            return false;
+        }
+        exited_ = ::waitpid(pid_, &status_, WNOHANG) == pid_;
+        return !exited_;
+    }
+
+    // Дождаться выхода не дольше timeout; true — процесс завершился
+    [[nodiscard]]
+    auto wait_exit(std::chrono::milliseconds timeout) -> bool {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (running() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return !running();
+    }
+
+    [[nodiscard]]
+    auto status() const -> int {
+        return status_;
+    }
+
+private:
+    pid_t pid_;
+    int status_{0};
+    bool exited_{false};
+};
+
+}  // namespace
+
+// Строки из stdin-канала уходят собеседнику по loopback, а процесс
+// завершается только после Ack на каждую из них
+TEST(HeadlessPipeTest, ExitsOnlyAfterEveryLineIsAcked) {
+    if (!std::filesystem::exists(MESSENGER_BINARY)) {
+        GTEST_SKIP() << "нет исполняемого файла " << MESSENGER_BINARY;
+    }
+    constexpr std::uint16_t PORT = 55571;
+    constexpr std::size_t LINES = 5;
+    const Socket listener = create_listen_socket(PORT, 1);
+
+    const std::filesystem::path work_dir =
+        std::filesystem::temp_directory_path() / "messenger_headless_test";
+    std::filesystem::remove_all(work_dir);
+    std::filesystem::create_directories(work_dir);
+
+    std::array<int, 2> input{};
+    ASSERT_EQ(::pipe(input.data()), 0);
+    const pid_t pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        ::dup2(input[0], STDIN_FILENO);
+        ::close(input[0]);
+        ::close(input[1]);
+        const int null_fd = ::open("/dev/null", O_WRONLY);
+        ::dup2(null_fd, STDOUT_FILENO);
+        ::dup2(null_fd, STDERR_FILENO);
+        if (::chdir(work_dir.c_str()) == 0) {
+            ::execl(MESSENGER_BINARY, MESSENGER_BINARY, "клиент", "127.0.0.1",
+                    std::to_string(PORT).c_str(), nullptr);
+        }
+        ::_exit(EXIT_FAILURE);
+    }
+    ChildProcess child(pid);
+    ::close(input[0]);
+
+    std::string lines;
+    for (std::size_t index = 1; index <= LINES; ++index) {
+        lines += "строка " + std::to_string(index) + "\n";
+    }
+    ASSERT_EQ(::write(input[1], lines.data(), lines.size()),
+              static_cast<ssize_t>(lines.size()));
+    ::close(input[1]);  // EOF: ввод закончился
+
+    const Socket peer = accept_client(listener);
+    timeval time_v{};
+    time_v.tv_sec = 5;
+    setsockopt(peer.fd_return(), SOL_SOCKET, SO_RCVTIMEO, &time_v,
+               sizeof(time_v));
+
+    // Собеседник без расширений: подтверждение Ack на каждое сообщение
+    proto::Hello hello{};
+    hello.session_id = 0x77U;
+    ASSERT_TRUE(net::send_bytes(
+        peer.fd_return(),
+        proto::serialize(proto::Message{proto::MsgType::Ping, 1,
+                                        proto::encode_hello(hello)})));
+
+    // Подтвердить все строки, кроме последней
+    std::vector<std::string> received;
+    std::uint32_t last_id = 0;
+    while (received.size() < LINES) {
+        proto::Message msg{};
+        bool disconnected = false;
+        ASSERT_TRUE(proto::receive_msg(peer.fd_return(), msg, disconnected));
+        ASSERT_FALSE(disconnected);
+        if (msg.type == proto::MsgType::Ping) {
+            ASSERT_TRUE(proto::send_pong(peer.fd_return(), msg.id));
+            continue;
+        }
+        if (msg.type != proto::MsgType::Text ||
+            std::find(received.begin(), received.end(), msg.payload) !=
+                received.end()) {
+            continue;  // повтор по таймауту
+        }
+        received.push_back(msg.payload);
+        if (received.size() < LINES) {
+            ASSERT_TRUE(proto::send_ack(peer.fd_return(), msg.id));
+        } else {
+            last_id = msg.id;
+        }
+    }
+    EXPECT_EQ(received.back(), "строка " + std::to_string(LINES));
+
+    // Пока последняя строка не подтверждена, процесс ждёт
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    EXPECT_TRUE(child.running());
+
+    ASSERT_TRUE(proto::send_ack(peer.fd_return(), last_id));
+    ASSERT_TRUE(child.wait_exit(std::chrono::seconds(5)));
+    EXPECT_TRUE(WIFEXITED(child.status()));
+    EXPECT_EQ(WEXITSTATUS(child.status()), EXIT_SUCCESS);
+
+    std::filesystem::remove_all(work_dir);
+}
+#endif  // MESSENGER_BINARY
+
 // ============= Тесты для функций Основной цикл чата =============
 // using namespace messenger::app;
 
@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""Сравнение двух прогонов bench_messenger в формате JSON.
+
+Результаты получаются целью bench_json (или вручную:
+bench_messenger --benchmark_out=run.json --benchmark_out_format=json).
+
+    tools/bench_compare.py base.json new.json [--threshold 10]
+                           [--metric cpu_time]
+
+Для каждого бенчмарка, который есть в обоих прогонах, печатается время
+до и после и изменение в процентах. Замедление больше порога помечается
+как регрессия, и скрипт завершается с кодом 1 — его можно ставить в CI.
+При прогоне с --benchmark_repetitions сравниваются медианы.
+"""
+
+import argparse
+import json
+import sys
+
+# Множители к наносекундам для поля time_unit
+TIME_UNITS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load_run(path, metric):
+    """Имя бенчмарка -> значение metric в наносекундах."""
+    with open(path, encoding="utf-8") as file:
+        report = json.load(file)
+
+    iterations = {}
+    medians = {}
+    for bench in report.get("benchmarks", []):
+        if bench.get("error_occurred"):
+            continue
+        scale = TIME_UNITS.get(bench.get("time_unit", "ns"), 1.0)
+        value = bench[metric] * scale
+        if bench.get("run_type") == "aggregate":
+            if bench.get("aggregate_name") == "median":
+                medians[bench["run_name"]] = value
+            continue
+        # Без повторов у каждого бенчмарка одна запись
+        iterations.setdefault(bench.get("run_name", bench["name"]), value)
+
+    iterations.update(medians)
+    return iterations
+
+
+def format_time(nanoseconds):
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if nanoseconds >= scale:
+            return f"{nanoseconds / scale:.2f} {unit}"
+    return f"{nanoseconds:.1f} ns"
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Сравнение двух JSON-прогонов bench_messenger")
+    parser.add_argument("base", help="исходный прогон")
+    parser.add_argument("new", help="новый прогон")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="допустимое замедление, %% (по умолчанию 10)")
+    parser.add_argument("--metric", choices=("cpu_time", "real_time"),
+                        default="cpu_time",
+                        help="сравниваемое время (по умолчанию cpu_time)")
+    args = parser.parse_args()
+
+    base = load_run(args.base, args.metric)
+    new = load_run(args.new, args.metric)
+
+    common = [name for name in base if name in new]
+    if not common:
+        print("Нет общих бенчмарков", file=sys.stderr)
+        return 2
+
+    width = max(len(name) for name in set(base) | set(new))
+    regressions = []
+    for name in common:
+        before, after = base[name], new[name]
+        change = (after - before) / before * 100.0 if before > 0 else 0.0
+        mark = ""
+        if change > args.threshold:
+            mark = "  РЕГРЕССИЯ"
+            regressions.append(name)
+        elif change < -args.threshold:
+            mark = "  ускорение"
+        print(f"{name:<{width}}  {format_time(before):>12}  "
+              f"{format_time(after):>12}  {change:+7.1f}%{mark}")
+
+    for name in sorted(set(base) ^ set(new)):
+        where = "только в " + (args.base if name in base else args.new)
+        print(f"{name:<{width}}  ({where})")
+
+    if regressions:
+        print(f"\nРегрессий больше {args.threshold:g}%: {len(regressions)}",
+              file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())